@@ -24,8 +24,9 @@ if [[ "$TASK" == "cpp-tests" ]]; then
         extra_cmake_opts=""
     fi
     cmake -DBUILD_CPP_TEST=ON -DUSE_OPENMP=OFF -DUSE_DEBUG=ON $extra_cmake_opts ..
-    make testlightgbm -j4 || exit -1
+    make testlightgbm testlightgbm_allocations -j4 || exit -1
     ./../testlightgbm || exit -1
+    ./../testlightgbm_allocations || exit -1
     exit 0
 fi
 
@@ -19,9 +19,10 @@ if ($env:TASK -eq "r-package") {
 if ($env:TASK -eq "cpp-tests") {
   mkdir $env:BUILD_SOURCESDIRECTORY/build; cd $env:BUILD_SOURCESDIRECTORY/build
   cmake -DBUILD_CPP_TEST=ON -DUSE_OPENMP=OFF -DUSE_DEBUG=ON -A x64 ..
-  cmake --build . --target testlightgbm --config Debug ; Check-Output $?
+  cmake --build . --target testlightgbm testlightgbm_allocations --config Debug ; Check-Output $?
   cd ../Debug
   .\testlightgbm.exe ; Check-Output $?
+  .\testlightgbm_allocations.exe ; Check-Output $?
   Exit 0
 }
 
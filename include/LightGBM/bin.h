@@ -41,6 +41,47 @@ const double kSparseThreshold = 0.7;
 #define GET_GRAD(hist, i) hist[(i) << 1]
 #define GET_HESS(hist, i) hist[((i) << 1) + 1]
 
+/*! \brief Quantized gradient and hessian of one row, packed as gradient * 2^8 + hessian */
+typedef int16_t int_score_t;
+/*! \brief Histogram entry of quantized gradients, packed as gradient_sum * 2^32 + hessian_sum */
+typedef int64_t int_hist_t;
+
+const int_hist_t kIntHistGradUnit = static_cast<int_hist_t>(1) << 32;
+
+/*!
+* \brief Pack a quantized gradient in [-128, 127] and hessian in [0, 255]
+*/
+inline static int_score_t PackIntScore(int gradient, int hessian) {
+  return static_cast<int_score_t>(gradient * 256 + hessian);
+}
+
+/*!
+* \brief Widen a packed row into a histogram entry, the hessian is never negative
+*        so both halves can be summed with a single integer add
+*/
+inline static int_hist_t IntHistEntry(int_score_t packed) {
+  return static_cast<int_hist_t>(packed >> 8) * kIntHistGradUnit + (packed & 0xff);
+}
+
+inline static int_hist_t IntHistHess(int_hist_t entry) {
+  return static_cast<int_hist_t>(static_cast<uint32_t>(entry));
+}
+
+inline static int_hist_t IntHistGrad(int_hist_t entry) {
+  return (entry - IntHistHess(entry)) / kIntHistGradUnit;
+}
+
+/*!
+* \brief Rescale integer histogram entries into gradient / hessian pairs
+*/
+inline static void IntHistToHist(const int_hist_t* src, int num_bin,
+                                 double grad_scale, double hess_scale, hist_t* dst) {
+  for (int i = 0; i < num_bin; ++i) {
+    GET_GRAD(dst, i) = static_cast<hist_t>(IntHistGrad(src[i])) * grad_scale;
+    GET_HESS(dst, i) = static_cast<hist_t>(IntHistHess(src[i])) * hess_scale;
+  }
+}
+
 inline static void HistogramSumReducer(const char* src, char* dst, int type_size, comm_size_t len) {
   comm_size_t used_size = 0;
   const hist_t* p1;
@@ -273,6 +314,13 @@ class Bin {
   virtual void LoadFromMemory(const void* memory,
     const std::vector<data_size_t>& local_used_indices) = 0;
 
+  /*!
+  * \brief Use the data saved by SaveBinaryToFile in place, without copying it, for a bin created with 0 data
+  * \param memory Saved data, e.g. in a memory-mapped file, must stay valid as long as the bin is used
+  * \param num_data Number of data of the saved bin
+  */
+  virtual void LoadFromMappedMemory(const void* memory, data_size_t num_data) = 0;
+
   /*!
   * \brief Get sizes in byte of this object
   */
@@ -328,6 +376,20 @@ class Bin {
   virtual void ConstructHistogram(data_size_t start, data_size_t end,
                                   const score_t* ordered_gradients, hist_t* out) const = 0;
 
+  /*!
+  * \brief Construct histogram of this feature from quantized gradients
+  * \param data_indices Used data indices in current leaf
+  * \param start start index in data_indices
+  * \param end end index in data_indices
+  * \param ordered_int_gradients Packed quantized gradients and hessians, ordered like ordered_gradients
+  * \param out Output Result, one int_hist_t per bin
+  */
+  virtual void ConstructIntHistogram(const data_size_t* data_indices, data_size_t start, data_size_t end,
+                                     const int_score_t* ordered_int_gradients, int_hist_t* out) const = 0;
+
+  virtual void ConstructIntHistogram(data_size_t start, data_size_t end,
+                                     const int_score_t* ordered_int_gradients, int_hist_t* out) const = 0;
+
   virtual data_size_t Split(uint32_t min_bin, uint32_t max_bin,
                             uint32_t default_bin, uint32_t most_freq_bin,
                             MissingType missing_type, bool default_left,
@@ -359,6 +421,12 @@ class Bin {
   */
   virtual void FinishLoad() = 0;
 
+  /*!
+  * \brief Encode the data pushed since the last call, when the rows pushed after are all after them,
+  *        so that the data pushed in order of rows takes the memory of the encoded data only
+  */
+  virtual void FlushPushedData() = 0;
+
   /*!
   * \brief Create object for bin data of one feature, used for dense feature
   * \param num_data Total number of data
@@ -437,6 +505,20 @@ class MultiValBin {
                                          const score_t* ordered_hessians,
                                          hist_t* out) const = 0;
 
+  virtual void ConstructIntHistogram(const data_size_t* data_indices,
+                                     data_size_t start, data_size_t end,
+                                     const int_score_t* int_gradients,
+                                     int_hist_t* out) const = 0;
+
+  virtual void ConstructIntHistogram(data_size_t start, data_size_t end,
+                                     const int_score_t* int_gradients,
+                                     int_hist_t* out) const = 0;
+
+  virtual void ConstructIntHistogramOrdered(const data_size_t* data_indices,
+                                            data_size_t start, data_size_t end,
+                                            const int_score_t* ordered_int_gradients,
+                                            int_hist_t* out) const = 0;
+
   virtual void FinishLoad() = 0;
 
   virtual bool IsSparse() = 0;
@@ -10,6 +10,7 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -17,9 +18,11 @@ namespace LightGBM {
 
 /*! \brief forward declaration */
 class Dataset;
+class FlatForest;
 class ObjectiveFunction;
 class Metric;
 struct PredictionEarlyStopInstance;
+struct PredictionEarlyStopConfig;
 
 /*!
 * \brief The interface for Boosting
@@ -123,7 +126,8 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void GetPredictAt(int data_idx, double* result, int64_t* out_len) = 0;
 
-  virtual int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib) const = 0;
+  virtual int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib,
+                               bool is_pred_contrib_interactions) const = 0;
 
   /*!
   * \brief Prediction for one record, not sigmoid transform
@@ -172,6 +176,17 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictContribByMap(const std::unordered_map<int, double>& features,
                                    std::vector<std::unordered_map<int, double>>* output) const = 0;
 
+  /*!
+  * \brief SHAP interaction values for the model's prediction of one record
+  * \param feature_values Feature value on this record
+  * \param output One (num_features + 1) x (num_features + 1) matrix per tree of an iteration, the diagonal
+  *        holds the main effects and the last element the expected value, each row sums to the SHAP value
+  */
+  virtual void PredictContribInteractions(const double* features, double* output) const = 0;
+
+  virtual void PredictContribInteractionsByMap(const std::unordered_map<int, double>& features,
+                                               std::vector<std::unordered_map<int, double>>* output) const = 0;
+
   /*!
   * \brief Dump model to json format string
   * \param start_iteration The model will be saved start from
@@ -290,6 +305,20 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib) = 0;
 
+  /*!
+  * \brief Precompute the Fast TreeSHAP data of the trees of the iterations set by InitPredict, if they do not
+  *        have it yet. It is kept for the next predictions of the contributions, until the trees change
+  * \param max_table_features Most distinct features on the path of a leaf with a weight table
+  * \param table_memory_mb Most memory of the weight tables of the model, in MB
+  */
+  virtual void PrecomputeContrib(int /*max_table_features*/, double /*table_memory_mb*/) {}
+
+  /*!
+  * \brief Free the data kept for the next predictions, the flat forests and the Fast TreeSHAP data,
+  *        they are built again when needed. Not thread-safe with the predictions
+  */
+  virtual void FreePredictCache() {}
+
   /*!
   * \brief Name of submodel
   */
@@ -314,6 +343,21 @@ class LIGHTGBM_EXPORT Boosting {
   static Boosting* CreateBoosting(const std::string& type, const char* filename);
 
   virtual bool IsLinear() const { return false; }
+
+  /*!
+  * \brief Flat copy of the trees of some iterations, for batch prediction. It is built once and kept by the
+  *        model for the next predictors of the same iterations, until the trees change
+  * \param start_iteration Start index of the iteration to predict
+  * \param num_iteration Number of iterations to predict, <= 0 for all the iterations after start_iteration
+  * \param cache_size Bytes of cache for a block of trees and rows, 0 to predict all the trees at once
+  * \param early_stop Early stopping of the rows. If nullptr, no early stopping is applied and all models are evaluated.
+  * \return The flat forest, nullptr when the model cannot be flattened
+  */
+  virtual std::shared_ptr<const FlatForest> GetFlatForest(int /*start_iteration*/, int /*num_iteration*/,
+                                                          size_t /*cache_size*/,
+                                                          const PredictionEarlyStopConfig* /*early_stop*/) const {
+    return nullptr;
+  }
 };
 
 class GBDTBase : public Boosting {
@@ -30,6 +30,7 @@
 typedef void* DatasetHandle;  /*!< \brief Handle of dataset. */
 typedef void* BoosterHandle;  /*!< \brief Handle of booster. */
 typedef void* FastConfigHandle; /*!< \brief Handle of FastConfig. */
+typedef void* PredictorHandle;  /*!< \brief Handle of predictor. */
 
 #define C_API_DTYPE_FLOAT32 (0)  /*!< \brief float32 (single precision float). */
 #define C_API_DTYPE_FLOAT64 (1)  /*!< \brief float64 (double precision float). */
@@ -40,6 +41,7 @@ typedef void* FastConfigHandle; /*!< \brief Handle of FastConfig. */
 #define C_API_PREDICT_RAW_SCORE  (1)  /*!< \brief Predict raw score. */
 #define C_API_PREDICT_LEAF_INDEX (2)  /*!< \brief Predict leaf index. */
 #define C_API_PREDICT_CONTRIB    (3)  /*!< \brief Predict feature contributions (SHAP values). */
+#define C_API_PREDICT_CONTRIB_INTERACTIONS (4)  /*!< \brief Predict SHAP interaction values. */
 
 #define C_API_MATRIX_TYPE_CSR (0)  /*!< \brief CSR sparse matrix type. */
 #define C_API_MATRIX_TYPE_CSC (1)  /*!< \brief CSC sparse matrix type. */
@@ -715,7 +717,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterGetPredict(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -739,7 +742,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForFile(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param[out] out_len Length of prediction
@@ -752,6 +756,15 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
                                                  int num_iteration,
                                                  int64_t* out_len);
 
+/*!
+ * \brief Free the data kept by the booster to speed up the next predictions:
+ *        the flat copies of the trees for the batch predictions and the precomputed SHAP weights.
+ *        They are computed again by the next predictions that need them.
+ * \param handle Handle of booster
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterFreePredictCache(BoosterHandle handle);
+
 /*!
  * \brief Release FastConfig object.
  *
@@ -780,7 +793,8 @@ LIGHTGBM_C_EXPORT int LGBM_FastConfigFree(FastConfigHandle fastConfig);
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -805,10 +819,13 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSR(BoosterHandle handle,
                                                 double* out_result);
 
 /*!
- * \brief Make sparse prediction for a new dataset in CSR or CSC format. Currently only used for feature contributions.
+ * \brief Make sparse prediction for a new dataset in CSR or CSC format. Currently only used for feature contributions
+ *        and SHAP interaction values.
  * \note
  * The outputs are pre-allocated, as they can vary for each invocation, but the shape should be the same:
- *   - for feature contributions, the shape of sparse matrix will be ``num_class * num_data * (num_feature + 1)``.
+ *   - for feature contributions, the shape of sparse matrix will be ``num_class * num_data * (num_feature + 1)``;
+ *   - for SHAP interaction values, the shape of sparse matrix will be ``num_class * num_data * (num_feature + 1)^2``,
+ *     the interaction of features ``i`` and ``j`` is in column ``i * (num_feature + 1) + j``.
  * The output indptr_type for the sparse matrix will be the same as the given input indptr_type.
  * Call ``LGBM_BoosterFreePredictSparse`` to deallocate resources.
  * \param handle Handle of booster
@@ -820,8 +837,9 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSR(BoosterHandle handle,
  * \param nindptr Number of rows in the matrix + 1
  * \param nelem Number of nonzero elements in the matrix
  * \param num_col_or_row Number of columns for CSR or number of rows for CSC
- * \param predict_type What should be predicted, only feature contributions supported currently
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ * \param predict_type What should be predicted, only feature contributions and SHAP interaction values supported currently
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -883,7 +901,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterFreePredictSparse(void* indptr, int32_t* indic
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -917,7 +936,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSRSingleRow(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
@@ -996,7 +1016,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSRSingleRowFast(FastConfigHandle fa
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1037,7 +1058,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSC(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1075,7 +1097,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMat(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1105,7 +1128,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
@@ -1148,6 +1172,79 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRowFast(FastConfigHandle fa
                                                              int64_t* out_len,
                                                              double* out_result);
 
+/*!
+ * \brief Create a predictor for single rows, from a copy of the current model.
+ * \note
+ * The predictor does not change when the booster is trained further, reloaded or freed,
+ * and it can be used by any number of threads at the same time, without locking.
+ * Release it by passing its handle to ``LGBM_PredictorFree`` when no longer needed.
+ * \param handle Handle of booster
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
+ *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
+ * \param start_iteration Start index of the iteration to predict
+ * \param num_iteration Number of iterations for prediction, <= 0 means no limit
+ * \param data_type Type of the row values, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param num_col Number of columns of the rows
+ * \param parameter Other parameters for prediction, e.g. early stopping for prediction
+ * \param[out] out Handle of the created predictor
+ * \return 0 when it succeeds, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterCreatePredictor(BoosterHandle handle,
+                                                  int predict_type,
+                                                  int start_iteration,
+                                                  int num_iteration,
+                                                  int data_type,
+                                                  int64_t num_col,
+                                                  const char* parameter,
+                                                  PredictorHandle* out);
+
+/*!
+ * \brief Make prediction for a single row with a predictor, thread-safe.
+ * \note
+ * You should pre-allocate memory for ``out_result``, of the same length as for ``LGBM_BoosterPredictForMatSingleRow``.
+ * \param handle Handle of predictor returned by ``LGBM_BoosterCreatePredictor``
+ * \param data Single-row array data, ``num_col`` values
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when it succeeds, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_PredictorPredictForMatSingleRow(PredictorHandle handle,
+                                                           const void* data,
+                                                           int64_t* out_len,
+                                                           double* out_result);
+
+/*!
+ * \brief Make prediction for a single row in CSR format with a predictor, thread-safe.
+ * \note
+ * You should pre-allocate memory for ``out_result``, of the same length as for ``LGBM_BoosterPredictForCSRSingleRow``.
+ * \param handle Handle of predictor returned by ``LGBM_BoosterCreatePredictor``
+ * \param indptr Pointer to row headers, two values
+ * \param indptr_type Type of ``indptr``, can be ``C_API_DTYPE_INT32`` or ``C_API_DTYPE_INT64``
+ * \param indices Pointer to column indices
+ * \param data Pointer to the data space, of the type given to ``LGBM_BoosterCreatePredictor``
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when it succeeds, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_PredictorPredictForCSRSingleRow(PredictorHandle handle,
+                                                           const void* indptr,
+                                                           int indptr_type,
+                                                           const int32_t* indices,
+                                                           const void* data,
+                                                           int64_t* out_len,
+                                                           double* out_result);
+
+/*!
+ * \brief Release a predictor created with ``LGBM_BoosterCreatePredictor``.
+ * \param handle Handle of predictor to be freed
+ * \return 0 when it succeeds, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_PredictorFree(PredictorHandle handle);
+
 /*!
  * \brief Make prediction for a new dataset presented in a form of array of pointers to rows.
  * \note
@@ -1164,7 +1261,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRowFast(FastConfigHandle fa
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_CONTRIB_INTERACTIONS``: SHAP interaction values
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
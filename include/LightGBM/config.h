@@ -201,6 +201,24 @@ struct Config {
   // desc = **Note**: please **don't** change this during training, especially when running multiple jobs simultaneously by external packages, otherwise it may cause undesirable errors
   int num_threads = 0;
 
+  // type = enum
+  // options = none, compact, spread
+  // desc = used only with ``cpu`` device type on Linux
+  // desc = how the OpenMP threads are pinned to NUMA nodes (sockets) during training
+  // descl2 = ``none``, leave thread placement to the OpenMP runtime, e.g. ``OMP_PROC_BIND``
+  // descl2 = ``compact``, fill the CPUs of one node before moving to the next. Neighbouring row blocks of the row-wise histogram construction then share a node
+  // descl2 = ``spread``, assign the threads to the nodes round-robin
+  // desc = each thread is bound to all CPUs of its node, the operating system still balances the threads within a node
+  // desc = the per-thread histogram buffers are allocated on the node of the thread that fills them, which only stays local when threads are pinned
+  // desc = **Note**: this is a process-wide setting, it also affects other OpenMP code running in the same process
+  std::string thread_affinity = "none";
+
+  // desc = used only with ``cpu`` device type
+  // desc = set this to ``true`` to run the short parallel loops of training (data partition, score updates, histogram construction of the feature groups) as tasks of an internal work-stealing scheduler instead of OpenMP parallel regions
+  // desc = this reduces the fork/join overhead per split on small datasets (e.g. less than 100k rows), and lets idle threads take over work from the loaded ones
+  // desc = **Note**: the scheduler threads are shared by the process, loops of boosters that train at the same time with this option run one after another
+  bool use_task_scheduler = false;
+
   // [doc-only]
   // type = enum
   // options = cpu, gpu, cuda
@@ -211,6 +229,18 @@ struct Config {
   // desc = **Note**: refer to `Installation Guide <./Installation-Guide.rst#build-gpu-version>`__ to build LightGBM with GPU support
   std::string device_type = "cpu";
 
+  // [doc-only]
+  // type = enum
+  // options = auto, none, sse4.2, avx2, avx512
+  // desc = instruction set used by the vectorized CPU kernels, e.g. dense histogram construction
+  // descl2 = ``auto``, use the widest instruction set supported by the CPU and the operating system, up to ``avx2``
+  // descl2 = ``none``, always use the scalar kernels
+  // descl2 = ``sse4.2``, ``avx2``, ``avx512``, use at most this instruction set. A level the CPU does not support falls back to the best supported one with a warning
+  // desc = **Note**: ``avx512`` is never chosen by ``auto``, its conflict-resolving gather / scatter kernels are usually slower than ``avx2`` for histogram construction
+  // desc = this is a process-wide setting. It is applied when it is passed to a booster at creation or with ``reset_parameter``, and by the CLI, not by the parameters of datasets or prediction
+  // desc = all levels produce bitwise identical results, this is mainly useful for benchmarking and debugging
+  std::string simd_level = "auto";
+
   // [doc-only]
   // alias = random_seed, random_state
   // default = None
@@ -252,11 +282,43 @@ struct Config {
   // desc = **Note**: this parameter cannot be used at the same time with ``force_col_wise``, choose only one of them
   bool force_row_wise = false;
 
+  // desc = used only with ``cpu`` device type
+  // desc = set this to ``true`` to choose between col-wise and row-wise histogram building for every leaf, instead of once for the whole training
+  // desc = the choice is made by an online cost model, from the measured building times of earlier leaves with a similar number of data
+  // desc = the layout chosen by ``force_col_wise``, ``force_row_wise`` or the initial test is still used to store the histograms, histograms built the other way are copied into it
+  // desc = **Note**: this keeps the data for both ways, so it increases the memory cost for Dataset object like ``force_row_wise=true`` does
+  // desc = **Note**: when ``deterministic=true``, the choice is made by a static cost model from the number of data in the leaf, the used features, the number of threads and the number of non-zero values and bins of both ways, so it is reproducible
+  bool adaptive_col_row_wise = false;
+
+  // check = >=1
+  // desc = used only with ``serial`` tree learner and ``cpu`` device type
+  // desc = number of leaves with the largest split gains that are split at once in leaf-wise growth, ``1`` means one leaf at a time
+  // desc = the histograms of the new leaves are then built as parallel tasks, one leaf per thread, which uses the threads better than building small leaves one after another
+  // desc = larger values may give a different tree, since a leaf is split before the best splits of the leaves split in the same step are known
+  // desc = **Note**: the leaves are only built in parallel with col-wise histograms, float gradients and without multi-value feature groups, otherwise they are built one after another
+  // desc = with ``use_task_scheduler``, the leaves are tasks of the scheduler and the feature groups of a leaf are nested tasks, so the idle threads help with the largest leaves
+  // desc = **Note**: this needs the histograms of all leaves in memory, it is set to ``1`` if ``histogram_pool_size`` is too small, with monotone constraints or with cost-efficient gradient boosting
+  int max_concurrent_leaves = 1;
+
   // alias = hist_pool_size
   // desc = max cache size in MB for historical histogram
   // desc = ``< 0`` means no limit
   double histogram_pool_size = -1.0;
 
+  // type = enum
+  // options = lru, gain
+  // desc = used only if ``histogram_pool_size`` is too small to keep the histograms of all leaves
+  // desc = which cached histogram to drop when the pool is full
+  // descl2 = ``lru``, the histogram of the least recently used leaf
+  // descl2 = ``gain``, the histogram of the leaf with the smallest best split gain, which is the least likely to be split. Its histogram would only be needed as the parent of a later split
+  std::string histogram_pool_eviction = "lru";
+
+  // desc = used only if ``histogram_pool_size`` is too small to keep the histograms of all leaves
+  // desc = set this to ``true`` to keep dropped histograms in a 4 times smaller 16-bit quantized form, so that splitting their leaves can still use the histogram subtraction instead of building both children from the data
+  // desc = half of ``histogram_pool_size`` is then used for the full precision histograms and the rest for the quantized ones
+  // desc = **Note**: the quantized histograms are lossy, so the model can differ slightly from the one trained with a large enough pool
+  bool histogram_pool_spill = false;
+
   // desc = limit the max depth for tree model. This is used to deal with over-fitting when ``#data`` is small. Tree still grows leaf-wise
   // desc = ``<= 0`` means no limit
   int max_depth = -1;
@@ -536,6 +598,23 @@ struct Config {
   // desc = any two features can only appear in the same branch only if there exists a constraint containing both features
   std::string interaction_constraints = "";
 
+  // desc = set this to ``true`` to quantize the gradients and hessians of each iteration into a few integer levels, and build histograms with integer arithmetic
+  // desc = this halves the memory traffic of histogram construction, usually with very similar accuracy
+  // desc = split gains and leaf outputs are computed from the rescaled quantized values
+  // desc = **Note**: only works with ``cpu`` device type
+  bool use_quantized_grad = false;
+
+  // check = >= 2
+  // check = <= 254
+  // desc = number of levels used to quantize gradients and hessians, gradients use ``[-num_grad_quant_bins / 2, num_grad_quant_bins / 2]`` and hessians use ``[0, num_grad_quant_bins]``
+  // desc = used only if ``use_quantized_grad=true``
+  // desc = **Note**: the number of rows times ``num_grad_quant_bins`` must be less than ``2^32``, otherwise quantization is disabled
+  int num_grad_quant_bins = 4;
+
+  // desc = whether to use stochastic rounding when quantizing gradients, which keeps the quantized values unbiased
+  // desc = used only if ``use_quantized_grad=true``
+  bool stochastic_rounding = true;
+
   // alias = verbose
   // desc = controls the level of LightGBM's verbosity
   // desc = ``< 0``: Fatal, ``= 0``: Error (Warning), ``= 1``: Info, ``> 1``: Debug
@@ -645,6 +724,7 @@ struct Config {
   // alias = two_round_loading, use_two_round_loading
   // desc = set this to ``true`` if data file is too big to fit in memory
   // desc = by default, LightGBM will map data file to memory and load features from memory. This will provide faster data loading speed, but may cause run out of memory error when the data file is very big
+  // desc = with ``true``, the data file is read twice, first to count the rows and sample them to construct the bins, then to bin the rows chunk by chunk, so that the memory used is close to the size of the binned dataset
   // desc = **Note**: works only in case of loading data directly from text file
   bool two_round = false;
 
@@ -716,6 +796,28 @@ struct Config {
   // desc = **Note**: can be used only in CLI version; for language-specific packages you can use the correspondent function
   bool save_binary = false;
 
+  // [no-save]
+  // alias = mmap_binary_file
+  // desc = if ``true``, LightGBM will map binary dataset files into memory and use their bins, labels and weights in place instead of copying them. Processes that load the same file share its pages
+  // desc = **Note**: the binary file must not be modified while a dataset loaded from it is in use
+  // desc = **Note**: the bins are still copied when the data is partitioned on loading in distributed learning (``pre_partition=false``)
+  bool mmap_binary = false;
+
+  // [no-save]
+  // check = >=1
+  // check = <=2
+  // desc = version of the format of the binary dataset files written by ``save_binary``. Both versions are detected when loading
+  // descl2 = ``1``, one sequential stream, which older versions of LightGBM can read
+  // descl2 = ``2``, the metadata, each feature group and the raw data are separate chunks with XXH64 checksums, listed in an index after the header. They are written and read in parallel, and can be compressed with ``binary_compression``. Older versions of LightGBM cannot read these files
+  int binary_version = 1;
+
+  // [no-save]
+  // type = enum
+  // options = none, lz4, zstd
+  // desc = compression of the chunks of binary dataset files of version 2. A chunk that does not get smaller is stored as is
+  // desc = **Note**: ``lz4`` and ``zstd`` need LightGBM to be compiled with ``USE_LZ4`` and ``USE_ZSTD``. Compressed chunks are decompressed when loading, they are not used in place with ``mmap_binary``
+  std::string binary_compression = "none";
+
   // desc = use precise floating point number parsing for text parser (e.g. CSV, TSV, LibSVM input)
   // desc = **Note**: setting this to ``true`` may lead to much slower text parsing
   bool precise_float_parser = false;
@@ -754,11 +856,35 @@ struct Config {
   // desc = used only in ``prediction`` task
   // desc = set this to ``true`` to estimate `SHAP values <https://arxiv.org/abs/1706.06060>`__, which represent how each feature contributes to each prediction
   // desc = produces ``#features + 1`` values where the last value is the expected value of the model output over the training data
-  // desc = **Note**: if you want to get more explanation for your model's predictions using SHAP values like SHAP interaction values, you can install `shap package <https://github.com/slundberg/shap>`__
+  // desc = **Note**: the SHAP interaction values are given by ``predict_contrib_interactions``, for more explanation of your model's predictions using SHAP values, you can install `shap package <https://github.com/slundberg/shap>`__
   // desc = **Note**: unlike the shap package, with ``predict_contrib`` we return a matrix with an extra column, where the last column is the expected value
   // desc = **Note**: this feature is not implemented for linear trees
   bool predict_contrib = false;
 
+  // [no-save]
+  // alias = contrib_interactions
+  // desc = used only in ``prediction`` task
+  // desc = set this to ``true`` to estimate SHAP interaction values, which represent how each pair of features contributes to each prediction
+  // desc = produces a ``(#features + 1) x (#features + 1)`` matrix of values per class: element ``(i, j)`` is the interaction value of features ``i`` and ``j``, split evenly with element ``(j, i)``, the diagonal holds the main effect of each feature, and the last element is the expected value of the model output over the training data
+  // desc = each row of the matrix sums to the SHAP value of ``predict_contrib`` for the feature
+  // desc = **Note**: this feature is not implemented for linear trees
+  bool predict_contrib_interactions = false;
+
+  // [no-save]
+  // check = >=0
+  // check = <=16
+  // desc = used only in ``prediction`` task with ``predict_contrib`` or ``predict_contrib_interactions``
+  // desc = the weights of the SHAP values are precomputed for the leaves with at most this number of distinct features on their path, so that the SHAP values of such a leaf are computed in ``O(D)`` time instead of ``O(D^2)``, where ``D`` is the number of these features
+  // desc = the weights of a leaf take ``D * 2^(D - 1)`` doubles, set this to ``0`` to precompute no weight
+  // desc = the weights are computed by the first prediction of the SHAP values and kept by the model, until the trees change or ``LGBM_BoosterFreePredictCache`` is called, so the value of the first prediction is used
+  int pred_contrib_table_max_features = 8;
+
+  // [no-save]
+  // check = >=0.0
+  // desc = used only in ``prediction`` task with ``predict_contrib`` or ``predict_contrib_interactions``
+  // desc = most memory (in MB) of the weights of ``pred_contrib_table_max_features`` for the whole model, each tree gets an equal share and its leaves past the share are computed without weights
+  double pred_contrib_table_memory_mb = 64.0;
+
   // [no-save]
   // desc = used only in ``prediction`` task
   // desc = control whether or not LightGBM raises an error when you try to predict on data with a different number of features than the training data
@@ -784,6 +910,13 @@ struct Config {
   // desc = the threshold of margin in early-stopping prediction
   double pred_early_stop_margin = 10.0;
 
+  // [no-save]
+  // desc = used only in ``prediction`` task
+  // desc = set this to ``true`` to predict dense matrices (``LGBM_BoosterPredictForMat``, e.g. numpy arrays in Python) by blocks of trees that fit in the L2 cache, each block of trees goes through a block of rows before the next one is loaded
+  // desc = this speeds up the prediction of models that do not fit in the cache, e.g. with thousands of trees
+  // desc = the predictions are the same as without it
+  bool pred_tree_blocking = false;
+
   // [no-save]
   // alias = predict_result, prediction_result, predict_name, prediction_name, pred_name, name_pred
   // desc = used only in ``prediction`` task
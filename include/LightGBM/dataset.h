@@ -59,8 +59,10 @@ class Metadata {
   /*!
   * \brief Initial with binary memory
   * \param memory Pointer to memory
+  * \param in_place True to use the labels and weights in memory without copying them, memory must then
+  *        outlive the metadata
   */
-  void LoadFromMemory(const void* memory);
+  void LoadFromMemory(const void* memory, bool in_place = false);
   /*! \brief Destructor */
   ~Metadata();
 
@@ -226,9 +228,9 @@ class Metadata {
   /*! \brief Number of weights, used to check correct weight file */
   data_size_t num_weights_;
   /*! \brief Label data */
-  std::vector<label_t> label_;
+  Common::ViewableVector<label_t> label_;
   /*! \brief Weights data */
-  std::vector<label_t> weights_;
+  Common::ViewableVector<label_t> weights_;
   /*! \brief Query boundaries */
   std::vector<data_size_t> query_boundaries_;
   /*! \brief Query weights */
@@ -266,6 +268,27 @@ class Parser {
   virtual void ParseOneLine(const char* str,
                             std::vector<std::pair<int, double>>* out_features, double* out_label) const = 0;
 
+  /*! \brief Whether ParseBlock is implemented, for the formats with one value per column */
+  virtual bool SupportsParseBlock() const { return false; }
+
+  /*!
+  * \brief Parse a block of lines into columns, as ParseOneLine without the (column_idx, value) pairs
+  * \param lines Lines of the block
+  * \param num_lines Number of lines
+  * \param num_col Number of columns of out_values, the columns after are skipped
+  * \param out_values Column j of line i is at out_values[j * num_lines + i], 0 for the columns missing in the line
+  * \param out_labels Labels of the lines
+  */
+  virtual void ParseBlock(const std::string* lines, data_size_t num_lines, int num_col,
+                          double* out_values, double* out_labels) const {
+    (void) lines;       // UNUSED VARIABLE
+    (void) num_lines;   // UNUSED VARIABLE
+    (void) num_col;     // UNUSED VARIABLE
+    (void) out_values;  // UNUSED VARIABLE
+    (void) out_labels;  // UNUSED VARIABLE
+    Log::Fatal("This format cannot be parsed in columns");
+  }
+
   virtual int NumFeatures() const = 0;
 
   /*!
@@ -426,6 +449,12 @@ class Dataset {
 
   LIGHTGBM_EXPORT void FinishLoad();
 
+  /*!
+  * \brief Encode the data pushed so far, when the rows pushed after are all after them, so that
+  *        the memory used to push the rows in order does not grow with the pushed rows
+  */
+  void FlushPushedData();
+
   LIGHTGBM_EXPORT bool SetFloatField(const char* field_name, const float* field_data, data_size_t num_element);
 
   LIGHTGBM_EXPORT bool SetDoubleField(const char* field_name, const double* field_data, data_size_t num_element);
@@ -440,6 +469,8 @@ class Dataset {
 
   /*!
   * \brief Save current dataset into binary file, will save to "filename.bin"
+  *        The format version and compression are the binary_version and binary_compression of the config
+  *        the dataset was constructed or loaded with
   */
   LIGHTGBM_EXPORT void SaveBinaryFile(const char* bin_filename);
 
@@ -503,6 +534,42 @@ class Dataset {
     }
   }
 
+  template <bool USE_INDICES>
+  void ConstructIntHistogramsInner(const std::vector<int8_t>& is_feature_used,
+                                   const data_size_t* data_indices,
+                                   data_size_t num_data,
+                                   const int_score_t* int_gradients,
+                                   int_score_t* ordered_int_gradients,
+                                   TrainingShareStates* share_state,
+                                   double grad_scale, double hess_scale,
+                                   hist_t* hist_data) const;
+
+  /*!
+  * \brief Construct histograms from quantized gradients. The histograms are
+  *        accumulated in integers and rescaled by grad_scale / hess_scale into
+  *        hist_data, which has the same layout as for ConstructHistograms
+  */
+  inline void ConstructIntHistograms(
+      const std::vector<int8_t>& is_feature_used,
+      const data_size_t* data_indices, data_size_t num_data,
+      const int_score_t* int_gradients, int_score_t* ordered_int_gradients,
+      TrainingShareStates* share_state, double grad_scale, double hess_scale,
+      hist_t* hist_data) const {
+    if (num_data <= 0) {
+      return;
+    }
+    bool use_indices = data_indices != nullptr && (num_data < num_data_);
+    if (use_indices) {
+      ConstructIntHistogramsInner<true>(
+          is_feature_used, data_indices, num_data, int_gradients,
+          ordered_int_gradients, share_state, grad_scale, hess_scale, hist_data);
+    } else {
+      ConstructIntHistogramsInner<false>(
+          is_feature_used, data_indices, num_data, int_gradients,
+          ordered_int_gradients, share_state, grad_scale, hess_scale, hist_data);
+    }
+  }
+
   void FixHistogram(int feature_idx, double sum_gradient, double sum_hessian, hist_t* data) const;
 
   inline data_size_t Split(int feature, const uint32_t* threshold,
@@ -682,7 +749,24 @@ class Dataset {
   }
 
  private:
+  /*!
+  * \brief Write the size of the header and the header of binary files, the same in all versions
+  * \return Size of the header
+  */
+  size_t SaveBinaryHeader(const VirtualFileWriter* writer);
+
+  /*! \brief Write the raw data, row by row */
+  void SaveBinaryRawData(const VirtualFileWriter* writer) const;
+
+  /*!
+  * \brief Write the chunk index and the chunks of binary files v2, serialized and compressed in parallel
+  * \param offset Bytes written before, i.e. the token and the header
+  */
+  void SaveBinaryChunks(const VirtualFileWriter* writer, size_t offset) const;
+
   std::string data_filename_;
+  /*! \brief Binary file whose bins, labels and weights are used in place, declared first to outlive them */
+  std::unique_ptr<MappedFile> mapped_file_;
   /*! \brief Store used features */
   std::vector<std::unique_ptr<FeatureGroup>> feature_groups_;
   /*! \brief Mapper from real feature index to used index*/
@@ -701,6 +785,12 @@ class Dataset {
   std::vector<std::string> feature_names_;
   /*! \brief store feature names */
   static const char* binary_file_token;
+  /*! \brief token of the binary files v2, of the same length */
+  static const char* binary_file_token_v2;
+  /*! \brief format version of the binary files saved by SaveBinaryFile */
+  int binary_version_;
+  /*! \brief compression of the chunks of the binary files v2 saved by SaveBinaryFile */
+  std::string binary_compression_;
   int num_groups_;
   std::vector<int> real_feature_idx_;
   std::vector<int> feature2group_;
@@ -60,6 +60,13 @@ class DatasetLoader {
   /*! \brief Extract local features from file */
   void ExtractFeaturesFromFile(const char* filename, const Parser* parser, const std::vector<data_size_t>& used_data_indices, Dataset* dataset);
 
+  /*!
+  * \brief Extract local features of lines parsed in columns by Parser::ParseBlock, without initial model
+  * \param lines Lines of the rows [start_idx, start_idx + num_lines)
+  */
+  void ExtractFeaturesFromBlocks(const std::string* lines, data_size_t num_lines, data_size_t start_idx,
+                                 const Parser* parser, Dataset* dataset);
+
   /*! \brief Check can load from binary file */
   std::string CheckCanLoadFromBin(const char* filename);
 
@@ -114,10 +114,12 @@ class FeatureGroup {
    * \param memory Pointer of memory
    * \param num_all_data Number of global data
    * \param local_used_indices Local used indices, empty means using all data
+   * \param in_place True to use the bins in memory without copying them, memory must then outlive
+   *        the group. Only with all data
    */
   FeatureGroup(const void* memory, data_size_t num_all_data,
                const std::vector<data_size_t>& local_used_indices,
-               int group_id) {
+               int group_id, bool in_place = false) {
     const char* memory_ptr = reinterpret_cast<const char*>(memory);
     // get is_sparse
     is_multi_val_ = *(reinterpret_cast<const bool*>(memory_ptr));
@@ -162,27 +164,38 @@ class FeatureGroup {
     if (!local_used_indices.empty()) {
       num_data = static_cast<data_size_t>(local_used_indices.size());
     }
+    CHECK(!in_place || local_used_indices.empty());
+    // bins used in place are created without data, so that nothing is allocated for them
+    const data_size_t num_allocated_data = in_place ? 0 : num_data;
     if (is_multi_val_) {
       for (int i = 0; i < num_feature_; ++i) {
         int addi = bin_mappers_[i]->GetMostFreqBin() == 0 ? 0 : 1;
         if (bin_mappers_[i]->sparse_rate() >= kSparseThreshold) {
           multi_bin_data_.emplace_back(Bin::CreateSparseBin(
-              num_data, bin_mappers_[i]->num_bin() + addi));
+              num_allocated_data, bin_mappers_[i]->num_bin() + addi));
         } else {
           multi_bin_data_.emplace_back(
-              Bin::CreateDenseBin(num_data, bin_mappers_[i]->num_bin() + addi));
+              Bin::CreateDenseBin(num_allocated_data, bin_mappers_[i]->num_bin() + addi));
+        }
+        if (in_place) {
+          multi_bin_data_.back()->LoadFromMappedMemory(memory_ptr, num_data);
+        } else {
+          multi_bin_data_.back()->LoadFromMemory(memory_ptr, local_used_indices);
         }
-        multi_bin_data_.back()->LoadFromMemory(memory_ptr, local_used_indices);
         memory_ptr += multi_bin_data_.back()->SizesInByte();
       }
     } else {
       if (is_sparse_) {
-        bin_data_.reset(Bin::CreateSparseBin(num_data, num_total_bin_));
+        bin_data_.reset(Bin::CreateSparseBin(num_allocated_data, num_total_bin_));
       } else {
-        bin_data_.reset(Bin::CreateDenseBin(num_data, num_total_bin_));
+        bin_data_.reset(Bin::CreateDenseBin(num_allocated_data, num_total_bin_));
       }
       // get bin data
-      bin_data_->LoadFromMemory(memory_ptr, local_used_indices);
+      if (in_place) {
+        bin_data_->LoadFromMappedMemory(memory_ptr, num_data);
+      } else {
+        bin_data_->LoadFromMemory(memory_ptr, local_used_indices);
+      }
     }
   }
 
@@ -320,6 +333,17 @@ class FeatureGroup {
     }
   }
 
+  /*! \brief Encode the data pushed so far, see Bin::FlushPushedData */
+  inline void FlushPushedData() {
+    if (is_multi_val_) {
+      for (int i = 0; i < num_feature_; ++i) {
+        multi_bin_data_[i]->FlushPushedData();
+      }
+    } else {
+      bin_data_->FlushPushedData();
+    }
+  }
+
   inline BinIterator* FeatureGroupIterator() {
     if (is_multi_val_) {
       return nullptr;
@@ -0,0 +1,227 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_FLAT_FOREST_H_
+#define LIGHTGBM_FLAT_FOREST_H_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/objective_function.h>
+#include <LightGBM/prediction_early_stop.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/common.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Read-only copy of the trees of a model, laid out for predicting blocks of dense rows.
+*        Trees with at most 64 leaves and only numerical splits are evaluated QuickScorer-style:
+*        the conditions of all these trees are grouped by feature and sorted by threshold, and
+*        a row clears, in a bitvector of leaves per tree, the leaves that it cannot reach. With
+*        AVX2 the conditions of a feature are compared with four rows at once.
+*        The other trees are packed in one contiguous node array, in depth-first order. When a block
+*        has enough of them, the rows are first mapped to bins, one per interval between the sorted
+*        distinct thresholds of a feature in these trees, and the numerical splits compare the bins
+*        as in the trainer, instead of the values with their missing-value checks at every node.
+*        The trees are summed in the order of the model, so that the scores are bit-identical
+*        to the ones of Tree::Predict.
+*        Large models can be split in blocks of consecutive trees that fit in the cache: a block of
+*        rows goes through all the trees of a block before the next block of trees is loaded.
+*        Float rows are compared in float with thresholds rounded down to a float, which takes the
+*        same decisions as comparing the values converted to double with the double thresholds.
+*        With early stopping, the blocks of trees end at the iterations where the scores are checked,
+*        and the rows that stop are not predicted by the next blocks.
+*/
+class FlatForest {
+ public:
+  /*!
+  * \brief Constructor
+  * \param models Trees of the model
+  * \param start_iteration First iteration to predict
+  * \param num_iteration Number of iterations to predict
+  * \param num_tree_per_iteration Number of trees per iteration
+  * \param num_feature Number of features of the rows, i.e. max feature index + 1
+  * \param average_output Whether the scores are averaged over the iterations, as for random forest
+  * \param objective Objective used to convert the raw scores, can be nullptr
+  * \param early_stop Early stopping of the rows, as in GBDT::PredictRaw, nullptr to predict all the trees
+  * \param cache_size Bytes of cache for the trees and rows of a block, 0 to keep all the trees in one block
+  */
+  FlatForest(const std::vector<std::unique_ptr<Tree>>& models, int start_iteration,
+             int num_iteration, int num_tree_per_iteration, int num_feature,
+             bool average_output, const ObjectiveFunction* objective,
+             const PredictionEarlyStopInstance* early_stop, size_t cache_size);
+
+  /*! \brief Size of the L2 cache of a core, or a common size when it is unknown */
+  static size_t L2CacheSize();
+
+  /*! \brief Number of features used by the trees */
+  int num_feature() const { return num_feature_; }
+
+  /*! \brief Number of scores per row in the output */
+  int num_tree_per_iteration() const { return num_tree_per_iteration_; }
+
+  /*! \brief Number of rows to predict at once, so that the rows of a block stay in cache as well */
+  data_size_t row_block_size() const { return row_block_size_; }
+
+  /*!
+  * \brief Predict a block of rows, read in place from the matrix of the caller
+  * \param data Feature j of row i is data[i * row_stride + j * col_stride]
+  * \param num_col Number of columns of the matrix, the other features are zero
+  * \param row_stride Distance between two rows
+  * \param col_stride Distance between two columns
+  * \param num_rows Number of rows
+  * \param is_raw_score True to skip the averaging and the conversion by the objective
+  * \param output num_tree_per_iteration() scores per row
+  */
+  template <typename T>
+  void Predict(const T* data, int num_col, size_t row_stride, size_t col_stride,
+               data_size_t num_rows, bool is_raw_score, double* output) const;
+
+ private:
+  /*! \brief Split of the node array, 32 bytes so that two nodes share a cache line */
+  struct Node {
+    double threshold;
+    int32_t feature;
+    /*! \brief >= 0 for a node, ~index in leaf_values_ for a leaf */
+    int32_t left;
+    int32_t right;
+    union {
+      /*! \brief categorical splits only, range of the bitset in cat_bitsets_ */
+      int32_t cat_begin;
+      /*! \brief numerical splits only, threshold for float rows */
+      float threshold_float;
+    };
+    union {
+      int32_t cat_size;
+      /*! \brief numerical splits only, index of the feature in the bin columns of the tree block, or -1 */
+      int32_t bin_column;
+    };
+    int8_t decision_type;
+    /*! \brief split with a bin column only, the rows go left up to this bin */
+    uint16_t threshold_bin;
+  };
+
+  /*! \brief Numerical feature of the node trees of a block, whose values are mapped to bins */
+  struct BinColumn {
+    int32_t feature;
+    /*! \brief sorted distinct thresholds are [threshold_begin, threshold_end) in bin_thresholds_ */
+    int32_t threshold_begin;
+    int32_t threshold_end;
+    /*! \brief bin of the zeros only, the thresholds include the bounds of kZeroThreshold */
+    uint16_t zero_bin;
+    /*! \brief bin of NaN, after the bins of the values */
+    uint16_t nan_bin;
+  };
+
+  /*! \brief Split of a QuickScorer tree */
+  struct Condition {
+    double threshold;
+    /*! \brief leaves of the left subtree cleared, for rows that go right */
+    uint64_t mask;
+    int32_t tree;
+    int8_t decision_type;
+  };
+
+  /*! \brief Condition compared with float rows, 16 bytes, the decision type is in the Condition of the same index */
+  struct FloatCondition {
+    uint64_t mask;
+    float threshold;
+    int32_t tree;
+  };
+
+  /*! \brief Consecutive trees predicted together */
+  struct TreeBlock {
+    int tree_begin;
+    int tree_end;
+    int num_quick_scorer_trees;
+    /*! \brief features with QuickScorer conditions in the block, range of condition_features_ */
+    int feature_begin;
+    int feature_end;
+    /*! \brief features mapped to bins for the node trees of the block, range of bin_columns_, can be empty */
+    int bin_column_begin;
+    int bin_column_end;
+  };
+
+  /*! \brief Where the tree is stored */
+  struct TreeInfo {
+    /*! \brief >= 0 for QuickScorer trees, index in the bitvectors of a row for the tree block */
+    int32_t quick_scorer_index;
+    /*! \brief node array root, ~index in leaf_values_ for single leaf trees */
+    int32_t root;
+    /*! \brief QuickScorer trees only, leaves in left-to-right order start here in leaf_values_ */
+    int32_t leaf_begin;
+  };
+
+  void AddQuickScorerTree(const Tree* tree, int quick_scorer_index,
+                          std::vector<std::vector<Condition>>* feature_conditions, TreeInfo* info);
+
+  void AddNodeTree(const Tree* tree, TreeInfo* info);
+
+  /*! \brief Move the conditions of the trees of the block to conditions_, sorted by feature and threshold */
+  void FinishTreeBlock(std::vector<std::vector<Condition>>* feature_conditions, TreeBlock* block);
+
+  /*! \brief Build the bin columns of the block and the bin thresholds of its nodes, if it has enough node trees */
+  void AddBinColumns(TreeBlock* block);
+
+  /*! \brief Bin of a value read with ReadValue, float values are converted to double exactly */
+  inline uint16_t ValueToBin(const BinColumn& column, double fval) const;
+
+  /*!
+  * \brief Clear the unreachable leaves of every QuickScorer tree of a block, for a group of kLanes rows
+  * \param block Tree block
+  * \param conditions conditions_ for double rows, float_conditions_ for float rows
+  * \param fvals Values of condition_features_[block.feature_begin + i] for the rows of the group, at i * kLanes + lane
+  * \param num_lanes Number of rows in the group
+  * \param masks Bitvector of tree t for the row of lane is at t * kLanes + lane
+  */
+  template <typename T, typename CONDITION>
+  void ComputeLeafMasks(const TreeBlock& block, const CONDITION* conditions, const T* fvals, int num_lanes,
+                        uint64_t* masks) const;
+
+  const Condition* ConditionsFor(const double*) const { return conditions_.data(); }
+  const FloatCondition* ConditionsFor(const float*) const { return float_conditions_.data(); }
+
+  /*!
+  * \brief Output of a node tree for a row
+  * \param bins Bins of the row for the bin columns of the tree block, unused if the block has none
+  * \param bin_columns Bin columns of the tree block
+  */
+  template <typename T>
+  inline double NodeTreeOutput(const T* row, int num_col, size_t col_stride, const uint16_t* bins,
+                               const BinColumn* bin_columns, int32_t node) const;
+
+  /*! \brief Rows whose bitvectors are computed together, one per lane of an AVX2 register */
+  static const int kLanes = 4;
+
+  int num_feature_;
+  int num_tree_per_iteration_;
+  int num_iteration_;
+  bool average_output_;
+  const ObjectiveFunction* objective_;
+  /*! \brief iterations between two checks of early stopping, 0 without early stopping */
+  int early_stop_period_;
+  PredictionEarlyStopInstance::FunctionType early_stop_callback_;
+  std::vector<TreeInfo> trees_;
+  std::vector<Node, Common::AlignmentAllocator<Node, kCacheLineSize>> nodes_;
+  std::vector<uint32_t> cat_bitsets_;
+  std::vector<double> leaf_values_;
+  std::vector<TreeBlock> tree_blocks_;
+  data_size_t row_block_size_;
+  /*! \brief conditions of the features with QuickScorer splits, sorted by threshold */
+  std::vector<Condition> conditions_;
+  /*! \brief same conditions, with the thresholds for float rows */
+  std::vector<FloatCondition> float_conditions_;
+  std::vector<int> condition_features_;
+  /*! \brief conditions of condition_features_[i] are [condition_begin_[i], condition_begin_[i + 1]) */
+  std::vector<int> condition_begin_;
+  std::vector<BinColumn> bin_columns_;
+  std::vector<double> bin_thresholds_;
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_FLAT_FOREST_H_
@@ -77,6 +77,8 @@ typedef void(*AllgatherFunction)(char* input, comm_size_t input_size, const comm
 
 const int kAlignedSize = 32;
 
+const int kCacheLineSize = 64;
+
 #define SIZE_ALIGNED(t) ((t) + kAlignedSize - 1) / kAlignedSize * kAlignedSize
 
 // Refer to https://docs.microsoft.com/en-us/cpp/error-messages/compiler-warnings/compiler-warning-level-4-c4127?view=vs-2019
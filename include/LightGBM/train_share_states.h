@@ -8,6 +8,7 @@
 #include <LightGBM/bin.h>
 #include <LightGBM/feature_group.h>
 #include <LightGBM/meta.h>
+#include <LightGBM/utils/numa.h>
 #include <LightGBM/utils/threading.h>
 
 #include <algorithm>
@@ -16,6 +17,13 @@
 
 namespace LightGBM {
 
+/*!
+* \brief Per-block histogram buffers of the row-wise histogram construction. Resizing leaves
+*        them uninitialized, each block is first written by the thread that builds it
+*/
+typedef std::vector<hist_t, Common::FirstTouchAllocator<hist_t, kAlignedSize>> HistBuffer;
+typedef std::vector<int_hist_t, Common::FirstTouchAllocator<int_hist_t, kAlignedSize>> IntHistBuffer;
+
 class MultiValBinWrapper {
  public:
   MultiValBinWrapper(MultiValBin* bin, data_size_t num_data,
@@ -34,11 +42,11 @@ class MultiValBinWrapper {
     const data_size_t* bagging_use_indices,
     data_size_t bagging_indices_cnt);
 
-  void HistMove(const std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>& hist_buf);
+  void HistMove(const HistBuffer& hist_buf);
 
-  void HistMerge(std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf);
+  void HistMerge(HistBuffer* hist_buf);
 
-  void ResizeHistBuf(std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf,
+  void ResizeHistBuf(HistBuffer* hist_buf,
     MultiValBin* sub_multi_val_bin,
     hist_t* origin_hist_data);
 
@@ -47,7 +55,7 @@ class MultiValBinWrapper {
       data_size_t num_data,
       const score_t* gradients,
       const score_t* hessians,
-      std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf,
+      HistBuffer* hist_buf,
       hist_t* origin_hist_data) {
     const auto cur_multi_val_bin = (is_use_subcol_ || is_use_subrow_)
           ? multi_val_bin_subset_.get()
@@ -86,7 +94,7 @@ class MultiValBinWrapper {
   void ConstructHistogramsForBlock(const MultiValBin* sub_multi_val_bin,
     data_size_t start, data_size_t end, const data_size_t* data_indices,
     const score_t* gradients, const score_t* hessians, int block_id,
-    std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf) {
+    HistBuffer* hist_buf) {
     hist_t* data_ptr = origin_hist_data_;
     if (block_id == 0) {
       if (is_use_subcol_) {
@@ -111,6 +119,81 @@ class MultiValBinWrapper {
     }
   }
 
+  template <bool USE_INDICES, bool ORDERED>
+  void ConstructIntHistograms(const data_size_t* data_indices,
+      data_size_t num_data,
+      const int_score_t* int_gradients,
+      IntHistBuffer* int_hist_buf,
+      int_hist_t* origin_int_hist_data) {
+    const auto cur_multi_val_bin = (is_use_subcol_ || is_use_subrow_)
+          ? multi_val_bin_subset_.get()
+          : multi_val_bin_.get();
+    if (cur_multi_val_bin != nullptr) {
+      global_timer.Start("Dataset::sparse_bin_histogram");
+      n_data_block_ = 1;
+      data_block_size_ = num_data;
+      Threading::BlockInfo<data_size_t>(num_threads_, num_data, min_block_size_,
+                                        &n_data_block_, &data_block_size_);
+      ResizeIntHistBuf(int_hist_buf, cur_multi_val_bin, origin_int_hist_data);
+      OMP_INIT_EX();
+      #pragma omp parallel for schedule(static) num_threads(num_threads_)
+      for (int block_id = 0; block_id < n_data_block_; ++block_id) {
+        OMP_LOOP_EX_BEGIN();
+        data_size_t start = block_id * data_block_size_;
+        data_size_t end = std::min<data_size_t>(start + data_block_size_, num_data);
+        ConstructIntHistogramsForBlock<USE_INDICES, ORDERED>(
+          cur_multi_val_bin, start, end, data_indices, int_gradients,
+          block_id, int_hist_buf);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
+      global_timer.Stop("Dataset::sparse_bin_histogram");
+
+      global_timer.Start("Dataset::sparse_bin_histogram_merge");
+      IntHistMerge(int_hist_buf);
+      global_timer.Stop("Dataset::sparse_bin_histogram_merge");
+      global_timer.Start("Dataset::sparse_bin_histogram_move");
+      IntHistMove(*int_hist_buf);
+      global_timer.Stop("Dataset::sparse_bin_histogram_move");
+    }
+  }
+
+  template <bool USE_INDICES, bool ORDERED>
+  void ConstructIntHistogramsForBlock(const MultiValBin* sub_multi_val_bin,
+    data_size_t start, data_size_t end, const data_size_t* data_indices,
+    const int_score_t* int_gradients, int block_id,
+    IntHistBuffer* int_hist_buf) {
+    int_hist_t* data_ptr = origin_int_hist_data_;
+    if (block_id == 0) {
+      if (is_use_subcol_) {
+        data_ptr = int_hist_buf->data() + int_hist_buf->size() - static_cast<size_t>(num_bin_aligned_);
+      }
+    } else {
+      data_ptr = int_hist_buf->data() +
+        static_cast<size_t>(num_bin_aligned_) * (block_id - 1);
+    }
+    std::memset(reinterpret_cast<void*>(data_ptr), 0, num_bin_ * sizeof(int_hist_t));
+    if (USE_INDICES) {
+      if (ORDERED) {
+        sub_multi_val_bin->ConstructIntHistogramOrdered(data_indices, start, end,
+                                                        int_gradients, data_ptr);
+      } else {
+        sub_multi_val_bin->ConstructIntHistogram(data_indices, start, end,
+                                                 int_gradients, data_ptr);
+      }
+    } else {
+      sub_multi_val_bin->ConstructIntHistogram(start, end, int_gradients, data_ptr);
+    }
+  }
+
+  void IntHistMove(const IntHistBuffer& int_hist_buf);
+
+  void IntHistMerge(IntHistBuffer* int_hist_buf);
+
+  void ResizeIntHistBuf(IntHistBuffer* int_hist_buf,
+    MultiValBin* sub_multi_val_bin,
+    int_hist_t* origin_int_hist_data);
+
   void CopyMultiValBinSubset(const std::vector<int>& group_feature_start,
     const std::vector<std::unique_ptr<FeatureGroup>>& feature_groups,
     const std::vector<int8_t>& is_feature_used,
@@ -125,10 +208,20 @@ class MultiValBinWrapper {
     is_subrow_copied_ = is_subrow_copied;
   }
 
+  /*! \brief Merge the row block histograms pairwise or linearly, whatever the number of NUMA nodes */
+  void SetUseTreeMerge(bool use_tree_merge) {
+    use_tree_merge_ = use_tree_merge;
+  }
+
  private:
+  template <typename HIST_T, int ENTRIES_PER_BIN>
+  void MergeBlocks(HIST_T* buf, HIST_T* dst);
+
   bool is_use_subcol_ = false;
   bool is_use_subrow_ = false;
   bool is_subrow_copied_ = false;
+  /*! \brief Merge the row block histograms pairwise, used on hosts with several NUMA nodes */
+  bool use_tree_merge_ = false;
   std::unique_ptr<MultiValBin> multi_val_bin_;
   std::unique_ptr<MultiValBin> multi_val_bin_subset_;
   std::vector<uint32_t> hist_move_src_;
@@ -145,6 +238,7 @@ class MultiValBinWrapper {
   int num_data_;
 
   hist_t* origin_hist_data_;
+  int_hist_t* origin_int_hist_data_;
 
   const size_t kHistBufferEntrySize = 2 * sizeof(hist_t);
 };
@@ -153,6 +247,8 @@ struct TrainingShareStates {
   int num_threads = 0;
   bool is_col_wise = true;
   bool is_constant_hessian = true;
+  /*! \brief Whether the loops over the feature groups are tasks of the TaskScheduler */
+  bool use_task_scheduler = false;
   const data_size_t* bagging_use_indices;
   data_size_t bagging_indices_cnt;
 
@@ -199,6 +295,78 @@ struct TrainingShareStates {
     }
   }
 
+  template <bool USE_INDICES, bool ORDERED>
+  void ConstructIntHistograms(const data_size_t* data_indices,
+                              data_size_t num_data,
+                              const int_score_t* int_gradients,
+                              int_hist_t* int_hist_data) {
+    if (multi_val_bin_wrapper_ != nullptr) {
+      multi_val_bin_wrapper_->ConstructIntHistograms<USE_INDICES, ORDERED>(
+        data_indices, num_data, int_gradients, &int_hist_buf_, int_hist_data);
+    }
+  }
+
+  /*!
+  * \brief Scratch histogram of one leaf for quantized gradients, indexed like the hist_t histograms
+  */
+  int_hist_t* IntHistData(size_t num_bin) {
+    if (int_hist_data_.size() < num_bin) {
+      int_hist_data_.resize(num_bin);
+    }
+    return int_hist_data_.data();
+  }
+
+  /*!
+  * \brief Estimated cost of the histograms of a leaf, in bin updates done by the slowest thread.
+  *        The used groups outside the multi-value bin are built in parallel by group, the
+  *        multi-value bin in blocks of rows whose histograms are merged afterwards
+  * \param num_data Number of data in the leaf
+  * \param is_feature_used Features whose histograms are built for the leaf
+  * \param is_feature_used_bytree Features sampled for the tree, the multi-value bin is subset by them
+  */
+  double HistogramCost(data_size_t num_data, const std::vector<int8_t>& is_feature_used,
+                       const std::vector<int8_t>& is_feature_used_bytree) const {
+    const int num_threads_used = std::max(num_threads, 1);
+    double col_wise_elements_per_row = 0.0f;
+    int num_used_groups = 0;
+    int last_used_group = -1;
+    double multi_val_elements = 0.0f;
+    double used_multi_val_elements = 0.0f;
+    for (size_t feature_index = 0; feature_index < feature_col_wise_group_.size(); ++feature_index) {
+      const int group = feature_col_wise_group_[feature_index];
+      if (group >= 0) {
+        // the features of a group are consecutive, a group is built once if any of them is used
+        if (is_feature_used[feature_index] && group != last_used_group) {
+          col_wise_elements_per_row += col_wise_group_elements_[group];
+          ++num_used_groups;
+          last_used_group = group;
+        }
+      } else {
+        multi_val_elements += feature_multi_val_elements_[feature_index];
+        if (is_feature_used_bytree[feature_index]) {
+          used_multi_val_elements += feature_multi_val_elements_[feature_index];
+        }
+      }
+    }
+    double cost = 0.0f;
+    if (num_used_groups > 0) {
+      cost += num_data * col_wise_elements_per_row / std::min(num_threads_used, num_used_groups);
+    }
+    if (num_total_bin_ > 0) {
+      // same blocks as MultiValBinWrapper::ConstructHistograms
+      int min_block_size = std::min<int>(static_cast<int>(0.3f * num_total_bin_ /
+        (num_elements_per_row_ + kZeroThreshold)) + 1, 1024);
+      min_block_size = std::max<int>(min_block_size, 32);
+      const int num_blocks = std::max(1, std::min(num_threads_used,
+        static_cast<int>((num_data + min_block_size - 1) / min_block_size)));
+      const double used_ratio = multi_val_elements > 0.0f ? used_multi_val_elements / multi_val_elements : 1.0f;
+      cost += num_data * num_elements_per_row_ * used_ratio / num_blocks;
+      // clearing the block histograms, then merging them
+      cost += num_total_bin_ + static_cast<double>(num_blocks) * num_total_bin_ / num_threads_used;
+    }
+    return cost;
+  }
+
   void SetUseSubrow(bool is_use_subrow) {
     if (multi_val_bin_wrapper_ != nullptr) {
       multi_val_bin_wrapper_->SetUseSubrow(is_use_subrow);
@@ -211,13 +379,27 @@ struct TrainingShareStates {
     }
   }
 
+  void SetUseTreeMerge(bool use_tree_merge) {
+    if (multi_val_bin_wrapper_ != nullptr) {
+      multi_val_bin_wrapper_->SetUseTreeMerge(use_tree_merge);
+    }
+  }
+
  private:
   std::vector<uint32_t> feature_hist_offsets_;
   int num_hist_total_bin_ = 0;
   std::unique_ptr<MultiValBinWrapper> multi_val_bin_wrapper_;
-  std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>> hist_buf_;
+  HistBuffer hist_buf_;
+  IntHistBuffer int_hist_buf_;
+  std::vector<int_hist_t, Common::AlignmentAllocator<int_hist_t, kAlignedSize>> int_hist_data_;
   int num_total_bin_ = 0;
   double num_elements_per_row_ = 0.0f;
+  /*! \brief Col-wise group index of each feature, -1 for the features in the multi-value bin */
+  std::vector<int> feature_col_wise_group_;
+  /*! \brief Non-zero values per row of each group built outside the multi-value bin */
+  std::vector<double> col_wise_group_elements_;
+  /*! \brief Non-zero values per row of each feature in the multi-value bin */
+  std::vector<double> feature_multi_val_elements_;
 };
 
 }  // namespace LightGBM
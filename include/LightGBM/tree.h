@@ -140,6 +140,17 @@ class Tree {
   inline void PredictContribByMap(const std::unordered_map<int, double>& feature_values,
                                   int num_features, std::unordered_map<int, double>* output);
 
+  /*!
+  * \brief Add the SHAP interaction values of the pairs of distinct features, needs PrecomputeSHAP
+  * \param feature_values Feature value of this record
+  * \param num_features Number of features
+  * \param output Interaction of features i and j is at i * (num_features + 1) + j, the value is split between
+  *        (i, j) and (j, i), the diagonal is not changed
+  */
+  void PredictContribInteractions(const double* feature_values, int num_features, double* output) const;
+  void PredictContribInteractionsByMap(const std::unordered_map<int, double>& feature_values,
+                                       int num_features, std::unordered_map<int, double>* output) const;
+
   /*! \brief Get Number of leaves*/
   inline int num_leaves() const { return num_leaves_; }
 
@@ -176,6 +187,19 @@ class Tree {
     return threshold_in_bin_[node_idx];
   }
 
+  /*! \brief Get the threshold of a numerical split, or the index of the category bitset of a categorical one */
+  inline double threshold(int node_idx) const { return threshold_[node_idx]; }
+
+  /*! \brief Get the decision type (categorical flag, default direction and missing type) of a split */
+  inline int8_t decision_type(int node_idx) const { return decision_type_[node_idx]; }
+
+  /*! \brief Get the bitset of the categories that go to the left child of a categorical split */
+  inline std::vector<uint32_t> cat_threshold(int node_idx) const {
+    const int cat_idx = static_cast<int>(threshold_[node_idx]);
+    return std::vector<uint32_t>(cat_threshold_.begin() + cat_boundaries_[cat_idx],
+                                 cat_threshold_.begin() + cat_boundaries_[cat_idx + 1]);
+  }
+
   /*! \brief Get the number of data points that fall at or below this node*/
   inline int data_count(int node) const { return node >= 0 ? internal_count_[node] : leaf_count_[~node]; }
 
@@ -280,6 +304,19 @@ class Tree {
 
   void RecomputeMaxDepth();
 
+  /*!
+  * \brief Precompute the Fast TreeSHAP data used by PredictContrib: the path of every leaf and, for the
+  *        leaves with at most max_table_features distinct features on their path, the weights of all the
+  *        subsets of these features. Does nothing if they are already computed, they are freed by Split.
+  *        Not thread-safe
+  * \param max_table_features Most distinct features on the path of a leaf with a weight table, 0 for no table
+  * \param max_table_size Most weights in the tables of the tree, the next leaves are computed without table
+  */
+  void PrecomputeSHAP(int max_table_features, int64_t max_table_size);
+
+  /*! \brief Free the data of PrecomputeSHAP, PredictContrib runs the recursive TreeSHAP again */
+  void FreeSHAP();
+
   int NextLeafId() const { return num_leaves_; }
 
   /*! \brief Get the linear model constant term (bias) of one leaf */
@@ -447,6 +484,37 @@ class Tree {
     PathElement(int i, double z, double o, double w) : feature_index(i), zero_fraction(z), one_fraction(o), pweight(w) {}
   };
 
+  /*! \brief Fast TreeSHAP data of a leaf */
+  struct SHAPLeaf {
+    /*! \brief range of the path from the root in shap_path_ */
+    int path_begin;
+    int path_end;
+    /*! \brief distinct features of the path at [feature_begin, feature_begin + num_features) of shap_features_ */
+    int feature_begin;
+    int num_features;
+    /*! \brief weights in shap_tables_, -1 for the leaves evaluated without table, in O(D^2) time instead of O(D) */
+    int64_t table_begin;
+  };
+
+  /*! \brief Split on the path to a leaf */
+  struct SHAPPathStep {
+    int node;
+    /*! \brief index of the feature of the split in the features of the leaf */
+    int feature_slot;
+    bool is_left;
+  };
+
+  /*! \brief Same SHAP values as TreeSHAP, with the data of PrecomputeSHAP */
+  void FastTreeSHAP(const double* feature_values, double* phi) const;
+
+  /*!
+  * \brief SHAP interaction values of the leaves, with the data of PrecomputeSHAP
+  * \param goes_left Whether the row goes left at each node
+  * \param add_interaction Called with (feature i, feature j, value) for i < j
+  */
+  template <typename ADD_FUNCTION>
+  void SHAPInteractions(const std::vector<int8_t>& goes_left, ADD_FUNCTION add_interaction) const;
+
   /*! \brief Polynomial time algorithm for SHAP values (arXiv:1706.06060)*/
   void TreeSHAP(const double *feature_values, double *phi,
                 int node, int unique_depth,
@@ -518,6 +586,14 @@ class Tree {
   std::vector<std::vector<int>> branch_features_;
   double shrinkage_;
   int max_depth_;
+  /*! \brief Fast TreeSHAP data of PrecomputeSHAP, one SHAPLeaf per leaf */
+  std::vector<SHAPLeaf> shap_leaves_;
+  std::vector<SHAPPathStep> shap_path_;
+  std::vector<int> shap_features_;
+  /*! \brief product of the fractions of data going the way of the path, at the splits on the feature */
+  std::vector<double> shap_zero_fractions_;
+  /*! \brief weight of feature slot i and subset s of the other features of the leaf at i * 2^(d-1) + s */
+  std::vector<double> shap_tables_;
   /*! \brief Tree has linear model at each leaf */
   bool is_linear_;
   /*! \brief coefficients of linear models on leaves */
@@ -567,6 +643,7 @@ inline void Tree::Split(int leaf, int feature, int real_feature,
   // update leaf depth
   leaf_depth_[num_leaves_] = leaf_depth_[leaf] + 1;
   leaf_depth_[leaf]++;
+  FreeSHAP();
   if (track_branch_features_) {
     branch_features_[num_leaves_] = branch_features_[leaf];
     branch_features_[num_leaves_].push_back(split_feature_[new_node_idx]);
@@ -657,6 +734,10 @@ inline int Tree::PredictLeafIndexByMap(const std::unordered_map<int, double>& fe
 
 inline void Tree::PredictContrib(const double* feature_values, int num_features, double* output) {
   output[num_features] += ExpectedValue();
+  if (num_leaves_ > 1 && !shap_leaves_.empty()) {
+    FastTreeSHAP(feature_values, output);
+    return;
+  }
   // Run the recursion with preallocated space for the unique path data
   if (num_leaves_ > 1) {
     CHECK_GE(max_depth_, 0);
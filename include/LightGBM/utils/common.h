@@ -950,6 +950,169 @@ class AlignmentAllocator {
   }
 };
 
+/*!
+* \brief Same as AlignmentAllocator, but default-inserted elements are left uninitialized.
+*        A buffer resized with it is not written by the resizing thread, so on NUMA systems
+*        each page is allocated on the node of the thread that first writes it
+*/
+template <typename T, std::size_t N = 32>
+class FirstTouchAllocator : public AlignmentAllocator<T, N> {
+ public:
+  inline FirstTouchAllocator() throw() {}
+
+  template <typename T2>
+  inline FirstTouchAllocator(const FirstTouchAllocator<T2, N>&) throw() {}
+
+  using AlignmentAllocator<T, N>::construct;
+
+  inline void construct(T* p) {
+    new (p) T;
+  }
+
+  template <typename T2>
+  struct rebind {
+    typedef FirstTouchAllocator<T2, N> other;
+  };
+
+  bool operator!=(const FirstTouchAllocator<T, N>& other) const {
+    return !(*this == other);
+  }
+
+  bool operator==(const FirstTouchAllocator<T, N>&) const {
+    return true;
+  }
+};
+
+/*!
+* \brief Array that owns its elements in a std::vector, or refers to elements owned by someone
+*        else, e.g. in a memory-mapped file, without copying them. Changing the size of a view
+*        copies its elements first, the other writes go to the memory of the view
+*/
+template <typename T, typename ALLOC = std::allocator<T>>
+class ViewableVector {
+ public:
+  ViewableVector() : data_(nullptr), size_(0), is_view_(false) {}
+
+  ViewableVector(const ViewableVector& other)
+      : vec_(other.data_, other.data_ + other.size_), is_view_(false) {
+    Sync();
+  }
+
+  ViewableVector& operator=(const ViewableVector& other) {
+    if (this != &other) {
+      vec_.assign(other.data_, other.data_ + other.size_);
+      is_view_ = false;
+      Sync();
+    }
+    return *this;
+  }
+
+  ViewableVector(ViewableVector&& other) noexcept
+      : vec_(std::move(other.vec_)), data_(other.data_), size_(other.size_), is_view_(other.is_view_) {
+    other.clear();
+  }
+
+  ViewableVector& operator=(ViewableVector&& other) noexcept {
+    if (this != &other) {
+      vec_ = std::move(other.vec_);
+      data_ = other.data_;
+      size_ = other.size_;
+      is_view_ = other.is_view_;
+      if (!is_view_) {
+        Sync();
+      }
+      other.clear();
+    }
+    return *this;
+  }
+
+  ViewableVector& operator=(std::vector<T, ALLOC>&& vec) {
+    vec_ = std::move(vec);
+    is_view_ = false;
+    Sync();
+    return *this;
+  }
+
+  /*!
+  * \brief Refer to existing elements instead of owning them
+  * \param data First element, must stay valid as long as this array is a view of it. It is
+  *             written only through the non-const accessors, e.g. when it is a copy-on-write mapping
+  * \param size Number of elements
+  */
+  void SetView(const T* data, size_t size) {
+    std::vector<T, ALLOC>().swap(vec_);
+    data_ = const_cast<T*>(data);
+    size_ = size;
+    is_view_ = true;
+  }
+
+  bool is_view() const { return is_view_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  T& operator[](size_t i) { return data_[i]; }
+  const T& operator[](size_t i) const { return data_[i]; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+  void resize(size_t size) {
+    Own();
+    vec_.resize(size);
+    Sync();
+  }
+
+  void resize(size_t size, const T& value) {
+    Own();
+    vec_.resize(size, value);
+    Sync();
+  }
+
+  void reserve(size_t size) {
+    Own();
+    vec_.reserve(size);
+    Sync();
+  }
+
+  void push_back(const T& value) {
+    Own();
+    vec_.push_back(value);
+    Sync();
+  }
+
+  void clear() {
+    is_view_ = false;
+    vec_.clear();
+    Sync();
+  }
+
+  void shrink_to_fit() {
+    if (!is_view_) {
+      vec_.shrink_to_fit();
+      Sync();
+    }
+  }
+
+ private:
+  void Own() {
+    if (is_view_) {
+      vec_.assign(data_, data_ + size_);
+      is_view_ = false;
+    }
+  }
+
+  void Sync() {
+    data_ = vec_.data();
+    size_ = vec_.size();
+  }
+
+  std::vector<T, ALLOC> vec_;
+  T* data_;
+  size_t size_;
+  bool is_view_;
+};
+
 class Timer {
  public:
   Timer() {
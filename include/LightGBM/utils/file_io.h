@@ -64,6 +64,24 @@ struct VirtualFileWriter {
   }
 };
 
+/**
+ * \brief Writer appending to a buffer in memory, to serialize data with the code that writes files
+ */
+struct BufferWriter : VirtualFileWriter {
+  explicit BufferWriter(std::vector<char>* buffer) : buffer_(buffer) {}
+
+  bool Init() override { return true; }
+
+  size_t Write(const void* data, size_t bytes) const override {
+    const char* ptr = static_cast<const char*>(data);
+    buffer_->insert(buffer_->end(), ptr, ptr + bytes);
+    return bytes;
+  }
+
+ private:
+  std::vector<char>* buffer_;
+};
+
 /**
  * \brief An interface for reading files into buffers
  */
@@ -85,6 +103,15 @@ struct VirtualFileReader {
    * \return Number of bytes read
    */
   virtual size_t Read(void* buffer, size_t bytes) const = 0;
+  /*!
+   * \brief Read data at a position of the file, without moving the position of Read.
+   *        Several threads can read at the same time
+   * \param buffer Buffer to read data into
+   * \param bytes Number of bytes to read
+   * \param offset Position of the first byte to read
+   * \return Number of bytes read, fewer than bytes at the end of the file. Fatal error if the file cannot be read
+   */
+  virtual size_t ReadAt(void* buffer, size_t bytes, size_t offset) const = 0;
   /*!
    * \brief Create appropriate reader for filename
    * \param filename Filename of the data
@@ -93,6 +120,34 @@ struct VirtualFileReader {
   static std::unique_ptr<VirtualFileReader> Make(const std::string& filename);
 };
 
+/**
+ * \brief A local file mapped into memory. The pages are copy-on-write: they are shared with the
+ *        page cache, and thus with the other processes mapping the file, until they are written,
+ *        and the writes are never saved to the file
+ */
+class MappedFile {
+ public:
+  ~MappedFile();
+  /*!
+   * \brief Map a whole local file
+   * \param filename Filename of the data
+   * \return The mapped file, nullptr when the file cannot be mapped, e.g. when it is empty or on HDFS
+   */
+  static std::unique_ptr<MappedFile> Make(const std::string& filename);
+  /*! \brief First byte of the file, page-aligned */
+  char* data() const { return data_; }
+  /*! \brief Size of the file in bytes */
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(char* data, size_t size) : data_(data), size_(size) {}
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  char* data_;
+  size_t size_;
+};
+
 }  // namespace LightGBM
 
 #endif   // LightGBM_UTILS_FILE_IO_H_
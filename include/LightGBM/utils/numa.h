@@ -0,0 +1,219 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_UTILS_NUMA_H_
+#define LIGHTGBM_UTILS_NUMA_H_
+
+#include <LightGBM/utils/log.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#define LGBM_NUMA_LINUX
+#include <sched.h>
+#endif
+
+namespace LightGBM {
+
+/*! \brief Policies for pinning OpenMP threads to NUMA nodes */
+enum ThreadAffinity {
+  kAffinityNone = 0,
+  kAffinityCompact = 1,
+  kAffinitySpread = 2,
+};
+
+/*!
+* \brief NUMA topology of the host and pinning of the OpenMP threads to its nodes
+*/
+class NUMA {
+ public:
+  /*!
+  * \brief CPUs usable by this process, grouped by NUMA node. Hosts without NUMA
+  *        information report one node, with an empty CPU list outside Linux
+  */
+  static const std::vector<std::vector<int>>& NodeCPUs() {
+    static const std::vector<std::vector<int>> nodes = DetectNodes();
+    return nodes;
+  }
+
+  static int NumNodes() {
+    return static_cast<int>(NodeCPUs().size());
+  }
+
+  /*!
+  * \brief Parse a Linux CPU list such as "0-3,8,10-11"
+  */
+  static std::vector<int> ParseCPUList(const std::string& str) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < str.size()) {
+      size_t next = str.find(',', pos);
+      if (next == std::string::npos) {
+        next = str.size();
+      }
+      int first = 0, last = 0;
+      const std::string item = str.substr(pos, next - pos);
+      const int num_read = std::sscanf(item.c_str(), "%d-%d", &first, &last);
+      if (num_read == 1) {
+        cpus.push_back(first);
+      } else if (num_read == 2) {
+        for (int cpu = first; cpu <= last; ++cpu) {
+          cpus.push_back(cpu);
+        }
+      }
+      pos = next + 1;
+    }
+    return cpus;
+  }
+
+  static ThreadAffinity ParseAffinity(const std::string& name) {
+    if (name == std::string("none")) {
+      return kAffinityNone;
+    } else if (name == std::string("compact")) {
+      return kAffinityCompact;
+    } else if (name == std::string("spread")) {
+      return kAffinitySpread;
+    }
+    Log::Fatal("Unknown thread affinity %s", name.c_str());
+    return kAffinityNone;
+  }
+
+  /*!
+  * \brief Node of thread tid. Compact placement gives each node a contiguous range of
+  *        threads, proportional to its number of CPUs, so that neighbouring row blocks
+  *        share a node. Spread placement assigns the threads round-robin
+  */
+  static int NodeOfThread(int tid, int num_threads, ThreadAffinity affinity,
+                          const std::vector<std::vector<int>>& nodes) {
+    const int num_nodes = static_cast<int>(nodes.size());
+    if (affinity == kAffinitySpread || num_nodes <= 1) {
+      return tid % num_nodes;
+    }
+    size_t total_cpus = 0;
+    for (const auto& cpus : nodes) {
+      total_cpus += cpus.size();
+    }
+    size_t cpu_end = 0;
+    for (int node = 0; node < num_nodes; ++node) {
+      cpu_end += nodes[node].size();
+      // threads [0, thread_end) are placed on nodes [0, node]
+      const size_t thread_end = (cpu_end * num_threads + total_cpus - 1) / total_cpus;
+      if (static_cast<size_t>(tid) < thread_end) {
+        return node;
+      }
+    }
+    return num_nodes - 1;
+  }
+
+  /*!
+  * \brief Pin every thread of the OpenMP team to all CPUs of its node, or release the
+  *        pinning for kAffinityNone. Only redone when the policy or the number of threads changes
+  * \param name One of none, compact, spread
+  */
+  static void BindThreads(const std::string& name) {
+    const ThreadAffinity affinity = ParseAffinity(name);
+    const int num_threads = OMP_NUM_THREADS();
+    // policy and number of threads of the last binding, only the first caller with a new one binds
+    static std::atomic<int> bound_key(kAffinityNone);
+    const int key = affinity == kAffinityNone ? kAffinityNone : (num_threads << 2) | affinity;
+    if (bound_key.exchange(key) == key) {
+      return;
+    }
+#ifdef LGBM_NUMA_LINUX
+    const std::vector<std::vector<int>>& nodes = NodeCPUs();
+    const cpu_set_t& process_mask = ProcessMask();
+    #pragma omp parallel num_threads(num_threads)
+    {
+      cpu_set_t mask = process_mask;
+      if (affinity != kAffinityNone) {
+        const int node = NodeOfThread(omp_get_thread_num(), num_threads, affinity, nodes);
+        CPU_ZERO(&mask);
+        for (int cpu : nodes[node]) {
+          CPU_SET(cpu, &mask);
+        }
+      }
+      // pid 0 is the calling thread
+      sched_setaffinity(0, sizeof(mask), &mask);
+    }
+    if (affinity != kAffinityNone) {
+      Log::Debug("Pinned %d threads to %d NUMA nodes", num_threads, NumNodes());
+    }
+#else
+    if (affinity != kAffinityNone) {
+      Log::Warning("thread_affinity is only supported on Linux, threads are not pinned");
+    }
+#endif
+  }
+
+ private:
+#ifdef LGBM_NUMA_LINUX
+  /*! \brief CPUs the process was allowed to run on before any pinning */
+  static const cpu_set_t& ProcessMask() {
+    static const cpu_set_t mask = GetProcessMask();
+    return mask;
+  }
+
+  static cpu_set_t GetProcessMask() {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        CPU_SET(cpu, &mask);
+      }
+    }
+    return mask;
+  }
+
+  static std::string ReadLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    if (file.is_open()) {
+      std::getline(file, line);
+    }
+    return line;
+  }
+#endif  // LGBM_NUMA_LINUX
+
+  static std::vector<std::vector<int>> DetectNodes() {
+    std::vector<std::vector<int>> nodes;
+#ifdef LGBM_NUMA_LINUX
+    const cpu_set_t& process_mask = ProcessMask();
+    const std::string sys_node = "/sys/devices/system/node/";
+    for (int node : ParseCPUList(ReadLine(sys_node + "online"))) {
+      std::vector<int> cpus;
+      for (int cpu : ParseCPUList(ReadLine(sys_node + "node" + std::to_string(node) + "/cpulist"))) {
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &process_mask)) {
+          cpus.push_back(cpu);
+        }
+      }
+      // skip memory-only nodes and nodes whose CPUs are all disallowed
+      if (!cpus.empty()) {
+        nodes.push_back(cpus);
+      }
+    }
+    if (nodes.empty()) {
+      std::vector<int> cpus;
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &process_mask)) {
+          cpus.push_back(cpu);
+        }
+      }
+      nodes.push_back(cpus);
+    }
+#else
+    nodes.emplace_back();
+#endif
+    return nodes;
+  }
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_UTILS_NUMA_H_
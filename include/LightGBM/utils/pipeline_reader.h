@@ -7,11 +7,16 @@
 
 #include <LightGBM/utils/file_io.h>
 #include <LightGBM/utils/log.h>
+#include <LightGBM/utils/openmp_wrapper.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -19,50 +24,200 @@
 namespace LightGBM {
 
 /*!
-* \brief A pipeline file reader, use 2 threads, one read block from file, the other process the block
+* \brief Lines of a chunk of a text file, the lines that start in the chunk
+*/
+struct TextChunk {
+  /*! \brief Positions and sizes in buffer of the lines without end of line, the empty lines are skipped */
+  std::vector<std::pair<size_t, size_t>> line_ranges;
+  /*! \brief Copies of the lines, when they are copied by the reading threads */
+  std::vector<std::string> lines;
+  /*! \brief Number of bytes of the file in the chunk */
+  size_t num_bytes = 0;
+  /*! \brief True if the last line of the chunk ends the file without end of line */
+  bool last_line_without_eol = false;
+  /*! \brief True if the chunk starts after the end of the file */
+  bool is_end = false;
+  /*! \brief Buffer of the bytes read, kept for the next chunks */
+  std::vector<char> buffer;
+
+  /*! \brief Number of lines */
+  size_t num_lines() const { return line_ranges.size(); }
+  /*! \brief First byte of a line, the line does not end with '\0' */
+  const char* line_data(size_t i) const { return buffer.data() + line_ranges[i].first; }
+  /*! \brief Size of a line */
+  size_t line_size(size_t i) const { return line_ranges[i].second; }
+};
+
+/*!
+* \brief A pipeline file reader. The file is split in chunks, several threads read the chunks at their
+*        positions and split them into lines, and the chunks are processed in the order of the file
+*        by the calling thread, while the next chunks are read
 */
 class PipelineReader {
  public:
+  /*! \brief Bytes of a chunk */
+  static const size_t kChunkSize = 4 * 1024 * 1024;
+  /*! \brief Most threads reading the chunks */
+  static const int kMaxReadThreads = 4;
+
   /*!
-  * \brief Read data from a file, use pipeline methods
+  * \brief Read the lines of a file, use pipeline methods
   * \param filename Filename of data
-  * \process_fun Process function
+  * \param skip_bytes Number of bytes to skip at the beginning of the file, e.g. the header
+  * \param process_fun Process function of the chunks, called in the order of the file, it may take the lines
+  * \param copy_lines True to copy the lines into TextChunk::lines in the reading threads
+  * \param chunk_size Bytes of a chunk
+  * \param num_threads Number of threads reading the chunks, 0 for the number of OpenMP threads, at most kMaxReadThreads
+  * \return False if the file cannot be opened
   */
-  static size_t Read(const char* filename, int skip_bytes, const std::function<size_t(const char*, size_t)>& process_fun) {
+  static bool Read(const char* filename, size_t skip_bytes, const std::function<void(TextChunk*)>& process_fun,
+                   bool copy_lines = false, size_t chunk_size = kChunkSize, int num_threads = 0) {
     auto reader = VirtualFileReader::Make(filename);
     if (!reader->Init()) {
-      return 0;
+      return false;
+    }
+    if (num_threads <= 0) {
+      num_threads = std::min(OMP_NUM_THREADS(), static_cast<int>(kMaxReadThreads));
+    }
+    // chunk i is read into chunks[i % num_slots], once the chunk num_slots before is processed
+    const size_t num_slots = static_cast<size_t>(num_threads) + 1;
+    std::vector<TextChunk> chunks(num_slots);
+    std::vector<bool> is_ready(num_slots, false);
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t next_read = 0;
+    size_t next_process = 0;
+    bool is_stopped = false;
+    std::exception_ptr read_error = nullptr;
+
+    auto read_fun = [&] {
+      try {
+        while (true) {
+          size_t idx = 0;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [&] { return is_stopped || next_read < next_process + num_slots; });
+            if (is_stopped) { return; }
+            idx = next_read++;
+          }
+          TextChunk* chunk = &chunks[idx % num_slots];
+          ReadChunk(reader.get(), skip_bytes + idx * chunk_size, idx == 0, chunk_size, copy_lines, chunk);
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_ready[idx % num_slots] = true;
+          }
+          cond.notify_all();
+          if (chunk->is_end) { return; }
+        }
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (read_error == nullptr) {
+            read_error = std::current_exception();
+          }
+          is_stopped = true;
+        }
+        cond.notify_all();
+      }
+    };
+    std::vector<std::thread> read_workers;
+    for (int i = 0; i < num_threads; ++i) {
+      read_workers.emplace_back(read_fun);
     }
-    size_t cnt = 0;
-    const size_t buffer_size =  16 * 1024 * 1024;
-    // buffer used for the process_fun
-    auto buffer_process = std::vector<char>(buffer_size);
-    // buffer used for the file reading
-    auto buffer_read = std::vector<char>(buffer_size);
-    size_t read_cnt = 0;
-    if (skip_bytes > 0) {
-      // skip first k bytes
-      read_cnt = reader->Read(buffer_process.data(), skip_bytes);
+    auto stop_workers = [&] {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopped = true;
+      }
+      cond.notify_all();
+      for (auto& worker : read_workers) {
+        worker.join();
+      }
+    };
+
+    try {
+      for (size_t idx = 0; ; ++idx) {
+        const size_t slot = idx % num_slots;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cond.wait(lock, [&] { return is_ready[slot] || read_error != nullptr; });
+          if (read_error != nullptr) { break; }
+        }
+        if (chunks[slot].is_end) { break; }
+        process_fun(&chunks[slot]);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          is_ready[slot] = false;
+          ++next_process;
+        }
+        cond.notify_all();
+      }
+    } catch (...) {
+      stop_workers();
+      throw;
+    }
+    stop_workers();
+    if (read_error != nullptr) {
+      std::rethrow_exception(read_error);
     }
-    // read first block
-    read_cnt = reader->Read(buffer_process.data(), buffer_size);
+    return true;
+  }
+
+ private:
+  static bool IsEndOfLine(char c) {
+    return c == '\n' || c == '\r';
+  }
 
-    size_t last_read_cnt = 0;
-    while (read_cnt > 0) {
-      // start read thread
-      std::thread read_worker = std::thread(
-        [=, &last_read_cnt, &reader, &buffer_read] {
-        last_read_cnt = reader->Read(buffer_read.data(), buffer_size);
-      });
-      // start process
-      cnt += process_fun(buffer_process.data(), read_cnt);
-      // wait for read thread
-      read_worker.join();
-      // exchange the buffer
-      std::swap(buffer_process, buffer_read);
-      read_cnt = last_read_cnt;
+  /*!
+  * \brief Read a chunk and split its lines, the line continuing after the chunk is read to its end
+  * \param offset Position of the chunk in the file
+  * \param is_first True for the first chunk, which starts a line
+  */
+  static void ReadChunk(const VirtualFileReader* reader, size_t offset, bool is_first, size_t chunk_size,
+                        bool copy_lines, TextChunk* chunk) {
+    // with the byte before the chunk, to know if a line starts at the chunk
+    const size_t prefix = is_first ? 0 : 1;
+    const size_t read_offset = offset - prefix;
+    auto& buffer = chunk->buffer;
+    buffer.resize(prefix + chunk_size);
+    size_t cnt = reader->ReadAt(buffer.data(), buffer.size(), read_offset);
+    bool is_eof = cnt < buffer.size();
+    chunk->is_end = cnt <= prefix;
+    chunk->num_bytes = chunk->is_end ? 0 : cnt - prefix;
+    chunk->last_line_without_eol = false;
+    const size_t chunk_end = cnt;
+    size_t i = prefix;
+    if (!is_first && !IsEndOfLine(buffer[0])) {
+      // the line that starts before is in the previous chunk
+      while (i < chunk_end && !IsEndOfLine(buffer[i])) { ++i; }
+    }
+    chunk->line_ranges.clear();
+    while (true) {
+      while (i < chunk_end && IsEndOfLine(buffer[i])) { ++i; }
+      if (i >= chunk_end) { break; }
+      const size_t line_begin = i;
+      while (true) {
+        while (i < cnt && !IsEndOfLine(buffer[i])) { ++i; }
+        if (i < cnt || is_eof) { break; }
+        // read the rest of the last line
+        const size_t step = std::max<size_t>(chunk_size / 16, 4096);
+        buffer.resize(cnt + step);
+        const size_t read_cnt = reader->ReadAt(buffer.data() + cnt, step, read_offset + cnt);
+        cnt += read_cnt;
+        is_eof = read_cnt < step;
+      }
+      chunk->line_ranges.emplace_back(line_begin, i - line_begin);
+      if (i == cnt) {
+        chunk->last_line_without_eol = true;
+      }
+    }
+    const size_t num_lines = chunk->line_ranges.size();
+    if (copy_lines) {
+      chunk->lines.resize(num_lines);
+      for (size_t j = 0; j < num_lines; ++j) {
+        chunk->lines[j].assign(chunk->line_data(j), chunk->line_size(j));
+      }
     }
-    return cnt;
   }
 };
 
@@ -0,0 +1,197 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_UTILS_SIMD_H_
+#define LIGHTGBM_UTILS_SIMD_H_
+
+#include <LightGBM/utils/log.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LGBM_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit an instruction set inside functions that request it,
+// which lets the kernels be compiled without raising the baseline -m flags.
+// MSVC accepts all intrinsics everywhere.
+#if defined(LGBM_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LGBM_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define LGBM_TARGET_AVX2 __attribute__((target("avx2")))
+#define LGBM_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512cd,avx512vl")))
+#else
+#define LGBM_TARGET_SSE42
+#define LGBM_TARGET_AVX2
+#define LGBM_TARGET_AVX512
+#endif
+
+namespace LightGBM {
+
+/*! \brief Instruction set levels of the vectorized kernels, ordered by width */
+enum SIMDLevel {
+  kSIMDNone = 0,
+  kSIMDSSE42 = 1,
+  kSIMDAVX2 = 2,
+  kSIMDAVX512 = 3,
+};
+
+/*!
+* \brief Runtime instruction set detection and the process-wide level used for dispatch
+*/
+class SIMD {
+ public:
+  /*!
+  * \brief Highest level supported by both the CPU and the operating system
+  */
+  static SIMDLevel Detect() {
+    static const SIMDLevel detected = DetectInner();
+    return detected;
+  }
+
+  /*!
+  * \brief Level used unless another one is forced. AVX-512 has to be requested
+  *        explicitly, its gather / scatter based kernels are usually slower than AVX2
+  */
+  static SIMDLevel Default() {
+    const SIMDLevel detected = Detect();
+    return detected > kSIMDAVX2 ? kSIMDAVX2 : detected;
+  }
+
+  /*!
+  * \brief Level the kernels currently dispatch to
+  */
+  static SIMDLevel Level() {
+    return ActiveLevel().load(std::memory_order_relaxed);
+  }
+
+  /*!
+  * \brief Force a level, clamped to what the host supports
+  * \param level Requested level
+  */
+  static void SetLevel(SIMDLevel level) {
+    const SIMDLevel detected = Detect();
+    if (level > detected) {
+      Log::Warning("SIMD level %s is not supported by this CPU, using %s instead",
+                   Name(level), Name(detected));
+      level = detected;
+    }
+    ActiveLevel().store(level, std::memory_order_relaxed);
+  }
+
+  /*!
+  * \brief Force a level by name, "auto" restores the default level
+  * \param name One of auto, none, sse4.2, avx2, avx512
+  */
+  static void SetLevel(const std::string& name) {
+    if (name == std::string("auto")) {
+      ActiveLevel().store(Default(), std::memory_order_relaxed);
+    } else if (name == std::string("none")) {
+      SetLevel(kSIMDNone);
+    } else if (name == std::string("sse4.2")) {
+      SetLevel(kSIMDSSE42);
+    } else if (name == std::string("avx2")) {
+      SetLevel(kSIMDAVX2);
+    } else if (name == std::string("avx512")) {
+      SetLevel(kSIMDAVX512);
+    } else {
+      Log::Fatal("Unknown SIMD level %s", name.c_str());
+    }
+  }
+
+  static const char* Name(SIMDLevel level) {
+    switch (level) {
+      case kSIMDSSE42:
+        return "sse4.2";
+      case kSIMDAVX2:
+        return "avx2";
+      case kSIMDAVX512:
+        return "avx512";
+      default:
+        return "none";
+    }
+  }
+
+ private:
+  /*! \brief Read by the kernels of every thread while a booster may set it */
+  static std::atomic<SIMDLevel>& ActiveLevel() {
+    static std::atomic<SIMDLevel> level(Default());
+    return level;
+  }
+
+#ifdef LGBM_SIMD_X86
+  static void CPUID(int leaf, int subleaf, uint32_t info[4]) {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, leaf, subleaf);
+    for (int i = 0; i < 4; ++i) {
+      info[i] = static_cast<uint32_t>(regs[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+  }
+
+  static uint64_t XGETBV() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+  }
+#endif  // LGBM_SIMD_X86
+
+  static SIMDLevel DetectInner() {
+#ifdef LGBM_SIMD_X86
+    uint32_t info[4];
+    CPUID(0, 0, info);
+    const uint32_t max_leaf = info[0];
+    if (max_leaf < 1) {
+      return kSIMDNone;
+    }
+    CPUID(1, 0, info);
+    const bool has_sse42 = (info[2] & (1u << 20)) != 0;
+    const bool has_osxsave = (info[2] & (1u << 27)) != 0;
+    const bool has_avx = (info[2] & (1u << 28)) != 0;
+    if (!has_sse42) {
+      return kSIMDNone;
+    }
+    if (!has_osxsave || !has_avx || max_leaf < 7) {
+      return kSIMDSSE42;
+    }
+    // the OS must save the ymm (and zmm / opmask) registers on context switch
+    const uint64_t xcr0 = XGETBV();
+    if ((xcr0 & 0x6) != 0x6) {
+      return kSIMDSSE42;
+    }
+    CPUID(7, 0, info);
+    const bool has_avx2 = (info[1] & (1u << 5)) != 0;
+    const bool has_avx512f = (info[1] & (1u << 16)) != 0;
+    const bool has_avx512cd = (info[1] & (1u << 28)) != 0;
+    const bool has_avx512vl = (info[1] & (1u << 31)) != 0;
+    if (!has_avx2) {
+      return kSIMDSSE42;
+    }
+    if (has_avx512f && has_avx512cd && has_avx512vl && (xcr0 & 0xE6) == 0xE6) {
+      return kSIMDAVX512;
+    }
+    return kSIMDAVX2;
+#else
+    return kSIMDNone;
+#endif
+  }
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_UTILS_SIMD_H_
@@ -0,0 +1,311 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_UTILS_TASK_SCHEDULER_H_
+#define LIGHTGBM_UTILS_TASK_SCHEDULER_H_
+
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Work-stealing task scheduler, an alternative to the OpenMP loops of the training hot paths.
+*        A loop of n tasks is one range that is halved lazily: the running thread keeps the lower
+*        half and pushes the upper one to its own deque, idle threads steal the oldest, so largest,
+*        ranges from the other deques. A thread waiting for its loop runs tasks meanwhile, so a task
+*        can start a nested loop, e.g. the feature groups of a leaf inside the loop over leaves,
+*        and the idle threads join it instead of waiting at a barrier.
+*        The scheduler uses OMP_NUM_THREADS() threads, the calling thread included. Loops started
+*        from outside the scheduler are serialized, so only one outer loop runs at a time.
+*        The threads are busy with tasks during a loop, so the OpenMP regions reached from the tasks
+*        run on one thread, as long as they take the number of threads from OMP_NUM_THREADS().
+*        Between loops the workers sleep on a condition variable, and they stop after
+*        kIdleMilliseconds without tasks; the next loop starts them again.
+*/
+class TaskScheduler {
+ public:
+  /*!
+  * \brief Run fun(i) for every i in [0, num_tasks) and wait for all of them.
+  *        The first exception thrown by a task is rethrown once all tasks finished
+  */
+  static void ParallelFor(int num_tasks, const std::function<void(int)>& fun) {
+    if (num_tasks <= 0) {
+      return;
+    }
+    Instance()->Run(num_tasks, fun);
+  }
+
+  /*! \brief Number of threads of the loops, for the tasks that split their work in blocks */
+  static int NumThreads() {
+    if (CurrentSlot() >= 0) {
+      return static_cast<int>(Instance()->slots_.size());
+    }
+    return OMP_NUM_THREADS();
+  }
+
+ private:
+  /*! \brief Tasks of one ParallelFor call */
+  struct Group {
+    explicit Group(const std::function<void(int)>* f, int num_tasks)
+        : fun(f), pending(num_tasks) {}
+    const std::function<void(int)>* fun;
+    /*! \brief number of tasks not finished yet, the owner returns when it reaches 0 */
+    std::atomic<int> pending;
+    std::mutex mutex;
+    std::exception_ptr exception;
+  };
+
+  /*! \brief Tasks [begin, end) of a group */
+  struct Range {
+    Group* group;
+    int begin;
+    int end;
+  };
+
+  /*! \brief Deque of one thread, the owner pops the newest range, thieves the oldest */
+  struct Slot {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+    /*! \brief Whether the worker of the slot runs, it stops by itself when idle */
+    std::atomic<bool> is_running{false};
+  };
+
+  TaskScheduler() {}
+
+  /*! \brief Never destroyed, joining threads in static destructors can dead-lock on unload */
+  static TaskScheduler* Instance() {
+    static TaskScheduler* instance = new TaskScheduler();
+    return instance;
+  }
+
+  /*! \brief Slot of the calling thread, -1 outside the scheduler */
+  static int& CurrentSlot() {
+    static thread_local int slot = -1;
+    return slot;
+  }
+
+  void Run(int num_tasks, const std::function<void(int)>& fun) {
+    int slot = CurrentSlot();
+    if (slot >= 0) {
+      RunGroup(slot, num_tasks, fun);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(submit_mutex_);
+    Resize(OMP_NUM_THREADS());
+    StartWorkers();
+    // like the workers, the calling thread runs the OpenMP regions of its tasks alone
+    const int omp_num_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    is_loop_running_.store(true);
+    // nested loops started by the tasks must not take the lock again
+    CurrentSlot() = 0;
+    try {
+      RunGroup(0, num_tasks, fun);
+    } catch (...) {
+      EndLoop(omp_num_threads);
+      throw;
+    }
+    EndLoop(omp_num_threads);
+  }
+
+  void EndLoop(int omp_num_threads) {
+    CurrentSlot() = -1;
+    // the workers go to sleep instead of spinning next to the OpenMP threads
+    is_loop_running_.store(false);
+    omp_set_num_threads(omp_num_threads);
+  }
+
+  void RunGroup(int slot, int num_tasks, const std::function<void(int)>& fun) {
+    Group group(&fun, num_tasks);
+    if (slots_.size() <= 1) {
+      for (int i = 0; i < num_tasks; ++i) {
+        Execute(slot, Range{&group, i, i + 1});
+      }
+      if (group.exception) {
+        std::rethrow_exception(group.exception);
+      }
+      return;
+    }
+    Execute(slot, Range{&group, 0, num_tasks});
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+      Range range;
+      if (Pop(slot, &range) || Steal(slot, &range)) {
+        Execute(slot, range);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    if (group.exception) {
+      std::rethrow_exception(group.exception);
+    }
+  }
+
+  /*! \brief Run the first task of range, after pushing the other ones in halves */
+  void Execute(int slot, Range range) {
+    while (range.end - range.begin > 1) {
+      const int mid = range.begin + (range.end - range.begin) / 2;
+      Push(slot, Range{range.group, mid, range.end});
+      range.end = mid;
+    }
+    Group* group = range.group;
+    try {
+      (*group->fun)(range.begin);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(group->mutex);
+      if (!group->exception) {
+        group->exception = std::current_exception();
+      }
+    }
+    // the owner may return and destroy the group right after this
+    group->pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void Push(int slot, const Range& range) {
+    {
+      std::lock_guard<std::mutex> lock(slots_[slot]->mutex);
+      slots_[slot]->ranges.push_back(range);
+    }
+    num_queued_.fetch_add(1);
+    if (num_sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      wake_up_.notify_one();
+    }
+  }
+
+  bool Pop(int slot, Range* out) {
+    std::lock_guard<std::mutex> lock(slots_[slot]->mutex);
+    auto& ranges = slots_[slot]->ranges;
+    if (ranges.empty()) {
+      return false;
+    }
+    *out = ranges.back();
+    ranges.pop_back();
+    num_queued_.fetch_sub(1);
+    return true;
+  }
+
+  bool Steal(int slot, Range* out) {
+    if (num_queued_.load() <= 0) {
+      return false;
+    }
+    const int num_slots = static_cast<int>(slots_.size());
+    for (int i = 1; i < num_slots; ++i) {
+      Slot* victim = slots_[(slot + i) % num_slots].get();
+      std::lock_guard<std::mutex> lock(victim->mutex);
+      if (!victim->ranges.empty()) {
+        *out = victim->ranges.front();
+        victim->ranges.pop_front();
+        num_queued_.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void WorkerLoop(int slot) {
+    CurrentSlot() = slot;
+    // an OpenMP loop reached from a task must not start a team on every worker
+    omp_set_num_threads(1);
+    int num_idle_rounds = 0;
+    while (!stop_.load(std::memory_order_acquire)) {
+      Range range;
+      if (Pop(slot, &range) || Steal(slot, &range)) {
+        Execute(slot, range);
+        num_idle_rounds = 0;
+      } else if (is_loop_running_.load() && ++num_idle_rounds < kSpinRounds) {
+        // the running loop may push ranges soon
+        std::this_thread::yield();
+      } else {
+        // Push checks num_sleeping_ after adding to num_queued_, and this thread checks
+        // num_queued_ after adding to num_sleeping_, so a new range always wakes it up
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        num_sleeping_.fetch_add(1);
+        const bool is_woken_up = wake_up_.wait_for(
+            lock, std::chrono::milliseconds(static_cast<int64_t>(kIdleMilliseconds)), [this] {
+          return stop_.load() || num_queued_.load() > 0;
+        });
+        num_sleeping_.fetch_sub(1);
+        if (!is_woken_up && !is_loop_running_.load()) {
+          break;
+        }
+        num_idle_rounds = 0;
+      }
+    }
+    slots_[slot]->is_running.store(false);
+  }
+
+  /*! \brief Start the workers that stopped, only called without running tasks */
+  void StartWorkers() {
+    for (int i = 1; i < static_cast<int>(slots_.size()); ++i) {
+      if (slots_[i]->is_running.load()) {
+        continue;
+      }
+      if (workers_[i - 1].joinable()) {
+        workers_[i - 1].join();
+      }
+      slots_[i]->is_running.store(true);
+      workers_[i - 1] = std::thread(&TaskScheduler::WorkerLoop, this, i);
+    }
+  }
+
+  /*! \brief Restart the workers for a new number of threads, only called without running tasks */
+  void Resize(int num_threads) {
+    num_threads = num_threads > 1 ? num_threads : 1;
+    if (static_cast<int>(slots_.size()) == num_threads) {
+      return;
+    }
+    if (!workers_.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_.store(true);
+        wake_up_.notify_all();
+      }
+      for (auto& worker : workers_) {
+        if (worker.joinable()) {
+          worker.join();
+        }
+      }
+      workers_.clear();
+      stop_.store(false);
+    }
+    slots_.clear();
+    for (int i = 0; i < num_threads; ++i) {
+      slots_.emplace_back(new Slot());
+    }
+    // slot 0 belongs to the thread that starts the outer loop, StartWorkers runs the other ones
+    workers_.resize(num_threads - 1);
+  }
+
+  /*! \brief idle rounds of a loop before a worker sleeps, the tasks of a loop often come in waves */
+  static const int kSpinRounds = 4096;
+  /*! \brief a worker without tasks for this long stops, so that idle processes keep no threads */
+  static const int kIdleMilliseconds = 1000;
+
+  std::mutex submit_mutex_;
+  std::vector<std::unique_ptr<Slot>> slots_;
+  std::vector<std::thread> workers_;
+  std::atomic<int> num_queued_{0};
+  std::atomic<int> num_sleeping_{0};
+  std::atomic<bool> stop_{false};
+  /*! \brief Whether an outer loop runs, the workers only spin for tasks meanwhile */
+  std::atomic<bool> is_loop_running_{false};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_up_;
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_UTILS_TASK_SCHEDULER_H_
@@ -13,6 +13,7 @@
 #include <cstdio>
 #include <functional>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 namespace LightGBM {
@@ -86,58 +87,13 @@ class TextReader {
   inline std::vector<std::string>& Lines() { return lines_; }
 
   INDEX_T ReadAllAndProcess(const std::function<void(INDEX_T, const char*, size_t)>& process_fun) {
-    last_line_ = "";
     INDEX_T total_cnt = 0;
-    size_t bytes_read = 0;
-    PipelineReader::Read(filename_, skip_bytes_,
-        [&process_fun, &bytes_read, &total_cnt, this]
-    (const char* buffer_process, size_t read_cnt) {
-      size_t cnt = 0;
-      size_t i = 0;
-      size_t last_i = 0;
-      // skip the break between \r and \n
-      if (last_line_.size() == 0 && buffer_process[0] == '\n') {
-        i = 1;
-        last_i = i;
-      }
-      while (i < read_cnt) {
-        if (buffer_process[i] == '\n' || buffer_process[i] == '\r') {
-          if (last_line_.size() > 0) {
-            last_line_.append(buffer_process + last_i, i - last_i);
-            process_fun(total_cnt, last_line_.c_str(), last_line_.size());
-            last_line_ = "";
-          } else {
-            process_fun(total_cnt, buffer_process + last_i, i - last_i);
-          }
-          ++cnt;
-          ++i;
-          ++total_cnt;
-          // skip end of line
-          while ((buffer_process[i] == '\n' || buffer_process[i] == '\r') && i < read_cnt) { ++i; }
-          last_i = i;
-        } else {
-          ++i;
-        }
+    ReadChunks([&process_fun, &total_cnt] (TextChunk* chunk) {
+      for (size_t i = 0; i < chunk->num_lines(); ++i) {
+        process_fun(total_cnt, chunk->line_data(i), chunk->line_size(i));
+        ++total_cnt;
       }
-      if (last_i != read_cnt) {
-        last_line_.append(buffer_process + last_i, read_cnt - last_i);
-      }
-
-      size_t prev_bytes_read = bytes_read;
-      bytes_read += read_cnt;
-      if (prev_bytes_read / read_progress_interval_bytes_ < bytes_read / read_progress_interval_bytes_) {
-        Log::Debug("Read %.1f GBs from %s.", 1.0 * bytes_read / kGbs, filename_);
-      }
-
-      return cnt;
-    });
-    // if last line of file doesn't contain end of line
-    if (last_line_.size() > 0) {
-      Log::Info("Warning: last line of %s has no end of line, still using this line", filename_);
-      process_fun(total_cnt, last_line_.c_str(), last_line_.size());
-      ++total_cnt;
-      last_line_ = "";
-    }
+    }, false);
     return total_cnt;
   }
 
@@ -146,10 +102,14 @@ class TextReader {
   * \return number of lines of text data
   */
   INDEX_T ReadAllLines() {
-    return ReadAllAndProcess(
-      [=](INDEX_T, const char* buffer, size_t size) {
-      lines_.emplace_back(buffer, size);
-    });
+    INDEX_T total_cnt = 0;
+    ReadChunks([&total_cnt, this] (TextChunk* chunk) {
+      for (auto& line : chunk->lines) {
+        lines_.push_back(std::move(line));
+      }
+      total_cnt += static_cast<INDEX_T>(chunk->lines.size());
+    }, true);
+    return total_cnt;
   }
 
   std::vector<char> ReadContent(size_t* out_len) {
@@ -194,15 +154,16 @@ class TextReader {
   */
   INDEX_T ReadAndFilterLines(const std::function<bool(INDEX_T)>& filter_fun, std::vector<INDEX_T>* out_used_data_indices) {
     out_used_data_indices->clear();
-    INDEX_T total_cnt = ReadAllAndProcess(
-        [&filter_fun, &out_used_data_indices, this]
-    (INDEX_T line_idx , const char* buffer, size_t size) {
-      bool is_used = filter_fun(line_idx);
-      if (is_used) {
-        out_used_data_indices->push_back(line_idx);
-        lines_.emplace_back(buffer, size);
+    INDEX_T total_cnt = 0;
+    ReadChunks([&filter_fun, &out_used_data_indices, &total_cnt, this] (TextChunk* chunk) {
+      for (size_t i = 0; i < chunk->num_lines(); ++i) {
+        if (filter_fun(total_cnt)) {
+          out_used_data_indices->push_back(total_cnt);
+          lines_.emplace_back(chunk->line_data(i), chunk->line_size(i));
+        }
+        ++total_cnt;
       }
-    });
+    }, false);
     return total_cnt;
   }
 
@@ -237,74 +198,29 @@ class TextReader {
     });
   }
 
+  /*!
+  * \brief Read the text data from file chunk by chunk, use filter_fun to filter data
+  * \param process_fun Process function of the lines kept in a chunk, with the index of the first one among the kept lines
+  * \param filter_fun Function that perform data filter, of the number of kept lines and the line index
+  * \return The number of total data
+  */
   INDEX_T ReadAllAndProcessParallelWithFilter(const std::function<void(INDEX_T, const std::vector<std::string>&)>& process_fun, const std::function<bool(INDEX_T, INDEX_T)>& filter_fun) {
-    last_line_ = "";
     INDEX_T total_cnt = 0;
-    size_t bytes_read = 0;
     INDEX_T used_cnt = 0;
-    PipelineReader::Read(filename_, skip_bytes_,
-        [&process_fun, &filter_fun, &total_cnt, &bytes_read, &used_cnt, this]
-    (const char* buffer_process, size_t read_cnt) {
-      size_t cnt = 0;
-      size_t i = 0;
-      size_t last_i = 0;
-      INDEX_T start_idx = used_cnt;
-      // skip the break between \r and \n
-      if (last_line_.size() == 0 && buffer_process[0] == '\n') {
-        i = 1;
-        last_i = i;
-      }
-      while (i < read_cnt) {
-        if (buffer_process[i] == '\n' || buffer_process[i] == '\r') {
-          if (last_line_.size() > 0) {
-            last_line_.append(buffer_process + last_i, i - last_i);
-            if (filter_fun(used_cnt, total_cnt)) {
-              lines_.push_back(last_line_);
-              ++used_cnt;
-            }
-            last_line_ = "";
-          } else {
-            if (filter_fun(used_cnt, total_cnt)) {
-              lines_.emplace_back(buffer_process + last_i, i - last_i);
-              ++used_cnt;
-            }
-          }
-          ++cnt;
-          ++i;
-          ++total_cnt;
-          // skip end of line
-          while ((buffer_process[i] == '\n' || buffer_process[i] == '\r') && i < read_cnt) { ++i; }
-          last_i = i;
-        } else {
-          ++i;
+    ReadChunks([&process_fun, &filter_fun, &total_cnt, &used_cnt, this] (TextChunk* chunk) {
+      const INDEX_T start_idx = used_cnt;
+      for (auto& line : chunk->lines) {
+        if (filter_fun(used_cnt, total_cnt)) {
+          lines_.push_back(std::move(line));
+          ++used_cnt;
         }
+        ++total_cnt;
       }
-      process_fun(start_idx, lines_);
-      lines_.clear();
-      if (last_i != read_cnt) {
-        last_line_.append(buffer_process + last_i, read_cnt - last_i);
-      }
-
-      size_t prev_bytes_read = bytes_read;
-      bytes_read += read_cnt;
-      if (prev_bytes_read / read_progress_interval_bytes_ < bytes_read / read_progress_interval_bytes_) {
-        Log::Debug("Read %.1f GBs from %s.", 1.0 * bytes_read / kGbs, filename_);
-      }
-
-      return cnt;
-    });
-    // if last line of file doesn't contain end of line
-    if (last_line_.size() > 0) {
-      Log::Info("Warning: last line of %s has no end of line, still using this line", filename_);
-      if (filter_fun(used_cnt, total_cnt)) {
-        lines_.push_back(last_line_);
-        process_fun(used_cnt, lines_);
+      if (!lines_.empty()) {
+        process_fun(start_idx, lines_);
       }
       lines_.clear();
-      ++total_cnt;
-      ++used_cnt;
-      last_line_ = "";
-    }
+    }, true);
     return total_cnt;
   }
 
@@ -324,19 +240,39 @@ class TextReader {
   }
 
  private:
+  /*!
+  * \brief Read the lines of the file with PipelineReader
+  * \param chunk_fun Process function of the chunks, in the order of the file
+  * \param copy_lines True if chunk_fun uses TextChunk::lines
+  */
+  void ReadChunks(const std::function<void(TextChunk*)>& chunk_fun, bool copy_lines) {
+    size_t bytes_read = 0;
+    PipelineReader::Read(filename_, skip_bytes_,
+        [&chunk_fun, &bytes_read, this] (TextChunk* chunk) {
+      // if last line of file doesn't contain end of line
+      if (chunk->last_line_without_eol) {
+        Log::Info("Warning: last line of %s has no end of line, still using this line", filename_);
+      }
+      chunk_fun(chunk);
+      size_t prev_bytes_read = bytes_read;
+      bytes_read += chunk->num_bytes;
+      if (prev_bytes_read / read_progress_interval_bytes_ < bytes_read / read_progress_interval_bytes_) {
+        Log::Debug("Read %.1f GBs from %s.", 1.0 * bytes_read / kGbs, filename_);
+      }
+    }, copy_lines);
+  }
+
   /*! \brief Filename of text data */
   const char* filename_;
   /*! \brief Cache the read text data */
   std::vector<std::string> lines_;
-  /*! \brief Buffer for last line */
-  std::string last_line_;
   /*! \brief first line */
   std::string first_line_ = "";
   /*! \brief is skip first line */
   bool is_skip_first_line_ = false;
   size_t read_progress_interval_bytes_;
-  /*! \brief is skip first line */
-  int skip_bytes_ = 0;
+  /*! \brief bytes of the header */
+  size_t skip_bytes_ = 0;
 };
 
 }  // namespace LightGBM
@@ -9,6 +9,7 @@
 #include <LightGBM/meta.h>
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/openmp_wrapper.h>
+#include <LightGBM/utils/task_scheduler.h>
 
 #include <algorithm>
 #include <functional>
@@ -86,6 +87,48 @@ class Threading {
     OMP_THROW_EX();
     return n_block;
   }
+
+  /*!
+  * \brief Run fun(i) for i in [0, num_tasks), as tasks of the TaskScheduler if use_task_scheduler,
+  *        otherwise in an OpenMP loop giving task i to thread i % num_threads
+  */
+  template <typename FUNC>
+  static inline void ForEachTask(int num_tasks, int num_threads, bool use_task_scheduler, const FUNC& fun) {
+    if (use_task_scheduler) {
+      TaskScheduler::ParallelFor(num_tasks, fun);
+      return;
+    }
+    OMP_INIT_EX();
+#pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+    for (int i = 0; i < num_tasks; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      fun(i);
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+  }
+
+  /*!
+  * \brief Run fun(start, end) on blocks of [0, cnt) as tasks of the TaskScheduler. There are
+  *        a few blocks per thread, so that idle threads have blocks to steal
+  */
+  template <typename INDEX_T, typename FUNC>
+  static inline void TaskFor(INDEX_T cnt, INDEX_T min_block_size, const FUNC& fun) {
+    int n_block = 1;
+    INDEX_T block_size = cnt;
+    BlockInfo<INDEX_T>(TaskScheduler::NumThreads() * kTasksPerThread, cnt, min_block_size,
+                       &n_block, &block_size);
+    TaskScheduler::ParallelFor(n_block, [&](int i) {
+      const INDEX_T start = block_size * i;
+      const INDEX_T end = std::min(cnt, start + block_size);
+      if (start < end) {
+        fun(start, end);
+      }
+    });
+  }
+
+ private:
+  static const int kTasksPerThread = 4;
 };
 
 template <typename INDEX_T, bool TWO_BUFFER>
@@ -107,6 +150,11 @@ class ParallelPartitionRunner {
 
   ~ParallelPartitionRunner() {}
 
+  /*! \brief Run the blocks as tasks of the TaskScheduler instead of an OpenMP loop */
+  void SetUseTaskScheduler(bool use_task_scheduler) {
+    use_task_scheduler_ = use_task_scheduler;
+  }
+
   void ReSize(INDEX_T num_data) {
     left_.resize(num_data);
     if (TWO_BUFFER) {
@@ -129,17 +177,14 @@ class ParallelPartitionRunner {
                                     &inner_size);
     }
 
-    OMP_INIT_EX();
-#pragma omp parallel for schedule(static, 1) num_threads(num_threads_)
-    for (int i = 0; i < nblock; ++i) {
-      OMP_LOOP_EX_BEGIN();
+    Threading::ForEachTask(nblock, num_threads_, use_task_scheduler_, [&](int i) {
       INDEX_T cur_start = i * inner_size;
       INDEX_T cur_cnt = std::min(inner_size, cnt - cur_start);
       offsets_[i] = cur_start;
       if (cur_cnt <= 0) {
         left_cnts_[i] = 0;
         right_cnts_[i] = 0;
-        continue;
+        return;
       }
       auto left_ptr = left_.data() + cur_start;
       INDEX_T* right_ptr = nullptr;
@@ -155,9 +200,7 @@ class ParallelPartitionRunner {
       }
       left_cnts_[i] = cur_left_count;
       right_cnts_[i] = cur_cnt - cur_left_count;
-      OMP_LOOP_EX_END();
-    }
-    OMP_THROW_EX();
+    });
 
     left_write_pos_[0] = 0;
     right_write_pos_[0] = 0;
@@ -168,8 +211,7 @@ class ParallelPartitionRunner {
     data_size_t left_cnt = left_write_pos_[nblock - 1] + left_cnts_[nblock - 1];
 
     auto right_start = out + left_cnt;
-#pragma omp parallel for schedule(static, 1) num_threads(num_threads_)
-    for (int i = 0; i < nblock; ++i) {
+    Threading::ForEachTask(nblock, num_threads_, use_task_scheduler_, [&](int i) {
       std::copy_n(left_.data() + offsets_[i], left_cnts_[i],
                   out + left_write_pos_[i]);
       if (TWO_BUFFER) {
@@ -179,12 +221,39 @@ class ParallelPartitionRunner {
         std::copy_n(left_.data() + offsets_[i] + left_cnts_[i], right_cnts_[i],
                     right_start + right_write_pos_[i]);
       }
+    });
+    return left_cnt;
+  }
+
+  /*!
+  * \brief Partition cnt data in one block, with the buffers at [offset, offset + cnt).
+  *        Calls on disjoint ranges can run at the same time
+  */
+  INDEX_T RunInOneBlock(
+      INDEX_T offset, INDEX_T cnt,
+      const std::function<INDEX_T(int, INDEX_T, INDEX_T, INDEX_T*, INDEX_T*)>& func,
+      INDEX_T* out) {
+    if (cnt <= 0) {
+      return 0;
+    }
+    auto left_ptr = left_.data() + offset;
+    INDEX_T* right_ptr = nullptr;
+    if (TWO_BUFFER) {
+      right_ptr = right_.data() + offset;
+    }
+    const INDEX_T left_cnt = func(0, 0, cnt, left_ptr, right_ptr);
+    std::copy_n(left_ptr, left_cnt, out);
+    if (TWO_BUFFER) {
+      std::copy_n(right_ptr, cnt - left_cnt, out + left_cnt);
+    } else {
+      std::reverse_copy(left_ptr + left_cnt, left_ptr + cnt, out + left_cnt);
     }
     return left_cnt;
   }
 
  private:
   int num_threads_;
+  bool use_task_scheduler_ = false;
   INDEX_T min_block_size_;
   std::vector<INDEX_T> left_;
   std::vector<INDEX_T> right_;
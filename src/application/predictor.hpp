@@ -7,6 +7,7 @@
 
 #include <LightGBM/boosting.h>
 #include <LightGBM/dataset.h>
+#include <LightGBM/flat_forest.h>
 #include <LightGBM/meta.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/text_reader.h>
@@ -15,6 +16,7 @@
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -36,31 +38,52 @@ class Predictor {
   * \param is_raw_score True if need to predict result with raw score
   * \param predict_leaf_index True to output leaf index instead of prediction score
   * \param predict_contrib True to output feature contributions instead of prediction score
+  * \param predict_contrib_interactions True to output the SHAP interaction values instead of prediction score
+  * \param tree_blocking True to predict the dense rows by blocks of trees that fit in the L2 cache
+  * \param contrib_table_max_features Most distinct features on the path of a leaf with Fast TreeSHAP weights
+  * \param contrib_table_memory_mb Most memory of the Fast TreeSHAP weights of the model, in MB
   */
   Predictor(Boosting* boosting, int start_iteration, int num_iteration, bool is_raw_score,
-            bool predict_leaf_index, bool predict_contrib, bool early_stop,
-            int early_stop_freq, double early_stop_margin) {
+            bool predict_leaf_index, bool predict_contrib, bool predict_contrib_interactions, bool early_stop,
+            int early_stop_freq, double early_stop_margin, bool tree_blocking = false,
+            int contrib_table_max_features = 8, double contrib_table_memory_mb = 64.0) {
     early_stop_ = CreatePredictionEarlyStopInstance(
         "none", LightGBM::PredictionEarlyStopConfig());
+    // the flat forest predicts all the trees of the raw or converted scores
+    use_flat_forest_ = !predict_leaf_index && !predict_contrib && !predict_contrib_interactions;
+    is_raw_score_ = is_raw_score;
+    tree_blocking_ = tree_blocking;
+    start_iteration_ = start_iteration;
+    num_iteration_ = num_iteration;
+    has_early_stop_ = false;
     if (early_stop && !boosting->NeedAccuratePrediction()) {
-      PredictionEarlyStopConfig pred_early_stop_config;
+      has_early_stop_ = true;
       CHECK_GT(early_stop_freq, 0);
       CHECK_GE(early_stop_margin, 0);
-      pred_early_stop_config.margin_threshold = early_stop_margin;
-      pred_early_stop_config.round_period = early_stop_freq;
+      early_stop_config_.margin_threshold = early_stop_margin;
+      early_stop_config_.round_period = early_stop_freq;
       if (boosting->NumberOfClasses() == 1) {
         early_stop_ =
-            CreatePredictionEarlyStopInstance("binary", pred_early_stop_config);
+            CreatePredictionEarlyStopInstance("binary", early_stop_config_);
       } else {
         early_stop_ = CreatePredictionEarlyStopInstance("multiclass",
-                                                        pred_early_stop_config);
+                                                        early_stop_config_);
       }
     }
 
-    boosting->InitPredict(start_iteration, num_iteration, predict_contrib);
+    if (predict_contrib_interactions) {
+      const int64_t num_cols = boosting->MaxFeatureIdx() + 2;
+      if (num_cols * num_cols * boosting->NumModelPerIteration() > std::numeric_limits<int32_t>::max()) {
+        Log::Fatal("Too many features (%d) to predict the SHAP interaction values.", boosting->MaxFeatureIdx() + 1);
+      }
+    }
+    boosting->InitPredict(start_iteration, num_iteration, predict_contrib || predict_contrib_interactions);
+    if (predict_contrib || predict_contrib_interactions) {
+      boosting->PrecomputeContrib(contrib_table_max_features, contrib_table_memory_mb);
+    }
     boosting_ = boosting;
     num_pred_one_row_ = boosting_->NumPredictOneRow(start_iteration,
-        num_iteration, predict_leaf_index, predict_contrib);
+        num_iteration, predict_leaf_index, predict_contrib, predict_contrib_interactions);
     num_feature_ = boosting_->MaxFeatureIdx() + 1;
     predict_buf_.resize(
         OMP_NUM_THREADS(),
@@ -104,6 +127,23 @@ class Predictor {
         boosting_->PredictContribByMap(buf, output);
       };
 
+    } else if (predict_contrib_interactions) {
+      if (boosting_->IsLinear()) {
+        Log::Fatal("Predicting SHAP interaction values is not implemented for linear trees.");
+      }
+      predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
+                         double* output) {
+        int tid = omp_get_thread_num();
+        CopyToPredictBuffer(predict_buf_[tid].data(), features);
+        boosting_->PredictContribInteractions(predict_buf_[tid].data(), output);
+        ClearPredictBuffer(predict_buf_[tid].data(), predict_buf_[tid].size(),
+                           features);
+      };
+      predict_sparse_fun_ = [=](const std::vector<std::pair<int, double>>& features,
+                                std::vector<std::unordered_map<int, double>>* output) {
+        auto buf = CopyToPredictMap(features);
+        boosting_->PredictContribInteractionsByMap(buf, output);
+      };
     } else {
       if (is_raw_score) {
         predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
@@ -155,6 +195,57 @@ class Predictor {
     return predict_sparse_fun_;
   }
 
+  /*!
+  * \brief Predict the rows of a dense matrix with the flat forest of the model, the scores are
+  *        the same as the ones of the predict function
+  * \param data Matrix of num_row x num_col values
+  * \param num_row Number of rows
+  * \param num_col Number of columns, the missing features are zero
+  * \param is_row_major True for row-major data, false for column-major
+  * \param output num_pred_one_row scores per row
+  * \return False when the flat forest is not used, e.g. for leaf indices or for a few rows only,
+  *         and nothing was predicted
+  */
+  template <typename T>
+  bool PredictDenseRows(const T* data, data_size_t num_row, int num_col, bool is_row_major, double* output) {
+    // building the flat forest costs about as much as predicting a few rows
+    const data_size_t kMinNumRow = 32;
+    const data_size_t kMinBlockSize = 64;
+    if (!use_flat_forest_ || num_row < kMinNumRow) {
+      return false;
+    }
+    if (flat_forest_ == nullptr) {
+      // shared with the other predictors of the model
+      flat_forest_ = boosting_->GetFlatForest(start_iteration_, num_iteration_,
+                                              tree_blocking_ ? FlatForest::L2CacheSize() : 0,
+                                              has_early_stop_ ? &early_stop_config_ : nullptr);
+      if (flat_forest_ == nullptr) {
+        use_flat_forest_ = false;
+        return false;
+      }
+    }
+    // large blocks of rows with tree blocks, but enough blocks for all the threads
+    const int num_threads = OMP_NUM_THREADS();
+    const data_size_t block_size = std::max(kMinBlockSize, std::min(flat_forest_->row_block_size(),
+                                                                   (num_row + num_threads - 1) / num_threads));
+    const int num_block = (num_row + block_size - 1) / block_size;
+    const size_t row_stride = is_row_major ? static_cast<size_t>(num_col) : 1;
+    const size_t col_stride = is_row_major ? 1 : static_cast<size_t>(num_row);
+    OMP_INIT_EX();
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < num_block; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      const data_size_t start = block_size * i;
+      const data_size_t cnt = std::min(block_size, num_row - start);
+      // the rows are read in place, without the copy to the predict buffer
+      flat_forest_->Predict(data + row_stride * start, num_col, row_stride, col_stride, cnt, is_raw_score_,
+                            output + static_cast<size_t>(num_pred_one_row_) * start);
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+    return true;
+  }
+
   /*!
   * \brief predicting on data, then saving result to disk
   * \param data_filename Filename of data
@@ -290,6 +381,15 @@ class Predictor {
   PredictFunction predict_fun_;
   PredictSparseFunction predict_sparse_fun_;
   PredictionEarlyStopInstance early_stop_;
+  PredictionEarlyStopConfig early_stop_config_;
+  bool has_early_stop_;
+  int start_iteration_;
+  int num_iteration_;
+  /*! \brief taken from the model at the first call of PredictDenseRows */
+  std::shared_ptr<const FlatForest> flat_forest_;
+  bool use_flat_forest_;
+  bool is_raw_score_;
+  bool tree_blocking_;
   int num_feature_;
   int num_pred_one_row_;
   std::vector<std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>>> predict_buf_;
@@ -0,0 +1,576 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/flat_forest.h>
+#include <LightGBM/utils/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace LightGBM {
+
+namespace {
+
+/*! \brief Leaves of a QuickScorer tree, one bit each */
+const int kMaxQuickScorerLeaves = 64;
+/*! \brief Rows predicted together, the nodes of a tree stay in cache across them */
+const int kMaxBlockRows = 64;
+/*! \brief Bitvectors of a block of rows, 256KB */
+const int kMaxBlockMasks = 1 << 15;
+/*! \brief Rows per call of Predict without tree blocks, and at least with them */
+const data_size_t kDefaultRowBlockSize = 256;
+const data_size_t kMaxRowBlockSize = 4096;
+/*! \brief Node trees in a block for its rows to be mapped to bins, fewer trees compare the values directly */
+const int kMinBinnedTrees = 4;
+/*! \brief Bins of a feature, the last one is for NaN */
+const size_t kMaxBins = std::numeric_limits<uint16_t>::max() + 1;
+/*! \brief L2 cache of a core when the host does not report it */
+const size_t kDefaultCacheSize = 256 * 1024;
+
+/*! \brief Rows whose bitvectors are stored together, for num_masks trees */
+inline int BlockRows(int num_masks, int lanes) {
+  const int block_rows = std::min(kMaxBlockRows, kMaxBlockMasks / std::max(num_masks, 1));
+  return std::max(lanes, block_rows - block_rows % lanes);
+}
+
+inline int LowestSetBit(uint64_t x) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
+/*!
+* \brief Largest float not greater than threshold: a float v is <= this float exactly when
+*        static_cast<double>(v) <= threshold, as every float is exactly a double
+*/
+inline float FloatThreshold(double threshold) {
+  float result = static_cast<float>(threshold);
+  if (static_cast<double>(result) > threshold) {
+    result = std::nextafter(result, -std::numeric_limits<float>::infinity());
+  }
+  return result;
+}
+
+const float kZeroThresholdFloat = FloatThreshold(kZeroThreshold);
+
+/*! \brief Same decision as Tree::NumericalDecision, threshold is rounded with FloatThreshold for float values */
+template <typename T>
+inline bool NumericalGoesLeft(T fval, T threshold, int8_t decision_type) {
+  const uint8_t missing_type = Tree::GetMissingType(decision_type);
+  if (std::isnan(fval) && missing_type != MissingType::NaN) {
+    fval = 0.0f;
+  }
+  if ((missing_type == MissingType::Zero && Tree::IsZero(fval))
+      || (missing_type == MissingType::NaN && std::isnan(fval))) {
+    return Tree::GetDecisionType(decision_type, kDefaultLeftMask);
+  }
+  return fval <= threshold;
+}
+
+/*! \brief Same decision as Tree::NumericalDecision on the bins of the values, as Tree::NumericalDecisionInner */
+inline bool BinGoesLeft(uint16_t bin, uint16_t threshold_bin, uint16_t zero_bin, uint16_t nan_bin,
+                        int8_t decision_type) {
+  const uint8_t missing_type = Tree::GetMissingType(decision_type);
+  if (bin == nan_bin && missing_type != MissingType::NaN) {
+    bin = zero_bin;
+  }
+  if ((missing_type == MissingType::Zero && bin == zero_bin)
+      || (missing_type == MissingType::NaN && bin == nan_bin)) {
+    return Tree::GetDecisionType(decision_type, kDefaultLeftMask);
+  }
+  return bin <= threshold_bin;
+}
+
+/*! \brief Same value as in the sparse rows of the predictor, where the zeros are dropped */
+inline double ReadValue(double fval) {
+  return (std::fabs(fval) > kZeroThreshold || std::isnan(fval)) ? fval : 0.0f;
+}
+
+/*! \brief Same as the double value, without the conversion */
+inline float ReadValue(float fval) {
+  return (std::fabs(fval) > kZeroThresholdFloat || std::isnan(fval)) ? fval : 0.0f;
+}
+
+/*! \brief Values that may take the default side of a split, the others are compared with thresholds */
+template <typename T>
+inline bool IsMissingOrZero(T fval) {
+  return std::isnan(fval) || fval == 0.0f;
+}
+
+#ifdef LGBM_SIMD_X86
+/*!
+* \brief Sorted scan of the conditions of one feature for four rows at once: a row goes right
+*        at the conditions with a threshold smaller than its value. Rows with a missing or zero
+*        value are left to the scalar scan
+* \param fvals Values of the rows
+* \param masks Bitvector of tree t for the row of lane is at t * 4 + lane
+*/
+template <typename CONDITION>
+LGBM_TARGET_AVX2 void ScanConditionsAVX2(const CONDITION* cur, const CONDITION* end,
+                                         const double* fvals, uint64_t* masks) {
+  const __m256d fval = _mm256_loadu_pd(fvals);
+  // NaN compares false with every threshold, only the zeros have to be excluded
+  const __m256d is_regular = _mm256_cmp_pd(fval, _mm256_setzero_pd(), _CMP_NEQ_UQ);
+  for (; cur < end; ++cur) {
+    const __m256d goes_right = _mm256_and_pd(
+      _mm256_cmp_pd(fval, _mm256_set1_pd(cur->threshold), _CMP_GT_OQ), is_regular);
+    if (_mm256_movemask_pd(goes_right) == 0) {
+      break;
+    }
+    // leaves cleared in the lanes going right
+    const __m256i cleared = _mm256_and_si256(_mm256_castpd_si256(goes_right),
+                                             _mm256_set1_epi64x(static_cast<int64_t>(~cur->mask)));
+    __m256i* tree_masks = reinterpret_cast<__m256i*>(masks + static_cast<size_t>(cur->tree) * 4);
+    _mm256_storeu_si256(tree_masks, _mm256_andnot_si256(cleared, _mm256_loadu_si256(tree_masks)));
+  }
+}
+
+/*! \brief Same scan for float rows, the comparisons of the four lanes are widened to the 64-bit masks */
+template <typename CONDITION>
+LGBM_TARGET_AVX2 void ScanConditionsAVX2(const CONDITION* cur, const CONDITION* end,
+                                         const float* fvals, uint64_t* masks) {
+  const __m128 fval = _mm_loadu_ps(fvals);
+  const __m128 is_regular = _mm_cmp_ps(fval, _mm_setzero_ps(), _CMP_NEQ_UQ);
+  for (; cur < end; ++cur) {
+    const __m128 goes_right = _mm_and_ps(_mm_cmp_ps(fval, _mm_set1_ps(cur->threshold), _CMP_GT_OQ), is_regular);
+    if (_mm_movemask_ps(goes_right) == 0) {
+      break;
+    }
+    const __m256i cleared = _mm256_and_si256(_mm256_cvtepi32_epi64(_mm_castps_si128(goes_right)),
+                                             _mm256_set1_epi64x(static_cast<int64_t>(~cur->mask)));
+    __m256i* tree_masks = reinterpret_cast<__m256i*>(masks + static_cast<size_t>(cur->tree) * 4);
+    _mm256_storeu_si256(tree_masks, _mm256_andnot_si256(cleared, _mm256_loadu_si256(tree_masks)));
+  }
+}
+#endif  // LGBM_SIMD_X86
+
+}  // namespace
+
+const int FlatForest::kLanes;
+
+FlatForest::FlatForest(const std::vector<std::unique_ptr<Tree>>& models, int start_iteration,
+                       int num_iteration, int num_tree_per_iteration, int num_feature,
+                       bool average_output, const ObjectiveFunction* objective,
+                       const PredictionEarlyStopInstance* early_stop, size_t cache_size)
+    : num_feature_(num_feature), num_tree_per_iteration_(num_tree_per_iteration),
+      num_iteration_(num_iteration), average_output_(average_output), objective_(objective),
+      early_stop_period_(0), row_block_size_(kDefaultRowBlockSize) {
+  if (early_stop != nullptr && early_stop->round_period < num_iteration) {
+    early_stop_period_ = early_stop->round_period;
+    early_stop_callback_ = early_stop->callback_function;
+  }
+  const int start_tree = start_iteration * num_tree_per_iteration;
+  const int num_trees = num_iteration * num_tree_per_iteration;
+  // half of the cache for the trees of a block, the other half for the rows
+  const size_t block_bytes = cache_size / 2;
+  std::vector<std::vector<Condition>> feature_conditions(num_feature_);
+  trees_.resize(num_trees);
+  condition_begin_.push_back(0);
+  TreeBlock block = {0, 0, 0, 0, 0, 0, 0};
+  size_t cur_block_bytes = 0;
+  for (int i = 0; i < num_trees; ++i) {
+    const Tree* tree = models[start_tree + i].get();
+    bool is_numerical = true;
+    for (int node = 0; node < tree->num_leaves() - 1; ++node) {
+      if (!tree->IsNumericalSplit(node)) {
+        is_numerical = false;
+        break;
+      }
+    }
+    const bool is_quick_scorer = tree->num_leaves() > 1 && tree->num_leaves() <= kMaxQuickScorerLeaves
+                                 && is_numerical;
+    const size_t tree_bytes = (tree->num_leaves() - 1) * (is_quick_scorer ? sizeof(Condition) : sizeof(Node))
+                              + tree->num_leaves() * sizeof(double);
+    // the rows are checked for early stopping at the end of a block
+    const bool is_early_stop_check = early_stop_period_ > 0 && i % (early_stop_period_ * num_tree_per_iteration) == 0;
+    if (block.tree_end > block.tree_begin
+        && (is_early_stop_check || (block_bytes > 0 && cur_block_bytes + tree_bytes > block_bytes))) {
+      FinishTreeBlock(&feature_conditions, &block);
+      block = {i, i, 0, 0, 0, 0, 0};
+      cur_block_bytes = 0;
+    }
+    if (is_quick_scorer) {
+      AddQuickScorerTree(tree, block.num_quick_scorer_trees++, &feature_conditions, &trees_[i]);
+    } else {
+      AddNodeTree(tree, &trees_[i]);
+    }
+    block.tree_end = i + 1;
+    cur_block_bytes += tree_bytes;
+  }
+  if (block.tree_end > block.tree_begin) {
+    FinishTreeBlock(&feature_conditions, &block);
+  }
+  if (tree_blocks_.size() > 1) {
+    // a block of rows goes through every block of trees, as many rows as fit in the other half
+    const size_t row_bytes = static_cast<size_t>(std::max(num_feature_, 1)) * sizeof(double);
+    const data_size_t rows = static_cast<data_size_t>(
+      std::min<size_t>(kMaxRowBlockSize, block_bytes / row_bytes));
+    row_block_size_ = std::max(kDefaultRowBlockSize, rows - rows % kMaxBlockRows);
+  }
+}
+
+size_t FlatForest::L2CacheSize() {
+  static const size_t cache_size = []() {
+    int64_t size = 0;
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+    size = static_cast<int64_t>(sysconf(_SC_LEVEL2_CACHE_SIZE));
+#endif
+    return size > 0 ? static_cast<size_t>(size) : kDefaultCacheSize;
+  }();
+  return cache_size;
+}
+
+void FlatForest::FinishTreeBlock(std::vector<std::vector<Condition>>* feature_conditions, TreeBlock* block) {
+  block->feature_begin = static_cast<int>(condition_features_.size());
+  for (int feature = 0; feature < num_feature_; ++feature) {
+    auto& cur_conditions = (*feature_conditions)[feature];
+    if (cur_conditions.empty()) {
+      continue;
+    }
+    std::stable_sort(cur_conditions.begin(), cur_conditions.end(),
+                     [](const Condition& a, const Condition& b) { return a.threshold < b.threshold; });
+    conditions_.insert(conditions_.end(), cur_conditions.begin(), cur_conditions.end());
+    for (const Condition& condition : cur_conditions) {
+      // rounding down keeps the float thresholds sorted
+      float_conditions_.push_back({condition.mask, FloatThreshold(condition.threshold), condition.tree});
+    }
+    condition_features_.push_back(feature);
+    condition_begin_.push_back(static_cast<int>(conditions_.size()));
+    cur_conditions.clear();
+  }
+  block->feature_end = static_cast<int>(condition_features_.size());
+  AddBinColumns(block);
+  tree_blocks_.push_back(*block);
+}
+
+void FlatForest::AddBinColumns(TreeBlock* block) {
+  block->bin_column_begin = static_cast<int>(bin_columns_.size());
+  block->bin_column_end = block->bin_column_begin;
+  // the node trees of the block are the last ones added to the node array
+  int num_node_trees = 0;
+  int32_t node_begin = static_cast<int32_t>(nodes_.size());
+  for (int i = block->tree_begin; i < block->tree_end; ++i) {
+    if (trees_[i].quick_scorer_index < 0 && trees_[i].root >= 0) {
+      ++num_node_trees;
+      node_begin = std::min(node_begin, trees_[i].root);
+    }
+  }
+  if (num_node_trees < kMinBinnedTrees) {
+    return;
+  }
+  std::vector<std::vector<double>> feature_thresholds(num_feature_);
+  for (size_t node = node_begin; node < nodes_.size(); ++node) {
+    if (!Tree::GetDecisionType(nodes_[node].decision_type, kCategoricalMask)) {
+      feature_thresholds[nodes_[node].feature].push_back(nodes_[node].threshold);
+    }
+  }
+  std::vector<int> feature_columns(num_feature_, -1);
+  for (int feature = 0; feature < num_feature_; ++feature) {
+    auto& thresholds = feature_thresholds[feature];
+    if (thresholds.empty()) {
+      continue;
+    }
+    // the zeros have a bin of their own, read values are zero or outside [-kZeroThreshold, kZeroThreshold]
+    thresholds.push_back(-kZeroThreshold);
+    thresholds.push_back(kZeroThreshold);
+    std::sort(thresholds.begin(), thresholds.end());
+    thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+    if (thresholds.size() + 2 > kMaxBins) {
+      continue;
+    }
+    BinColumn column;
+    column.feature = feature;
+    column.threshold_begin = static_cast<int32_t>(bin_thresholds_.size());
+    bin_thresholds_.insert(bin_thresholds_.end(), thresholds.begin(), thresholds.end());
+    column.threshold_end = static_cast<int32_t>(bin_thresholds_.size());
+    column.zero_bin = static_cast<uint16_t>(std::lower_bound(thresholds.begin(), thresholds.end(), 0.0)
+                                            - thresholds.begin());
+    column.nan_bin = static_cast<uint16_t>(thresholds.size() + 1);
+    feature_columns[feature] = static_cast<int>(bin_columns_.size()) - block->bin_column_begin;
+    bin_columns_.push_back(column);
+  }
+  for (size_t node = node_begin; node < nodes_.size(); ++node) {
+    Node& cur = nodes_[node];
+    if (Tree::GetDecisionType(cur.decision_type, kCategoricalMask) || feature_columns[cur.feature] < 0) {
+      continue;
+    }
+    cur.bin_column = feature_columns[cur.feature];
+    // a value goes left when at most threshold_bin thresholds are smaller, i.e. up to this threshold
+    cur.threshold_bin = ValueToBin(bin_columns_[block->bin_column_begin + cur.bin_column], cur.threshold);
+  }
+  block->bin_column_end = static_cast<int>(bin_columns_.size());
+}
+
+inline uint16_t FlatForest::ValueToBin(const BinColumn& column, double fval) const {
+  if (std::isnan(fval)) {
+    return column.nan_bin;
+  }
+  const double* begin = bin_thresholds_.data() + column.threshold_begin;
+  return static_cast<uint16_t>(std::lower_bound(begin, bin_thresholds_.data() + column.threshold_end, fval) - begin);
+}
+
+void FlatForest::AddQuickScorerTree(const Tree* tree, int quick_scorer_index,
+                                    std::vector<std::vector<Condition>>* feature_conditions,
+                                    TreeInfo* info) {
+  info->quick_scorer_index = quick_scorer_index;
+  info->root = 0;
+  info->leaf_begin = static_cast<int32_t>(leaf_values_.size());
+  // numbers the leaves from left to right, and returns the first number after the subtree
+  std::function<int(int, int)> visit = [&](int node, int first_leaf) {
+    if (node < 0) {
+      leaf_values_.push_back(tree->LeafOutput(~node));
+      return first_leaf + 1;
+    }
+    const int right_first_leaf = visit(tree->left_child(node), first_leaf);
+    const int num_left_leaves = right_first_leaf - first_leaf;
+    Condition condition;
+    condition.threshold = tree->threshold(node);
+    condition.mask = ~(((static_cast<uint64_t>(1) << num_left_leaves) - 1) << first_leaf);
+    condition.tree = info->quick_scorer_index;
+    condition.decision_type = tree->decision_type(node);
+    (*feature_conditions)[tree->split_feature(node)].push_back(condition);
+    return visit(tree->right_child(node), right_first_leaf);
+  };
+  visit(0, 0);
+}
+
+void FlatForest::AddNodeTree(const Tree* tree, TreeInfo* info) {
+  info->quick_scorer_index = -1;
+  info->leaf_begin = 0;
+  if (tree->num_leaves() <= 1) {
+    leaf_values_.push_back(tree->LeafOutput(0));
+    info->root = ~static_cast<int32_t>(leaf_values_.size() - 1);
+    return;
+  }
+  // depth-first order, the left child of a node usually follows it in memory
+  std::function<int32_t(int)> visit = [&](int node) {
+    if (node < 0) {
+      leaf_values_.push_back(tree->LeafOutput(~node));
+      return ~static_cast<int32_t>(leaf_values_.size() - 1);
+    }
+    const int32_t index = static_cast<int32_t>(nodes_.size());
+    nodes_.emplace_back();
+    Node& cur = nodes_.back();
+    cur.threshold = tree->threshold(node);
+    cur.feature = tree->split_feature(node);
+    cur.decision_type = tree->decision_type(node);
+    cur.threshold_bin = 0;
+    if (tree->IsNumericalSplit(node)) {
+      cur.threshold_float = FloatThreshold(cur.threshold);
+      cur.bin_column = -1;
+    } else {
+      const auto bitset = tree->cat_threshold(node);
+      cur.cat_begin = static_cast<int32_t>(cat_bitsets_.size());
+      cur.cat_size = static_cast<int32_t>(bitset.size());
+      cat_bitsets_.insert(cat_bitsets_.end(), bitset.begin(), bitset.end());
+    }
+    // the children are added after this node, which may move it
+    const int32_t left = visit(tree->left_child(node));
+    nodes_[index].left = left;
+    const int32_t right = visit(tree->right_child(node));
+    nodes_[index].right = right;
+    return index;
+  };
+  info->root = visit(0);
+}
+
+template <typename T, typename CONDITION>
+void FlatForest::ComputeLeafMasks(const TreeBlock& block, const CONDITION* conditions, const T* fvals,
+                                  int num_lanes, uint64_t* masks) const {
+  std::fill(masks, masks + static_cast<size_t>(block.num_quick_scorer_trees) * kLanes, ~static_cast<uint64_t>(0));
+  const bool use_simd = num_lanes == kLanes && SIMD::Level() >= kSIMDAVX2;
+  for (int i = block.feature_begin; i < block.feature_end; ++i) {
+    const T* cur_fvals = fvals + (i - block.feature_begin) * kLanes;
+    const CONDITION* begin = conditions + condition_begin_[i];
+    const CONDITION* end = conditions + condition_begin_[i + 1];
+#ifdef LGBM_SIMD_X86
+    if (use_simd) {
+      ScanConditionsAVX2(begin, end, cur_fvals, masks);
+    }
+#endif
+    for (int lane = 0; lane < num_lanes; ++lane) {
+      const T fval = cur_fvals[lane];
+      uint64_t* lane_masks = masks + lane;
+      if (IsMissingOrZero(fval)) {
+        // missing values go to the default side of some splits, check them one by one,
+        // zero and NaN are the same in double for the float rows
+        const Condition* cur_end = conditions_.data() + condition_begin_[i + 1];
+        for (const Condition* cur = conditions_.data() + condition_begin_[i]; cur < cur_end; ++cur) {
+          if (!NumericalGoesLeft<double>(fval, cur->threshold, cur->decision_type)) {
+            lane_masks[cur->tree * kLanes] &= cur->mask;
+          }
+        }
+      } else if (!use_simd) {
+        // the row goes right exactly at the splits with a smaller threshold
+        for (const CONDITION* cur = begin; cur < end && fval > cur->threshold; ++cur) {
+          lane_masks[cur->tree * kLanes] &= cur->mask;
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+inline double FlatForest::NodeTreeOutput(const T* row, int num_col, size_t col_stride, const uint16_t* bins,
+                                         const BinColumn* bin_columns, int32_t node) const {
+  while (node >= 0) {
+    const Node& cur = nodes_[node];
+    if (!Tree::GetDecisionType(cur.decision_type, kCategoricalMask) && cur.bin_column >= 0) {
+      const BinColumn& column = bin_columns[cur.bin_column];
+      node = BinGoesLeft(bins[cur.bin_column], cur.threshold_bin, column.zero_bin, column.nan_bin, cur.decision_type)
+             ? cur.left : cur.right;
+      continue;
+    }
+    const T fval = cur.feature < num_col ? ReadValue(row[cur.feature * col_stride]) : 0.0f;
+    if (Tree::GetDecisionType(cur.decision_type, kCategoricalMask)) {
+      // same decision as Tree::CategoricalDecision
+      if (std::isnan(fval) || static_cast<int>(fval) < 0) {
+        node = cur.right;
+      } else if (Common::FindInBitset(cat_bitsets_.data() + cur.cat_begin, cur.cat_size,
+                                      static_cast<int>(fval))) {
+        node = cur.left;
+      } else {
+        node = cur.right;
+      }
+    } else {
+      const T threshold = std::is_same<T, float>::value ? static_cast<T>(cur.threshold_float)
+                                                        : static_cast<T>(cur.threshold);
+      node = NumericalGoesLeft(fval, threshold, cur.decision_type) ? cur.left : cur.right;
+    }
+  }
+  return leaf_values_[~node];
+}
+
+template <typename T>
+void FlatForest::Predict(const T* data, int num_col, size_t row_stride, size_t col_stride,
+                         data_size_t num_rows, bool is_raw_score, double* output) const {
+  const int num_class = num_tree_per_iteration_;
+  std::fill(output, output + static_cast<size_t>(num_rows) * num_class, 0.0f);
+  size_t max_masks = 0;
+  size_t max_bins = 0;
+  int max_condition_features = 0;
+  for (const TreeBlock& tree_block : tree_blocks_) {
+    const int num_masks = tree_block.num_quick_scorer_trees;
+    const int block_rows = BlockRows(num_masks, kLanes);
+    max_masks = std::max(max_masks, static_cast<size_t>(block_rows) * num_masks);
+    max_bins = std::max(max_bins, static_cast<size_t>(block_rows)
+                                  * (tree_block.bin_column_end - tree_block.bin_column_begin));
+    max_condition_features = std::max(max_condition_features, tree_block.feature_end - tree_block.feature_begin);
+  }
+  std::vector<uint64_t> masks(max_masks);
+  // bins of the rows for the node trees, each row is mapped once per tree block
+  std::vector<uint16_t> bins(max_bins);
+  // float rows stay in float, with the thresholds of float_conditions_
+  std::vector<T> fvals(static_cast<size_t>(max_condition_features) * kLanes);
+  const auto* conditions = ConditionsFor(data);
+  // rows still predicted, the ones stopped early are removed at the end of the tree blocks
+  std::vector<data_size_t> active_rows(num_rows);
+  std::iota(active_rows.begin(), active_rows.end(), 0);
+  data_size_t num_active_rows = num_rows;
+  // all the rows go through a block of trees before the next one, the trees are still summed
+  // in the order of the model, so every score is summed as in GBDT::PredictRaw
+  for (const TreeBlock& tree_block : tree_blocks_) {
+    const int num_masks = tree_block.num_quick_scorer_trees;
+    const int block_rows = BlockRows(num_masks, kLanes);
+    const BinColumn* bin_columns = bin_columns_.data() + tree_block.bin_column_begin;
+    const int num_bin_columns = tree_block.bin_column_end - tree_block.bin_column_begin;
+    for (data_size_t start = 0; start < num_active_rows; start += block_rows) {
+      const int cnt = static_cast<int>(std::min<data_size_t>(block_rows, num_active_rows - start));
+      const data_size_t* rows = active_rows.data() + start;
+      if (num_masks > 0) {
+        for (int group_start = 0; group_start < cnt; group_start += kLanes) {
+          const int num_lanes = std::min(kLanes, cnt - group_start);
+          for (int i = tree_block.feature_begin; i < tree_block.feature_end; ++i) {
+            const int feature = condition_features_[i];
+            T* cur_fvals = fvals.data() + (i - tree_block.feature_begin) * kLanes;
+            for (int lane = 0; lane < num_lanes; ++lane) {
+              cur_fvals[lane] = feature < num_col
+                ? ReadValue(data[rows[group_start + lane] * row_stride + feature * col_stride]) : 0.0f;
+            }
+          }
+          ComputeLeafMasks(tree_block, conditions, fvals.data(), num_lanes,
+                           masks.data() + static_cast<size_t>(group_start) * num_masks);
+        }
+      }
+      for (int r = 0; r < cnt && num_bin_columns > 0; ++r) {
+        const T* row = data + rows[r] * row_stride;
+        uint16_t* row_bins = bins.data() + static_cast<size_t>(r) * num_bin_columns;
+        for (int j = 0; j < num_bin_columns; ++j) {
+          const int feature = bin_columns[j].feature;
+          const T fval = feature < num_col ? ReadValue(row[feature * col_stride]) : 0.0f;
+          row_bins[j] = ValueToBin(bin_columns[j], static_cast<double>(fval));
+        }
+      }
+      for (int i = tree_block.tree_begin; i < tree_block.tree_end; ++i) {
+        const TreeInfo& info = trees_[i];
+        double* cur_output = output + i % num_class;
+        if (info.quick_scorer_index >= 0) {
+          const uint64_t* cur_masks = masks.data() + info.quick_scorer_index * kLanes;
+          const double* leaves = leaf_values_.data() + info.leaf_begin;
+          for (int r = 0; r < cnt; ++r) {
+            const uint64_t mask = cur_masks[(r - r % kLanes) * num_masks + r % kLanes];
+            cur_output[rows[r] * num_class] += leaves[LowestSetBit(mask)];
+          }
+        } else if (info.root < 0) {
+          const double value = leaf_values_[~info.root];
+          for (int r = 0; r < cnt; ++r) {
+            cur_output[rows[r] * num_class] += value;
+          }
+        } else {
+          for (int r = 0; r < cnt; ++r) {
+            cur_output[rows[r] * num_class] += NodeTreeOutput(data + rows[r] * row_stride, num_col, col_stride,
+                                                              bins.data() + static_cast<size_t>(r) * num_bin_columns,
+                                                              bin_columns, info.root);
+          }
+        }
+      }
+    }
+    // same checks as GBDT::PredictRaw, every early_stop_period_ iterations from the first one
+    if (early_stop_period_ > 0 && tree_block.tree_end % (early_stop_period_ * num_class) == 0
+        && tree_block.tree_end < static_cast<int>(trees_.size())) {
+      const auto is_stopped = [&](data_size_t row) {
+        return early_stop_callback_(output + static_cast<size_t>(row) * num_class, num_class);
+      };
+      num_active_rows = static_cast<data_size_t>(
+        std::remove_if(active_rows.begin(), active_rows.begin() + num_active_rows, is_stopped)
+        - active_rows.begin());
+    }
+  }
+  if (is_raw_score) {
+    return;
+  }
+  for (data_size_t i = 0; i < num_rows; ++i) {
+    double* cur_output = output + static_cast<size_t>(i) * num_class;
+    if (average_output_) {
+      for (int k = 0; k < num_class; ++k) {
+        cur_output[k] /= num_iteration_;
+      }
+    }
+    if (objective_ != nullptr) {
+      objective_->ConvertOutput(cur_output, cur_output);
+    }
+  }
+}
+
+template void FlatForest::Predict<float>(const float* data, int num_col, size_t row_stride, size_t col_stride,
+                                         data_size_t num_rows, bool is_raw_score, double* output) const;
+template void FlatForest::Predict<double>(const double* data, int num_col, size_t row_stride, size_t col_stride,
+                                          data_size_t num_rows, bool is_raw_score, double* output) const;
+
+}  // namespace LightGBM
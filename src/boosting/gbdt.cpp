@@ -50,6 +50,7 @@ void GBDT::Init(const Config* config, const Dataset* train_data, const Objective
                 const std::vector<const Metric*>& training_metrics) {
   CHECK_NOTNULL(train_data);
   train_data_ = train_data;
+  ClearFlatForests();
   if (!config->monotone_constraints.empty()) {
     CHECK_EQ(static_cast<size_t>(train_data_->num_total_features()), config->monotone_constraints.size());
   }
@@ -104,6 +105,7 @@ void GBDT::Init(const Config* config, const Dataset* train_data, const Objective
   training_metrics_.shrink_to_fit();
 
   train_score_updater_.reset(new ScoreUpdater(train_data_, num_tree_per_iteration_));
+  train_score_updater_->SetUseTaskScheduler(config_->use_task_scheduler);
 
   num_data_ = train_data_->num_data();
   // create buffer for gradients and Hessians
@@ -144,6 +146,7 @@ void GBDT::AddValidDataset(const Dataset* valid_data,
   }
   // for a validation dataset, we need its score and metric
   auto new_score_updater = std::unique_ptr<ScoreUpdater>(new ScoreUpdater(valid_data, num_tree_per_iteration_));
+  new_score_updater->SetUseTaskScheduler(config_->use_task_scheduler);
   // update score
   for (int i = 0; i < iter_; ++i) {
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
@@ -286,6 +289,7 @@ void GBDT::RefitTree(const std::vector<std::vector<int>>& tree_leaf_prediction)
   CHECK_GT(tree_leaf_prediction.size(), 0);
   CHECK_EQ(static_cast<size_t>(num_data_), tree_leaf_prediction.size());
   CHECK_EQ(static_cast<size_t>(models_.size()), tree_leaf_prediction[0].size());
+  ClearFlatForests();
   int num_iterations = static_cast<int>(models_.size() / num_tree_per_iteration_);
   std::vector<int> leaf_pred(num_data_);
   if (linear_tree_) {
@@ -368,6 +372,7 @@ double GBDT::BoostFromAverage(int class_id, bool update_scorer) {
 
 bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
   Common::FunctionTimer fun_timer("GBDT::TrainOneIter", global_timer);
+  ClearFlatForests();
   std::vector<double> init_scores(num_tree_per_iteration_, 0.0);
   // boosting first
   if (gradients == nullptr || hessians == nullptr) {
@@ -453,6 +458,7 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
 
 void GBDT::RollbackOneIter() {
   if (iter_ <= 0) { return; }
+  ClearFlatForests();
   // reset score
   for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
     auto curr_tree = models_.size() - num_tree_per_iteration_ + cur_tree_id;
@@ -628,6 +634,66 @@ void GBDT::PredictContribByMap(const std::unordered_map<int, double>& features,
   }
 }
 
+void GBDT::PredictContribInteractions(const double* features, double* output) const {
+  const int num_features = max_feature_idx_ + 1;
+  const int64_t num_cols = num_features + 1;
+  const int64_t matrix_size = num_cols * num_cols;
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_ * matrix_size);
+  // the main effects are what the interactions leave of the SHAP values
+  std::vector<double> contrib(num_tree_per_iteration_ * num_cols);
+  PredictContrib(features, contrib.data());
+  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
+  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      models_[i * num_tree_per_iteration_ + k]->PredictContribInteractions(features, num_features,
+                                                                          output + k * matrix_size);
+    }
+  }
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    double* matrix = output + k * matrix_size;
+    const double* cur_contrib = contrib.data() + k * num_cols;
+    for (int j = 0; j < num_features; ++j) {
+      double* row = matrix + j * num_cols;
+      double interactions = 0.0;
+      for (int l = 0; l < num_features; ++l) {
+        interactions += row[l];
+      }
+      row[j] = cur_contrib[j] - interactions;
+    }
+    matrix[num_features * num_cols + num_features] = cur_contrib[num_features];
+  }
+}
+
+void GBDT::PredictContribInteractionsByMap(const std::unordered_map<int, double>& features,
+                                           std::vector<std::unordered_map<int, double>>* output) const {
+  const int num_features = max_feature_idx_ + 1;
+  const int num_cols = num_features + 1;
+  std::vector<std::unordered_map<int, double>> contrib(num_tree_per_iteration_);
+  PredictContribByMap(features, &contrib);
+  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
+  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      models_[i * num_tree_per_iteration_ + k]->PredictContribInteractionsByMap(features, num_features,
+                                                                               &((*output)[k]));
+    }
+  }
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    std::unordered_map<int, double>& matrix = (*output)[k];
+    std::unordered_map<int, double> interactions;
+    for (const auto& element : matrix) {
+      interactions[element.first / num_cols] += element.second;
+    }
+    for (const auto& element : contrib[k]) {
+      const int j = element.first;
+      if (j == num_features) {
+        matrix[j * num_cols + j] = element.second;
+      } else {
+        matrix[j * num_cols + j] = element.second - interactions[j];
+      }
+    }
+  }
+}
+
 void GBDT::GetPredictAt(int data_idx, double* out_result, int64_t* out_len) {
   CHECK(data_idx >= 0 && data_idx <= static_cast<int>(valid_score_updater_.size()));
 
@@ -686,6 +752,7 @@ void GBDT::ResetTrainingData(const Dataset* train_data, const ObjectiveFunction*
   if (train_data != train_data_ && !train_data_->CheckAlign(*train_data)) {
     Log::Fatal("Cannot reset training data, since new training data has different bin mappers");
   }
+  ClearFlatForests();
 
   objective_function_ = objective_function;
   if (objective_function_ != nullptr) {
@@ -708,6 +775,7 @@ void GBDT::ResetTrainingData(const Dataset* train_data, const ObjectiveFunction*
     // not same training data, need reset score and others
     // create score tracker
     train_score_updater_.reset(new ScoreUpdater(train_data_, num_tree_per_iteration_));
+    train_score_updater_->SetUseTaskScheduler(config_->use_task_scheduler);
 
     // update score
     for (int i = 0; i < iter_; ++i) {
@@ -772,6 +840,12 @@ void GBDT::ResetConfig(const Config* config) {
       tree_learner_->SetForcedSplit(nullptr);
     }
   }
+  if (train_score_updater_ != nullptr) {
+    train_score_updater_->SetUseTaskScheduler(new_config->use_task_scheduler);
+  }
+  for (auto& score_updater : valid_score_updater_) {
+    score_updater->SetUseTaskScheduler(new_config->use_task_scheduler);
+  }
   config_.reset(new_config.release());
 }
 
@@ -62,6 +62,7 @@ class GBDT : public GBDTBase {
   */
   void MergeFrom(const Boosting* other) override {
     auto other_gbdt = reinterpret_cast<const GBDT*>(other);
+    ClearFlatForests();
     // tmp move to other vector
     auto original_models = std::move(models_);
     models_ = std::vector<std::unique_ptr<Tree>>();
@@ -86,6 +87,7 @@ class GBDT : public GBDTBase {
       end_iter = total_iter;
     }
     end_iter = std::min(total_iter, end_iter);
+    ClearFlatForests();
     auto original_models = std::move(models_);
     std::vector<int> indices(total_iter);
     for (int i = 0; i < total_iter; ++i) {
@@ -212,7 +214,8 @@ class GBDT : public GBDTBase {
   * \param is_pred_contrib True if predicting feature contribution
   * \return number of prediction
   */
-  inline int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib) const override {
+  inline int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib,
+                              bool is_pred_contrib_interactions) const override {
     int num_pred_in_one_row = num_class_;
     if (is_pred_leaf) {
       int max_iteration = GetCurrentIteration();
@@ -225,6 +228,8 @@ class GBDT : public GBDTBase {
       }
     } else if (is_pred_contrib) {
       num_pred_in_one_row = num_tree_per_iteration_ * (max_feature_idx_ + 2);  // +1 for 0-based indexing, +1 for baseline
+    } else if (is_pred_contrib_interactions) {
+      num_pred_in_one_row = num_tree_per_iteration_ * (max_feature_idx_ + 2) * (max_feature_idx_ + 2);
     }
     return num_pred_in_one_row;
   }
@@ -250,6 +255,11 @@ class GBDT : public GBDTBase {
   void PredictContribByMap(const std::unordered_map<int, double>& features,
                            std::vector<std::unordered_map<int, double>>* output) const override;
 
+  void PredictContribInteractions(const double* features, double* output) const override;
+
+  void PredictContribInteractionsByMap(const std::unordered_map<int, double>& features,
+                                       std::vector<std::unordered_map<int, double>>* output) const override;
+
   /*!
   * \brief Dump model to json format string
   * \param start_iteration The model will be saved start from
@@ -368,6 +378,7 @@ class GBDT : public GBDTBase {
     }
     start_iteration_for_pred_ = start_iteration;
     if (is_pred_contrib) {
+      std::lock_guard<std::mutex> lock(contrib_mutex_);
       #pragma omp parallel for schedule(static)
       for (int i = 0; i < static_cast<int>(models_.size()); ++i) {
         models_[i]->RecomputeMaxDepth();
@@ -375,6 +386,31 @@ class GBDT : public GBDTBase {
     }
   }
 
+  inline void PrecomputeContrib(int max_table_features, double table_memory_mb) override {
+    if (models_.empty()) {
+      return;
+    }
+    // an equal share of the memory for every tree, whatever the iterations predicted first
+    const int64_t max_table_size = static_cast<int64_t>(table_memory_mb * 1024 * 1024 / sizeof(double)
+                                                        / static_cast<double>(models_.size()));
+    const int start_tree = start_iteration_for_pred_ * num_tree_per_iteration_;
+    const int num_trees = num_iteration_for_pred_ * num_tree_per_iteration_;
+    // the Fast TreeSHAP data is kept across the predictors of the model
+    std::lock_guard<std::mutex> lock(contrib_mutex_);
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = start_tree; i < start_tree + num_trees; ++i) {
+      models_[i]->PrecomputeSHAP(max_table_features, max_table_size);
+    }
+  }
+
+  void FreePredictCache() override {
+    ClearFlatForests();
+    std::lock_guard<std::mutex> lock(contrib_mutex_);
+    for (auto& tree : models_) {
+      tree->FreeSHAP();
+    }
+  }
+
   inline double GetLeafValue(int tree_idx, int leaf_idx) const override {
     CHECK(tree_idx >= 0 && static_cast<size_t>(tree_idx) < models_.size());
     CHECK(leaf_idx >= 0 && leaf_idx < models_[tree_idx]->num_leaves());
@@ -384,6 +420,7 @@ class GBDT : public GBDTBase {
   inline void SetLeafValue(int tree_idx, int leaf_idx, double val) override {
     CHECK(tree_idx >= 0 && static_cast<size_t>(tree_idx) < models_.size());
     CHECK(leaf_idx >= 0 && leaf_idx < models_[tree_idx]->num_leaves());
+    ClearFlatForests();
     models_[tree_idx]->SetLeafOutput(leaf_idx, val);
   }
 
@@ -394,6 +431,9 @@ class GBDT : public GBDTBase {
 
   bool IsLinear() const override { return linear_tree_; }
 
+  std::shared_ptr<const FlatForest> GetFlatForest(int start_iteration, int num_iteration, size_t cache_size,
+                                                  const PredictionEarlyStopConfig* early_stop) const override;
+
  protected:
   virtual bool GetIsConstHessian(const ObjectiveFunction* objective_function) {
     if (objective_function != nullptr) {
@@ -402,6 +442,15 @@ class GBDT : public GBDTBase {
       return false;
     }
   }
+
+  /*!
+  * \brief Drop the cached flat forests, called whenever the trees change
+  */
+  void ClearFlatForests() {
+    std::lock_guard<std::mutex> lock(flat_forests_mutex_);
+    flat_forests_.clear();
+  }
+
   /*!
   * \brief Print eval result and check early stopping
   */
@@ -534,6 +583,21 @@ class GBDT : public GBDTBase {
   ParallelPartitionRunner<data_size_t, false> bagging_runner_;
   Json forced_splits_json_;
   bool linear_tree_;
+  /*! \brief Guards the Fast TreeSHAP data of the trees, computed by the first predictor of their contributions */
+  std::mutex contrib_mutex_;
+  /*! \brief Flat forest built for the predictors of some iterations */
+  struct CachedFlatForest {
+    int start_iteration;
+    int num_iteration;
+    size_t cache_size;
+    /*! \brief 0 without early stopping */
+    int early_stop_freq;
+    double early_stop_margin;
+    std::shared_ptr<const FlatForest> flat_forest;
+  };
+  /*! \brief Flat forests of the last predictors, most recent last, cleared when the trees change */
+  mutable std::vector<CachedFlatForest> flat_forests_;
+  mutable std::mutex flat_forests_mutex_;
 };
 
 }  // namespace LightGBM
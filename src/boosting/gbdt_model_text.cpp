@@ -415,6 +415,7 @@ bool GBDT::SaveModelToFile(int start_iteration, int num_iteration, int feature_i
 
 bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
   // use serialized string to restore this object
+  ClearFlatForests();
   models_.clear();
   auto c_str = buffer;
   auto p = c_str;
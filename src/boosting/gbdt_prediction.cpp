@@ -2,10 +2,14 @@
  * Copyright (c) 2017 Microsoft Corporation. All rights reserved.
  * Licensed under the MIT License. See LICENSE file in the project root for license information.
  */
+#include <LightGBM/flat_forest.h>
 #include <LightGBM/objective_function.h>
 #include <LightGBM/prediction_early_stop.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
+#include <memory>
+
 #include "gbdt.h"
 
 namespace LightGBM {
@@ -94,4 +98,47 @@ void GBDT::PredictLeafIndexByMap(const std::unordered_map<int, double>& features
   }
 }
 
+std::shared_ptr<const FlatForest> GBDT::GetFlatForest(int start_iteration, int num_iteration, size_t cache_size,
+                                                      const PredictionEarlyStopConfig* early_stop) const {
+  // the iterations of InitPredict
+  const int total_iteration = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  start_iteration = std::min(std::max(start_iteration, 0), total_iteration);
+  if (num_iteration > 0) {
+    num_iteration = std::min(num_iteration, total_iteration - start_iteration);
+  } else {
+    num_iteration = total_iteration - start_iteration;
+  }
+  const int early_stop_freq = early_stop != nullptr ? early_stop->round_period : 0;
+  const double early_stop_margin = early_stop != nullptr ? early_stop->margin_threshold : 0.0;
+  std::lock_guard<std::mutex> lock(flat_forests_mutex_);
+  for (const auto& cached : flat_forests_) {
+    if (cached.start_iteration == start_iteration && cached.num_iteration == num_iteration
+        && cached.cache_size == cache_size && cached.early_stop_freq == early_stop_freq
+        && cached.early_stop_margin == early_stop_margin) {
+      return cached.flat_forest;
+    }
+  }
+  const int start_tree = start_iteration * num_tree_per_iteration_;
+  const int num_trees = num_iteration * num_tree_per_iteration_;
+  std::shared_ptr<const FlatForest> flat_forest;
+  if (std::none_of(models_.begin() + start_tree, models_.begin() + start_tree + num_trees,
+                   [](const std::unique_ptr<Tree>& tree) { return tree->is_linear(); })) {
+    PredictionEarlyStopInstance early_stop_instance;
+    if (early_stop != nullptr) {
+      early_stop_instance = CreatePredictionEarlyStopInstance(num_class_ == 1 ? "binary" : "multiclass", *early_stop);
+    }
+    flat_forest.reset(new FlatForest(models_, start_iteration, num_iteration, num_tree_per_iteration_,
+                                     max_feature_idx_ + 1, average_output_, objective_function_,
+                                     early_stop != nullptr ? &early_stop_instance : nullptr, cache_size));
+  }
+  // a few iterations ranges and settings, each flat forest holds a copy of its trees
+  const size_t kMaxNumFlatForests = 4;
+  if (flat_forests_.size() >= kMaxNumFlatForests) {
+    flat_forests_.erase(flat_forests_.begin());
+  }
+  flat_forests_.push_back({start_iteration, num_iteration, cache_size, early_stop_freq, early_stop_margin,
+                           flat_forest});
+  return flat_forest;
+}
+
 }  // namespace LightGBM
@@ -9,7 +9,6 @@
 #include <limits>
 #include <algorithm>
 #include <cmath>
-#include <vector>
 
 namespace LightGBM {
 
@@ -32,14 +31,19 @@ PredictionEarlyStopInstance CreateMulticlass(const PredictionEarlyStopConfig& co
       Log::Fatal("Multiclass early stopping needs predictions to be of length two or larger");
     }
 
-    // copy and sort
-    std::vector<double> votes(static_cast<size_t>(sz));
-    for (int i = 0; i < sz; ++i) {
-      votes[i] = pred[i];
+    // the two largest votes, without copying them
+    double first = std::max(pred[0], pred[1]);
+    double second = std::min(pred[0], pred[1]);
+    for (int i = 2; i < sz; ++i) {
+      if (pred[i] > first) {
+        second = first;
+        first = pred[i];
+      } else if (pred[i] > second) {
+        second = pred[i];
+      }
     }
-    std::partial_sort(votes.begin(), votes.begin() + 2, votes.end(), std::greater<double>());
 
-    const auto margin = votes[0] - votes[1];
+    const auto margin = first - second;
 
     if (margin > margin_threshold) {
       return true;
@@ -101,6 +101,7 @@ class RF : public GBDT {
   }
 
   bool TrainOneIter(const score_t* gradients, const score_t* hessians) override {
+    ClearFlatForests();
     // bagging logic
     Bagging(iter_);
     CHECK_EQ(gradients, nullptr);
@@ -166,6 +167,7 @@ class RF : public GBDT {
 
   void RollbackOneIter() override {
     if (iter_ <= 0) { return; }
+    ClearFlatForests();
     int cur_iter = iter_ + num_init_iteration_ - 1;
     // reset score
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
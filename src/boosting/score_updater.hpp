@@ -10,6 +10,7 @@
 #include <LightGBM/tree.h>
 #include <LightGBM/tree_learner.h>
 #include <LightGBM/utils/openmp_wrapper.h>
+#include <LightGBM/utils/threading.h>
 
 #include <cstring>
 #include <vector>
@@ -51,9 +52,20 @@ class ScoreUpdater {
 
   inline bool has_init_score() const { return has_init_score_; }
 
+  /*! \brief Run the loops over the data as tasks of the TaskScheduler instead of OpenMP loops */
+  inline void SetUseTaskScheduler(bool use_task_scheduler) { use_task_scheduler_ = use_task_scheduler; }
+
   inline void AddScore(double val, int cur_tree_id) {
     Common::FunctionTimer fun_timer("ScoreUpdater::AddScore", global_timer);
     const size_t offset = static_cast<size_t>(num_data_) * cur_tree_id;
+    if (use_task_scheduler_) {
+      Threading::TaskFor<data_size_t>(num_data_, 1024, [&](data_size_t start, data_size_t end) {
+        for (data_size_t i = start; i < end; ++i) {
+          score_[offset + i] += val;
+        }
+      });
+      return;
+    }
 #pragma omp parallel for schedule(static, 512) if (num_data_ >= 1024)
     for (int i = 0; i < num_data_; ++i) {
       score_[offset + i] += val;
@@ -62,6 +74,14 @@ class ScoreUpdater {
 
   inline void MultiplyScore(double val, int cur_tree_id) {
     const size_t offset = static_cast<size_t>(num_data_) * cur_tree_id;
+    if (use_task_scheduler_) {
+      Threading::TaskFor<data_size_t>(num_data_, 1024, [&](data_size_t start, data_size_t end) {
+        for (data_size_t i = start; i < end; ++i) {
+          score_[offset + i] *= val;
+        }
+      });
+      return;
+    }
 #pragma omp parallel for schedule(static, 512) if (num_data_ >= 1024)
     for (int i = 0; i < num_data_; ++i) {
       score_[offset + i] *= val;
@@ -122,6 +142,7 @@ class ScoreUpdater {
   /*! \brief Scores for data set */
   std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>> score_;
   bool has_init_score_;
+  bool use_task_scheduler_ = false;
 };
 
 }  // namespace LightGBM
@@ -16,11 +16,15 @@
 #include <LightGBM/utils/log.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/random.h>
+#include <LightGBM/utils/simd.h>
 #include <LightGBM/utils/threading.h>
 
 #include <string>
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
@@ -59,28 +63,48 @@ const int PREDICTOR_TYPES = 4;
 // Single row predictor to abstract away caching logic
 class SingleRowPredictor {
  public:
-  PredictFunction predict_function;
   int64_t num_pred_in_one_row;
 
   SingleRowPredictor(int predict_type, Boosting* boosting, const Config& config, int start_iter, int num_iter) {
     bool is_predict_leaf = false;
-    bool is_raw_score = false;
     bool predict_contrib = false;
+    bool predict_contrib_interactions = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
-    } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
-      is_raw_score = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+      if (boosting->IsLinear()) {
+        Log::Fatal("Predicting SHAP feature contributions is not implemented for linear trees.");
+      }
+    } else if (predict_type == C_API_PREDICT_CONTRIB_INTERACTIONS) {
+      predict_contrib_interactions = true;
+      if (boosting->IsLinear()) {
+        Log::Fatal("Predicting SHAP interaction values is not implemented for linear trees.");
+      }
     }
     early_stop_ = config.pred_early_stop;
     early_stop_freq_ = config.pred_early_stop_freq;
     early_stop_margin_ = config.pred_early_stop_margin;
     iter_ = num_iter;
-    predictor_.reset(new Predictor(boosting, start_iter, iter_, is_raw_score, is_predict_leaf, predict_contrib,
-                                   early_stop_, early_stop_freq_, early_stop_margin_));
-    num_pred_in_one_row = boosting->NumPredictOneRow(start_iter, iter_, is_predict_leaf, predict_contrib);
-    predict_function = predictor_->GetPredictFunction();
+    early_stop_instance_ = CreatePredictionEarlyStopInstance("none", PredictionEarlyStopConfig());
+    if (early_stop_ && !boosting->NeedAccuratePrediction()) {
+      PredictionEarlyStopConfig pred_early_stop_config;
+      CHECK_GT(early_stop_freq_, 0);
+      CHECK_GE(early_stop_margin_, 0);
+      pred_early_stop_config.margin_threshold = early_stop_margin_;
+      pred_early_stop_config.round_period = early_stop_freq_;
+      early_stop_instance_ = CreatePredictionEarlyStopInstance(boosting->NumberOfClasses() == 1 ? "binary" : "multiclass",
+                                                               pred_early_stop_config);
+    }
+    boosting->InitPredict(start_iter, iter_, predict_contrib || predict_contrib_interactions);
+    if (predict_contrib || predict_contrib_interactions) {
+      boosting->PrecomputeContrib(config.pred_contrib_table_max_features, config.pred_contrib_table_memory_mb);
+    }
+    boosting_ = boosting;
+    predict_type_ = predict_type;
+    num_feature_ = boosting->MaxFeatureIdx() + 1;
+    num_pred_in_one_row = boosting->NumPredictOneRow(start_iter, iter_, is_predict_leaf, predict_contrib,
+                                                     predict_contrib_interactions);
     num_total_model_ = boosting->NumberOfTotalModel();
   }
 
@@ -94,8 +118,105 @@ class SingleRowPredictor {
       num_total_model_ == boosting->NumberOfTotalModel();
   }
 
+  /*!
+  * \brief Predict one dense row, read in place: no pair vector and no allocation once the
+  *        buffer of the calling thread is large enough
+  */
+  void PredictDenseRow(const void* data, int data_type, int32_t ncol, double* out_result) const {
+    double* buf = PredictBuffer(num_feature_);
+    const int num_value = std::min(ncol, num_feature_);
+    if (data_type == C_API_DTYPE_FLOAT32) {
+      CopyDenseRow(reinterpret_cast<const float*>(data), num_value, buf);
+    } else if (data_type == C_API_DTYPE_FLOAT64) {
+      CopyDenseRow(reinterpret_cast<const double*>(data), num_value, buf);
+    } else {
+      Log::Fatal("Unknown data type in PredictDenseRow");
+    }
+    Predict(buf, out_result);
+    std::memset(buf, 0, sizeof(double) * num_value);
+  }
+
+  /*! \brief Predict one row in CSR format, without the map or pair vector of a sparse row */
+  void PredictCSRRow(const void* indptr, int indptr_type, const int32_t* indices, const void* data,
+                     int data_type, double* out_result) const {
+    int64_t start = 0;
+    int64_t end = 0;
+    if (indptr_type == C_API_DTYPE_INT32) {
+      start = reinterpret_cast<const int32_t*>(indptr)[0];
+      end = reinterpret_cast<const int32_t*>(indptr)[1];
+    } else if (indptr_type == C_API_DTYPE_INT64) {
+      start = reinterpret_cast<const int64_t*>(indptr)[0];
+      end = reinterpret_cast<const int64_t*>(indptr)[1];
+    } else {
+      Log::Fatal("Unknown indptr type in PredictCSRRow");
+    }
+    double* buf = PredictBuffer(num_feature_);
+    if (data_type == C_API_DTYPE_FLOAT32) {
+      CopySparseRow(reinterpret_cast<const float*>(data), indices, start, end, buf);
+    } else if (data_type == C_API_DTYPE_FLOAT64) {
+      CopySparseRow(reinterpret_cast<const double*>(data), indices, start, end, buf);
+    } else {
+      Log::Fatal("Unknown data type in PredictCSRRow");
+    }
+    Predict(buf, out_result);
+    for (int64_t i = start; i < end; ++i) {
+      if (indices[i] >= 0 && indices[i] < num_feature_) {
+        buf[indices[i]] = 0.0f;
+      }
+    }
+  }
+
  private:
-  std::unique_ptr<Predictor> predictor_;
+  /*!
+  * \brief Dense feature buffer of the calling thread, shared by all the predictors and kept at
+  *        zero between calls. It only grows, and works for threads not started by OpenMP
+  */
+  static double* PredictBuffer(int num_feature) {
+    static thread_local std::vector<double> buf;
+    if (buf.size() < static_cast<size_t>(num_feature)) {
+      buf.resize(num_feature, 0.0f);
+    }
+    return buf.data();
+  }
+
+  template <typename T>
+  static void CopyDenseRow(const T* data, int num_value, double* buf) {
+    for (int i = 0; i < num_value; ++i) {
+      const double value = static_cast<double>(data[i]);
+      // same values as the sparse rows of the predictor
+      if (std::fabs(value) > kZeroThreshold || std::isnan(value)) {
+        buf[i] = value;
+      }
+    }
+  }
+
+  template <typename T>
+  void CopySparseRow(const T* data, const int32_t* indices, int64_t start, int64_t end, double* buf) const {
+    for (int64_t i = start; i < end; ++i) {
+      if (indices[i] >= 0 && indices[i] < num_feature_) {
+        buf[indices[i]] = static_cast<double>(data[i]);
+      }
+    }
+  }
+
+  void Predict(const double* features, double* out_result) const {
+    if (predict_type_ == C_API_PREDICT_LEAF_INDEX) {
+      boosting_->PredictLeafIndex(features, out_result);
+    } else if (predict_type_ == C_API_PREDICT_CONTRIB) {
+      boosting_->PredictContrib(features, out_result);
+    } else if (predict_type_ == C_API_PREDICT_CONTRIB_INTERACTIONS) {
+      boosting_->PredictContribInteractions(features, out_result);
+    } else if (predict_type_ == C_API_PREDICT_RAW_SCORE) {
+      boosting_->PredictRaw(features, out_result, &early_stop_instance_);
+    } else {
+      boosting_->Predict(features, out_result, &early_stop_instance_);
+    }
+  }
+
+  const Boosting* boosting_;
+  PredictionEarlyStopInstance early_stop_instance_;
+  int predict_type_;
+  int num_feature_;
   bool early_stop_;
   int early_stop_freq_;
   double early_stop_margin_;
@@ -103,6 +224,39 @@ class SingleRowPredictor {
   int num_total_model_;
 };
 
+/*!
+* \brief Immutable copy of a model for single-row prediction, see LGBM_BoosterCreatePredictor.
+*        It owns its trees, so later training or reloading of the booster does not affect it,
+*        and any number of threads can predict with it without locking
+*/
+class PredictorSnapshot {
+ public:
+  PredictorSnapshot(const std::string& model_str, int predict_type, int data_type, int32_t ncol,
+                    const Config& config) : data_type_(data_type), ncol_(ncol) {
+    boosting_.reset(Boosting::CreateBoosting("gbdt", nullptr));
+    boosting_->LoadModelFromString(model_str.c_str(), model_str.size());
+    // the copy holds the selected iterations only
+    predictor_.reset(new SingleRowPredictor(predict_type, boosting_.get(), config, 0, -1));
+  }
+
+  void PredictDenseRow(const void* data, double* out_result, int64_t* out_len) const {
+    predictor_->PredictDenseRow(data, data_type_, ncol_, out_result);
+    *out_len = predictor_->num_pred_in_one_row;
+  }
+
+  void PredictCSRRow(const void* indptr, int indptr_type, const int32_t* indices, const void* data,
+                     double* out_result, int64_t* out_len) const {
+    predictor_->PredictCSRRow(indptr, indptr_type, indices, data, data_type_, out_result);
+    *out_len = predictor_->num_pred_in_one_row;
+  }
+
+ private:
+  std::unique_ptr<Boosting> boosting_;
+  std::unique_ptr<SingleRowPredictor> predictor_;
+  const int data_type_;
+  const int32_t ncol_;
+};
+
 class Booster {
  public:
   explicit Booster(const char* filename) {
@@ -116,6 +270,9 @@ class Booster {
     if (config_.num_threads > 0) {
       omp_set_num_threads(config_.num_threads);
     }
+    if (param.count("simd_level")) {
+      SIMD::SetLevel(config_.simd_level);
+    }
     // create boosting
     if (config_.input_model.size() > 0) {
       Log::Warning("Continued train from model is not supported for c_api,\n"
@@ -317,6 +474,9 @@ class Booster {
     if (config_.num_threads > 0) {
       omp_set_num_threads(config_.num_threads);
     }
+    if (param.count("simd_level")) {
+      SIMD::SetLevel(config_.simd_level);
+    }
 
     if (param.count("objective")) {
       // create objective function
@@ -385,21 +545,42 @@ class Booster {
       }
   }
 
-  void PredictSingleRow(int predict_type, int ncol,
-               std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
-               const Config& config,
-               double* out_result, int64_t* out_len) const {
+  void PredictSingleRow(int predict_type, int ncol, const void* data, int data_type,
+                        const Config& config, double* out_result, int64_t* out_len) const {
+    CheckSingleRowShape(ncol, config);
+    // the row is read in the buffer of the calling thread, so predictions can run concurrently
+    SHARED_LOCK(mutex_)
+    const auto& single_row_predictor = single_row_predictor_[predict_type];
+    single_row_predictor->PredictDenseRow(data, data_type, ncol, out_result);
+    *out_len = single_row_predictor->num_pred_in_one_row;
+  }
+
+  void PredictSingleRowCSR(int predict_type, int ncol, const void* indptr, int indptr_type,
+                           const int32_t* indices, const void* data, int data_type,
+                           const Config& config, double* out_result, int64_t* out_len) const {
+    CheckSingleRowShape(ncol, config);
+    SHARED_LOCK(mutex_)
+    const auto& single_row_predictor = single_row_predictor_[predict_type];
+    single_row_predictor->PredictCSRRow(indptr, indptr_type, indices, data, data_type, out_result);
+    *out_len = single_row_predictor->num_pred_in_one_row;
+  }
+
+  void CheckSingleRowShape(int ncol, const Config& config) const {
     if (!config.predict_disable_shape_check && ncol != boosting_->MaxFeatureIdx() + 1) {
       Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).\n"\
                  "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", ncol, boosting_->MaxFeatureIdx() + 1);
     }
-    UNIQUE_LOCK(mutex_)
-    const auto& single_row_predictor = single_row_predictor_[predict_type];
-    auto one_row = get_row_fun(0);
-    auto pred_wrt_ptr = out_result;
-    single_row_predictor->predict_function(one_row, pred_wrt_ptr);
+  }
 
-    *out_len = single_row_predictor->num_pred_in_one_row;
+  PredictorSnapshot* CreatePredictorSnapshot(int start_iteration, int num_iteration, int predict_type,
+                                             int data_type, int32_t ncol, const Config& config) const {
+    CheckSingleRowShape(ncol, config);
+    std::string model_str;
+    {
+      SHARED_LOCK(mutex_);
+      model_str = boosting_->SaveModelToString(start_iteration, num_iteration, C_API_FEATURE_IMPORTANCE_SPLIT);
+    }
+    return new PredictorSnapshot(model_str, predict_type, data_type, ncol, config);
   }
 
   Predictor CreatePredictor(int start_iteration, int num_iteration, int predict_type, int ncol, const Config& config) const {
@@ -410,18 +591,24 @@ class Booster {
     bool is_predict_leaf = false;
     bool is_raw_score = false;
     bool predict_contrib = false;
+    bool predict_contrib_interactions = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
     } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
       is_raw_score = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+    } else if (predict_type == C_API_PREDICT_CONTRIB_INTERACTIONS) {
+      predict_contrib_interactions = true;
     } else {
       is_raw_score = false;
     }
 
     return Predictor(boosting_.get(), start_iteration, num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                     predict_contrib_interactions,
+                     config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                     config.pred_tree_blocking, config.pred_contrib_table_max_features,
+                     config.pred_contrib_table_memory_mb);
   }
 
   void Predict(int start_iteration, int num_iteration, int predict_type, int nrow, int ncol,
@@ -430,15 +617,41 @@ class Booster {
                double* out_result, int64_t* out_len) const {
     SHARED_LOCK(mutex_);
     auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config);
-    bool is_predict_leaf = false;
-    bool predict_contrib = false;
-    if (predict_type == C_API_PREDICT_LEAF_INDEX) {
-      is_predict_leaf = true;
-    } else if (predict_type == C_API_PREDICT_CONTRIB) {
-      predict_contrib = true;
+    PredictRows(&predictor, start_iteration, num_iteration, predict_type, nrow, get_row_fun,
+                out_result, out_len);
+  }
+
+  void PredictForMat(int start_iteration, int num_iteration, int predict_type, const void* data,
+                     int data_type, int nrow, int ncol, int is_row_major,
+                     std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
+                     const Config& config, double* out_result, int64_t* out_len) const {
+    SHARED_LOCK(mutex_);
+    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config);
+    bool is_predicted = false;
+    if (data_type == C_API_DTYPE_FLOAT32) {
+      is_predicted = predictor.PredictDenseRows(reinterpret_cast<const float*>(data), nrow, ncol,
+                                                is_row_major != 0, out_result);
+    } else if (data_type == C_API_DTYPE_FLOAT64) {
+      is_predicted = predictor.PredictDenseRows(reinterpret_cast<const double*>(data), nrow, ncol,
+                                                is_row_major != 0, out_result);
     }
-    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration, is_predict_leaf, predict_contrib);
-    auto pred_fun = predictor.GetPredictFunction();
+    if (is_predicted) {
+      *out_len = static_cast<int64_t>(boosting_->NumPredictOneRow(start_iteration, num_iteration, false, false, false)) * nrow;
+      return;
+    }
+    // the sparse rows of the other types of predictions
+    PredictRows(&predictor, start_iteration, num_iteration, predict_type, nrow, get_row_fun,
+                out_result, out_len);
+  }
+
+  void PredictRows(Predictor* predictor, int start_iteration, int num_iteration, int predict_type, int nrow,
+                   std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
+                   double* out_result, int64_t* out_len) const {
+    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration,
+                                                              predict_type == C_API_PREDICT_LEAF_INDEX,
+                                                              predict_type == C_API_PREDICT_CONTRIB,
+                                                              predict_type == C_API_PREDICT_CONTRIB_INTERACTIONS);
+    auto pred_fun = predictor->GetPredictFunction();
     OMP_INIT_EX();
     #pragma omp parallel for schedule(static)
     for (int i = 0; i < nrow; ++i) {
@@ -597,7 +810,17 @@ class Booster {
     auto pred_sparse_fun = predictor.GetPredictSparseFunction();
     bool is_col_ptr_int32 = false;
     bool is_data_float32 = false;
-    int num_output_cols = ncol + 1;
+    // the contributions are indexed by the features of the model, whatever ncol is with
+    // predict_disable_shape_check=true, the sparse interaction matrix of a row is flattened
+    // in one row of (num_features + 1)^2 columns
+    int64_t num_output_cols_64 = boosting_->MaxFeatureIdx() + 2;
+    if (predict_type == C_API_PREDICT_CONTRIB_INTERACTIONS) {
+      num_output_cols_64 *= num_output_cols_64;
+    }
+    if ((num_output_cols_64 + 1) * num_matrices > std::numeric_limits<int32_t>::max()) {
+      Log::Fatal("Too many features (%d) to predict the contributions in CSC format", boosting_->MaxFeatureIdx() + 1);
+    }
+    const int num_output_cols = static_cast<int>(num_output_cols_64);
     int col_ptr_size = (num_output_cols + 1) * num_matrices;
     if (col_ptr_type == C_API_DTYPE_INT32) {
       *out_col_ptr = new int32_t[col_ptr_size];
@@ -701,17 +924,22 @@ class Booster {
     bool is_predict_leaf = false;
     bool is_raw_score = false;
     bool predict_contrib = false;
+    bool predict_contrib_interactions = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
     } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
       is_raw_score = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+    } else if (predict_type == C_API_PREDICT_CONTRIB_INTERACTIONS) {
+      predict_contrib_interactions = true;
     } else {
       is_raw_score = false;
     }
     Predictor predictor(boosting_.get(), start_iteration, num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        predict_contrib_interactions, config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_tree_blocking, config.pred_contrib_table_max_features,
+                        config.pred_contrib_table_memory_mb);
     bool bool_data_has_header = data_has_header > 0 ? true : false;
     predictor.Predict(data_filename, result_filename, bool_data_has_header, config.predict_disable_shape_check,
                       config.precise_float_parser);
@@ -766,6 +994,11 @@ class Booster {
     dynamic_cast<GBDTBase*>(boosting_.get())->SetLeafValue(tree_idx, leaf_idx, val);
   }
 
+  void FreePredictCache() {
+    UNIQUE_LOCK(mutex_)
+    boosting_->FreePredictCache();
+  }
+
   void ShuffleModels(int start_iter, int end_iter) {
     UNIQUE_LOCK(mutex_)
     boosting_->ShuffleModels(start_iter, end_iter);
@@ -848,6 +1081,7 @@ using LightGBM::kZeroThreshold;
 using LightGBM::LGBM_APIHandleException;
 using LightGBM::Log;
 using LightGBM::Network;
+using LightGBM::PredictorSnapshot;
 using LightGBM::Random;
 using LightGBM::ReduceScatterFunction;
 
@@ -1834,7 +2068,15 @@ int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
   API_BEGIN();
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
   *out_len = static_cast<int64_t>(num_row) * ref_booster->GetBoosting()->NumPredictOneRow(start_iteration,
-    num_iteration, predict_type == C_API_PREDICT_LEAF_INDEX, predict_type == C_API_PREDICT_CONTRIB);
+    num_iteration, predict_type == C_API_PREDICT_LEAF_INDEX, predict_type == C_API_PREDICT_CONTRIB,
+    predict_type == C_API_PREDICT_CONTRIB_INTERACTIONS);
+  API_END();
+}
+
+int LGBM_BoosterFreePredictCache(BoosterHandle handle) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->FreePredictCache();
   API_END();
 }
 
@@ -1864,6 +2106,23 @@ struct FastConfig {
   const int32_t ncol;
 };
 
+/*!
+* \brief Config of the parameters of the single-row predictions of the calling thread. It is parsed
+*        again only when the parameter string changes, so that repeated calls do not allocate
+*/
+static inline const Config& SingleRowConfig(const char* parameter) {
+  static thread_local std::string last_parameter;
+  static thread_local std::unique_ptr<Config> config;
+  const char* parameter_str = parameter == nullptr ? "" : parameter;
+  if (config == nullptr || last_parameter != parameter_str) {
+    std::unique_ptr<Config> new_config(new Config());
+    new_config->Set(Config::Str2Map(parameter_str));
+    config = std::move(new_config);
+    last_parameter = parameter_str;
+  }
+  return *config;
+}
+
 int LGBM_FastConfigFree(FastConfigHandle fastConfig) {
   API_BEGIN();
   delete reinterpret_cast<FastConfig*>(fastConfig);
@@ -1997,8 +2256,8 @@ int LGBM_BoosterPredictForCSRSingleRow(BoosterHandle handle,
                                        const int32_t* indices,
                                        const void* data,
                                        int data_type,
-                                       int64_t nindptr,
-                                       int64_t nelem,
+                                       int64_t,
+                                       int64_t,
                                        int64_t num_col,
                                        int predict_type,
                                        int start_iteration,
@@ -2012,16 +2271,14 @@ int LGBM_BoosterPredictForCSRSingleRow(BoosterHandle handle,
   } else if (num_col >= INT32_MAX) {
     Log::Fatal("The number of columns should be smaller than INT32_MAX.");
   }
-  auto param = Config::Str2Map(parameter);
-  Config config;
-  config.Set(param);
+  const Config& config = SingleRowConfig(parameter);
   if (config.num_threads > 0) {
     omp_set_num_threads(config.num_threads);
   }
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
   ref_booster->SetSingleRowPredictor(start_iteration, num_iteration, predict_type, config);
-  ref_booster->PredictSingleRow(predict_type, static_cast<int32_t>(num_col), get_row_fun, config, out_result, out_len);
+  ref_booster->PredictSingleRowCSR(predict_type, static_cast<int32_t>(num_col), indptr, indptr_type, indices, data,
+                                   data_type, config, out_result, out_len);
   API_END();
 }
 
@@ -2062,15 +2319,14 @@ int LGBM_BoosterPredictForCSRSingleRowFast(FastConfigHandle fastConfig_handle,
                                            const int indptr_type,
                                            const int32_t* indices,
                                            const void* data,
-                                           const int64_t nindptr,
-                                           const int64_t nelem,
+                                           const int64_t,
+                                           const int64_t,
                                            int64_t* out_len,
                                            double* out_result) {
   API_BEGIN();
   FastConfig *fastConfig = reinterpret_cast<FastConfig*>(fastConfig_handle);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, fastConfig->data_type, nindptr, nelem);
-  fastConfig->booster->PredictSingleRow(fastConfig->predict_type, fastConfig->ncol,
-                                        get_row_fun, fastConfig->config, out_result, out_len);
+  fastConfig->booster->PredictSingleRowCSR(fastConfig->predict_type, fastConfig->ncol, indptr, indptr_type, indices,
+                                           data, fastConfig->data_type, fastConfig->config, out_result, out_len);
   API_END();
 }
 
@@ -2145,8 +2401,8 @@ int LGBM_BoosterPredictForMat(BoosterHandle handle,
   }
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
   auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, is_row_major);
-  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun,
-                       config, out_result, out_len);
+  ref_booster->PredictForMat(start_iteration, num_iteration, predict_type, data, data_type, nrow, ncol,
+                             is_row_major, get_row_fun, config, out_result, out_len);
   API_END();
 }
 
@@ -2154,7 +2410,7 @@ int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
                                        const void* data,
                                        int data_type,
                                        int32_t ncol,
-                                       int is_row_major,
+                                       int,
                                        int predict_type,
                                        int start_iteration,
                                        int num_iteration,
@@ -2162,16 +2418,14 @@ int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
                                        int64_t* out_len,
                                        double* out_result) {
   API_BEGIN();
-  auto param = Config::Str2Map(parameter);
-  Config config;
-  config.Set(param);
+  const Config& config = SingleRowConfig(parameter);
   if (config.num_threads > 0) {
     omp_set_num_threads(config.num_threads);
   }
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, ncol, data_type, is_row_major);
+  // a single row has the same layout in row-major and column-major order
   ref_booster->SetSingleRowPredictor(start_iteration, num_iteration, predict_type, config);
-  ref_booster->PredictSingleRow(predict_type, ncol, get_row_fun, config, out_result, out_len);
+  ref_booster->PredictSingleRow(predict_type, ncol, data, data_type, config, out_result, out_len);
   API_END();
 }
 
@@ -2207,11 +2461,61 @@ int LGBM_BoosterPredictForMatSingleRowFast(FastConfigHandle fastConfig_handle,
                                            double* out_result) {
   API_BEGIN();
   FastConfig *fastConfig = reinterpret_cast<FastConfig*>(fastConfig_handle);
-  // Single row in row-major format:
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, fastConfig->ncol, fastConfig->data_type, 1);
-  fastConfig->booster->PredictSingleRow(fastConfig->predict_type, fastConfig->ncol,
-                                        get_row_fun, fastConfig->config,
-                                        out_result, out_len);
+  fastConfig->booster->PredictSingleRow(fastConfig->predict_type, fastConfig->ncol, data, fastConfig->data_type,
+                                        fastConfig->config, out_result, out_len);
+  API_END();
+}
+
+int LGBM_BoosterCreatePredictor(BoosterHandle handle,
+                                int predict_type,
+                                int start_iteration,
+                                int num_iteration,
+                                int data_type,
+                                int64_t num_col,
+                                const char* parameter,
+                                PredictorHandle* out) {
+  API_BEGIN();
+  if (num_col <= 0) {
+    Log::Fatal("The number of columns should be greater than zero.");
+  } else if (num_col >= INT32_MAX) {
+    Log::Fatal("The number of columns should be smaller than INT32_MAX.");
+  }
+  if (data_type != C_API_DTYPE_FLOAT32 && data_type != C_API_DTYPE_FLOAT64) {
+    Log::Fatal("Unknown data type in LGBM_BoosterCreatePredictor");
+  }
+  Config config;
+  config.Set(Config::Str2Map(parameter));
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  *out = ref_booster->CreatePredictorSnapshot(start_iteration, num_iteration, predict_type, data_type,
+                                              static_cast<int32_t>(num_col), config);
+  API_END();
+}
+
+int LGBM_PredictorPredictForMatSingleRow(PredictorHandle handle,
+                                         const void* data,
+                                         int64_t* out_len,
+                                         double* out_result) {
+  API_BEGIN();
+  reinterpret_cast<const PredictorSnapshot*>(handle)->PredictDenseRow(data, out_result, out_len);
+  API_END();
+}
+
+int LGBM_PredictorPredictForCSRSingleRow(PredictorHandle handle,
+                                         const void* indptr,
+                                         int indptr_type,
+                                         const int32_t* indices,
+                                         const void* data,
+                                         int64_t* out_len,
+                                         double* out_result) {
+  API_BEGIN();
+  reinterpret_cast<const PredictorSnapshot*>(handle)->PredictCSRRow(indptr, indptr_type, indices, data,
+                                                                    out_result, out_len);
+  API_END();
+}
+
+int LGBM_PredictorFree(PredictorHandle handle) {
+  API_BEGIN();
+  delete reinterpret_cast<PredictorSnapshot*>(handle);
   API_END();
 }
 
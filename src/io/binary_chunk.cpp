@@ -0,0 +1,183 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include "binary_chunk.hpp"
+
+#include <LightGBM/utils/log.h>
+
+#include <cstring>
+#include <utility>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace LightGBM {
+
+BinaryCompression ParseBinaryCompression(const std::string& name) {
+  if (name == std::string("none")) {
+    return BinaryCompression::kNone;
+  } else if (name == std::string("lz4")) {
+#ifndef USE_LZ4
+    Log::Fatal("LZ4 compression of binary files is not enabled in this build, compile with USE_LZ4");
+#endif
+    return BinaryCompression::kLZ4;
+  } else if (name == std::string("zstd")) {
+#ifndef USE_ZSTD
+    Log::Fatal("Zstd compression of binary files is not enabled in this build, compile with USE_ZSTD");
+#endif
+    return BinaryCompression::kZstd;
+  }
+  Log::Fatal("Unknown binary compression %s", name.c_str());
+  return BinaryCompression::kNone;
+}
+
+namespace {
+
+const uint64_t kPrime1 = 11400714785074694791ULL;
+const uint64_t kPrime2 = 14029467366897019727ULL;
+const uint64_t kPrime3 = 1609587929392839161ULL;
+const uint64_t kPrime4 = 9650029242287828579ULL;
+const uint64_t kPrime5 = 2870177450012600261ULL;
+
+inline uint64_t RotateLeft(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t Load64(const char* p) {
+  uint64_t ret;
+  std::memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+inline uint64_t Load32(const char* p) {
+  uint32_t ret;
+  std::memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  return RotateLeft(acc, 31) * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+  acc ^= Round(0, val);
+  return acc * kPrime1 + kPrime4;
+}
+
+}  // namespace
+
+uint64_t BinaryChunkChecksum(const char* data, size_t size) {
+  const char* p = data;
+  const char* end = data + size;
+  uint64_t h;
+  if (size >= 32) {
+    // four independent lanes, so that the multiplications of a step overlap
+    uint64_t v1 = kPrime1 + kPrime2;
+    uint64_t v2 = kPrime2;
+    uint64_t v3 = 0;
+    uint64_t v4 = 0 - kPrime1;
+    for (; p + 32 <= end; p += 32) {
+      v1 = Round(v1, Load64(p));
+      v2 = Round(v2, Load64(p + 8));
+      v3 = Round(v3, Load64(p + 16));
+      v4 = Round(v4, Load64(p + 24));
+    }
+    h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+    h = MergeRound(h, v1);
+    h = MergeRound(h, v2);
+    h = MergeRound(h, v3);
+    h = MergeRound(h, v4);
+  } else {
+    h = kPrime5;
+  }
+  h += static_cast<uint64_t>(size);
+  for (; p + 8 <= end; p += 8) {
+    h ^= Round(0, Load64(p));
+    h = RotateLeft(h, 27) * kPrime1 + kPrime4;
+  }
+  if (p + 4 <= end) {
+    h ^= Load32(p) * kPrime1;
+    h = RotateLeft(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= static_cast<uint64_t>(static_cast<uint8_t>(*p)) * kPrime5;
+    h = RotateLeft(h, 11) * kPrime1;
+  }
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+std::vector<char> CompressBinaryChunk(BinaryCompression* compression, std::vector<char>&& data) {
+  std::vector<char> ret;
+  size_t size = 0;
+  if (*compression == BinaryCompression::kLZ4) {
+#ifdef USE_LZ4
+    if (data.size() <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+      const int src_size = static_cast<int>(data.size());
+      ret.resize(LZ4_compressBound(src_size));
+      size = static_cast<size_t>(LZ4_compress_default(data.data(), ret.data(), src_size,
+                                                      static_cast<int>(ret.size())));
+    }
+#endif
+  } else if (*compression == BinaryCompression::kZstd) {
+#ifdef USE_ZSTD
+    ret.resize(ZSTD_compressBound(data.size()));
+    size = ZSTD_compress(ret.data(), ret.size(), data.data(), data.size(), ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(size)) {
+      size = 0;
+    }
+#endif
+  }
+  if (size == 0 || size >= data.size()) {
+    *compression = BinaryCompression::kNone;
+    return std::move(data);
+  }
+  ret.resize(size);
+  ret.shrink_to_fit();
+  return ret;
+}
+
+void DecompressBinaryChunk(BinaryCompression compression, const char* data, size_t size,
+                           size_t raw_size, std::vector<char>* out) {
+  (void) data;  // UNUSED VARIABLE without compression
+  (void) size;  // UNUSED VARIABLE without compression
+  out->resize(raw_size);
+  size_t decompressed_size = 0;
+  if (compression == BinaryCompression::kLZ4) {
+#ifdef USE_LZ4
+    if (size <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE) && raw_size <= static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+      const int ret = LZ4_decompress_safe(data, out->data(), static_cast<int>(size), static_cast<int>(raw_size));
+      decompressed_size = ret < 0 ? raw_size + 1 : static_cast<size_t>(ret);
+    }
+#else
+    Log::Fatal("Binary file is compressed with LZ4, which is not enabled in this build, compile with USE_LZ4");
+#endif
+  } else if (compression == BinaryCompression::kZstd) {
+#ifdef USE_ZSTD
+    decompressed_size = ZSTD_decompress(out->data(), raw_size, data, size);
+    if (ZSTD_isError(decompressed_size)) {
+      decompressed_size = raw_size + 1;
+    }
+#else
+    Log::Fatal("Binary file is compressed with zstd, which is not enabled in this build, compile with USE_ZSTD");
+#endif
+  } else {
+    Log::Fatal("Binary file error: unknown compression %d", static_cast<int>(compression));
+  }
+  if (decompressed_size != raw_size) {
+    Log::Fatal("Binary file error: chunk does not decompress to its size");
+  }
+}
+
+}  // namespace LightGBM
@@ -0,0 +1,71 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_IO_BINARY_CHUNK_HPP_
+#define LIGHTGBM_IO_BINARY_CHUNK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Binary dataset files v2 store the metadata, each feature group and the raw data in
+*        separate chunks. The header is followed by an index of the chunks, and every chunk
+*        starts at a multiple of kBinaryChunkAlignment, so that mapped chunks are page-aligned
+*/
+const size_t kBinaryChunkAlignment = 4096;
+
+/*! \brief Compression of a chunk, saved in the files */
+enum class BinaryCompression : int32_t {
+  kNone = 0,
+  kLZ4 = 1,
+  kZstd = 2,
+};
+
+/*! \brief Entry of the chunk index */
+struct BinaryChunkInfo {
+  /*! \brief position of the chunk in the file */
+  uint64_t offset;
+  /*! \brief bytes stored in the file */
+  uint64_t size;
+  /*! \brief bytes after decompression */
+  uint64_t raw_size;
+  /*! \brief BinaryChunkChecksum of the stored bytes */
+  uint64_t checksum;
+  int32_t compression;
+  int32_t reserved;
+};
+
+static_assert(sizeof(BinaryChunkInfo) == 40, "the chunk index is saved as is");
+
+/*!
+* \brief Parse the binary_compression parameter, fatal if it is unknown or not compiled in
+*/
+BinaryCompression ParseBinaryCompression(const std::string& name);
+
+/*!
+* \brief 64-bit checksum to detect corrupted chunks, XXH64 with seed 0. The words are read in the byte
+*        order of the host, as the rest of the binary file
+*/
+uint64_t BinaryChunkChecksum(const char* data, size_t size);
+
+/*!
+* \brief Compress a chunk
+* \param compression Compression to use, set to kNone when the data is stored as is because it
+*                    does not get smaller or is too large for the compression
+* \param data Bytes of the chunk
+* \return Bytes to store
+*/
+std::vector<char> CompressBinaryChunk(BinaryCompression* compression, std::vector<char>&& data);
+
+/*! \brief Decompress the stored bytes of a chunk into out, fatal if they do not decompress to raw_size bytes */
+void DecompressBinaryChunk(BinaryCompression compression, const char* data, size_t size,
+                           size_t raw_size, std::vector<char>* out);
+
+}  // namespace LightGBM
+
+#endif   // LIGHTGBM_IO_BINARY_CHUNK_HPP_
@@ -134,6 +134,14 @@ void GetDeviceType(const std::unordered_map<std::string, std::string>& params, s
   }
 }
 
+void GetSIMDLevel(const std::unordered_map<std::string, std::string>& params, std::string* simd_level) {
+  std::string value;
+  if (Config::GetString(params, "simd_level", &value)) {
+    std::transform(value.begin(), value.end(), value.begin(), Common::tolower);
+    *simd_level = value;
+  }
+}
+
 void GetTreeLearnerType(const std::unordered_map<std::string, std::string>& params, std::string* tree_learner) {
   std::string value;
   if (Config::GetString(params, "tree_learner", &value)) {
@@ -212,6 +220,7 @@ void Config::Set(const std::unordered_map<std::string, std::string>& params) {
     LGBM_config_::current_device = lgbm_device_cuda;
   }
   GetTreeLearnerType(params, &tree_learner);
+  GetSIMDLevel(params, &simd_level);
 
   GetMembersFromString(params);
 
@@ -282,6 +291,15 @@ void Config::CheckParamConflict() {
     }
   }
 
+  if (simd_level != std::string("auto") && simd_level != std::string("none") && simd_level != std::string("sse4.2")
+      && simd_level != std::string("avx2") && simd_level != std::string("avx512")) {
+    Log::Fatal("Unknown SIMD level %s", simd_level.c_str());
+  }
+  if (thread_affinity != std::string("none") && thread_affinity != std::string("compact")
+      && thread_affinity != std::string("spread")) {
+    Log::Fatal("Unknown thread affinity %s", thread_affinity.c_str());
+  }
+
   if (num_machines > 1) {
     is_parallel = true;
   } else {
@@ -361,6 +379,23 @@ void Config::CheckParamConflict() {
       Log::Fatal("Cannot use regression_l1 objective when fitting linear trees.");
     }
   }
+  // the per-leaf choice between col-wise and row-wise uses the CPU histogram kernels
+  if (adaptive_col_row_wise && device_type != std::string("cpu")) {
+    Log::Warning("adaptive_col_row_wise only works with CPU, it is set to false.");
+    adaptive_col_row_wise = false;
+  }
+  // quantized gradients are only supported by the CPU histogram kernels
+  if (use_quantized_grad && device_type != std::string("cpu")) {
+    Log::Warning("Quantized gradients only work with CPU, use_quantized_grad is set to false.");
+    use_quantized_grad = false;
+  }
+  if (max_concurrent_leaves > 1 && (tree_learner != std::string("serial") || device_type != std::string("cpu") || linear_tree)) {
+    Log::Warning("max_concurrent_leaves only works with the serial tree learner on CPU, it is set to 1.");
+    max_concurrent_leaves = 1;
+  }
+  if (histogram_pool_eviction != std::string("lru") && histogram_pool_eviction != std::string("gain")) {
+    Log::Fatal("Unknown histogram pool eviction %s", histogram_pool_eviction.c_str());
+  }
   // min_data_in_leaf must be at least 2 if path smoothing is active. This is because when the split is calculated
   // the count is calculated using the proportion of hessian in the leaf which is rounded up to nearest int, so it can
   // be 1 when there is actually no data in the leaf. In rare cases this can cause a bug because with path smoothing the
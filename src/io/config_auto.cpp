@@ -140,6 +140,7 @@ const std::unordered_map<std::string, std::string>& Config::alias_table() {
   {"categorical_features", "categorical_feature"},
   {"is_save_binary", "save_binary"},
   {"is_save_binary_file", "save_binary"},
+  {"mmap_binary_file", "mmap_binary"},
   {"is_predict_raw_score", "predict_raw_score"},
   {"predict_rawscore", "predict_raw_score"},
   {"raw_score", "predict_raw_score"},
@@ -147,6 +148,7 @@ const std::unordered_map<std::string, std::string>& Config::alias_table() {
   {"leaf_index", "predict_leaf_index"},
   {"is_predict_contrib", "predict_contrib"},
   {"contrib", "predict_contrib"},
+  {"contrib_interactions", "predict_contrib_interactions"},
   {"predict_result", "output_result"},
   {"prediction_result", "output_result"},
   {"predict_name", "output_result"},
@@ -192,12 +194,19 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "num_leaves",
   "tree_learner",
   "num_threads",
+  "thread_affinity",
+  "use_task_scheduler",
   "device_type",
+  "simd_level",
   "seed",
   "deterministic",
   "force_col_wise",
   "force_row_wise",
+  "adaptive_col_row_wise",
+  "max_concurrent_leaves",
   "histogram_pool_size",
+  "histogram_pool_eviction",
+  "histogram_pool_spill",
   "max_depth",
   "min_data_in_leaf",
   "min_sum_hessian_in_leaf",
@@ -244,6 +253,9 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "cegb_penalty_feature_coupled",
   "path_smooth",
   "interaction_constraints",
+  "use_quantized_grad",
+  "num_grad_quant_bins",
+  "stochastic_rounding",
   "verbosity",
   "input_model",
   "output_model",
@@ -270,16 +282,23 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "categorical_feature",
   "forcedbins_filename",
   "save_binary",
+  "mmap_binary",
+  "binary_version",
+  "binary_compression",
   "precise_float_parser",
   "start_iteration_predict",
   "num_iteration_predict",
   "predict_raw_score",
   "predict_leaf_index",
   "predict_contrib",
+  "predict_contrib_interactions",
+  "pred_contrib_table_max_features",
+  "pred_contrib_table_memory_mb",
   "predict_disable_shape_check",
   "pred_early_stop",
   "pred_early_stop_freq",
   "pred_early_stop_margin",
+  "pred_tree_blocking",
   "output_result",
   "convert_model_language",
   "convert_model",
@@ -336,14 +355,27 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetInt(params, "num_threads", &num_threads);
 
+  GetString(params, "thread_affinity", &thread_affinity);
+
+  GetBool(params, "use_task_scheduler", &use_task_scheduler);
+
   GetBool(params, "deterministic", &deterministic);
 
   GetBool(params, "force_col_wise", &force_col_wise);
 
   GetBool(params, "force_row_wise", &force_row_wise);
 
+  GetBool(params, "adaptive_col_row_wise", &adaptive_col_row_wise);
+
+  GetInt(params, "max_concurrent_leaves", &max_concurrent_leaves);
+  CHECK_GE(max_concurrent_leaves, 1);
+
   GetDouble(params, "histogram_pool_size", &histogram_pool_size);
 
+  GetString(params, "histogram_pool_eviction", &histogram_pool_eviction);
+
+  GetBool(params, "histogram_pool_spill", &histogram_pool_spill);
+
   GetInt(params, "max_depth", &max_depth);
 
   GetInt(params, "min_data_in_leaf", &min_data_in_leaf);
@@ -480,6 +512,14 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetString(params, "interaction_constraints", &interaction_constraints);
 
+  GetBool(params, "use_quantized_grad", &use_quantized_grad);
+
+  GetInt(params, "num_grad_quant_bins", &num_grad_quant_bins);
+  CHECK_GE(num_grad_quant_bins,  2);
+  CHECK_LE(num_grad_quant_bins,  254);
+
+  GetBool(params, "stochastic_rounding", &stochastic_rounding);
+
   GetInt(params, "verbosity", &verbosity);
 
   GetString(params, "input_model", &input_model);
@@ -537,6 +577,14 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetBool(params, "save_binary", &save_binary);
 
+  GetBool(params, "mmap_binary", &mmap_binary);
+
+  GetInt(params, "binary_version", &binary_version);
+  CHECK_GE(binary_version, 1);
+  CHECK_LE(binary_version, 2);
+
+  GetString(params, "binary_compression", &binary_compression);
+
   GetBool(params, "precise_float_parser", &precise_float_parser);
 
   GetInt(params, "start_iteration_predict", &start_iteration_predict);
@@ -549,6 +597,15 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetBool(params, "predict_contrib", &predict_contrib);
 
+  GetBool(params, "predict_contrib_interactions", &predict_contrib_interactions);
+
+  GetInt(params, "pred_contrib_table_max_features", &pred_contrib_table_max_features);
+  CHECK_GE(pred_contrib_table_max_features, 0);
+  CHECK_LE(pred_contrib_table_max_features, 16);
+
+  GetDouble(params, "pred_contrib_table_memory_mb", &pred_contrib_table_memory_mb);
+  CHECK_GE(pred_contrib_table_memory_mb, 0.0);
+
   GetBool(params, "predict_disable_shape_check", &predict_disable_shape_check);
 
   GetBool(params, "pred_early_stop", &pred_early_stop);
@@ -557,6 +614,8 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetDouble(params, "pred_early_stop_margin", &pred_early_stop_margin);
 
+  GetBool(params, "pred_tree_blocking", &pred_tree_blocking);
+
   GetString(params, "output_result", &output_result);
 
   GetString(params, "convert_model_language", &convert_model_language);
@@ -649,10 +708,16 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[learning_rate: " << learning_rate << "]\n";
   str_buf << "[num_leaves: " << num_leaves << "]\n";
   str_buf << "[num_threads: " << num_threads << "]\n";
+  str_buf << "[thread_affinity: " << thread_affinity << "]\n";
+  str_buf << "[use_task_scheduler: " << use_task_scheduler << "]\n";
   str_buf << "[deterministic: " << deterministic << "]\n";
   str_buf << "[force_col_wise: " << force_col_wise << "]\n";
   str_buf << "[force_row_wise: " << force_row_wise << "]\n";
+  str_buf << "[adaptive_col_row_wise: " << adaptive_col_row_wise << "]\n";
+  str_buf << "[max_concurrent_leaves: " << max_concurrent_leaves << "]\n";
   str_buf << "[histogram_pool_size: " << histogram_pool_size << "]\n";
+  str_buf << "[histogram_pool_eviction: " << histogram_pool_eviction << "]\n";
+  str_buf << "[histogram_pool_spill: " << histogram_pool_spill << "]\n";
   str_buf << "[max_depth: " << max_depth << "]\n";
   str_buf << "[min_data_in_leaf: " << min_data_in_leaf << "]\n";
   str_buf << "[min_sum_hessian_in_leaf: " << min_sum_hessian_in_leaf << "]\n";
@@ -699,6 +764,9 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[cegb_penalty_feature_coupled: " << Common::Join(cegb_penalty_feature_coupled, ",") << "]\n";
   str_buf << "[path_smooth: " << path_smooth << "]\n";
   str_buf << "[interaction_constraints: " << interaction_constraints << "]\n";
+  str_buf << "[use_quantized_grad: " << use_quantized_grad << "]\n";
+  str_buf << "[num_grad_quant_bins: " << num_grad_quant_bins << "]\n";
+  str_buf << "[stochastic_rounding: " << stochastic_rounding << "]\n";
   str_buf << "[verbosity: " << verbosity << "]\n";
   str_buf << "[saved_feature_importance_type: " << saved_feature_importance_type << "]\n";
   str_buf << "[linear_tree: " << linear_tree << "]\n";
@@ -16,17 +16,24 @@
 #include <limits>
 #include <sstream>
 #include <unordered_map>
+#include <utility>
+
+#include "binary_chunk.hpp"
 
 namespace LightGBM {
 
 const char* Dataset::binary_file_token =
     "______LightGBM_Binary_File_Token______\n";
+const char* Dataset::binary_file_token_v2 =
+    "______LightGBM_Binary_File_Token_v2___\n";
 
 Dataset::Dataset() {
   data_filename_ = "noname";
   num_data_ = 0;
   is_finish_load_ = false;
   has_raw_ = false;
+  binary_version_ = 1;
+  binary_compression_ = "none";
 }
 
 Dataset::Dataset(data_size_t num_data) {
@@ -37,6 +44,8 @@ Dataset::Dataset(data_size_t num_data) {
   is_finish_load_ = false;
   group_bin_boundaries_.push_back(0);
   has_raw_ = false;
+  binary_version_ = 1;
+  binary_compression_ = "none";
 }
 
 Dataset::~Dataset() {}
@@ -413,6 +422,8 @@ void Dataset::Construct(std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
   bin_construct_sample_cnt_ = io_config.bin_construct_sample_cnt;
   use_missing_ = io_config.use_missing;
   zero_as_missing_ = io_config.zero_as_missing;
+  binary_version_ = io_config.binary_version;
+  binary_compression_ = io_config.binary_compression;
   has_raw_ = false;
   if (io_config.linear_tree) {
     has_raw_ = true;
@@ -439,6 +450,20 @@ void Dataset::FinishLoad() {
   is_finish_load_ = true;
 }
 
+void Dataset::FlushPushedData() {
+  if (is_finish_load_) {
+    return;
+  }
+  OMP_INIT_EX();
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < num_groups_; ++i) {
+    OMP_LOOP_EX_BEGIN();
+    feature_groups_[i]->FlushPushedData();
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+}
+
 void PushDataToMultiValBin(
     data_size_t num_data, const std::vector<uint32_t> most_freq_bins,
     const std::vector<uint32_t> offsets,
@@ -721,6 +746,8 @@ void Dataset::CopyFeatureMapperFrom(const Dataset* dataset) {
   group_feature_cnt_ = dataset->group_feature_cnt_;
   forced_bin_bounds_ = dataset->forced_bin_bounds_;
   feature_need_push_zeros_ = dataset->feature_need_push_zeros_;
+  binary_version_ = dataset->binary_version_;
+  binary_compression_ = dataset->binary_compression_;
 }
 
 void Dataset::CreateValid(const Dataset* dataset) {
@@ -732,6 +759,8 @@ void Dataset::CreateValid(const Dataset* dataset) {
   bin_construct_sample_cnt_ = dataset->bin_construct_sample_cnt_;
   use_missing_ = dataset->use_missing_;
   zero_as_missing_ = dataset->zero_as_missing_;
+  binary_version_ = dataset->binary_version_;
+  binary_compression_ = dataset->binary_compression_;
   feature2group_.clear();
   feature2subfeature_.clear();
   has_raw_ = dataset->has_raw();
@@ -949,86 +978,23 @@ void Dataset::SaveBinaryFile(const char* bin_filename) {
   }
 
   if (!is_file_existed) {
+    if (binary_version_ >= 2) {
+      // fail before creating the file
+      ParseBinaryCompression(binary_compression_);
+    }
     auto writer = VirtualFileWriter::Make(bin_filename);
     if (!writer->Init()) {
       Log::Fatal("Cannot write binary data to %s ", bin_filename);
     }
     Log::Info("Saving data to binary file %s", bin_filename);
-    size_t size_of_token = std::strlen(binary_file_token);
-    writer->AlignedWrite(binary_file_token, size_of_token);
-    // get size of header
-    size_t size_of_header =
-        VirtualFileWriter::AlignedSize(sizeof(num_data_)) +
-        VirtualFileWriter::AlignedSize(sizeof(num_features_)) +
-        VirtualFileWriter::AlignedSize(sizeof(num_total_features_)) +
-        VirtualFileWriter::AlignedSize(sizeof(int) * num_total_features_) +
-        VirtualFileWriter::AlignedSize(sizeof(label_idx_)) +
-        VirtualFileWriter::AlignedSize(sizeof(num_groups_)) +
-        3 * VirtualFileWriter::AlignedSize(sizeof(int) * num_features_) +
-        sizeof(uint64_t) * (num_groups_ + 1) +
-        2 * VirtualFileWriter::AlignedSize(sizeof(int) * num_groups_) +
-        VirtualFileWriter::AlignedSize(sizeof(int32_t) * num_total_features_) +
-        VirtualFileWriter::AlignedSize(sizeof(int)) * 3 +
-        VirtualFileWriter::AlignedSize(sizeof(bool)) * 3;
-    // size of feature names
-    for (int i = 0; i < num_total_features_; ++i) {
-      size_of_header +=
-          VirtualFileWriter::AlignedSize(feature_names_[i].size()) +
-          VirtualFileWriter::AlignedSize(sizeof(int));
-    }
-    // size of forced bins
-    for (int i = 0; i < num_total_features_; ++i) {
-      size_of_header += forced_bin_bounds_[i].size() * sizeof(double) +
-                        VirtualFileWriter::AlignedSize(sizeof(int));
-    }
-    writer->Write(&size_of_header, sizeof(size_of_header));
-    // write header
-    writer->AlignedWrite(&num_data_, sizeof(num_data_));
-    writer->AlignedWrite(&num_features_, sizeof(num_features_));
-    writer->AlignedWrite(&num_total_features_, sizeof(num_total_features_));
-    writer->AlignedWrite(&label_idx_, sizeof(label_idx_));
-    writer->AlignedWrite(&max_bin_, sizeof(max_bin_));
-    writer->AlignedWrite(&bin_construct_sample_cnt_,
-                         sizeof(bin_construct_sample_cnt_));
-    writer->AlignedWrite(&min_data_in_bin_, sizeof(min_data_in_bin_));
-    writer->AlignedWrite(&use_missing_, sizeof(use_missing_));
-    writer->AlignedWrite(&zero_as_missing_, sizeof(zero_as_missing_));
-    writer->AlignedWrite(&has_raw_, sizeof(has_raw_));
-    writer->AlignedWrite(used_feature_map_.data(),
-                         sizeof(int) * num_total_features_);
-    writer->AlignedWrite(&num_groups_, sizeof(num_groups_));
-    writer->AlignedWrite(real_feature_idx_.data(), sizeof(int) * num_features_);
-    writer->AlignedWrite(feature2group_.data(), sizeof(int) * num_features_);
-    writer->AlignedWrite(feature2subfeature_.data(),
-                         sizeof(int) * num_features_);
-    writer->Write(group_bin_boundaries_.data(),
-                  sizeof(uint64_t) * (num_groups_ + 1));
-    writer->AlignedWrite(group_feature_start_.data(),
-                         sizeof(int) * num_groups_);
-    writer->AlignedWrite(group_feature_cnt_.data(), sizeof(int) * num_groups_);
-    if (max_bin_by_feature_.empty()) {
-      ArrayArgs<int32_t>::Assign(&max_bin_by_feature_, -1, num_total_features_);
-    }
-    writer->AlignedWrite(max_bin_by_feature_.data(),
-                  sizeof(int32_t) * num_total_features_);
-    if (ArrayArgs<int32_t>::CheckAll(max_bin_by_feature_, -1)) {
-      max_bin_by_feature_.clear();
-    }
-    // write feature names
-    for (int i = 0; i < num_total_features_; ++i) {
-      int str_len = static_cast<int>(feature_names_[i].size());
-      writer->AlignedWrite(&str_len, sizeof(int));
-      const char* c_str = feature_names_[i].c_str();
-      writer->AlignedWrite(c_str, sizeof(char) * str_len);
-    }
-    // write forced bins
-    for (int i = 0; i < num_total_features_; ++i) {
-      int num_bounds = static_cast<int>(forced_bin_bounds_[i].size());
-      writer->AlignedWrite(&num_bounds, sizeof(int));
-
-      for (size_t j = 0; j < forced_bin_bounds_[i].size(); ++j) {
-        writer->Write(&forced_bin_bounds_[i][j], sizeof(double));
-      }
+    const char* token = binary_version_ >= 2 ? binary_file_token_v2 : binary_file_token;
+    size_t size_of_token = std::strlen(token);
+    writer->AlignedWrite(token, size_of_token);
+    size_t size_of_header = SaveBinaryHeader(writer.get());
+    if (binary_version_ >= 2) {
+      SaveBinaryChunks(writer.get(), VirtualFileWriter::AlignedSize(size_of_token) + sizeof(size_of_header) +
+                       size_of_header);
+      return;
     }
 
     // get size of meta data
@@ -1048,18 +1014,153 @@ void Dataset::SaveBinaryFile(const char* bin_filename) {
 
     // write raw data; use row-major order so we can read row-by-row
     if (has_raw_) {
-      for (int i = 0; i < num_data_; ++i) {
-        for (int j = 0; j < num_features_; ++j) {
-          int feat_ind = numeric_feature_map_[j];
-          if (feat_ind > -1) {
-            writer->Write(&raw_data_[feat_ind][i], sizeof(float));
-          }
-        }
+      SaveBinaryRawData(writer.get());
+    }
+  }
+}
+
+size_t Dataset::SaveBinaryHeader(const VirtualFileWriter* writer) {
+  // get size of header
+  size_t size_of_header =
+      VirtualFileWriter::AlignedSize(sizeof(num_data_)) +
+      VirtualFileWriter::AlignedSize(sizeof(num_features_)) +
+      VirtualFileWriter::AlignedSize(sizeof(num_total_features_)) +
+      VirtualFileWriter::AlignedSize(sizeof(int) * num_total_features_) +
+      VirtualFileWriter::AlignedSize(sizeof(label_idx_)) +
+      VirtualFileWriter::AlignedSize(sizeof(num_groups_)) +
+      3 * VirtualFileWriter::AlignedSize(sizeof(int) * num_features_) +
+      sizeof(uint64_t) * (num_groups_ + 1) +
+      2 * VirtualFileWriter::AlignedSize(sizeof(int) * num_groups_) +
+      VirtualFileWriter::AlignedSize(sizeof(int32_t) * num_total_features_) +
+      VirtualFileWriter::AlignedSize(sizeof(int)) * 3 +
+      VirtualFileWriter::AlignedSize(sizeof(bool)) * 3;
+  // size of feature names
+  for (int i = 0; i < num_total_features_; ++i) {
+    size_of_header +=
+        VirtualFileWriter::AlignedSize(feature_names_[i].size()) +
+        VirtualFileWriter::AlignedSize(sizeof(int));
+  }
+  // size of forced bins
+  for (int i = 0; i < num_total_features_; ++i) {
+    size_of_header += forced_bin_bounds_[i].size() * sizeof(double) +
+                      VirtualFileWriter::AlignedSize(sizeof(int));
+  }
+  writer->Write(&size_of_header, sizeof(size_of_header));
+  // write header
+  writer->AlignedWrite(&num_data_, sizeof(num_data_));
+  writer->AlignedWrite(&num_features_, sizeof(num_features_));
+  writer->AlignedWrite(&num_total_features_, sizeof(num_total_features_));
+  writer->AlignedWrite(&label_idx_, sizeof(label_idx_));
+  writer->AlignedWrite(&max_bin_, sizeof(max_bin_));
+  writer->AlignedWrite(&bin_construct_sample_cnt_,
+                       sizeof(bin_construct_sample_cnt_));
+  writer->AlignedWrite(&min_data_in_bin_, sizeof(min_data_in_bin_));
+  writer->AlignedWrite(&use_missing_, sizeof(use_missing_));
+  writer->AlignedWrite(&zero_as_missing_, sizeof(zero_as_missing_));
+  writer->AlignedWrite(&has_raw_, sizeof(has_raw_));
+  writer->AlignedWrite(used_feature_map_.data(),
+                       sizeof(int) * num_total_features_);
+  writer->AlignedWrite(&num_groups_, sizeof(num_groups_));
+  writer->AlignedWrite(real_feature_idx_.data(), sizeof(int) * num_features_);
+  writer->AlignedWrite(feature2group_.data(), sizeof(int) * num_features_);
+  writer->AlignedWrite(feature2subfeature_.data(),
+                       sizeof(int) * num_features_);
+  writer->Write(group_bin_boundaries_.data(),
+                sizeof(uint64_t) * (num_groups_ + 1));
+  writer->AlignedWrite(group_feature_start_.data(),
+                       sizeof(int) * num_groups_);
+  writer->AlignedWrite(group_feature_cnt_.data(), sizeof(int) * num_groups_);
+  if (max_bin_by_feature_.empty()) {
+    ArrayArgs<int32_t>::Assign(&max_bin_by_feature_, -1, num_total_features_);
+  }
+  writer->AlignedWrite(max_bin_by_feature_.data(),
+                sizeof(int32_t) * num_total_features_);
+  if (ArrayArgs<int32_t>::CheckAll(max_bin_by_feature_, -1)) {
+    max_bin_by_feature_.clear();
+  }
+  // write feature names
+  for (int i = 0; i < num_total_features_; ++i) {
+    int str_len = static_cast<int>(feature_names_[i].size());
+    writer->AlignedWrite(&str_len, sizeof(int));
+    const char* c_str = feature_names_[i].c_str();
+    writer->AlignedWrite(c_str, sizeof(char) * str_len);
+  }
+  // write forced bins
+  for (int i = 0; i < num_total_features_; ++i) {
+    int num_bounds = static_cast<int>(forced_bin_bounds_[i].size());
+    writer->AlignedWrite(&num_bounds, sizeof(int));
+
+    for (size_t j = 0; j < forced_bin_bounds_[i].size(); ++j) {
+      writer->Write(&forced_bin_bounds_[i][j], sizeof(double));
+    }
+  }
+  return size_of_header;
+}
+
+void Dataset::SaveBinaryRawData(const VirtualFileWriter* writer) const {
+  for (int i = 0; i < num_data_; ++i) {
+    for (int j = 0; j < num_features_; ++j) {
+      int feat_ind = numeric_feature_map_[j];
+      if (feat_ind > -1) {
+        writer->Write(&raw_data_[feat_ind][i], sizeof(float));
       }
     }
   }
 }
 
+void Dataset::SaveBinaryChunks(const VirtualFileWriter* writer, size_t offset) const {
+  const BinaryCompression compression = ParseBinaryCompression(binary_compression_);
+  // metadata, feature groups, raw data
+  const int num_chunks = 1 + num_groups_ + (has_raw_ ? 1 : 0);
+  std::vector<std::vector<char>> chunks(num_chunks);
+  std::vector<BinaryChunkInfo> chunk_infos(num_chunks);
+  OMP_INIT_EX();
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < num_chunks; ++i) {
+    OMP_LOOP_EX_BEGIN();
+    std::vector<char> data;
+    BufferWriter chunk_writer(&data);
+    if (i == 0) {
+      data.reserve(metadata_.SizesInByte());
+      metadata_.SaveBinaryToFile(&chunk_writer);
+    } else if (i <= num_groups_) {
+      data.reserve(feature_groups_[i - 1]->SizesInByte());
+      feature_groups_[i - 1]->SaveBinaryToFile(&chunk_writer);
+    } else {
+      data.reserve(sizeof(float) * num_numeric_features_ * num_data_);
+      SaveBinaryRawData(&chunk_writer);
+    }
+    BinaryCompression chunk_compression = compression;
+    chunk_infos[i].raw_size = data.size();
+    chunks[i] = CompressBinaryChunk(&chunk_compression, std::move(data));
+    chunk_infos[i].size = chunks[i].size();
+    chunk_infos[i].checksum = BinaryChunkChecksum(chunks[i].data(), chunks[i].size());
+    chunk_infos[i].compression = static_cast<int32_t>(chunk_compression);
+    chunk_infos[i].reserved = 0;
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  // the chunks start after the index, at multiples of kBinaryChunkAlignment
+  offset += sizeof(size_t) + sizeof(BinaryChunkInfo) * num_chunks;
+  const size_t index_end = offset;
+  for (int i = 0; i < num_chunks; ++i) {
+    offset = VirtualFileWriter::AlignedSize(offset, kBinaryChunkAlignment);
+    chunk_infos[i].offset = offset;
+    offset += chunk_infos[i].size;
+  }
+  size_t size_of_index = static_cast<size_t>(num_chunks);
+  writer->Write(&size_of_index, sizeof(size_of_index));
+  writer->Write(chunk_infos.data(), sizeof(BinaryChunkInfo) * num_chunks);
+  const std::vector<char> padding(kBinaryChunkAlignment, 0);
+  offset = index_end;
+  for (int i = 0; i < num_chunks; ++i) {
+    writer->Write(padding.data(), chunk_infos[i].offset - offset);
+    writer->Write(chunks[i].data(), chunks[i].size());
+    offset = chunk_infos[i].offset + chunk_infos[i].size;
+    std::vector<char>().swap(chunks[i]);
+  }
+}
+
 void Dataset::DumpTextFile(const char* text_filename) {
   FILE* file = NULL;
 #if _MSC_VER
@@ -1171,26 +1272,35 @@ void Dataset::ConstructHistogramsInner(
   auto ptr_ordered_hess = hessians;
   if (num_used_dense_group > 0) {
     if (USE_INDICES) {
-      if (USE_HESSIAN) {
+      if (share_state->use_task_scheduler) {
+        Threading::TaskFor<data_size_t>(num_data, 1024, [&](data_size_t start, data_size_t end) {
+          for (data_size_t i = start; i < end; ++i) {
+            ordered_gradients[i] = gradients[data_indices[i]];
+          }
+          if (USE_HESSIAN) {
+            for (data_size_t i = start; i < end; ++i) {
+              ordered_hessians[i] = hessians[data_indices[i]];
+            }
+          }
+        });
+      } else if (USE_HESSIAN) {
 #pragma omp parallel for schedule(static, 512) if (num_data >= 1024)
         for (data_size_t i = 0; i < num_data; ++i) {
           ordered_gradients[i] = gradients[data_indices[i]];
           ordered_hessians[i] = hessians[data_indices[i]];
         }
-        ptr_ordered_grad = ordered_gradients;
-        ptr_ordered_hess = ordered_hessians;
       } else {
 #pragma omp parallel for schedule(static, 512) if (num_data >= 1024)
         for (data_size_t i = 0; i < num_data; ++i) {
           ordered_gradients[i] = gradients[data_indices[i]];
         }
-        ptr_ordered_grad = ordered_gradients;
+      }
+      ptr_ordered_grad = ordered_gradients;
+      if (USE_HESSIAN) {
+        ptr_ordered_hess = ordered_hessians;
       }
     }
-    OMP_INIT_EX();
-#pragma omp parallel for schedule(static) num_threads(share_state->num_threads)
-    for (int gi = 0; gi < num_used_dense_group; ++gi) {
-      OMP_LOOP_EX_BEGIN();
+    auto construct_group_histogram = [&](int gi) {
       int group = used_dense_group[gi];
       auto data_ptr = hist_data + group_bin_boundaries_[group] * 2;
       const int num_bin = feature_groups_[group]->num_total_bin_;
@@ -1218,9 +1328,19 @@ void Dataset::ConstructHistogramsInner(
           data_ptr[i + 1] = static_cast<double>(cnt_dst[i]) * hessians[0];
         }
       }
-      OMP_LOOP_EX_END();
+    };
+    if (share_state->use_task_scheduler) {
+      TaskScheduler::ParallelFor(num_used_dense_group, construct_group_histogram);
+    } else {
+      OMP_INIT_EX();
+#pragma omp parallel for schedule(static) num_threads(share_state->num_threads)
+      for (int gi = 0; gi < num_used_dense_group; ++gi) {
+        OMP_LOOP_EX_BEGIN();
+        construct_group_histogram(gi);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
     }
-    OMP_THROW_EX();
   }
   global_timer.Stop("Dataset::dense_bin_histogram");
   if (multi_val_groud_id >= 0) {
@@ -1262,6 +1382,118 @@ template void Dataset::ConstructHistogramsInner<false, false>(
     score_t* ordered_gradients, score_t* ordered_hessians,
     TrainingShareStates* share_state, hist_t* hist_data) const;
 
+template <bool USE_INDICES>
+void Dataset::ConstructIntHistogramsInner(
+    const std::vector<int8_t>& is_feature_used, const data_size_t* data_indices,
+    data_size_t num_data, const int_score_t* int_gradients,
+    int_score_t* ordered_int_gradients, TrainingShareStates* share_state,
+    double grad_scale, double hess_scale, hist_t* hist_data) const {
+  int_hist_t* int_hist_data = share_state->IntHistData(std::max<size_t>(
+      static_cast<size_t>(share_state->num_hist_total_bin()),
+      static_cast<size_t>(NumTotalBin())));
+  if (!share_state->is_col_wise) {
+    share_state->ConstructIntHistograms<USE_INDICES, false>(
+        data_indices, num_data, int_gradients, int_hist_data);
+    global_timer.Start("Dataset::int_histogram_rescale");
+    const int num_bin = share_state->num_hist_total_bin();
+    int n_block = 1;
+    int block_size = num_bin;
+    Threading::BlockInfo<int>(share_state->num_threads, num_bin, 512, &n_block,
+                              &block_size);
+#pragma omp parallel for schedule(static, 1) num_threads(share_state->num_threads)
+    for (int t = 0; t < n_block; ++t) {
+      const int start = t * block_size;
+      const int end = std::min(start + block_size, num_bin);
+      IntHistToHist(int_hist_data + start, end - start, grad_scale, hess_scale,
+                    hist_data + start * 2);
+    }
+    global_timer.Stop("Dataset::int_histogram_rescale");
+    return;
+  }
+  std::vector<int> used_dense_group;
+  int multi_val_groud_id = -1;
+  used_dense_group.reserve(num_groups_);
+  for (int group = 0; group < num_groups_; ++group) {
+    const int f_start = group_feature_start_[group];
+    const int f_cnt = group_feature_cnt_[group];
+    bool is_group_used = false;
+    for (int j = 0; j < f_cnt; ++j) {
+      const int fidx = f_start + j;
+      if (is_feature_used[fidx]) {
+        is_group_used = true;
+        break;
+      }
+    }
+    if (is_group_used) {
+      if (feature_groups_[group]->is_multi_val_) {
+        multi_val_groud_id = group;
+      } else {
+        used_dense_group.push_back(group);
+      }
+    }
+  }
+  int num_used_dense_group = static_cast<int>(used_dense_group.size());
+  global_timer.Start("Dataset::dense_bin_histogram");
+  auto ptr_ordered_int_grad = int_gradients;
+  if (num_used_dense_group > 0) {
+    if (USE_INDICES) {
+#pragma omp parallel for schedule(static, 512) if (num_data >= 1024)
+      for (data_size_t i = 0; i < num_data; ++i) {
+        ordered_int_gradients[i] = int_gradients[data_indices[i]];
+      }
+      ptr_ordered_int_grad = ordered_int_gradients;
+    }
+    OMP_INIT_EX();
+#pragma omp parallel for schedule(static) num_threads(share_state->num_threads)
+    for (int gi = 0; gi < num_used_dense_group; ++gi) {
+      OMP_LOOP_EX_BEGIN();
+      int group = used_dense_group[gi];
+      auto int_data_ptr = int_hist_data + group_bin_boundaries_[group];
+      const int num_bin = feature_groups_[group]->num_total_bin_;
+      std::memset(reinterpret_cast<void*>(int_data_ptr), 0,
+                  num_bin * sizeof(int_hist_t));
+      if (USE_INDICES) {
+        feature_groups_[group]->bin_data_->ConstructIntHistogram(
+            data_indices, 0, num_data, ptr_ordered_int_grad, int_data_ptr);
+      } else {
+        feature_groups_[group]->bin_data_->ConstructIntHistogram(
+            0, num_data, ptr_ordered_int_grad, int_data_ptr);
+      }
+      IntHistToHist(int_data_ptr, num_bin, grad_scale, hess_scale,
+                    hist_data + group_bin_boundaries_[group] * 2);
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+  }
+  global_timer.Stop("Dataset::dense_bin_histogram");
+  if (multi_val_groud_id >= 0) {
+    const uint64_t offset = group_bin_boundaries_[multi_val_groud_id];
+    if (num_used_dense_group > 0) {
+      share_state->ConstructIntHistograms<USE_INDICES, true>(
+          data_indices, num_data, ptr_ordered_int_grad, int_hist_data + offset);
+    } else {
+      share_state->ConstructIntHistograms<USE_INDICES, false>(
+          data_indices, num_data, int_gradients, int_hist_data + offset);
+    }
+    IntHistToHist(int_hist_data + offset,
+                  feature_groups_[multi_val_groud_id]->num_total_bin_,
+                  grad_scale, hess_scale, hist_data + offset * 2);
+  }
+}
+
+// explicitly initialize template methods, for cross module call
+template void Dataset::ConstructIntHistogramsInner<true>(
+    const std::vector<int8_t>& is_feature_used, const data_size_t* data_indices,
+    data_size_t num_data, const int_score_t* int_gradients,
+    int_score_t* ordered_int_gradients, TrainingShareStates* share_state,
+    double grad_scale, double hess_scale, hist_t* hist_data) const;
+
+template void Dataset::ConstructIntHistogramsInner<false>(
+    const std::vector<int8_t>& is_feature_used, const data_size_t* data_indices,
+    data_size_t num_data, const int_score_t* int_gradients,
+    int_score_t* ordered_int_gradients, TrainingShareStates* share_state,
+    double grad_scale, double hess_scale, hist_t* hist_data) const;
+
 void Dataset::FixHistogram(int feature_idx, double sum_gradient,
                            double sum_hessian, hist_t* data) const {
   const int group = feature2group_[feature_idx];
@@ -10,13 +10,125 @@
 #include <LightGBM/utils/log.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <fstream>
 
+#include "binary_chunk.hpp"
+
 namespace LightGBM {
 
 using json11::Json;
 
+namespace {
+
+/*!
+* \brief Sequential reads of a binary dataset file, in place from a mapping of the file when
+*        there is one, otherwise through a buffer
+*/
+class BinaryFileReader {
+ public:
+  BinaryFileReader(const char* filename, bool use_mmap) : offset_(0) {
+    if (use_mmap) {
+      mapped_file_ = MappedFile::Make(filename);
+      if (mapped_file_ == nullptr) {
+        Log::Warning("Could not map binary data from %s into memory, reading it instead", filename);
+      }
+    }
+    if (mapped_file_ == nullptr) {
+      reader_ = VirtualFileReader::Make(filename);
+      buffer_.resize(16 * 1024 * 1024);
+    }
+  }
+
+  bool Init() { return mapped_file_ != nullptr || reader_->Init(); }
+
+  bool is_mapped() const { return mapped_file_ != nullptr; }
+
+  /*!
+  * \brief Read the next bytes of the file
+  * \return The bytes, in the mapped file or in the buffer until the next read, nullptr if the file is shorter
+  */
+  const char* Read(size_t bytes) {
+    if (mapped_file_ != nullptr) {
+      if (bytes > mapped_file_->size() - offset_) {
+        return nullptr;
+      }
+      const char* ptr = mapped_file_->data() + offset_;
+      offset_ += bytes;
+      return ptr;
+    }
+    if (bytes > buffer_.size()) {
+      buffer_.resize(bytes);
+    }
+    if (reader_->Read(buffer_.data(), bytes) != bytes) {
+      return nullptr;
+    }
+    offset_ += bytes;
+    return buffer_.data();
+  }
+
+  /*!
+  * \brief Read bytes at a position of the file after the previous reads
+  * \param storage Where the bytes are read to when the file is not mapped
+  * \return The bytes, nullptr if the file is shorter or the position was passed
+  */
+  const char* ReadAt(size_t offset, size_t bytes, std::vector<char>* storage) {
+    if (offset < offset_) {
+      return nullptr;
+    }
+    if (mapped_file_ != nullptr) {
+      if (offset > mapped_file_->size()) {
+        return nullptr;
+      }
+      offset_ = offset;
+      return Read(bytes);
+    }
+    while (offset_ < offset) {
+      if (Read(std::min(offset - offset_, buffer_.size())) == nullptr) {
+        return nullptr;
+      }
+    }
+    storage->resize(bytes);
+    if (reader_->Read(storage->data(), bytes) != bytes) {
+      return nullptr;
+    }
+    offset_ += bytes;
+    return storage->data();
+  }
+
+  /*! \brief The mapped file, for the dataset that uses it in place */
+  std::unique_ptr<MappedFile> ReleaseMappedFile() { return std::move(mapped_file_); }
+
+ private:
+  std::unique_ptr<MappedFile> mapped_file_;
+  size_t offset_;
+  std::unique_ptr<VirtualFileReader> reader_;
+  std::vector<char> buffer_;
+};
+
+/*!
+* \brief Bytes of a chunk of a binary file v2, checked against the checksum and decompressed
+* \param stored Bytes stored in the file
+* \param storage Storage of the decompressed bytes
+* \return The bytes, stored itself when the chunk is not compressed
+*/
+const char* UnpackChunk(const BinaryChunkInfo& info, int index, const char* stored, std::vector<char>* storage) {
+  if (BinaryChunkChecksum(stored, static_cast<size_t>(info.size)) != info.checksum) {
+    Log::Fatal("Binary file error: checksum of chunk %d does not match, the file is corrupted", index);
+  }
+  const BinaryCompression compression = static_cast<BinaryCompression>(info.compression);
+  if (compression == BinaryCompression::kNone) {
+    return stored;
+  }
+  DecompressBinaryChunk(compression, stored, static_cast<size_t>(info.size), static_cast<size_t>(info.raw_size),
+                        storage);
+  return storage->data();
+}
+
+}  // namespace
+
 DatasetLoader::DatasetLoader(const Config& io_config, const PredictFunction& predict_fun, int num_class, const char* filename)
   :config_(io_config), random_(config_.data_random_seed), predict_fun_(predict_fun), num_class_(num_class) {
   label_idx_ = 0;
@@ -317,50 +429,44 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
                                         int rank, int num_machines, int* num_global_data,
                                         std::vector<data_size_t>* used_data_indices) {
   auto dataset = std::unique_ptr<Dataset>(new Dataset());
-  auto reader = VirtualFileReader::Make(bin_filename);
+  BinaryFileReader reader(bin_filename, config_.mmap_binary);
   dataset->data_filename_ = data_filename;
-  if (!reader->Init()) {
+  if (!reader.Init()) {
     Log::Fatal("Could not read binary data from %s", bin_filename);
   }
 
-  // buffer to read binary file
-  size_t buffer_size = 16 * 1024 * 1024;
-  auto buffer = std::vector<char>(buffer_size);
-
-  // check token
+  // check token, both versions have tokens of the same size
   size_t size_of_token = std::strlen(Dataset::binary_file_token);
-  size_t read_cnt = reader->Read(
-      buffer.data(),
-      VirtualFileWriter::AlignedSize(sizeof(char) * size_of_token));
-  if (read_cnt < sizeof(char) * size_of_token) {
+  const char* read_ptr = reader.Read(VirtualFileWriter::AlignedSize(sizeof(char) * size_of_token));
+  if (read_ptr == nullptr) {
     Log::Fatal("Binary file error: token has the wrong size");
   }
-  if (std::string(buffer.data()) != std::string(Dataset::binary_file_token)) {
+  int version = 0;
+  if (std::string(read_ptr, size_of_token) == std::string(Dataset::binary_file_token)) {
+    version = 1;
+  } else if (std::string(read_ptr, size_of_token) == std::string(Dataset::binary_file_token_v2)) {
+    version = 2;
+  } else {
     Log::Fatal("Input file is not LightGBM binary file");
   }
 
   // read size of header
-  read_cnt = reader->Read(buffer.data(), sizeof(size_t));
+  read_ptr = reader.Read(sizeof(size_t));
 
-  if (read_cnt != sizeof(size_t)) {
+  if (read_ptr == nullptr) {
     Log::Fatal("Binary file error: header has the wrong size");
   }
 
-  size_t size_of_head = *(reinterpret_cast<size_t*>(buffer.data()));
+  size_t size_of_head = *(reinterpret_cast<const size_t*>(read_ptr));
 
-  // re-allocmate space if not enough
-  if (size_of_head > buffer_size) {
-    buffer_size = size_of_head;
-    buffer.resize(buffer_size);
-  }
   // read header
-  read_cnt = reader->Read(buffer.data(), size_of_head);
+  read_ptr = reader.Read(size_of_head);
 
-  if (read_cnt != size_of_head) {
+  if (read_ptr == nullptr) {
     Log::Fatal("Binary file error: header is incorrect");
   }
   // get header
-  const char* mem_ptr = buffer.data();
+  const char* mem_ptr = read_ptr;
   dataset->num_data_ = *(reinterpret_cast<const data_size_t*>(mem_ptr));
   mem_ptr += VirtualFileWriter::AlignedSize(sizeof(dataset->num_data_));
   dataset->num_features_ = *(reinterpret_cast<const int*>(mem_ptr));
@@ -490,29 +596,63 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
     }
     mem_ptr += num_bounds * sizeof(double);
   }
+  dataset->binary_version_ = config_.binary_version;
+  dataset->binary_compression_ = config_.binary_compression;
+
+  // the sampled data of the machines are copied, all the data can be used in place
+  const bool in_place = reader.is_mapped() && (num_machines <= 1 || config_.pre_partition);
+  // chunk index of v2: metadata, feature groups, raw data
+  std::vector<BinaryChunkInfo> chunk_infos;
+  if (version >= 2) {
+    read_ptr = reader.Read(sizeof(size_t));
+    if (read_ptr == nullptr) {
+      Log::Fatal("Binary file error: chunk index has the wrong size");
+    }
+    size_t num_chunks = *(reinterpret_cast<const size_t*>(read_ptr));
+    if (num_chunks != static_cast<size_t>(1 + dataset->num_groups_ + (dataset->has_raw_ ? 1 : 0))) {
+      Log::Fatal("Binary file error: chunk index has the wrong size");
+    }
+    read_ptr = reader.Read(sizeof(BinaryChunkInfo) * num_chunks);
+    if (read_ptr == nullptr) {
+      Log::Fatal("Binary file error: chunk index is incorrect");
+    }
+    chunk_infos.resize(num_chunks);
+    std::memcpy(chunk_infos.data(), read_ptr, sizeof(BinaryChunkInfo) * num_chunks);
+  }
+  auto chunk_in_place = [&](int index) {
+    return in_place && (version < 2 || chunk_infos[index].compression == static_cast<int32_t>(BinaryCompression::kNone));
+  };
 
-  // read size of meta data
-  read_cnt = reader->Read(buffer.data(), sizeof(size_t));
+  std::vector<char> metadata_storage;
+  std::vector<char> metadata_unpacked;
+  if (version >= 2) {
+    read_ptr = reader.ReadAt(static_cast<size_t>(chunk_infos[0].offset), static_cast<size_t>(chunk_infos[0].size),
+                             &metadata_storage);
+    if (read_ptr == nullptr) {
+      Log::Fatal("Binary file error: meta data is incorrect");
+    }
+    read_ptr = UnpackChunk(chunk_infos[0], 0, read_ptr, &metadata_unpacked);
+  } else {
+    // read size of meta data
+    read_ptr = reader.Read(sizeof(size_t));
 
-  if (read_cnt != sizeof(size_t)) {
-    Log::Fatal("Binary file error: meta data has the wrong size");
-  }
+    if (read_ptr == nullptr) {
+      Log::Fatal("Binary file error: meta data has the wrong size");
+    }
 
-  size_t size_of_metadata = *(reinterpret_cast<size_t*>(buffer.data()));
+    size_t size_of_metadata = *(reinterpret_cast<const size_t*>(read_ptr));
 
-  // re-allocate space if not enough
-  if (size_of_metadata > buffer_size) {
-    buffer_size = size_of_metadata;
-    buffer.resize(buffer_size);
-  }
-  //  read meta data
-  read_cnt = reader->Read(buffer.data(), size_of_metadata);
+    //  read meta data
+    read_ptr = reader.Read(size_of_metadata);
 
-  if (read_cnt != size_of_metadata) {
-    Log::Fatal("Binary file error: meta data is incorrect");
+    if (read_ptr == nullptr) {
+      Log::Fatal("Binary file error: meta data is incorrect");
+    }
   }
   // load meta data
-  dataset->metadata_.LoadFromMemory(buffer.data());
+  dataset->metadata_.LoadFromMemory(read_ptr, chunk_in_place(0));
+  std::vector<char>().swap(metadata_storage);
+  std::vector<char>().swap(metadata_unpacked);
 
   *num_global_data = dataset->num_data_;
   used_data_indices->clear();
@@ -552,29 +692,57 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
     dataset->num_data_ = static_cast<data_size_t>((*used_data_indices).size());
   }
   dataset->metadata_.PartitionLabel(*used_data_indices);
+  if (version >= 2) {
+    // read the chunks of a window of groups in the order of the file, then check, decompress and load
+    // them in parallel. One chunk per thread is read at a time, so that the read chunks of all the
+    // groups are not held in memory at once
+    const int window_size = OMP_NUM_THREADS();
+    std::vector<std::vector<char>> group_storage(window_size);
+    std::vector<const char*> group_data(window_size);
+    dataset->feature_groups_.resize(dataset->num_groups_);
+    for (int window_start = 0; window_start < dataset->num_groups_; window_start += window_size) {
+      const int num_window_groups = std::min(window_size, dataset->num_groups_ - window_start);
+      for (int j = 0; j < num_window_groups; ++j) {
+        const BinaryChunkInfo& info = chunk_infos[window_start + j + 1];
+        group_data[j] = reader.ReadAt(static_cast<size_t>(info.offset), static_cast<size_t>(info.size),
+                                      &group_storage[j]);
+        if (group_data[j] == nullptr) {
+          Log::Fatal("Binary file error: feature %d is incorrect", window_start + j);
+        }
+      }
+      OMP_INIT_EX();
+#pragma omp parallel for schedule(dynamic)
+      for (int j = 0; j < num_window_groups; ++j) {
+        OMP_LOOP_EX_BEGIN();
+        const int i = window_start + j;
+        std::vector<char> unpacked;
+        const char* group_ptr = UnpackChunk(chunk_infos[i + 1], i + 1, group_data[j], &unpacked);
+        dataset->feature_groups_[i].reset(new FeatureGroup(group_ptr, *num_global_data, *used_data_indices, i,
+                                                           chunk_in_place(i + 1)));
+        std::vector<char>().swap(group_storage[j]);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
+    }
+  }
   // read feature data
-  for (int i = 0; i < dataset->num_groups_; ++i) {
+  for (int i = 0; i < dataset->num_groups_ && version < 2; ++i) {
     // read feature size
-    read_cnt = reader->Read(buffer.data(), sizeof(size_t));
-    if (read_cnt != sizeof(size_t)) {
+    read_ptr = reader.Read(sizeof(size_t));
+    if (read_ptr == nullptr) {
       Log::Fatal("Binary file error: feature %d has the wrong size", i);
     }
-    size_t size_of_feature = *(reinterpret_cast<size_t*>(buffer.data()));
-    // re-allocate space if not enough
-    if (size_of_feature > buffer_size) {
-      buffer_size = size_of_feature;
-      buffer.resize(buffer_size);
-    }
+    size_t size_of_feature = *(reinterpret_cast<const size_t*>(read_ptr));
 
-    read_cnt = reader->Read(buffer.data(), size_of_feature);
+    read_ptr = reader.Read(size_of_feature);
 
-    if (read_cnt != size_of_feature) {
-      Log::Fatal("Binary file error: feature %d is incorrect, read count: %d", i, read_cnt);
+    if (read_ptr == nullptr) {
+      Log::Fatal("Binary file error: feature %d is incorrect", i);
     }
     dataset->feature_groups_.emplace_back(std::unique_ptr<FeatureGroup>(
-      new FeatureGroup(buffer.data(),
+      new FeatureGroup(read_ptr,
                        *num_global_data,
-                       *used_data_indices, i)));
+                       *used_data_indices, i, in_place)));
   }
   dataset->feature_groups_.shrink_to_fit();
 
@@ -592,16 +760,25 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
   if (dataset->has_raw()) {
     dataset->ResizeRaw(dataset->num_data());
       size_t row_size = dataset->num_numeric_features_ * sizeof(float);
-      if (row_size > buffer_size) {
-        buffer_size = row_size;
-        buffer.resize(buffer_size);
+    // all the rows of v2 are in the last chunk
+    const char* raw_ptr = nullptr;
+    std::vector<char> raw_storage;
+    std::vector<char> raw_unpacked;
+    if (version >= 2) {
+      const int index = static_cast<int>(chunk_infos.size()) - 1;
+      const BinaryChunkInfo& info = chunk_infos[index];
+      raw_ptr = reader.ReadAt(static_cast<size_t>(info.offset), static_cast<size_t>(info.size), &raw_storage);
+      if (raw_ptr == nullptr || info.raw_size < row_size * dataset->num_data()) {
+        Log::Fatal("Binary file error: raw data is incorrect");
       }
+      raw_ptr = UnpackChunk(info, index, raw_ptr, &raw_unpacked);
+    }
     for (int i = 0; i < dataset->num_data(); ++i) {
-      read_cnt = reader->Read(buffer.data(), row_size);
-      if (read_cnt != row_size) {
-        Log::Fatal("Binary file error: row %d of raw data is incorrect, read count: %d", i, read_cnt);
+      read_ptr = raw_ptr != nullptr ? raw_ptr + row_size * i : reader.Read(row_size);
+      if (read_ptr == nullptr) {
+        Log::Fatal("Binary file error: row %d of raw data is incorrect", i);
       }
-      mem_ptr = buffer.data();
+      mem_ptr = read_ptr;
       const float* tmp_ptr_raw_row = reinterpret_cast<const float*>(mem_ptr);
       for (int j = 0; j < dataset->num_features(); ++j) {
         int feat_ind = dataset->numeric_feature_map_[j];
@@ -613,6 +790,13 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
     }
   }
 
+  bool uses_mapped_file = chunk_in_place(0);
+  for (int i = 1; i < static_cast<int>(chunk_infos.size()); ++i) {
+    uses_mapped_file = uses_mapped_file || chunk_in_place(i);
+  }
+  if (uses_mapped_file) {
+    dataset->mapped_file_ = reader.ReleaseMappedFile();
+  }
   dataset->is_finish_load_ = true;
   return dataset.release();
 }
@@ -1156,7 +1340,9 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
   double tmp_label = 0.0f;
   auto& ref_text_data = *text_data;
   std::vector<float> feature_row(dataset->num_features_);
-  if (!predict_fun_) {
+  if (!predict_fun_ && parser->SupportsParseBlock()) {
+    ExtractFeaturesFromBlocks(ref_text_data.data(), dataset->num_data_, 0, parser, dataset);
+  } else if (!predict_fun_) {
     OMP_INIT_EX();
     // if doesn't need to prediction with initial model
     #pragma omp parallel for schedule(static) private(oneline_features) firstprivate(tmp_label, feature_row)
@@ -1173,6 +1359,9 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
       // shrink_to_fit will be very slow in linux, and seems not free memory, disable for now
       // text_reader_->Lines()[i].shrink_to_fit();
       std::vector<bool> is_feature_added(dataset->num_features_, false);
+      if (dataset->has_raw()) {
+        std::fill(feature_row.begin(), feature_row.end(), 0.0f);
+      }
       // push data
       for (auto& inner_data : oneline_features) {
         if (inner_data.first >= dataset->num_total_features_) { continue; }
@@ -1231,6 +1420,9 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
       // text_reader_->Lines()[i].shrink_to_fit();
       // push data
       std::vector<bool> is_feature_added(dataset->num_features_, false);
+      if (dataset->has_raw()) {
+        std::fill(feature_row.begin(), feature_row.end(), 0.0f);
+      }
       for (auto& inner_data : oneline_features) {
         if (inner_data.first >= dataset->num_total_features_) { continue; }
         int feature_idx = dataset->used_feature_map_[inner_data.first];
@@ -1281,6 +1473,12 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
   std::function<void(data_size_t, const std::vector<std::string>&)> process_fun =
     [this, &init_score, &parser, &dataset]
   (data_size_t start_idx, const std::vector<std::string>& lines) {
+    if (init_score.empty() && parser->SupportsParseBlock()) {
+      ExtractFeaturesFromBlocks(lines.data(), static_cast<data_size_t>(lines.size()), start_idx, parser, dataset);
+      // the lines are read in order
+      dataset->FlushPushedData();
+      return;
+    }
     std::vector<std::pair<int, double>> oneline_features;
     double tmp_label = 0.0f;
     std::vector<float> feature_row(dataset->num_features_);
@@ -1303,6 +1501,9 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
       // set label
       dataset->metadata_.SetLabelAt(start_idx + i, static_cast<label_t>(tmp_label));
       std::vector<bool> is_feature_added(dataset->num_features_, false);
+      if (dataset->has_raw()) {
+        std::fill(feature_row.begin(), feature_row.end(), 0.0f);
+      }
       // push data
       for (auto& inner_data : oneline_features) {
         if (inner_data.first >= dataset->num_total_features_) { continue; }
@@ -1328,14 +1529,15 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
         for (size_t j = 0; j < feature_row.size(); ++j) {
           int feat_ind = dataset->numeric_feature_map_[j];
           if (feat_ind >= 0) {
-            dataset->raw_data_[feat_ind][i] = feature_row[j];
+            dataset->raw_data_[feat_ind][start_idx + i] = feature_row[j];
           }
         }
       }
-      dataset->FinishOneRow(tid, i, is_feature_added);
+      dataset->FinishOneRow(tid, start_idx + i, is_feature_added);
       OMP_LOOP_EX_END();
     }
     OMP_THROW_EX();
+    dataset->FlushPushedData();
   };
   TextReader<data_size_t> text_reader(filename, config_.header, config_.file_load_progress_interval_bytes);
   if (!used_data_indices.empty()) {
@@ -1353,6 +1555,74 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
   dataset->FinishLoad();
 }
 
+void DatasetLoader::ExtractFeaturesFromBlocks(const std::string* lines, data_size_t num_lines, data_size_t start_idx,
+                                              const Parser* parser, Dataset* dataset) {
+  const int num_col = dataset->num_total_features_;
+  // blocks of about 256KB of values, so that the columns of a block stay in cache while they are pushed
+  const data_size_t block_size = std::max<data_size_t>(16, 32768 / std::max(num_col, 1));
+  const data_size_t num_blocks = (num_lines + block_size - 1) / block_size;
+  std::vector<bool> need_push_zeros(dataset->num_features_, false);
+  for (int fidx : dataset->feature_need_push_zeros_) {
+    need_push_zeros[fidx] = true;
+  }
+  OMP_INIT_EX();
+  #pragma omp parallel
+  {
+    std::vector<double> values;
+    std::vector<double> labels;
+    #pragma omp for schedule(static)
+    for (data_size_t block = 0; block < num_blocks; ++block) {
+      OMP_LOOP_EX_BEGIN();
+      const int tid = omp_get_thread_num();
+      const data_size_t begin = block * block_size;
+      const data_size_t cnt = std::min(block_size, num_lines - begin);
+      values.resize(static_cast<size_t>(num_col) * cnt);
+      labels.resize(cnt);
+      parser->ParseBlock(lines + begin, cnt, num_col, values.data(), labels.data());
+      const data_size_t row_begin = start_idx + begin;
+      for (data_size_t i = 0; i < cnt; ++i) {
+        dataset->metadata_.SetLabelAt(row_begin + i, static_cast<label_t>(labels[i]));
+      }
+      for (int col = 0; col < num_col; ++col) {
+        const double* col_values = values.data() + static_cast<size_t>(col) * cnt;
+        const int feature_idx = dataset->used_feature_map_[col];
+        if (feature_idx >= 0) {
+          // the values that ParseOneLine would output are pushed, the others are zeros
+          const int group = dataset->feature2group_[feature_idx];
+          const int sub_feature = dataset->feature2subfeature_[feature_idx];
+          const bool push_zeros = need_push_zeros[feature_idx];
+          const int feat_ind = dataset->has_raw() ? dataset->numeric_feature_map_[feature_idx] : -1;
+          for (data_size_t i = 0; i < cnt; ++i) {
+            const double value = col_values[i];
+            const bool is_added = std::fabs(value) > kZeroThreshold || std::isnan(value);
+            if (is_added) {
+              dataset->feature_groups_[group]->PushData(tid, sub_feature, row_begin + i, value);
+            } else if (push_zeros) {
+              dataset->feature_groups_[group]->PushData(tid, sub_feature, row_begin + i, 0.0f);
+            }
+            if (feat_ind >= 0) {
+              dataset->raw_data_[feat_ind][row_begin + i] = is_added ? static_cast<float>(value) : 0.0f;
+            }
+          }
+        } else if (col == weight_idx_ || col == group_idx_) {
+          for (data_size_t i = 0; i < cnt; ++i) {
+            const double value = col_values[i];
+            if (std::fabs(value) > kZeroThreshold || std::isnan(value)) {
+              if (col == weight_idx_) {
+                dataset->metadata_.SetWeightAt(row_begin + i, static_cast<label_t>(value));
+              } else {
+                dataset->metadata_.SetQueryAt(row_begin + i, static_cast<data_size_t>(value));
+              }
+            }
+          }
+        }
+      }
+      OMP_LOOP_EX_END();
+    }
+  }
+  OMP_THROW_EX();
+}
+
 /*! \brief Check can load from binary file */
 std::string DatasetLoader::CheckCanLoadFromBin(const char* filename) {
   std::string bin_filename(filename);
@@ -1374,7 +1644,8 @@ std::string DatasetLoader::CheckCanLoadFromBin(const char* filename) {
   size_t size_of_token = std::strlen(Dataset::binary_file_token);
   size_t read_cnt = reader->Read(buffer.data(), size_of_token);
   if (read_cnt == size_of_token
-      && std::string(buffer.data()) == std::string(Dataset::binary_file_token)) {
+      && (std::string(buffer.data()) == std::string(Dataset::binary_file_token)
+          || std::string(buffer.data()) == std::string(Dataset::binary_file_token_v2))) {
     return bin_filename;
   } else {
     return std::string();
@@ -13,6 +13,8 @@
 #include <cstring>
 #include <vector>
 
+#include "dense_bin_simd.hpp"
+
 namespace LightGBM {
 
 template <typename VAL_T, bool IS_4BIT>
@@ -140,11 +142,50 @@ class DenseBin : public Bin {
     }
   }
 
+  template <bool USE_INDICES, bool USE_HESSIAN>
+  void ConstructHistogramDispatch(const data_size_t* data_indices,
+                                  data_size_t start, data_size_t end,
+                                  const score_t* ordered_gradients,
+                                  const score_t* ordered_hessians,
+                                  hist_t* out) const {
+#ifdef LGBM_DENSE_HIST_SIMD
+    const SIMDLevel level = SIMD::Level();
+    if (level != kSIMDNone) {
+      // vector loads of packed 4-bit bins must start at a byte boundary
+      if (IS_4BIT && !USE_INDICES && (start & 1) && start < end) {
+        ConstructHistogramInner<false, false, USE_HESSIAN>(
+            nullptr, start, start + 1, ordered_gradients, ordered_hessians, out);
+        ++start;
+      }
+      typedef DenseHistogramSIMD<VAL_T, IS_4BIT> Kernels;
+      switch (level) {
+        case kSIMDAVX512:
+          start = Kernels::template ConstructAVX512<USE_INDICES, USE_HESSIAN>(
+              data_.data(), data_indices, start, end, ordered_gradients,
+              ordered_hessians, out);
+          break;
+        case kSIMDAVX2:
+          start = Kernels::template ConstructAVX2<USE_INDICES, USE_HESSIAN>(
+              data_.data(), data_indices, start, end, ordered_gradients,
+              ordered_hessians, out);
+          break;
+        default:
+          start = Kernels::template ConstructSSE42<USE_INDICES, USE_HESSIAN>(
+              data_.data(), data_indices, start, end, ordered_gradients,
+              ordered_hessians, out);
+          break;
+      }
+    }
+#endif  // LGBM_DENSE_HIST_SIMD
+    ConstructHistogramInner<USE_INDICES, USE_INDICES, USE_HESSIAN>(
+        data_indices, start, end, ordered_gradients, ordered_hessians, out);
+  }
+
   void ConstructHistogram(const data_size_t* data_indices, data_size_t start,
                           data_size_t end, const score_t* ordered_gradients,
                           const score_t* ordered_hessians,
                           hist_t* out) const override {
-    ConstructHistogramInner<true, true, true>(
+    ConstructHistogramDispatch<true, true>(
         data_indices, start, end, ordered_gradients, ordered_hessians, out);
   }
 
@@ -152,24 +193,65 @@ class DenseBin : public Bin {
                           const score_t* ordered_gradients,
                           const score_t* ordered_hessians,
                           hist_t* out) const override {
-    ConstructHistogramInner<false, false, true>(
+    ConstructHistogramDispatch<false, true>(
         nullptr, start, end, ordered_gradients, ordered_hessians, out);
   }
 
   void ConstructHistogram(const data_size_t* data_indices, data_size_t start,
                           data_size_t end, const score_t* ordered_gradients,
                           hist_t* out) const override {
-    ConstructHistogramInner<true, true, false>(data_indices, start, end,
-                                               ordered_gradients, nullptr, out);
+    ConstructHistogramDispatch<true, false>(data_indices, start, end,
+                                            ordered_gradients, nullptr, out);
   }
 
   void ConstructHistogram(data_size_t start, data_size_t end,
                           const score_t* ordered_gradients,
                           hist_t* out) const override {
-    ConstructHistogramInner<false, false, false>(
+    ConstructHistogramDispatch<false, false>(
         nullptr, start, end, ordered_gradients, nullptr, out);
   }
 
+  template <bool USE_INDICES, bool USE_PREFETCH>
+  void ConstructIntHistogramInner(const data_size_t* data_indices,
+                                  data_size_t start, data_size_t end,
+                                  const int_score_t* ordered_int_gradients,
+                                  int_hist_t* out) const {
+    data_size_t i = start;
+    if (USE_PREFETCH) {
+      const data_size_t pf_offset = 64 / sizeof(VAL_T);
+      const data_size_t pf_end = end - pf_offset;
+      for (; i < pf_end; ++i) {
+        const auto idx = USE_INDICES ? data_indices[i] : i;
+        const auto pf_idx =
+            USE_INDICES ? data_indices[i + pf_offset] : i + pf_offset;
+        if (IS_4BIT) {
+          PREFETCH_T0(data_.data() + (pf_idx >> 1));
+        } else {
+          PREFETCH_T0(data_.data() + pf_idx);
+        }
+        out[data(idx)] += IntHistEntry(ordered_int_gradients[i]);
+      }
+    }
+    for (; i < end; ++i) {
+      const auto idx = USE_INDICES ? data_indices[i] : i;
+      out[data(idx)] += IntHistEntry(ordered_int_gradients[i]);
+    }
+  }
+
+  void ConstructIntHistogram(const data_size_t* data_indices, data_size_t start,
+                             data_size_t end,
+                             const int_score_t* ordered_int_gradients,
+                             int_hist_t* out) const override {
+    ConstructIntHistogramInner<true, true>(data_indices, start, end,
+                                           ordered_int_gradients, out);
+  }
+
+  void ConstructIntHistogram(data_size_t start, data_size_t end,
+                             const int_score_t* ordered_int_gradients,
+                             int_hist_t* out) const override {
+    ConstructIntHistogramInner<false, false>(nullptr, start, end,
+                                             ordered_int_gradients, out);
+  }
 
   template <bool MISS_IS_ZERO, bool MISS_IS_NA, bool MFB_IS_ZERO,
             bool MFB_IS_NA, bool USE_MIN_BIN>
@@ -380,6 +462,9 @@ class DenseBin : public Bin {
     }
   }
 
+  // the values are pushed in place
+  void FlushPushedData() override {}
+
   void LoadFromMemory(
       const void* memory,
       const std::vector<data_size_t>& local_used_indices) override {
@@ -416,6 +501,12 @@ class DenseBin : public Bin {
     }
   }
 
+  void LoadFromMappedMemory(const void* memory, data_size_t num_data) override {
+    num_data_ = num_data;
+    buf_.clear();
+    data_.SetView(reinterpret_cast<const VAL_T*>(memory), IS_4BIT ? (num_data_ + 1) / 2 : num_data_);
+  }
+
   inline VAL_T data(data_size_t idx) const {
     if (IS_4BIT) {
       return (data_[idx >> 1] >> ((idx & 1) << 2)) & 0xf;
@@ -464,9 +555,9 @@ class DenseBin : public Bin {
  private:
   data_size_t num_data_;
 #ifdef USE_CUDA
-  std::vector<VAL_T, CHAllocator<VAL_T>> data_;
+  Common::ViewableVector<VAL_T, CHAllocator<VAL_T>> data_;
 #else
-  std::vector<VAL_T, Common::AlignmentAllocator<VAL_T, kAlignedSize>> data_;
+  Common::ViewableVector<VAL_T, Common::AlignmentAllocator<VAL_T, kAlignedSize>> data_;
 #endif
   std::vector<uint8_t> buf_;
 
@@ -0,0 +1,257 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for
+ * license information.
+ */
+#ifndef LIGHTGBM_IO_DENSE_BIN_SIMD_HPP_
+#define LIGHTGBM_IO_DENSE_BIN_SIMD_HPP_
+
+#include <LightGBM/bin.h>
+#include <LightGBM/meta.h>
+#include <LightGBM/utils/simd.h>
+
+#include <cstdint>
+#include <cstring>
+
+// the kernels convert float gradients to double lane by lane, so they are only
+// enabled for the default 32-bit score_t
+#if defined(LGBM_SIMD_X86) && !defined(SCORE_T_USE_DOUBLE)
+#define LGBM_DENSE_HIST_SIMD
+#endif
+
+#ifdef LGBM_DENSE_HIST_SIMD
+
+namespace LightGBM {
+
+/*!
+ * \brief Vectorized histogram construction for DenseBin.
+ * Every kernel processes whole blocks of rows starting at start and returns
+ * the first row it did not process, the caller finishes the tail with the
+ * scalar loop. Rows falling into the same bin are accumulated in row order,
+ * so the results are bitwise identical to the scalar loop.
+ */
+template <typename VAL_T, bool IS_4BIT>
+struct DenseHistogramSIMD {
+  static inline uint32_t Get(const VAL_T* data, data_size_t idx) {
+    if (IS_4BIT) {
+      return (data[idx >> 1] >> ((idx & 1) << 2)) & 0xf;
+    } else {
+      return data[idx];
+    }
+  }
+
+  static inline void Prefetch(const VAL_T* data, data_size_t idx) {
+    if (IS_4BIT) {
+      PREFETCH_T0(data + (idx >> 1));
+    } else {
+      PREFETCH_T0(data + idx);
+    }
+  }
+
+  /*! \brief Interleave low and high nibbles of packed 4-bit bins into bytes */
+  LGBM_TARGET_SSE42 static inline __m128i UnpackNibbles(__m128i packed) {
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i lo = _mm_and_si128(packed, mask);
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+    return _mm_unpacklo_epi8(lo, hi);
+  }
+
+  /*! \brief Bins of rows [i, i + 4), i must be even for 4-bit bins */
+  LGBM_TARGET_SSE42 static inline __m128i LoadBins4(const VAL_T* data, data_size_t i) {
+    if (IS_4BIT) {
+      uint16_t packed;
+      std::memcpy(&packed, data + (i >> 1), sizeof(packed));
+      return _mm_cvtepu8_epi32(UnpackNibbles(_mm_cvtsi32_si128(packed)));
+    } else if (sizeof(VAL_T) == 1) {
+      int32_t packed;
+      std::memcpy(&packed, data + i, sizeof(packed));
+      return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+    } else if (sizeof(VAL_T) == 2) {
+      return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i)));
+    } else {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    }
+  }
+
+  /*! \brief Bins of rows [i, i + 8), i must be even for 4-bit bins */
+  LGBM_TARGET_AVX2 static inline __m256i LoadBins8(const VAL_T* data, data_size_t i) {
+    if (IS_4BIT) {
+      int32_t packed;
+      std::memcpy(&packed, data + (i >> 1), sizeof(packed));
+      return _mm256_cvtepu8_epi32(UnpackNibbles(_mm_cvtsi32_si128(packed)));
+    } else if (sizeof(VAL_T) == 1) {
+      return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i)));
+    } else if (sizeof(VAL_T) == 2) {
+      return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    } else {
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    }
+  }
+
+  /*! \brief Bins of the rows data_indices[i, i + 8) */
+  LGBM_TARGET_AVX2 static inline __m256i GatherBins8(const VAL_T* data,
+                                                     const data_size_t* data_indices,
+                                                     data_size_t i) {
+    if (!IS_4BIT && sizeof(VAL_T) == 4) {
+      const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data_indices + i));
+      return _mm256_i32gather_epi32(reinterpret_cast<const int*>(data), idx, 4);
+    }
+    // narrower bins would need 32-bit loads that may run past the end of data
+    return _mm256_setr_epi32(
+        Get(data, data_indices[i]), Get(data, data_indices[i + 1]),
+        Get(data, data_indices[i + 2]), Get(data, data_indices[i + 3]),
+        Get(data, data_indices[i + 4]), Get(data, data_indices[i + 5]),
+        Get(data, data_indices[i + 6]), Get(data, data_indices[i + 7]));
+  }
+
+  /*! \brief Add a (gradient, hessian) pair to one histogram entry */
+  LGBM_TARGET_SSE42 static inline void AddPair(hist_t* entry, __m128d pair) {
+    _mm_storeu_pd(entry, _mm_add_pd(_mm_loadu_pd(entry), pair));
+  }
+
+  template <bool USE_INDICES>
+  static inline void PrefetchBlock(const VAL_T* data, const data_size_t* data_indices,
+                                   data_size_t i, data_size_t end, int block) {
+    if (USE_INDICES) {
+      const data_size_t pf_offset = 64 / sizeof(VAL_T);
+      if (i + pf_offset + block <= end) {
+        for (int k = 0; k < block; ++k) {
+          Prefetch(data, data_indices[i + pf_offset + k]);
+        }
+      }
+    }
+  }
+
+  template <bool USE_INDICES, bool USE_HESSIAN>
+  LGBM_TARGET_SSE42 static data_size_t ConstructSSE42(
+      const VAL_T* data, const data_size_t* data_indices, data_size_t start,
+      data_size_t end, const score_t* ordered_gradients,
+      const score_t* ordered_hessians, hist_t* out) {
+    hist_cnt_t* cnt = reinterpret_cast<hist_cnt_t*>(out + 1);
+    alignas(16) uint32_t ti[4];
+    data_size_t i = start;
+    for (; i + 4 <= end; i += 4) {
+      PrefetchBlock<USE_INDICES>(data, data_indices, i, end, 4);
+      if (USE_INDICES) {
+        for (int k = 0; k < 4; ++k) {
+          ti[k] = Get(data, data_indices[i + k]) << 1;
+        }
+      } else {
+        _mm_store_si128(reinterpret_cast<__m128i*>(ti), _mm_slli_epi32(LoadBins4(data, i), 1));
+      }
+      const __m128 g = _mm_loadu_ps(ordered_gradients + i);
+      if (USE_HESSIAN) {
+        const __m128 h = _mm_loadu_ps(ordered_hessians + i);
+        const __m128 lo = _mm_unpacklo_ps(g, h);
+        const __m128 hi = _mm_unpackhi_ps(g, h);
+        AddPair(out + ti[0], _mm_cvtps_pd(lo));
+        AddPair(out + ti[1], _mm_cvtps_pd(_mm_movehl_ps(lo, lo)));
+        AddPair(out + ti[2], _mm_cvtps_pd(hi));
+        AddPair(out + ti[3], _mm_cvtps_pd(_mm_movehl_ps(hi, hi)));
+      } else {
+        alignas(16) hist_t gd[4];
+        _mm_store_pd(gd, _mm_cvtps_pd(g));
+        _mm_store_pd(gd + 2, _mm_cvtps_pd(_mm_movehl_ps(g, g)));
+        for (int k = 0; k < 4; ++k) {
+          out[ti[k]] += gd[k];
+          ++cnt[ti[k]];
+        }
+      }
+    }
+    return i;
+  }
+
+  template <bool USE_INDICES, bool USE_HESSIAN>
+  LGBM_TARGET_AVX2 static data_size_t ConstructAVX2(
+      const VAL_T* data, const data_size_t* data_indices, data_size_t start,
+      data_size_t end, const score_t* ordered_gradients,
+      const score_t* ordered_hessians, hist_t* out) {
+    hist_cnt_t* cnt = reinterpret_cast<hist_cnt_t*>(out + 1);
+    alignas(32) uint32_t ti[8];
+    data_size_t i = start;
+    for (; i + 8 <= end; i += 8) {
+      PrefetchBlock<USE_INDICES>(data, data_indices, i, end, 8);
+      const __m256i bins = USE_INDICES ? GatherBins8(data, data_indices, i) : LoadBins8(data, i);
+      _mm256_store_si256(reinterpret_cast<__m256i*>(ti), _mm256_slli_epi32(bins, 1));
+      const __m256 g = _mm256_loadu_ps(ordered_gradients + i);
+      if (USE_HESSIAN) {
+        const __m256 h = _mm256_loadu_ps(ordered_hessians + i);
+        // lo holds rows 0, 1, 4, 5 and hi holds rows 2, 3, 6, 7
+        const __m256 lo = _mm256_unpacklo_ps(g, h);
+        const __m256 hi = _mm256_unpackhi_ps(g, h);
+        const __m256d gh01 = _mm256_cvtps_pd(_mm256_castps256_ps128(lo));
+        const __m256d gh23 = _mm256_cvtps_pd(_mm256_castps256_ps128(hi));
+        const __m256d gh45 = _mm256_cvtps_pd(_mm256_extractf128_ps(lo, 1));
+        const __m256d gh67 = _mm256_cvtps_pd(_mm256_extractf128_ps(hi, 1));
+        AddPair(out + ti[0], _mm256_castpd256_pd128(gh01));
+        AddPair(out + ti[1], _mm256_extractf128_pd(gh01, 1));
+        AddPair(out + ti[2], _mm256_castpd256_pd128(gh23));
+        AddPair(out + ti[3], _mm256_extractf128_pd(gh23, 1));
+        AddPair(out + ti[4], _mm256_castpd256_pd128(gh45));
+        AddPair(out + ti[5], _mm256_extractf128_pd(gh45, 1));
+        AddPair(out + ti[6], _mm256_castpd256_pd128(gh67));
+        AddPair(out + ti[7], _mm256_extractf128_pd(gh67, 1));
+      } else {
+        alignas(32) hist_t gd[8];
+        _mm256_store_pd(gd, _mm256_cvtps_pd(_mm256_castps256_ps128(g)));
+        _mm256_store_pd(gd + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(g, 1)));
+        for (int k = 0; k < 8; ++k) {
+          out[ti[k]] += gd[k];
+          ++cnt[ti[k]];
+        }
+      }
+    }
+    return i;
+  }
+
+  /*!
+   * \brief Gather / add / scatter over 8 rows at a time.
+   * Rows sharing a bin are detected with vpconflictd and committed in rounds,
+   * a lane is only written once every earlier lane with the same bin has been.
+   */
+  template <bool USE_INDICES, bool USE_HESSIAN>
+  LGBM_TARGET_AVX512 static data_size_t ConstructAVX512(
+      const VAL_T* data, const data_size_t* data_indices, data_size_t start,
+      data_size_t end, const score_t* ordered_gradients,
+      const score_t* ordered_hessians, hist_t* out) {
+    const __m256i one_epi32 = _mm256_set1_epi32(1);
+    const __m512i one_epi64 = _mm512_set1_epi64(1);
+    const __m512d zero_pd = _mm512_setzero_pd();
+    const __m512i zero_epi64 = _mm512_setzero_si512();
+    data_size_t i = start;
+    for (; i + 8 <= end; i += 8) {
+      PrefetchBlock<USE_INDICES>(data, data_indices, i, end, 8);
+      const __m256i bins = USE_INDICES ? GatherBins8(data, data_indices, i) : LoadBins8(data, i);
+      const __m256i grad_idx = _mm256_slli_epi32(bins, 1);
+      const __m256i hess_idx = _mm256_add_epi32(grad_idx, one_epi32);
+      // the zero-masked form avoids a spurious -Wmaybe-uninitialized from GCC's _mm512_cvtps_pd
+      const __m512d g = _mm512_maskz_cvtps_pd(0xff, _mm256_loadu_ps(ordered_gradients + i));
+      const __m512d h = USE_HESSIAN ? _mm512_maskz_cvtps_pd(0xff, _mm256_loadu_ps(ordered_hessians + i)) : zero_pd;
+      // bit j of lane k is set when lane j < k has the same bin
+      const __m256i conflicts = _mm256_conflict_epi32(bins);
+      __mmask8 todo = 0xff;
+      while (todo) {
+        const __mmask8 blocked = _mm256_mask_test_epi32_mask(
+            todo, conflicts, _mm256_set1_epi32(static_cast<int>(todo)));
+        const __mmask8 ready = todo & static_cast<__mmask8>(~blocked);
+        const __m512d cur_g = _mm512_mask_i32gather_pd(zero_pd, ready, grad_idx, out, 8);
+        _mm512_mask_i32scatter_pd(out, ready, grad_idx, _mm512_add_pd(cur_g, g), 8);
+        if (USE_HESSIAN) {
+          const __m512d cur_h = _mm512_mask_i32gather_pd(zero_pd, ready, hess_idx, out, 8);
+          _mm512_mask_i32scatter_pd(out, ready, hess_idx, _mm512_add_pd(cur_h, h), 8);
+        } else {
+          const __m512i cur_c = _mm512_mask_i32gather_epi64(zero_epi64, ready, hess_idx, out, 8);
+          _mm512_mask_i32scatter_epi64(out, ready, hess_idx, _mm512_add_epi64(cur_c, one_epi64), 8);
+        }
+        todo &= static_cast<__mmask8>(~ready);
+      }
+    }
+    return i;
+  }
+};
+
+}  // namespace LightGBM
+
+#endif  // LGBM_DENSE_HIST_SIMD
+
+#endif  // LIGHTGBM_IO_DENSE_BIN_SIMD_HPP_
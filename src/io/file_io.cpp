@@ -8,9 +8,23 @@
 #include <LightGBM/utils/log.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <sstream>
 #include <unordered_map>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifdef USE_HDFS
 #include <hdfs.h>
 #endif
@@ -24,6 +38,11 @@ struct LocalFile : VirtualFileReader, VirtualFileWriter {
     if (file_ != NULL) {
       fclose(file_);
     }
+#ifdef _WIN32
+    if (overlapped_handle_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(overlapped_handle_);
+    }
+#endif
   }
 
   bool Init() {
@@ -32,6 +51,13 @@ struct LocalFile : VirtualFileReader, VirtualFileWriter {
       fopen_s(&file_, filename_.c_str(), mode_.c_str());
 #else
       file_ = fopen(filename_.c_str(), mode_.c_str());
+#endif
+#ifdef _WIN32
+      // ReadAt reads with another handle, a read of the handle of file_ would move its position
+      if (file_ != NULL && mode_[0] == 'r') {
+        overlapped_handle_ = CreateFileA(filename_.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                         OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+      }
 #endif
     }
     return file_ != NULL;
@@ -46,12 +72,67 @@ struct LocalFile : VirtualFileReader, VirtualFileWriter {
     return fread(buffer, 1, bytes, file_);
   }
 
+  size_t ReadAt(void* buffer, size_t bytes, size_t offset) const {
+    char* ptr = static_cast<char*>(buffer);
+    size_t cnt = 0;
+    while (cnt < bytes) {
+#ifdef _WIN32
+      if (overlapped_handle_ == INVALID_HANDLE_VALUE) {
+        Log::Fatal("Cannot open file %s for positional reads", filename_.c_str());
+      }
+      // ReadFile reads at most 4GB at a time, each read waits for its own event
+      const uint64_t position = static_cast<uint64_t>(offset + cnt);
+      OVERLAPPED overlapped = {};
+      overlapped.Offset = static_cast<DWORD>(position);
+      overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+      overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+      if (overlapped.hEvent == NULL) {
+        Log::Fatal("Cannot create the event to read file %s, error %lu", filename_.c_str(),
+                   static_cast<unsigned long>(GetLastError()));
+      }
+      DWORD ret = 0;
+      const DWORD to_read = static_cast<DWORD>(std::min<size_t>(bytes - cnt, MAXDWORD));
+      BOOL is_read = ReadFile(overlapped_handle_, ptr + cnt, to_read, NULL, &overlapped);
+      if (is_read || GetLastError() == ERROR_IO_PENDING) {
+        is_read = GetOverlappedResult(overlapped_handle_, &overlapped, &ret, TRUE);
+      }
+      const DWORD error = is_read ? ERROR_SUCCESS : GetLastError();
+      CloseHandle(overlapped.hEvent);
+      if (error == ERROR_HANDLE_EOF || (is_read && ret == 0)) {
+        break;
+      }
+      if (!is_read) {
+        Log::Fatal("Cannot read file %s at position %llu, error %lu", filename_.c_str(),
+                   static_cast<unsigned long long>(position), static_cast<unsigned long>(error));
+      }
+#else
+      const ssize_t ret = pread(fileno(file_), ptr + cnt, bytes - cnt, static_cast<off_t>(offset + cnt));
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret < 0) {
+        Log::Fatal("Cannot read file %s at position %llu: %s", filename_.c_str(),
+                   static_cast<unsigned long long>(offset + cnt), std::strerror(errno));
+      }
+      if (ret == 0) {
+        break;
+      }
+#endif
+      cnt += static_cast<size_t>(ret);
+    }
+    return cnt;
+  }
+
   size_t Write(const void* buffer, size_t bytes) const {
     return fwrite(buffer, bytes, 1, file_) == 1 ? bytes : 0;
   }
 
  private:
   FILE* file_ = NULL;
+#ifdef _WIN32
+  /*! \brief handle opened with FILE_FLAG_OVERLAPPED for ReadAt */
+  HANDLE overlapped_handle_ = INVALID_HANDLE_VALUE;
+#endif
   const std::string filename_;
   const std::string mode_;
 };
@@ -94,6 +175,24 @@ struct HDFSFile : VirtualFileReader, VirtualFileWriter {
     return FileOperation<void*>(data, bytes, &hdfsRead);
   }
 
+  size_t ReadAt(void* data, size_t bytes, size_t offset) const {
+    char* buffer = static_cast<char*>(data);
+    size_t cnt = 0;
+    while (cnt < bytes) {
+      size_t nmax = static_cast<size_t>(std::numeric_limits<tSize>::max());
+      tSize ret = hdfsPread(fs_, file_, static_cast<tOffset>(offset + cnt), buffer + cnt,
+                            static_cast<tSize>(std::min(nmax, bytes - cnt)));
+      if (ret > 0) {
+        cnt += static_cast<size_t>(ret);
+      } else if (ret == 0) {
+        break;
+      } else if (errno != EINTR) {
+        Log::Fatal("Failed HDFS file operation [%s]", strerror(errno));
+      }
+    }
+    return cnt;
+  }
+
   size_t Write(const void* data, size_t bytes) const {
     return FileOperation<const void*>(data, bytes, &hdfsWrite);
   }
@@ -186,6 +285,58 @@ std::unique_ptr<VirtualFileWriter> VirtualFileWriter::Make(
   return std::unique_ptr<VirtualFileWriter>(new LocalFile(filename, "wb"));
 }
 
+std::unique_ptr<MappedFile> MappedFile::Make(const std::string& filename) {
+  if (0 == filename.find(kHdfsProto)) {
+    return nullptr;
+  }
+  char* data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER file_size;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+    // the view keeps the mapping alive after its handle is closed
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (mapping != NULL) {
+      data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+      size = static_cast<size_t>(file_size.QuadPart);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    size = static_cast<size_t>(file_stat.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      data = static_cast<char*>(addr);
+    }
+  }
+  close(fd);
+#endif
+  if (data == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(new MappedFile(data, size));
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+#else
+  munmap(data_, size_);
+#endif
+}
+
 bool VirtualFileWriter::Exists(const std::string& filename) {
 #ifdef USE_HDFS
   if (0 == filename.find(kHdfsProto)) {
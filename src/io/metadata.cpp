@@ -472,7 +472,7 @@ void Metadata::LoadQueryWeights() {
   }
 }
 
-void Metadata::LoadFromMemory(const void* memory) {
+void Metadata::LoadFromMemory(const void* memory, bool in_place) {
   const char* mem_ptr = reinterpret_cast<const char*>(memory);
 
   num_data_ = *(reinterpret_cast<const data_size_t*>(mem_ptr));
@@ -482,15 +482,23 @@ void Metadata::LoadFromMemory(const void* memory) {
   num_queries_ = *(reinterpret_cast<const data_size_t*>(mem_ptr));
   mem_ptr += VirtualFileWriter::AlignedSize(sizeof(num_queries_));
 
-  if (!label_.empty()) { label_.clear(); }
-  label_ = std::vector<label_t>(num_data_);
-  std::memcpy(label_.data(), mem_ptr, sizeof(label_t) * num_data_);
+  if (in_place) {
+    label_.SetView(reinterpret_cast<const label_t*>(mem_ptr), num_data_);
+  } else {
+    if (!label_.empty()) { label_.clear(); }
+    label_ = std::vector<label_t>(num_data_);
+    std::memcpy(label_.data(), mem_ptr, sizeof(label_t) * num_data_);
+  }
   mem_ptr += VirtualFileWriter::AlignedSize(sizeof(label_t) * num_data_);
 
   if (num_weights_ > 0) {
-    if (!weights_.empty()) { weights_.clear(); }
-    weights_ = std::vector<label_t>(num_weights_);
-    std::memcpy(weights_.data(), mem_ptr, sizeof(label_t) * num_weights_);
+    if (in_place) {
+      weights_.SetView(reinterpret_cast<const label_t*>(mem_ptr), num_weights_);
+    } else {
+      if (!weights_.empty()) { weights_.clear(); }
+      weights_ = std::vector<label_t>(num_weights_);
+      std::memcpy(weights_.data(), mem_ptr, sizeof(label_t) * num_weights_);
+    }
     mem_ptr += VirtualFileWriter::AlignedSize(sizeof(label_t) * num_weights_);
     weight_load_from_file_ = true;
   }
@@ -179,6 +179,67 @@ class MultiValSparseBin : public MultiValBin {
                                               gradients, hessians, out);
   }
 
+  template <bool USE_INDICES, bool USE_PREFETCH, bool ORDERED>
+  void ConstructIntHistogramInner(const data_size_t* data_indices,
+                                  data_size_t start, data_size_t end,
+                                  const int_score_t* int_gradients,
+                                  int_hist_t* out) const {
+    data_size_t i = start;
+    const VAL_T* data_ptr = data_.data();
+    if (USE_PREFETCH) {
+      const data_size_t pf_offset = 32 / sizeof(VAL_T);
+      const data_size_t pf_end = end - pf_offset;
+
+      for (; i < pf_end; ++i) {
+        const auto idx = USE_INDICES ? data_indices[i] : i;
+        const auto pf_idx =
+            USE_INDICES ? data_indices[i + pf_offset] : i + pf_offset;
+        if (!ORDERED) {
+          PREFETCH_T0(int_gradients + pf_idx);
+        }
+        PREFETCH_T0(row_ptr_.data() + pf_idx);
+        PREFETCH_T0(data_ptr + row_ptr_[pf_idx]);
+        const auto j_start = RowPtr(idx);
+        const auto j_end = RowPtr(idx + 1);
+        const int_hist_t entry = IntHistEntry(ORDERED ? int_gradients[i] : int_gradients[idx]);
+        for (auto j = j_start; j < j_end; ++j) {
+          out[data_ptr[j]] += entry;
+        }
+      }
+    }
+    for (; i < end; ++i) {
+      const auto idx = USE_INDICES ? data_indices[i] : i;
+      const auto j_start = RowPtr(idx);
+      const auto j_end = RowPtr(idx + 1);
+      const int_hist_t entry = IntHistEntry(ORDERED ? int_gradients[i] : int_gradients[idx]);
+      for (auto j = j_start; j < j_end; ++j) {
+        out[data_ptr[j]] += entry;
+      }
+    }
+  }
+
+  void ConstructIntHistogram(const data_size_t* data_indices, data_size_t start,
+                             data_size_t end, const int_score_t* int_gradients,
+                             int_hist_t* out) const override {
+    ConstructIntHistogramInner<true, true, false>(data_indices, start, end,
+                                                  int_gradients, out);
+  }
+
+  void ConstructIntHistogram(data_size_t start, data_size_t end,
+                             const int_score_t* int_gradients,
+                             int_hist_t* out) const override {
+    ConstructIntHistogramInner<false, false, false>(nullptr, start, end,
+                                                    int_gradients, out);
+  }
+
+  void ConstructIntHistogramOrdered(const data_size_t* data_indices,
+                                    data_size_t start, data_size_t end,
+                                    const int_score_t* ordered_int_gradients,
+                                    int_hist_t* out) const override {
+    ConstructIntHistogramInner<true, true, true>(data_indices, start, end,
+                                                 ordered_int_gradients, out);
+  }
+
   MultiValBin* CreateLike(data_size_t num_data, int num_bin, int,
                           double estimate_element_per_row,
                           const std::vector<uint32_t>& /*offsets*/) const override {
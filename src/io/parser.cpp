@@ -230,6 +230,41 @@ DataType GetDataType(const char* filename, bool header,
   return type;
 }
 
+void ParseSeparatedBlock(const std::string* lines, data_size_t num_lines, int num_col, char separator,
+                         int label_idx, Parser::AtofFunc atof, const char* format,
+                         double* out_values, double* out_labels) {
+  for (data_size_t i = 0; i < num_lines; ++i) {
+    const char* str = lines[i].c_str();
+    const char* line_end = str + lines[i].size();
+    out_labels[i] = 0.0f;
+    // atof stops at the separator, so the fields are found while they are parsed.
+    // as in ParseOneLine, a separator that ends the line does not start a field
+    int idx = 0;
+    int num_parsed_col = 0;
+    for (const char* begin = str; begin < line_end; ++idx) {
+      double val = 0.0f;
+      const char* end = atof(begin, &val);
+      if (end != line_end && *end != separator) {
+        Log::Fatal("Input format error when parsing as %s", format);
+      }
+      begin = end + 1;
+      if (idx == label_idx) {
+        out_labels[i] = val;
+        continue;
+      }
+      const int col = (label_idx >= 0 && idx > label_idx) ? idx - 1 : idx;
+      if (col < num_col) {
+        out_values[static_cast<size_t>(col) * num_lines + i] = val;
+        num_parsed_col = col + 1;
+      }
+    }
+    // the columns missing in the line
+    for (int col = num_parsed_col; col < num_col; ++col) {
+      out_values[static_cast<size_t>(col) * num_lines + i] = 0.0f;
+    }
+  }
+}
+
 Parser* Parser::CreateParser(const char* filename, bool header, int num_features, int label_idx, bool precise_float_parser) {
   const int n_read_line = 32;
   auto lines = ReadKLineFromFile(filename, header, n_read_line);
@@ -9,12 +9,22 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/log.h>
 
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace LightGBM {
 
+/*!
+* \brief ParseBlock of the formats with one value per column and a separator, splitting the lines
+*        while parsing the fields with atof, which stops at the separator
+* \param format Name of the format for the errors
+*/
+void ParseSeparatedBlock(const std::string* lines, data_size_t num_lines, int num_col, char separator,
+                         int label_idx, Parser::AtofFunc atof, const char* format,
+                         double* out_values, double* out_labels);
+
 class CSVParser: public Parser {
  public:
   explicit CSVParser(int label_idx, int total_columns, AtofFunc atof)
@@ -43,6 +53,13 @@ class CSVParser: public Parser {
     }
   }
 
+  bool SupportsParseBlock() const override { return true; }
+
+  void ParseBlock(const std::string* lines, data_size_t num_lines, int num_col,
+                  double* out_values, double* out_labels) const override {
+    ParseSeparatedBlock(lines, num_lines, num_col, ',', label_idx_, atof_, "CSV", out_values, out_labels);
+  }
+
   inline int NumFeatures() const override {
     return total_columns_ - (label_idx_ >= 0);
   }
@@ -80,6 +97,13 @@ class TSVParser: public Parser {
     }
   }
 
+  bool SupportsParseBlock() const override { return true; }
+
+  void ParseBlock(const std::string* lines, data_size_t num_lines, int num_col,
+                  double* out_values, double* out_labels) const override {
+    ParseSeparatedBlock(lines, num_lines, num_col, '\t', label_idx_, atof_, "TSV", out_values, out_labels);
+  }
+
   inline int NumFeatures() const override {
     return total_columns_ - (label_idx_ >= 0);
   }
@@ -11,9 +11,11 @@
 #include <LightGBM/utils/openmp_wrapper.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -23,6 +25,10 @@ template <typename VAL_T>
 class SparseBin;
 
 const size_t kNumFastIndex = 64;
+/*! \brief Bins with at most this fraction of non-zero rows also keep a row index of their non-zeros */
+const double kRowIndexMaxDensity = 0.05;
+/*! \brief The row index is used when one side of the intersection is this many times smaller */
+const data_size_t kRowIndexMinRatio = 8;
 
 template <typename VAL_T>
 class SparseBinIterator : public BinIterator {
@@ -102,6 +108,11 @@ class SparseBin : public Bin {
                           data_size_t end, const score_t* ordered_gradients,
                           const score_t* ordered_hessians,
                           hist_t* out) const override {
+    if (IntersectRowIndex(data_indices, start, end, [=](data_size_t i, VAL_T bin) {
+          ACC_GH(out, bin, ordered_gradients[i], ordered_hessians[i]);
+        })) {
+      return;
+    }
     data_size_t i_delta, cur_pos;
     InitIndex(data_indices[start], &i_delta, &cur_pos);
     data_size_t i = start;
@@ -148,11 +159,18 @@ class SparseBin : public Bin {
   void ConstructHistogram(const data_size_t* data_indices, data_size_t start,
                           data_size_t end, const score_t* ordered_gradients,
                           hist_t* out) const override {
+    hist_t* grad = out;
+    hist_cnt_t* cnt = reinterpret_cast<hist_cnt_t*>(out + 1);
+    if (IntersectRowIndex(data_indices, start, end, [=](data_size_t i, VAL_T bin) {
+          const uint32_t ti = static_cast<uint32_t>(bin) << 1;
+          grad[ti] += ordered_gradients[i];
+          ++cnt[ti];
+        })) {
+      return;
+    }
     data_size_t i_delta, cur_pos;
     InitIndex(data_indices[start], &i_delta, &cur_pos);
     data_size_t i = start;
-    hist_t* grad = out;
-    hist_cnt_t* cnt = reinterpret_cast<hist_cnt_t*>(out + 1);
     for (;;) {
       if (cur_pos < data_indices[i]) {
         cur_pos += deltas_[++i_delta];
@@ -197,6 +215,127 @@ class SparseBin : public Bin {
   }
 #undef ACC_GH
 
+  void ConstructIntHistogram(const data_size_t* data_indices, data_size_t start,
+                             data_size_t end,
+                             const int_score_t* ordered_int_gradients,
+                             int_hist_t* out) const override {
+    if (IntersectRowIndex(data_indices, start, end, [=](data_size_t i, VAL_T bin) {
+          out[bin] += IntHistEntry(ordered_int_gradients[i]);
+        })) {
+      return;
+    }
+    data_size_t i_delta, cur_pos;
+    InitIndex(data_indices[start], &i_delta, &cur_pos);
+    data_size_t i = start;
+    for (;;) {
+      if (cur_pos < data_indices[i]) {
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      } else if (cur_pos > data_indices[i]) {
+        if (++i >= end) {
+          break;
+        }
+      } else {
+        out[vals_[i_delta]] += IntHistEntry(ordered_int_gradients[i]);
+        if (++i >= end) {
+          break;
+        }
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      }
+    }
+  }
+
+  void ConstructIntHistogram(data_size_t start, data_size_t end,
+                             const int_score_t* ordered_int_gradients,
+                             int_hist_t* out) const override {
+    data_size_t i_delta, cur_pos;
+    InitIndex(start, &i_delta, &cur_pos);
+    while (cur_pos < start && i_delta < num_vals_) {
+      cur_pos += deltas_[++i_delta];
+    }
+    while (cur_pos < end && i_delta < num_vals_) {
+      out[vals_[i_delta]] += IntHistEntry(ordered_int_gradients[cur_pos]);
+      cur_pos += deltas_[++i_delta];
+    }
+  }
+
+  /*!
+  * \brief First position in [first, last) of the sorted array whose value is not less than
+  *        value, found by doubling the step from first and a binary search in the last step
+  */
+  template <typename T>
+  static inline data_size_t GallopLowerBound(const T* arr, data_size_t first,
+                                             data_size_t last, T value) {
+    data_size_t lo = first;
+    data_size_t hi = first;
+    data_size_t step = 1;
+    while (hi < last && arr[hi] < value) {
+      lo = hi + 1;
+      hi += step;
+      step <<= 1;
+    }
+    hi = std::min(hi, last);
+    return static_cast<data_size_t>(std::lower_bound(arr + lo, arr + hi, value) - arr);
+  }
+
+  /*!
+  * \brief Call acc(i, bin) for every i in [start, end) whose row data_indices[i] has a non-zero bin,
+  *        by intersecting the sorted leaf rows with the row index. Each element of the smaller
+  *        side is looked up in the larger one, so the cost is O(min * log(max / min))
+  * \return false if the bin has no row index or both sides have similar sizes, then nothing is done
+  */
+  template <typename ACC>
+  inline bool IntersectRowIndex(const data_size_t* data_indices, data_size_t start,
+                                data_size_t end, ACC acc) const {
+    if (!is_row_index_built_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(row_index_mutex_);
+      if (!is_row_index_built_.load(std::memory_order_relaxed)) {
+        GetRowIndex();
+      }
+    }
+    if (row_index_.empty()) {
+      return false;
+    }
+    const data_size_t* rows = row_index_.data();
+    const data_size_t num_rows = static_cast<data_size_t>(row_index_.size());
+    data_size_t k = static_cast<data_size_t>(
+        std::lower_bound(rows, rows + num_rows, data_indices[start]) - rows);
+    const data_size_t k_end = static_cast<data_size_t>(
+        std::upper_bound(rows + k, rows + num_rows, data_indices[end - 1]) - rows);
+    const data_size_t num_leaf = end - start;
+    const data_size_t num_nonzero = k_end - k;
+    if (num_nonzero * kRowIndexMinRatio < num_leaf) {
+      data_size_t i = start;
+      for (; k < k_end; ++k) {
+        i = GallopLowerBound(data_indices, i, end, rows[k]);
+        if (i >= end) {
+          break;
+        }
+        if (data_indices[i] == rows[k]) {
+          acc(i, row_vals_[k]);
+        }
+      }
+      return true;
+    } else if (num_leaf * kRowIndexMinRatio < num_nonzero) {
+      for (data_size_t i = start; i < end; ++i) {
+        k = GallopLowerBound(rows, k, k_end, data_indices[i]);
+        if (k >= k_end) {
+          break;
+        }
+        if (rows[k] == data_indices[i]) {
+          acc(i, row_vals_[k]);
+        }
+      }
+      return true;
+    }
+    return false;
+  }
+
   inline void NextNonzeroFast(data_size_t* i_delta,
                               data_size_t* cur_pos) const {
     *cur_pos += deltas_[++(*i_delta)];
@@ -412,6 +551,48 @@ class SparseBin : public Bin {
   void* get_data() override { return nullptr; }
 
   void FinishLoad() override {
+    std::vector<std::pair<data_size_t, VAL_T>>& idx_val_pairs = MergePushBuffers();
+    if (is_flushed_) {
+      AppendPairs(idx_val_pairs);
+      FinishDeltas();
+      is_flushed_ = false;
+    } else {
+      // load delta array
+      LoadFromPair(idx_val_pairs);
+    }
+    // all the rows are pushed, the buffers of the threads were kept by the flushes
+    for (auto& push_buffer : push_buffers_) {
+      push_buffer.clear();
+      push_buffer.shrink_to_fit();
+    }
+  }
+
+  void FlushPushedData() override {
+    std::vector<std::pair<data_size_t, VAL_T>>& idx_val_pairs = MergePushBuffers();
+    if (!is_flushed_) {
+      deltas_.clear();
+      vals_.clear();
+      last_pair_idx_ = 0;
+      is_flushed_ = true;
+    }
+    AppendPairs(idx_val_pairs);
+    // keep the memory for the next rows
+    idx_val_pairs.clear();
+  }
+
+  void LoadFromPair(
+      const std::vector<std::pair<data_size_t, VAL_T>>& idx_val_pairs) {
+    deltas_.clear();
+    vals_.clear();
+    deltas_.reserve(idx_val_pairs.size());
+    vals_.reserve(idx_val_pairs.size());
+    last_pair_idx_ = 0;
+    AppendPairs(idx_val_pairs);
+    FinishDeltas();
+  }
+
+  /*! \brief Merge the push buffers into the first one, sorted by data index */
+  std::vector<std::pair<data_size_t, VAL_T>>& MergePushBuffers() {
     // get total non zero size
     size_t pair_cnt = 0;
     for (size_t i = 0; i < push_buffers_.size(); ++i) {
@@ -425,7 +606,9 @@ class SparseBin : public Bin {
       idx_val_pairs.insert(idx_val_pairs.end(), push_buffers_[i].begin(),
                            push_buffers_[i].end());
       push_buffers_[i].clear();
-      push_buffers_[i].shrink_to_fit();
+      if (!is_flushed_) {
+        push_buffers_[i].shrink_to_fit();
+      }
     }
     // sort by data index
     std::sort(idx_val_pairs.begin(), idx_val_pairs.end(),
@@ -433,24 +616,20 @@ class SparseBin : public Bin {
                  const std::pair<data_size_t, VAL_T>& b) {
                 return a.first < b.first;
               });
-    // load delta array
-    LoadFromPair(idx_val_pairs);
+    return idx_val_pairs;
   }
 
-  void LoadFromPair(
+  /*! \brief Append sorted pairs after the last one to the delta array */
+  void AppendPairs(
       const std::vector<std::pair<data_size_t, VAL_T>>& idx_val_pairs) {
-    deltas_.clear();
-    vals_.clear();
-    deltas_.reserve(idx_val_pairs.size());
-    vals_.reserve(idx_val_pairs.size());
     // transform to delta array
-    data_size_t last_idx = 0;
+    data_size_t last_idx = last_pair_idx_;
     for (size_t i = 0; i < idx_val_pairs.size(); ++i) {
       const data_size_t cur_idx = idx_val_pairs[i].first;
       const VAL_T bin = idx_val_pairs[i].second;
       data_size_t cur_delta = cur_idx - last_idx;
       // disallow the multi-val in one row
-      if (i > 0 && cur_delta == 0) {
+      if (!deltas_.empty() && cur_delta == 0) {
         continue;
       }
       while (cur_delta >= 256) {
@@ -462,6 +641,10 @@ class SparseBin : public Bin {
       vals_.push_back(bin);
       last_idx = cur_idx;
     }
+    last_pair_idx_ = last_idx;
+  }
+
+  void FinishDeltas() {
     // avoid out of range
     deltas_.push_back(0);
     num_vals_ = static_cast<data_size_t>(vals_.size());
@@ -472,6 +655,7 @@ class SparseBin : public Bin {
 
     // generate fast index
     GetFastIndex();
+    GetRowIndex();
   }
 
   void GetFastIndex() {
@@ -502,6 +686,36 @@ class SparseBin : public Bin {
     fast_index_.shrink_to_fit();
   }
 
+  /*!
+  * \brief Keep the absolute rows and bins of the non-zeros when the bin is sparse enough,
+  *        so that small leaves do not have to walk all deltas between their rows
+  */
+  void GetRowIndex() const {
+    row_index_.clear();
+    row_vals_.clear();
+    data_size_t num_nonzero = 0;
+    for (data_size_t i = 0; i < num_vals_; ++i) {
+      if (vals_[i] != 0) {
+        ++num_nonzero;
+      }
+    }
+    if (num_nonzero > 0 && num_nonzero <= num_data_ * kRowIndexMaxDensity) {
+      row_index_.reserve(num_nonzero);
+      row_vals_.reserve(num_nonzero);
+      data_size_t cur_pos = 0;
+      for (data_size_t i = 0; i < num_vals_; ++i) {
+        cur_pos += deltas_[i];
+        if (vals_[i] != 0) {
+          row_index_.push_back(cur_pos);
+          row_vals_.push_back(vals_[i]);
+        }
+      }
+    }
+    row_index_.shrink_to_fit();
+    row_vals_.shrink_to_fit();
+    is_row_index_built_.store(true, std::memory_order_release);
+  }
+
   void SaveBinaryToFile(const VirtualFileWriter* writer) const override {
     writer->AlignedWrite(&num_vals_, sizeof(num_vals_));
     writer->AlignedWrite(deltas_.data(), sizeof(uint8_t) * (num_vals_ + 1));
@@ -539,6 +753,7 @@ class SparseBin : public Bin {
     if (local_used_indices.empty()) {
       // generate fast index
       GetFastIndex();
+      GetRowIndex();
     } else {
       std::vector<std::pair<data_size_t, VAL_T>> tmp_pair;
       data_size_t cur_pos = 0;
@@ -558,6 +773,23 @@ class SparseBin : public Bin {
     }
   }
 
+  void LoadFromMappedMemory(const void* memory, data_size_t num_data) override {
+    num_data_ = num_data;
+    const char* mem_ptr = reinterpret_cast<const char*>(memory);
+    num_vals_ = *(reinterpret_cast<const data_size_t*>(mem_ptr));
+    mem_ptr += VirtualFileWriter::AlignedSize(sizeof(num_vals_));
+    // the saved deltas end with the 0 added after the last non-zero
+    deltas_.SetView(reinterpret_cast<const uint8_t*>(mem_ptr), num_vals_ + 1);
+    mem_ptr += VirtualFileWriter::AlignedSize(sizeof(uint8_t) * (num_vals_ + 1));
+    vals_.SetView(reinterpret_cast<const VAL_T*>(mem_ptr), num_vals_);
+    GetFastIndex();
+    // built by the first histogram that uses it, so that bins of features which are
+    // never split on do not take private memory next to the mapping
+    std::vector<data_size_t>().swap(row_index_);
+    std::vector<VAL_T>().swap(row_vals_);
+    is_row_index_built_.store(false, std::memory_order_release);
+  }
+
   void CopySubrow(const Bin* full_bin, const data_size_t* used_indices,
                   data_size_t num_used_indices) override {
     auto other_bin = dynamic_cast<const SparseBin<VAL_T>*>(full_bin);
@@ -594,6 +826,7 @@ class SparseBin : public Bin {
 
     // generate fast index
     GetFastIndex();
+    GetRowIndex();
   }
 
   SparseBin<VAL_T>* Clone() override;
@@ -605,7 +838,10 @@ class SparseBin : public Bin {
         num_vals_(other.num_vals_),
         push_buffers_(other.push_buffers_),
         fast_index_(other.fast_index_),
-        fast_index_shift_(other.fast_index_shift_) {}
+        fast_index_shift_(other.fast_index_shift_),
+        row_index_(other.row_index_),
+        row_vals_(other.row_vals_),
+        is_row_index_built_(other.is_row_index_built_.load(std::memory_order_acquire)) {}
 
   void InitIndex(data_size_t start_idx, data_size_t* i_delta,
                  data_size_t* cur_pos) const {
@@ -622,13 +858,23 @@ class SparseBin : public Bin {
 
  private:
   data_size_t num_data_;
-  std::vector<uint8_t, Common::AlignmentAllocator<uint8_t, kAlignedSize>>
-      deltas_;
-  std::vector<VAL_T, Common::AlignmentAllocator<VAL_T, kAlignedSize>> vals_;
+  Common::ViewableVector<uint8_t, Common::AlignmentAllocator<uint8_t, kAlignedSize>> deltas_;
+  Common::ViewableVector<VAL_T, Common::AlignmentAllocator<VAL_T, kAlignedSize>> vals_;
   data_size_t num_vals_;
   std::vector<std::vector<std::pair<data_size_t, VAL_T>>> push_buffers_;
+  /*! \brief True when FlushPushedData appended pairs to the deltas that are not finished */
+  bool is_flushed_ = false;
+  /*! \brief Data index of the last pair appended to the deltas */
+  data_size_t last_pair_idx_ = 0;
   std::vector<std::pair<data_size_t, data_size_t>> fast_index_;
   data_size_t fast_index_shift_;
+  /*! \brief Sorted rows of the non-zeros, empty unless the density is below kRowIndexMaxDensity */
+  mutable std::vector<data_size_t> row_index_;
+  /*! \brief Bins of the rows in row_index_ */
+  mutable std::vector<VAL_T> row_vals_;
+  /*! \brief False until row_index_ is built, bins loaded from a mapped file build it when first used */
+  mutable std::atomic<bool> is_row_index_built_{false};
+  mutable std::mutex row_index_mutex_;
 };
 
 template <typename VAL_T>
@@ -13,6 +13,7 @@ MultiValBinWrapper::MultiValBinWrapper(MultiValBin* bin, data_size_t num_data,
     feature_groups_contained_(feature_groups_contained) {
   num_threads_ = OMP_NUM_THREADS();
   num_data_ = num_data;
+  use_tree_merge_ = NUMA::NumNodes() > 1;
   multi_val_bin_.reset(bin);
   if (bin == nullptr) {
     return;
@@ -45,8 +46,7 @@ void MultiValBinWrapper::InitTrain(const std::vector<int>& group_feature_start,
   }
 }
 
-void MultiValBinWrapper::HistMove(const std::vector<hist_t,
-  Common::AlignmentAllocator<hist_t, kAlignedSize>>& hist_buf) {
+void MultiValBinWrapper::HistMove(const HistBuffer& hist_buf) {
   if (!is_use_subcol_) {
     return;
   }
@@ -59,31 +59,61 @@ void MultiValBinWrapper::HistMove(const std::vector<hist_t,
   }
 }
 
-void MultiValBinWrapper::HistMerge(std::vector<hist_t,
-  Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf) {
-  int n_bin_block = 1;
-  int bin_block_size = num_bin_;
-  Threading::BlockInfo<data_size_t>(num_threads_, num_bin_, 512, &n_bin_block,
-                                  &bin_block_size);
+void MultiValBinWrapper::HistMerge(HistBuffer* hist_buf) {
   hist_t* dst = origin_hist_data_;
   if (is_use_subcol_) {
     dst = hist_buf->data() + hist_buf->size() - 2 * static_cast<size_t>(num_bin_aligned_);
   }
-  #pragma omp parallel for schedule(static, 1) num_threads(num_threads_)
-  for (int t = 0; t < n_bin_block; ++t) {
-    const int start = t * bin_block_size;
-    const int end = std::min(start + bin_block_size, num_bin_);
-    for (int tid = 1; tid < n_data_block_; ++tid) {
-      auto src_ptr = hist_buf->data() + static_cast<size_t>(num_bin_aligned_) * 2 * (tid - 1);
-      for (int i = start * 2; i < end * 2; ++i) {
-        dst[i] += src_ptr[i];
+  MergeBlocks<hist_t, 2>(hist_buf->data(), dst);
+}
+
+template <typename HIST_T, int ENTRIES_PER_BIN>
+void MultiValBinWrapper::MergeBlocks(HIST_T* buf, HIST_T* dst) {
+  const size_t block_stride = static_cast<size_t>(num_bin_aligned_) * ENTRIES_PER_BIN;
+  auto block_ptr = [buf, dst, block_stride] (int block_id) {
+    return block_id == 0 ? dst : buf + block_stride * (block_id - 1);
+  };
+  if (!use_tree_merge_ || n_data_block_ <= 2) {
+    int n_bin_block = 1;
+    int bin_block_size = num_bin_;
+    Threading::BlockInfo<data_size_t>(num_threads_, num_bin_, 512, &n_bin_block,
+                                    &bin_block_size);
+    #pragma omp parallel for schedule(static, 1) num_threads(num_threads_)
+    for (int t = 0; t < n_bin_block; ++t) {
+      const int start = t * bin_block_size;
+      const int end = std::min(start + bin_block_size, num_bin_);
+      for (int tid = 1; tid < n_data_block_; ++tid) {
+        auto src_ptr = block_ptr(tid);
+        for (int i = start * ENTRIES_PER_BIN; i < end * ENTRIES_PER_BIN; ++i) {
+          dst[i] += src_ptr[i];
+        }
+      }
+    }
+    return;
+  }
+  // pairwise merge, block i takes block i + step in round step = 1, 2, 4, ...
+  // the two blocks of a pair were built by nearby threads, on the same node under compact affinity
+  for (int step = 1; step < n_data_block_; step <<= 1) {
+    const int num_pairs = (n_data_block_ - 1 - step) / (2 * step) + 1;
+    int n_bin_block = 1;
+    int bin_block_size = num_bin_;
+    Threading::BlockInfo<int>(std::max(1, num_threads_ / num_pairs), num_bin_, 512,
+                              &n_bin_block, &bin_block_size);
+    #pragma omp parallel for schedule(static) num_threads(num_threads_)
+    for (int task = 0; task < num_pairs * n_bin_block; ++task) {
+      const int dst_block = task / n_bin_block * 2 * step;
+      const int start = task % n_bin_block * bin_block_size;
+      const int end = std::min(start + bin_block_size, num_bin_);
+      HIST_T* dst_ptr = block_ptr(dst_block);
+      const HIST_T* src_ptr = block_ptr(dst_block + step);
+      for (int i = start * ENTRIES_PER_BIN; i < end * ENTRIES_PER_BIN; ++i) {
+        dst_ptr[i] += src_ptr[i];
       }
     }
   }
 }
 
-void MultiValBinWrapper::ResizeHistBuf(std::vector<hist_t,
-  Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf,
+void MultiValBinWrapper::ResizeHistBuf(HistBuffer* hist_buf,
   MultiValBin* sub_multi_val_bin,
   hist_t* origin_hist_data) {
   num_bin_ = sub_multi_val_bin->num_bin();
@@ -91,7 +121,42 @@ void MultiValBinWrapper::ResizeHistBuf(std::vector<hist_t,
   origin_hist_data_ = origin_hist_data;
   size_t new_buf_size = static_cast<size_t>(n_data_block_) * static_cast<size_t>(num_bin_aligned_) * 2;
   if (hist_buf->size() < new_buf_size) {
-    hist_buf->resize(new_buf_size);
+    // the old contents are not needed, a fresh buffer avoids touching its pages here
+    HistBuffer(new_buf_size).swap(*hist_buf);
+  }
+}
+
+void MultiValBinWrapper::IntHistMove(const IntHistBuffer& int_hist_buf) {
+  if (!is_use_subcol_) {
+    return;
+  }
+  const int_hist_t* src = int_hist_buf.data() + int_hist_buf.size() -
+    static_cast<size_t>(num_bin_aligned_);
+  // the move offsets are kept in hist_t units, two per bin
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < static_cast<int>(hist_move_src_.size()); ++i) {
+    std::copy_n(src + hist_move_src_[i] / 2, hist_move_size_[i] / 2,
+                origin_int_hist_data_ + hist_move_dest_[i] / 2);
+  }
+}
+
+void MultiValBinWrapper::IntHistMerge(IntHistBuffer* int_hist_buf) {
+  int_hist_t* dst = origin_int_hist_data_;
+  if (is_use_subcol_) {
+    dst = int_hist_buf->data() + int_hist_buf->size() - static_cast<size_t>(num_bin_aligned_);
+  }
+  MergeBlocks<int_hist_t, 1>(int_hist_buf->data(), dst);
+}
+
+void MultiValBinWrapper::ResizeIntHistBuf(IntHistBuffer* int_hist_buf,
+  MultiValBin* sub_multi_val_bin,
+  int_hist_t* origin_int_hist_data) {
+  num_bin_ = sub_multi_val_bin->num_bin();
+  num_bin_aligned_ = (num_bin_ + kAlignedSize - 1) / kAlignedSize * kAlignedSize;
+  origin_int_hist_data_ = origin_int_hist_data;
+  size_t new_buf_size = static_cast<size_t>(n_data_block_) * static_cast<size_t>(num_bin_aligned_);
+  if (int_hist_buf->size() < new_buf_size) {
+    IntHistBuffer(new_buf_size).swap(*int_hist_buf);
   }
 }
 
@@ -388,19 +453,36 @@ void TrainingShareStates::SetMultiValBin(MultiValBin* bin, data_size_t num_data,
   const std::vector<std::unique_ptr<FeatureGroup>>& feature_groups,
   bool dense_only, bool sparse_only) {
   num_threads = OMP_NUM_THREADS();
-  if (bin == nullptr) {
-    return;
-  }
   std::vector<int> feature_groups_contained;
+  feature_col_wise_group_.clear();
+  col_wise_group_elements_.clear();
+  feature_multi_val_elements_.clear();
   for (int group = 0; group < static_cast<int>(feature_groups.size()); ++group) {
     const auto& feature_group = feature_groups[group];
+    bool is_contained = false;
     if (feature_group->is_multi_val_) {
       if (!dense_only) {
         feature_groups_contained.push_back(group);
+        is_contained = true;
       }
     } else if (!sparse_only) {
       feature_groups_contained.push_back(group);
+      is_contained = true;
+    }
+    // a sparse group stores the non-zero values of its bundled features
+    double group_elements = 0.0f;
+    for (int i = 0; i < feature_group->num_feature_; ++i) {
+      const double elements = 1.0f - feature_group->bin_mappers_[i]->sparse_rate();
+      group_elements += elements;
+      feature_col_wise_group_.push_back(is_contained ? -1 : static_cast<int>(col_wise_group_elements_.size()));
+      feature_multi_val_elements_.push_back(is_contained ? elements : 0.0f);
     }
+    if (!is_contained) {
+      col_wise_group_elements_.push_back(feature_group->is_sparse_ ? std::min(group_elements, 1.0) : 1.0f);
+    }
+  }
+  if (bin == nullptr) {
+    return;
   }
   num_total_bin_ += bin->num_bin();
   num_elements_per_row_ += bin->num_element_per_row();
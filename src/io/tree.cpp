@@ -1024,6 +1024,297 @@ void Tree::TreeSHAPByMap(const std::unordered_map<int, double>& feature_values,
   }
 }
 
+void Tree::PrecomputeSHAP(int max_table_features, int64_t max_table_size) {
+  if (num_leaves_ <= 1 || !shap_leaves_.empty()) {
+    return;
+  }
+  FreeSHAP();
+  shap_leaves_.resize(num_leaves_);
+  std::vector<SHAPPathStep> path;
+  std::vector<double> shapley_weights;
+  std::vector<double> polynomials;
+  std::function<void(int)> visit = [&](int node) {
+    if (node >= 0) {
+      path.push_back({node, 0, true});
+      visit(left_child_[node]);
+      path.back().is_left = false;
+      visit(right_child_[node]);
+      path.pop_back();
+      return;
+    }
+    SHAPLeaf& leaf = shap_leaves_[~node];
+    leaf.path_begin = static_cast<int>(shap_path_.size());
+    leaf.feature_begin = static_cast<int>(shap_features_.size());
+    // the splits on the same feature are merged, as TreeSHAP unwinds and extends them
+    for (size_t i = 0; i < path.size(); ++i) {
+      SHAPPathStep step = path[i];
+      const int child = i + 1 < path.size() ? path[i + 1].node : node;
+      const double zero_fraction = data_count(child) / static_cast<double>(data_count(step.node));
+      const int feature = split_feature_[step.node];
+      step.feature_slot = 0;
+      while (leaf.feature_begin + step.feature_slot < static_cast<int>(shap_features_.size())
+             && shap_features_[leaf.feature_begin + step.feature_slot] != feature) {
+        ++step.feature_slot;
+      }
+      if (leaf.feature_begin + step.feature_slot == static_cast<int>(shap_features_.size())) {
+        shap_features_.push_back(feature);
+        shap_zero_fractions_.push_back(zero_fraction);
+      } else {
+        double* cur = &shap_zero_fractions_[leaf.feature_begin + step.feature_slot];
+        *cur = zero_fraction * (*cur);
+      }
+      shap_path_.push_back(step);
+    }
+    leaf.path_end = static_cast<int>(shap_path_.size());
+    leaf.num_features = static_cast<int>(shap_features_.size()) - leaf.feature_begin;
+    leaf.table_begin = -1;
+    const int d = leaf.num_features;
+    // a leaf with d features has d * 2^(d - 1) weights
+    if (d > max_table_features
+        || static_cast<int64_t>(shap_tables_.size()) + (static_cast<int64_t>(d) << (d - 1)) > max_table_size) {
+      return;
+    }
+    // Shapley weight of a subset of k of the other d - 1 features: k! (d - k - 1)! / d!
+    shapley_weights.resize(d);
+    shapley_weights[0] = 1.0 / d;
+    for (int k = 0; k + 1 < d; ++k) {
+      shapley_weights[k + 1] = shapley_weights[k] * (k + 1) / (d - k - 1);
+    }
+    const double* zero_fractions = shap_zero_fractions_.data() + leaf.feature_begin;
+    const int num_subsets = 1 << (d - 1);
+    leaf.table_begin = static_cast<int64_t>(shap_tables_.size());
+    shap_tables_.resize(shap_tables_.size() + static_cast<size_t>(d) * num_subsets);
+    polynomials.resize(static_cast<size_t>(num_subsets) * d);
+    for (int i = 0; i < d; ++i) {
+      double* table = shap_tables_.data() + leaf.table_begin + static_cast<int64_t>(i) * num_subsets;
+      // subset s of the features other than i, the features in s go the way of the path: the weight is
+      // sum over S in s of w(|S|) * prod over the other features not in S of their zero fraction, and
+      // the sums over |S| = k are the coefficients of prod over s of (x + zero fraction)
+      for (int subset = 0; subset < num_subsets; ++subset) {
+        double* poly = polynomials.data() + static_cast<size_t>(subset) * d;
+        std::fill(poly, poly + d, 0.0);
+        if (subset == 0) {
+          poly[0] = 1.0;
+        } else {
+          const int bit = subset & (-subset);
+          int slot = 0;
+          while ((1 << slot) != bit) {
+            ++slot;
+          }
+          const double z = zero_fractions[slot < i ? slot : slot + 1];
+          const double* prev = polynomials.data() + static_cast<size_t>(subset ^ bit) * d;
+          poly[0] = z * prev[0];
+          for (int k = 1; k < d; ++k) {
+            poly[k] = prev[k - 1] + z * prev[k];
+          }
+        }
+        double weight = 0.0;
+        for (int k = 0; k < d; ++k) {
+          weight += shapley_weights[k] * poly[k];
+        }
+        for (int slot = 0; slot + 1 < d; ++slot) {
+          if (((subset >> slot) & 1) == 0) {
+            weight *= zero_fractions[slot < i ? slot : slot + 1];
+          }
+        }
+        table[subset] = weight;
+      }
+    }
+  };
+  visit(0);
+}
+
+void Tree::FreeSHAP() {
+  std::vector<SHAPLeaf>().swap(shap_leaves_);
+  std::vector<SHAPPathStep>().swap(shap_path_);
+  std::vector<int>().swap(shap_features_);
+  std::vector<double>().swap(shap_zero_fractions_);
+  std::vector<double>().swap(shap_tables_);
+}
+
+void Tree::FastTreeSHAP(const double* feature_values, double* phi) const {
+  // the direction of every split for this row, instead of one pass of the recursion per leaf
+  static thread_local std::vector<int8_t> goes_left;
+  static thread_local std::vector<double> one_fractions;
+  static thread_local std::vector<PathElement> unique_path;
+  goes_left.resize(num_leaves_ - 1);
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    goes_left[node] = Decision(feature_values[split_feature_[node]], node) == left_child_[node];
+  }
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    const SHAPLeaf& cur = shap_leaves_[leaf];
+    const int d = cur.num_features;
+    const int* features = shap_features_.data() + cur.feature_begin;
+    const double* zero_fractions = shap_zero_fractions_.data() + cur.feature_begin;
+    const double value = leaf_value_[leaf];
+    if (cur.table_begin >= 0) {
+      // features whose splits all go the way of the path
+      uint32_t ones = (1u << d) - 1;
+      for (int i = cur.path_begin; i < cur.path_end; ++i) {
+        const SHAPPathStep& step = shap_path_[i];
+        if (static_cast<bool>(goes_left[step.node]) != step.is_left) {
+          ones &= ~(1u << step.feature_slot);
+        }
+      }
+      const double* table = shap_tables_.data() + cur.table_begin;
+      const int num_subsets = 1 << (d - 1);
+      for (int i = 0; i < d; ++i) {
+        const uint32_t low_mask = (1u << i) - 1;
+        const uint32_t others = (ones & low_mask) | ((ones >> (i + 1)) << i);
+        const double one_fraction = (ones >> i) & 1;
+        phi[features[i]] += table[i * num_subsets + others] * (one_fraction - zero_fractions[i]) * value;
+      }
+    } else {
+      one_fractions.assign(d, 1.0);
+      for (int i = cur.path_begin; i < cur.path_end; ++i) {
+        const SHAPPathStep& step = shap_path_[i];
+        if (static_cast<bool>(goes_left[step.node]) != step.is_left) {
+          one_fractions[step.feature_slot] = 0.0;
+        }
+      }
+      unique_path.resize(d + 1);
+      ExtendPath(unique_path.data(), 0, 1, 1, -1);
+      for (int i = 0; i < d; ++i) {
+        ExtendPath(unique_path.data(), i + 1, zero_fractions[i], one_fractions[i], features[i]);
+      }
+      for (int i = 1; i <= d; ++i) {
+        const double w = UnwoundPathSum(unique_path.data(), d, i);
+        const PathElement& el = unique_path[i];
+        phi[el.feature_index] += w * (el.one_fraction - el.zero_fraction) * value;
+      }
+    }
+  }
+}
+
+template <typename ADD_FUNCTION>
+void Tree::SHAPInteractions(const std::vector<int8_t>& goes_left, ADD_FUNCTION add_interaction) const {
+  static thread_local std::vector<double> one_fractions;
+  static thread_local std::vector<double> shapley_weights;
+  static thread_local std::vector<double> poly;
+  static thread_local std::vector<double> poly_i;
+  static thread_local std::vector<double> poly_ij;
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    const SHAPLeaf& cur = shap_leaves_[leaf];
+    const int d = cur.num_features;
+    if (d < 2) {
+      continue;
+    }
+    const int* features = shap_features_.data() + cur.feature_begin;
+    const double* zero_fractions = shap_zero_fractions_.data() + cur.feature_begin;
+    one_fractions.assign(d, 1.0);
+    for (int i = cur.path_begin; i < cur.path_end; ++i) {
+      const SHAPPathStep& step = shap_path_[i];
+      if (static_cast<bool>(goes_left[step.node]) != step.is_left) {
+        one_fractions[step.feature_slot] = 0.0;
+      }
+    }
+    // interaction of i and j: half of the Shapley value of i in the game of the other d - 1 features with j
+    // present minus the one with j absent, i.e. 1/2 * v * (o_i - z_i) * (o_j - z_j) * sum over S of the
+    // features other than i and j that follow the path of w(|S|) * prod over the others of their zero
+    // fraction, with w(k) = k! (d - k - 2)! / (d - 1)!
+    shapley_weights.resize(d - 1);
+    shapley_weights[0] = 1.0 / (d - 1);
+    for (int k = 0; k + 2 < d; ++k) {
+      shapley_weights[k + 1] = shapley_weights[k] * (k + 1) / (d - k - 2);
+    }
+    // prod over the features that follow the path of (x + z), its coefficient k sums the subsets of size k
+    poly.assign(d + 1, 0.0);
+    poly[0] = 1.0;
+    int degree = 0;
+    for (int i = 0; i < d; ++i) {
+      if (one_fractions[i] != 0.0) {
+        ++degree;
+        for (int k = degree; k > 0; --k) {
+          poly[k] = poly[k - 1] + zero_fractions[i] * poly[k];
+        }
+        poly[0] *= zero_fractions[i];
+      }
+    }
+    // removes the factor (x + z) of a feature that follows the path, z <= 1 keeps the division stable
+    auto divide = [](const std::vector<double>& from, int from_degree, double z, std::vector<double>* to) {
+      to->assign(from.size(), 0.0);
+      double carry = from[from_degree];
+      for (int k = from_degree - 1; k >= 0; --k) {
+        (*to)[k] = carry;
+        carry = from[k] - z * carry;
+      }
+    };
+    const double value = leaf_value_[leaf];
+    for (int i = 0; i < d; ++i) {
+      const double factor_i = one_fractions[i] - zero_fractions[i];
+      if (factor_i == 0.0) {
+        continue;
+      }
+      int degree_i = degree;
+      if (one_fractions[i] != 0.0) {
+        divide(poly, degree, zero_fractions[i], &poly_i);
+        --degree_i;
+      } else {
+        poly_i = poly;
+      }
+      for (int j = i + 1; j < d; ++j) {
+        const double factor_j = one_fractions[j] - zero_fractions[j];
+        if (factor_j == 0.0) {
+          continue;
+        }
+        int degree_ij = degree_i;
+        const std::vector<double>* cur_poly = &poly_i;
+        if (one_fractions[j] != 0.0) {
+          divide(poly_i, degree_i, zero_fractions[j], &poly_ij);
+          cur_poly = &poly_ij;
+          --degree_ij;
+        }
+        double weight = 0.0;
+        for (int k = 0; k <= degree_ij; ++k) {
+          weight += shapley_weights[k] * (*cur_poly)[k];
+        }
+        for (int l = 0; l < d; ++l) {
+          if (l != i && l != j && one_fractions[l] == 0.0) {
+            weight *= zero_fractions[l];
+          }
+        }
+        add_interaction(features[i], features[j], 0.5 * value * factor_i * factor_j * weight);
+      }
+    }
+  }
+}
+
+void Tree::PredictContribInteractions(const double* feature_values, int num_features, double* output) const {
+  if (num_leaves_ <= 1) {
+    return;
+  }
+  CHECK(!shap_leaves_.empty());
+  static thread_local std::vector<int8_t> goes_left;
+  goes_left.resize(num_leaves_ - 1);
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    goes_left[node] = Decision(feature_values[split_feature_[node]], node) == left_child_[node];
+  }
+  const int64_t num_cols = num_features + 1;
+  SHAPInteractions(goes_left, [output, num_cols](int i, int j, double value) {
+    output[i * num_cols + j] += value;
+    output[j * num_cols + i] += value;
+  });
+}
+
+void Tree::PredictContribInteractionsByMap(const std::unordered_map<int, double>& feature_values,
+                                           int num_features, std::unordered_map<int, double>* output) const {
+  if (num_leaves_ <= 1) {
+    return;
+  }
+  CHECK(!shap_leaves_.empty());
+  static thread_local std::vector<int8_t> goes_left;
+  goes_left.resize(num_leaves_ - 1);
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    const auto it = feature_values.find(split_feature_[node]);
+    goes_left[node] = Decision(it != feature_values.end() ? it->second : 0.0f, node) == left_child_[node];
+  }
+  const int num_cols = num_features + 1;
+  SHAPInteractions(goes_left, [output, num_cols](int i, int j, double value) {
+    (*output)[i * num_cols + j] += value;
+    (*output)[j * num_cols + i] += value;
+  });
+}
+
 double Tree::ExpectedValue() const {
   if (num_leaves_ == 1) return LeafOutput(0);
   const double total_count = internal_count_[0];
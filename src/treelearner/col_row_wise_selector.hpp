@@ -0,0 +1,132 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for
+ * license information.
+ */
+#ifndef LIGHTGBM_TREELEARNER_COL_ROW_WISE_SELECTOR_HPP_
+#define LIGHTGBM_TREELEARNER_COL_ROW_WISE_SELECTOR_HPP_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/train_share_states.h>
+
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Chooses between the col-wise and the row-wise histogram construction for every leaf.
+* By default it is an online cost model: leaves are bucketed by log2 of their number of data,
+* each bucket keeps an exponential moving average of the measured time per used feature of
+* both strategies. A bucket tries each strategy once, then takes the cheaper one and
+* re-measures the other one periodically, so the model follows costs that change during training.
+* The measured times differ between runs, so with deterministic=true the layouts are compared
+* by TrainingShareStates::HistogramCost instead, which only depends on the data, the used
+* features and the number of threads.
+*/
+class ColRowWiseSelector {
+ public:
+  /*! \brief Choose with the measured times */
+  ColRowWiseSelector() : buckets_(kNumBuckets) {}
+
+  /*!
+  * \brief Choose with TrainingShareStates::HistogramCost, the share states must outlive the selector
+  * \param primary Share states of the layout of the histogram pool
+  * \param alternative Share states of the other layout
+  */
+  ColRowWiseSelector(const TrainingShareStates* primary, const TrainingShareStates* alternative)
+    : primary_(primary), alternative_(alternative) {}
+
+  /*!
+  * \brief Use the same layout for all the leaves
+  * \param use_alternative true for the alternative layout, false for the primary one
+  */
+  explicit ColRowWiseSelector(bool use_alternative)
+    : is_fixed_(true), fixed_use_alternative_(use_alternative) {}
+
+  /*! \brief Whether the choices depend on the times given to AddSample */
+  bool IsTimed() const {
+    return !is_fixed_ && primary_ == nullptr;
+  }
+
+  /*!
+  * \brief Choose the strategy for a histogram of num_data rows
+  * \param num_data Number of data in the leaf
+  * \param is_feature_used Features whose histograms are built for the leaf
+  * \param is_feature_used_bytree Features sampled for the tree
+  * \return true for the alternative strategy, false for the primary one
+  */
+  bool UseAlternative(data_size_t num_data, const std::vector<int8_t>& is_feature_used,
+                      const std::vector<int8_t>& is_feature_used_bytree) {
+    if (is_fixed_) {
+      return fixed_use_alternative_;
+    }
+    if (primary_ != nullptr) {
+      return alternative_->HistogramCost(num_data, is_feature_used, is_feature_used_bytree) <
+             primary_->HistogramCost(num_data, is_feature_used, is_feature_used_bytree);
+    }
+    Bucket& bucket = buckets_[BucketIndex(num_data)];
+    for (int s = 0; s < 2; ++s) {
+      if (bucket.num_samples[s] == 0) {
+        return s == 1;
+      }
+    }
+    const int best = bucket.cost[1] < bucket.cost[0] ? 1 : 0;
+    if (++bucket.num_decisions % kExplorePeriod == 0) {
+      return best == 0;
+    }
+    return best == 1;
+  }
+
+  /*!
+  * \brief Record the time of one histogram construction, only used when IsTimed()
+  * \param use_alternative Strategy that was used
+  * \param num_data Number of data in the leaf
+  * \param used_feature_ratio Fraction of the features whose histograms were built
+  * \param milliseconds Measured time
+  */
+  void AddSample(bool use_alternative, data_size_t num_data,
+                 double used_feature_ratio, double milliseconds) {
+    Bucket& bucket = buckets_[BucketIndex(num_data)];
+    const int s = use_alternative ? 1 : 0;
+    const double cost = milliseconds / (used_feature_ratio > kMinUsedFeatureRatio
+                                        ? used_feature_ratio : kMinUsedFeatureRatio);
+    if (bucket.num_samples[s] == 0) {
+      bucket.cost[s] = cost;
+    } else {
+      bucket.cost[s] += kDecay * (cost - bucket.cost[s]);
+    }
+    ++bucket.num_samples[s];
+  }
+
+ private:
+  struct Bucket {
+    double cost[2] = {0.0, 0.0};
+    int num_samples[2] = {0, 0};
+    int num_decisions = 0;
+  };
+
+  static int BucketIndex(data_size_t num_data) {
+    int index = 0;
+    while (num_data > 1 && index < kNumBuckets - 1) {
+      num_data >>= 1;
+      ++index;
+    }
+    return index;
+  }
+
+  static const int kNumBuckets = 32;
+  /*! \brief one of kExplorePeriod decisions uses the currently slower strategy */
+  static const int kExplorePeriod = 32;
+  static constexpr double kDecay = 0.25;
+  static constexpr double kMinUsedFeatureRatio = 1e-3;
+
+  std::vector<Bucket> buckets_;
+  const TrainingShareStates* primary_ = nullptr;
+  const TrainingShareStates* alternative_ = nullptr;
+  bool is_fixed_ = false;
+  bool fixed_use_alternative_ = false;
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_TREELEARNER_COL_ROW_WISE_SELECTOR_HPP_
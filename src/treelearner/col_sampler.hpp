@@ -11,6 +11,7 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/random.h>
+#include <LightGBM/utils/threading.h>
 
 #include <algorithm>
 #include <unordered_set>
@@ -23,7 +24,8 @@ class ColSampler {
       : fraction_bytree_(config->feature_fraction),
         fraction_bynode_(config->feature_fraction_bynode),
         seed_(config->feature_fraction_seed),
-        random_(config->feature_fraction_seed) {
+        random_(config->feature_fraction_seed),
+        use_task_scheduler_(config->use_task_scheduler) {
     for (auto constraint : config->interaction_constraints_vector) {
       std::unordered_set<int> constraint_set(constraint.begin(), constraint.end());
       interaction_constraints_.push_back(constraint_set);
@@ -54,6 +56,7 @@ class ColSampler {
   void SetConfig(const Config* config) {
     fraction_bytree_ = config->feature_fraction;
     fraction_bynode_ = config->feature_fraction_bynode;
+    use_task_scheduler_ = config->use_task_scheduler;
     is_feature_used_.resize(train_data_->num_features(), 1);
     // seed is changed
     if (seed_ != config->feature_fraction_seed) {
@@ -78,6 +81,15 @@ class ColSampler {
       used_feature_indices_ = random_.Sample(
           static_cast<int>(valid_feature_indices_.size()), used_cnt_bytree_);
       int omp_loop_size = static_cast<int>(used_feature_indices_.size());
+      if (use_task_scheduler_) {
+        Threading::TaskFor<int>(omp_loop_size, 1024, [this](int start, int end) {
+          for (int i = start; i < end; ++i) {
+            int used_feature = valid_feature_indices_[used_feature_indices_[i]];
+            is_feature_used_[train_data_->InnerFeatureIndex(used_feature)] = 1;
+          }
+        });
+        return;
+      }
 
 #pragma omp parallel for schedule(static, 512) if (omp_loop_size >= 1024)
       for (int i = 0; i < omp_loop_size; ++i) {
@@ -194,6 +206,7 @@ class ColSampler {
   int used_cnt_bytree_;
   int seed_;
   Random random_;
+  bool use_task_scheduler_;
   std::vector<int8_t> is_feature_used_;
   std::vector<int> used_feature_indices_;
   std::vector<int> valid_feature_indices_;
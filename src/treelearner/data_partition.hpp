@@ -43,6 +43,10 @@ class DataPartition {
   ~DataPartition() {
   }
 
+  void SetUseTaskScheduler(bool use_task_scheduler) {
+    runner_.SetUseTaskScheduler(use_task_scheduler);
+  }
+
   /*!
   * \brief Init, will put all data on the root(leaf_idx = 0)
   */
@@ -97,23 +101,25 @@ class DataPartition {
   * \param feature_bins feature bin data
   * \param threshold threshold that want to split
   * \param right_leaf index of right leaf
+  * \param in_one_block Partition the leaf by the calling thread only, so that
+  *        different leaves can be split at the same time
   */
   void Split(int leaf, const Dataset* dataset, int feature,
              const uint32_t* threshold, int num_threshold, bool default_left,
-             int right_leaf) {
+             int right_leaf, bool in_one_block = false) {
     Common::FunctionTimer fun_timer("DataPartition::Split", global_timer);
     // get leaf boundary
     const data_size_t begin = leaf_begin_[leaf];
     const data_size_t cnt = leaf_count_[leaf];
     auto left_start = indices_.data() + begin;
-    const auto left_cnt = runner_.Run<false>(
-        cnt,
-        [=](int, data_size_t cur_start, data_size_t cur_cnt, data_size_t* left,
-            data_size_t* right) {
-          return dataset->Split(feature, threshold, num_threshold, default_left,
-                                left_start + cur_start, cur_cnt, left, right);
-        },
-        left_start);
+    auto split_block = [=](int, data_size_t cur_start, data_size_t cur_cnt, data_size_t* left,
+                           data_size_t* right) {
+      return dataset->Split(feature, threshold, num_threshold, default_left,
+                            left_start + cur_start, cur_cnt, left, right);
+    };
+    // the rows of a leaf are at [begin, begin + cnt) of indices_, so leaves use disjoint buffers
+    const auto left_cnt = in_one_block ? runner_.RunInOneBlock(begin, cnt, split_block, left_start)
+                                       : runner_.Run<false>(cnt, split_block, left_start);
     leaf_count_[leaf] = left_cnt;
     leaf_begin_[right_leaf] = left_cnt + begin;
     leaf_count_[right_leaf] = cnt - left_cnt;
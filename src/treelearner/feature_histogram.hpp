@@ -13,11 +13,13 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "monotone_constraints.hpp"
+#include "split_gain_simd.hpp"
 #include "split_info.hpp"
 
 namespace LightGBM {
@@ -877,7 +879,13 @@ class FeatureHistogram {
       constraints->InitCumulativeConstraints(REVERSE);
     }
 
-    if (REVERSE) {
+    if (!USE_MC && !USE_RAND && UseBatchedScan()) {
+      FindBestThresholdBatched<USE_L1, USE_MAX_OUTPUT, USE_SMOOTHING, REVERSE,
+                               SKIP_DEFAULT_BIN, NA_AS_MISSING>(
+          sum_gradient, sum_hessian, num_data, min_gain_shift, parent_output,
+          &best_gain, &best_left_count, &best_sum_left_gradient,
+          &best_sum_left_hessian, &best_threshold);
+    } else if (REVERSE) {
       double sum_right_gradient = 0.0f;
       double sum_right_hessian = kEpsilon;
       data_size_t right_count = 0;
@@ -1082,6 +1090,202 @@ class FeatureHistogram {
     }
   }
 
+  /*!
+   * \brief Whether the split gains are computed by blocks with the vectorized kernel,
+   *        the result is the same, only short histograms are faster with the scalar loop
+   */
+  bool UseBatchedScan() const {
+#ifdef LGBM_SIMD_X86
+    return meta_->num_bin >= kMinBinsForBatchedScan && SIMD::Level() >= kSIMDAVX2;
+#else
+    return false;
+#endif
+  }
+
+  /*!
+   * \brief Same scan as FindBestThresholdSequentially without monotone constraints and
+   *        random thresholds. The running sums stay sequential, so they are the same as
+   *        in the scalar loop; the gains are computed by blocks of candidates with the
+   *        vectorized kernel, then the blocks are searched in scan order with the same
+   *        tie-breaking
+   */
+  template <bool USE_L1, bool USE_MAX_OUTPUT, bool USE_SMOOTHING,
+            bool REVERSE, bool SKIP_DEFAULT_BIN, bool NA_AS_MISSING>
+  void FindBestThresholdBatched(double sum_gradient, double sum_hessian,
+                                data_size_t num_data, double min_gain_shift,
+                                double parent_output, double* best_gain,
+                                data_size_t* best_left_count,
+                                double* best_sum_left_gradient,
+                                double* best_sum_left_hessian,
+                                uint32_t* best_threshold) {
+    const int8_t offset = meta_->offset;
+    const double cnt_factor = num_data / sum_hessian;
+    const data_size_t min_data_in_leaf = meta_->config->min_data_in_leaf;
+    const double min_sum_hessian_in_leaf = meta_->config->min_sum_hessian_in_leaf;
+    SplitCandidates cand;
+    auto push = [&](double sum_left_gradient, double sum_left_hessian,
+                    data_size_t left_count, double sum_right_gradient,
+                    double sum_right_hessian, data_size_t right_count,
+                    uint32_t threshold) {
+      const int i = cand.size++;
+      cand.left_grad[i] = sum_left_gradient;
+      cand.left_hess[i] = sum_left_hessian;
+      cand.left_cnt[i] = left_count;
+      cand.right_grad[i] = sum_right_gradient;
+      cand.right_hess[i] = sum_right_hessian;
+      cand.right_cnt[i] = right_count;
+      cand.left_count[i] = left_count;
+      cand.threshold[i] = threshold;
+      if (cand.size == SplitCandidates::kSize) {
+        EvaluateCandidates<USE_L1, USE_MAX_OUTPUT, USE_SMOOTHING>(
+            &cand, min_gain_shift, parent_output, best_gain, best_left_count,
+            best_sum_left_gradient, best_sum_left_hessian, best_threshold);
+      }
+    };
+
+    if (REVERSE) {
+      double sum_right_gradient = 0.0f;
+      double sum_right_hessian = kEpsilon;
+      data_size_t right_count = 0;
+
+      int t = meta_->num_bin - 1 - offset - NA_AS_MISSING;
+      const int t_end = 1 - offset;
+
+      for (; t >= t_end; --t) {
+        if (SKIP_DEFAULT_BIN) {
+          if ((t + offset) == static_cast<int>(meta_->default_bin)) {
+            continue;
+          }
+        }
+        const auto grad = GET_GRAD(data_, t);
+        const auto hess = GET_HESS(data_, t);
+        data_size_t cnt =
+            static_cast<data_size_t>(Common::RoundInt(hess * cnt_factor));
+        sum_right_gradient += grad;
+        sum_right_hessian += hess;
+        right_count += cnt;
+        if (right_count < min_data_in_leaf ||
+            sum_right_hessian < min_sum_hessian_in_leaf) {
+          continue;
+        }
+        data_size_t left_count = num_data - right_count;
+        if (left_count < min_data_in_leaf) {
+          break;
+        }
+        double sum_left_hessian = sum_hessian - sum_right_hessian;
+        if (sum_left_hessian < min_sum_hessian_in_leaf) {
+          break;
+        }
+        double sum_left_gradient = sum_gradient - sum_right_gradient;
+        push(sum_left_gradient, sum_left_hessian, left_count, sum_right_gradient,
+             sum_right_hessian, right_count, static_cast<uint32_t>(t - 1 + offset));
+      }
+    } else {
+      double sum_left_gradient = 0.0f;
+      double sum_left_hessian = kEpsilon;
+      data_size_t left_count = 0;
+
+      int t = 0;
+      const int t_end = meta_->num_bin - 2 - offset;
+
+      if (NA_AS_MISSING) {
+        if (offset == 1) {
+          sum_left_gradient = sum_gradient;
+          sum_left_hessian = sum_hessian - kEpsilon;
+          left_count = num_data;
+          for (int i = 0; i < meta_->num_bin - offset; ++i) {
+            const auto grad = GET_GRAD(data_, i);
+            const auto hess = GET_HESS(data_, i);
+            data_size_t cnt =
+                static_cast<data_size_t>(Common::RoundInt(hess * cnt_factor));
+            sum_left_gradient -= grad;
+            sum_left_hessian -= hess;
+            left_count -= cnt;
+          }
+          t = -1;
+        }
+      }
+
+      for (; t <= t_end; ++t) {
+        if (SKIP_DEFAULT_BIN) {
+          if ((t + offset) == static_cast<int>(meta_->default_bin)) {
+            continue;
+          }
+        }
+        if (t >= 0) {
+          sum_left_gradient += GET_GRAD(data_, t);
+          sum_left_hessian += GET_HESS(data_, t);
+          left_count += static_cast<data_size_t>(
+              Common::RoundInt(GET_HESS(data_, t) * cnt_factor));
+        }
+        if (left_count < min_data_in_leaf ||
+            sum_left_hessian < min_sum_hessian_in_leaf) {
+          continue;
+        }
+        data_size_t right_count = num_data - left_count;
+        if (right_count < min_data_in_leaf) {
+          break;
+        }
+        double sum_right_hessian = sum_hessian - sum_left_hessian;
+        if (sum_right_hessian < min_sum_hessian_in_leaf) {
+          break;
+        }
+        double sum_right_gradient = sum_gradient - sum_left_gradient;
+        push(sum_left_gradient, sum_left_hessian, left_count, sum_right_gradient,
+             sum_right_hessian, right_count, static_cast<uint32_t>(t + offset));
+      }
+    }
+    EvaluateCandidates<USE_L1, USE_MAX_OUTPUT, USE_SMOOTHING>(
+        &cand, min_gain_shift, parent_output, best_gain, best_left_count,
+        best_sum_left_gradient, best_sum_left_hessian, best_threshold);
+  }
+
+  /*! \brief Compute the gains of a block of candidates, update the best one and empty the block */
+  template <bool USE_L1, bool USE_MAX_OUTPUT, bool USE_SMOOTHING>
+  void EvaluateCandidates(SplitCandidates* cand, double min_gain_shift,
+                          double parent_output, double* best_gain,
+                          data_size_t* best_left_count,
+                          double* best_sum_left_gradient,
+                          double* best_sum_left_hessian,
+                          uint32_t* best_threshold) {
+    const Config* config = meta_->config;
+    int i = 0;
+#ifdef LGBM_SIMD_X86
+    i = SplitGainSIMD<USE_L1, USE_MAX_OUTPUT, USE_SMOOTHING>::Run(
+        cand, config->lambda_l1, config->lambda_l2, config->max_delta_step,
+        config->path_smooth, parent_output);
+#endif
+    for (; i < cand->size; ++i) {
+      cand->gain[i] = GetSplitGains<false, USE_L1, USE_MAX_OUTPUT, USE_SMOOTHING>(
+          cand->left_grad[i], cand->left_hess[i], cand->right_grad[i],
+          cand->right_hess[i], config->lambda_l1, config->lambda_l2,
+          config->max_delta_step, nullptr, meta_->monotone_type,
+          config->path_smooth, cand->left_count[i],
+          static_cast<data_size_t>(cand->right_cnt[i]), parent_output);
+    }
+    for (i = 0; i < cand->size; ++i) {
+      const double current_gain = cand->gain[i];
+      // gain with split is worse than without split
+      if (current_gain <= min_gain_shift) {
+        continue;
+      }
+      // mark as able to be split
+      is_splittable_ = true;
+      // better split point
+      if (current_gain > *best_gain) {
+        *best_left_count = cand->left_count[i];
+        *best_sum_left_gradient = cand->left_grad[i];
+        *best_sum_left_hessian = cand->left_hess[i];
+        *best_threshold = cand->threshold[i];
+        *best_gain = current_gain;
+      }
+    }
+    cand->size = 0;
+  }
+
+  /*! \brief Features with fewer bins are scanned by the scalar loop */
+  static const int kMinBinsForBatchedScan = 16;
+
   const FeatureMetainfo* meta_;
   /*! \brief sum of gradient of each bin */
   hist_t* data_;
@@ -1111,8 +1315,9 @@ class HistogramPool {
    * \brief Reset pool size
    * \param cache_size Max cache size
    * \param total_size Total size will be used
+   * \param spill_size Max number of evicted histograms kept in quantized form
    */
-  void Reset(int cache_size, int total_size) {
+  void Reset(int cache_size, int total_size, int spill_size = 0) {
     cache_size_ = cache_size;
     // at least need 2 bucket to store smaller leaf and larger leaf
     CHECK_GE(cache_size_, 2);
@@ -1121,10 +1326,14 @@ class HistogramPool {
       cache_size_ = total_size_;
     }
     is_enough_ = (cache_size_ == total_size_);
+    spill_size_ = is_enough_ ? 0 : std::max(0, std::min(spill_size, total_size_ - cache_size_));
     if (!is_enough_) {
       mapper_.resize(total_size_);
       inverse_mapper_.resize(cache_size_);
       last_used_time_.resize(cache_size_);
+      spill_mapper_.resize(spill_size_ > 0 ? total_size_ : 0);
+      spill_inverse_mapper_.resize(spill_size_);
+      spill_last_used_time_.resize(spill_size_);
       ResetMap();
     }
   }
@@ -1138,7 +1347,30 @@ class HistogramPool {
       std::fill(mapper_.begin(), mapper_.end(), -1);
       std::fill(inverse_mapper_.begin(), inverse_mapper_.end(), -1);
       std::fill(last_used_time_.begin(), last_used_time_.end(), 0);
+      std::fill(spill_mapper_.begin(), spill_mapper_.end(), -1);
+      std::fill(spill_inverse_mapper_.begin(), spill_inverse_mapper_.end(), -1);
+      std::fill(spill_last_used_time_.begin(), spill_last_used_time_.end(), 0);
+    }
+  }
+
+  /*! \brief Whether the histograms of all leaves fit, then no histogram is ever evicted */
+  bool is_enough() const { return is_enough_; }
+
+  /*!
+   * \brief Choose the histograms to evict by the best split gain of their leaves instead of by the last usage
+   * \param best_split_per_leaf Best splits of the leaves, nullptr for least recently used eviction
+   */
+  void SetEvictionByGain(const std::vector<SplitInfo>* best_split_per_leaf) {
+    best_split_per_leaf_ = best_split_per_leaf;
+  }
+
+  /*! \brief Bytes of one histogram of all features kept in quantized form */
+  static size_t SpilledHistogramSize(const Dataset* train_data) {
+    size_t size = 0;
+    for (int i = 0; i < train_data->num_features(); ++i) {
+      size += kSpillEntrySize * train_data->FeatureNumBin(i) + 2 * sizeof(hist_t) + sizeof(int8_t);
     }
+    return size;
   }
   template <bool USE_DATA, bool USE_CONFIG>
   static void SetFeatureInfo(const Dataset* train_data, const Config* config,
@@ -1183,7 +1415,7 @@ class HistogramPool {
 
   void DynamicChangeSize(const Dataset* train_data, int num_total_bin,
                         const std::vector<uint32_t>& offsets, const Config* config,
-                        int cache_size, int total_size) {
+                        int cache_size, int total_size, int spill_size = 0) {
     if (feature_metas_.empty()) {
       SetFeatureInfo<true, true>(train_data, config, &feature_metas_);
       uint64_t bin_cnt_over_features = 0;
@@ -1194,11 +1426,23 @@ class HistogramPool {
       Log::Info("Total Bins %d", bin_cnt_over_features);
     }
     int old_cache_size = static_cast<int>(pool_.size());
-    Reset(cache_size, total_size);
+    Reset(cache_size, total_size, spill_size);
+    if (static_cast<int>(spill_.size()) != spill_size_) {
+      spill_.resize(spill_size_);
+      for (auto& spilled : spill_) {
+        spilled.data.resize(num_total_bin * 2);
+        spilled.scales.resize(train_data->num_features() * 2);
+        spilled.is_splittable.resize(train_data->num_features());
+      }
+    }
+    spill_offsets_ = offsets;
 
-    if (cache_size > old_cache_size) {
+    if (cache_size != old_cache_size) {
+      // a smaller pool releases the histograms it no longer uses
       pool_.resize(cache_size);
       data_.resize(cache_size);
+      pool_.shrink_to_fit();
+      data_.shrink_to_fit();
     }
     OMP_INIT_EX();
 #pragma omp parallel for schedule(static)
@@ -1250,17 +1494,26 @@ class HistogramPool {
       last_used_time_[slot] = ++cur_time_;
       return true;
     } else {
-      // choose the least used slot
-      int slot = static_cast<int>(ArrayArgs<int>::ArgMin(last_used_time_));
+      int slot = ChooseEvictedSlot();
+      const int spill_slot = spill_size_ > 0 ? spill_mapper_[idx] : -1;
       *out = pool_[slot].get();
       last_used_time_[slot] = ++cur_time_;
 
       // reset previous mapper
-      if (inverse_mapper_[slot] >= 0) mapper_[inverse_mapper_[slot]] = -1;
+      if (inverse_mapper_[slot] >= 0) {
+        if (spill_size_ > 0) {
+          Spill(slot, spill_slot);
+        }
+        mapper_[inverse_mapper_[slot]] = -1;
+      }
 
       // update current mapper
       mapper_[idx] = slot;
       inverse_mapper_[slot] = idx;
+      if (spill_slot >= 0) {
+        Restore(spill_slot, slot);
+        return true;
+      }
       return false;
     }
   }
@@ -1275,7 +1528,15 @@ class HistogramPool {
       std::swap(pool_[src_idx], pool_[dst_idx]);
       return;
     }
+    // the histograms of dst_idx are replaced, a spilled copy of them must not be restored later
+    ReleaseSpillSlot(dst_idx);
     if (mapper_[src_idx] < 0) {
+      if (spill_size_ > 0 && spill_mapper_[src_idx] >= 0) {
+        const int spill_slot = spill_mapper_[src_idx];
+        spill_mapper_[src_idx] = -1;
+        spill_mapper_[dst_idx] = spill_slot;
+        spill_inverse_mapper_[spill_slot] = dst_idx;
+      }
       return;
     }
     // get slot of src idx
@@ -1290,6 +1551,135 @@ class HistogramPool {
   }
 
  private:
+  /*! \brief Histograms of all features of one leaf, quantized to 16 bits with a scale per feature */
+  struct SpilledHistogram {
+    std::vector<int16_t> data;
+    std::vector<hist_t> scales;
+    std::vector<int8_t> is_splittable;
+  };
+
+  /*! \brief Priority of keeping the histogram of leaf with the given last used time, the smallest is evicted first */
+  std::pair<double, int> KeepPriority(int leaf, int last_used_time) const {
+    if (leaf < 0) {
+      return std::make_pair(-std::numeric_limits<double>::infinity(), 0);
+    }
+    if (best_split_per_leaf_ == nullptr) {
+      return std::make_pair(0.0, last_used_time);
+    }
+    return std::make_pair((*best_split_per_leaf_)[leaf].gain, last_used_time);
+  }
+
+  /*!
+   * \brief Slot for a histogram that is not in the pool. The slot accessed last is never chosen,
+   *        it is the other leaf of the current split
+   */
+  int ChooseEvictedSlot() const {
+    if (best_split_per_leaf_ == nullptr) {
+      // choose the least used slot
+      return static_cast<int>(ArrayArgs<int>::ArgMin(last_used_time_));
+    }
+    int slot = -1;
+    for (int i = 0; i < cache_size_; ++i) {
+      if (last_used_time_[i] == cur_time_ && cur_time_ > 0) {
+        continue;
+      }
+      if (slot < 0 || KeepPriority(inverse_mapper_[i], last_used_time_[i]) <
+                      KeepPriority(inverse_mapper_[slot], last_used_time_[slot])) {
+        slot = i;
+      }
+    }
+    return slot;
+  }
+
+  /*!
+   * \brief Quantize the histograms in slot before they are overwritten. Evicts another spilled
+   *        histogram with a lower priority if needed, or drops this one
+   * \param slot Slot being evicted
+   * \param excluded_spill_slot Spilled histogram that is about to be restored, it is never evicted
+   */
+  void Spill(int slot, int excluded_spill_slot) {
+    const int leaf = inverse_mapper_[slot];
+    int spill_slot = -1;
+    for (int i = 0; i < spill_size_; ++i) {
+      if (i == excluded_spill_slot) {
+        continue;
+      }
+      if (spill_slot < 0 || KeepPriority(spill_inverse_mapper_[i], spill_last_used_time_[i]) <
+                            KeepPriority(spill_inverse_mapper_[spill_slot], spill_last_used_time_[spill_slot])) {
+        spill_slot = i;
+      }
+    }
+    if (spill_slot < 0 || KeepPriority(leaf, last_used_time_[slot]) <
+                          KeepPriority(spill_inverse_mapper_[spill_slot], spill_last_used_time_[spill_slot])) {
+      return;
+    }
+    if (spill_inverse_mapper_[spill_slot] >= 0) {
+      spill_mapper_[spill_inverse_mapper_[spill_slot]] = -1;
+    }
+    spill_mapper_[leaf] = spill_slot;
+    spill_inverse_mapper_[spill_slot] = leaf;
+    spill_last_used_time_[spill_slot] = last_used_time_[slot];
+
+    SpilledHistogram* spilled = &spill_[spill_slot];
+    FeatureHistogram* histograms = pool_[slot].get();
+    const int num_feature = static_cast<int>(feature_metas_.size());
+#pragma omp parallel for schedule(static, 512) if (num_feature >= 1024)
+    for (int i = 0; i < num_feature; ++i) {
+      const hist_t* hist = histograms[i].RawData();
+      int16_t* data = spilled->data.data() + spill_offsets_[i] * 2;
+      const int num_values = (feature_metas_[i].num_bin - feature_metas_[i].offset) * 2;
+      // even entries are gradients, odd entries are hessians
+      for (int k = 0; k < 2; ++k) {
+        hist_t max_abs = 0.0f;
+        for (int j = k; j < num_values; j += 2) {
+          max_abs = std::max(max_abs, std::fabs(hist[j]));
+        }
+        const hist_t scale = max_abs / kSpillMaxValue;
+        const hist_t inv_scale = max_abs > 0.0f ? kSpillMaxValue / max_abs : 0.0f;
+        for (int j = k; j < num_values; j += 2) {
+          data[j] = static_cast<int16_t>(std::lround(hist[j] * inv_scale));
+        }
+        spilled->scales[i * 2 + k] = scale;
+      }
+      spilled->is_splittable[i] = histograms[i].is_splittable() ? 1 : 0;
+    }
+  }
+
+  /*! \brief Drop the spilled histogram of leaf idx, if any */
+  void ReleaseSpillSlot(int idx) {
+    if (spill_size_ <= 0 || spill_mapper_[idx] < 0) {
+      return;
+    }
+    const int spill_slot = spill_mapper_[idx];
+    spill_mapper_[idx] = -1;
+    spill_inverse_mapper_[spill_slot] = -1;
+    spill_last_used_time_[spill_slot] = 0;
+  }
+
+  /*! \brief Dequantize a spilled histogram into slot and release its spill slot */
+  void Restore(int spill_slot, int slot) {
+    spill_mapper_[spill_inverse_mapper_[spill_slot]] = -1;
+    spill_inverse_mapper_[spill_slot] = -1;
+    spill_last_used_time_[spill_slot] = 0;
+
+    const SpilledHistogram& spilled = spill_[spill_slot];
+    FeatureHistogram* histograms = pool_[slot].get();
+    const int num_feature = static_cast<int>(feature_metas_.size());
+#pragma omp parallel for schedule(static, 512) if (num_feature >= 1024)
+    for (int i = 0; i < num_feature; ++i) {
+      hist_t* hist = histograms[i].RawData();
+      const int16_t* data = spilled.data.data() + spill_offsets_[i] * 2;
+      const int num_values = (feature_metas_[i].num_bin - feature_metas_[i].offset) * 2;
+      for (int j = 0; j < num_values; ++j) {
+        hist[j] = data[j] * spilled.scales[i * 2 + (j & 1)];
+      }
+      histograms[i].set_is_splittable(spilled.is_splittable[i] > 0);
+    }
+  }
+
+  static constexpr hist_t kSpillMaxValue = 32767.0f;
+  static const size_t kSpillEntrySize = 2 * sizeof(int16_t);
+
   std::vector<std::unique_ptr<FeatureHistogram[]>> pool_;
   std::vector<
       std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>>
@@ -1302,6 +1692,13 @@ class HistogramPool {
   std::vector<int> inverse_mapper_;
   std::vector<int> last_used_time_;
   int cur_time_ = 0;
+  const std::vector<SplitInfo>* best_split_per_leaf_ = nullptr;
+  int spill_size_ = 0;
+  std::vector<SpilledHistogram> spill_;
+  std::vector<uint32_t> spill_offsets_;
+  std::vector<int> spill_mapper_;
+  std::vector<int> spill_inverse_mapper_;
+  std::vector<int> spill_last_used_time_;
 };
 
 }  // namespace LightGBM
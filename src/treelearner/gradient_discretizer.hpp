@@ -0,0 +1,136 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for
+ * license information.
+ */
+#ifndef LIGHTGBM_TREELEARNER_GRADIENT_DISCRETIZER_HPP_
+#define LIGHTGBM_TREELEARNER_GRADIENT_DISCRETIZER_HPP_
+
+#include <LightGBM/bin.h>
+#include <LightGBM/config.h>
+#include <LightGBM/meta.h>
+#include <LightGBM/utils/common.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+#include <LightGBM/utils/random.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+ * \brief Quantizes the gradients and hessians of one iteration into a few
+ * integer levels, so that histograms can be accumulated in integers.
+ * Gradients are mapped into [-num_grad_quant_bins / 2, num_grad_quant_bins / 2]
+ * and hessians into [0, num_grad_quant_bins], the two are packed into one
+ * int_score_t per row. The dequantized values are kept as well, the rest of
+ * the tree learner uses them so that leaf sums agree with the histograms.
+ */
+class GradientDiscretizer {
+ public:
+  explicit GradientDiscretizer(const Config* config)
+      : config_(config), random_(config->seed) {}
+
+  /*!
+   * \brief Whether the integer histograms of a leaf with num_data rows can overflow
+   */
+  static bool CanOverflow(data_size_t num_data, int num_grad_quant_bins) {
+    return static_cast<double>(num_data) * num_grad_quant_bins >= static_cast<double>(kIntHistGradUnit);
+  }
+
+  void Init(data_size_t num_data, const Config* config) {
+    config_ = config;
+    num_data_ = num_data;
+    int_gradients_.resize(num_data_);
+    ordered_int_gradients_.resize(num_data_);
+    gradients_.resize(num_data_);
+    hessians_.resize(num_data_);
+    if (config_->stochastic_rounding) {
+      // a fixed table of uniform noise, each iteration reads it from a random offset
+      Random rand(config_->seed);
+      random_values_.resize(num_data_);
+      for (data_size_t i = 0; i < num_data_; ++i) {
+        random_values_[i] = rand.NextFloat();
+      }
+    } else {
+      random_values_.clear();
+    }
+  }
+
+  void DiscretizeGradients(const score_t* gradients, const score_t* hessians) {
+    Common::FunctionTimer fun_timer("GradientDiscretizer::DiscretizeGradients", global_timer);
+    const int num_threads = OMP_NUM_THREADS();
+    std::vector<double> thread_max_grad(num_threads, 0.0);
+    std::vector<double> thread_max_hess(num_threads, 0.0);
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      const int tid = omp_get_thread_num();
+      thread_max_grad[tid] = std::max(thread_max_grad[tid], static_cast<double>(std::fabs(gradients[i])));
+      thread_max_hess[tid] = std::max(thread_max_hess[tid], static_cast<double>(hessians[i]));
+    }
+    const double max_grad = *std::max_element(thread_max_grad.begin(), thread_max_grad.end());
+    const double max_hess = *std::max_element(thread_max_hess.begin(), thread_max_hess.end());
+    const int grad_half_bins = config_->num_grad_quant_bins / 2;
+    const int hess_bins = config_->num_grad_quant_bins;
+    grad_scale_ = max_grad > 0.0 ? max_grad / grad_half_bins : 1.0;
+    hess_scale_ = max_hess > 0.0 ? max_hess / hess_bins : 1.0;
+    const double inv_grad_scale = 1.0 / grad_scale_;
+    const double inv_hess_scale = 1.0 / hess_scale_;
+    const bool stochastic = !random_values_.empty();
+    const data_size_t random_offset = stochastic ? random_.NextInt(0, num_data_) : 0;
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      double grad_noise = 0.5;
+      double hess_noise = 0.5;
+      if (stochastic) {
+        data_size_t pos = i + random_offset;
+        if (pos >= num_data_) {
+          pos -= num_data_;
+        }
+        grad_noise = random_values_[pos];
+        // use a different sample for the hessian to keep the two roundings independent
+        hess_noise = random_values_[num_data_ - 1 - pos];
+      }
+      int grad = static_cast<int>(std::floor(gradients[i] * inv_grad_scale + grad_noise));
+      int hess = static_cast<int>(std::floor(hessians[i] * inv_hess_scale + hess_noise));
+      grad = std::max(-grad_half_bins, std::min(grad_half_bins, grad));
+      hess = std::max(0, std::min(hess_bins, hess));
+      int_gradients_[i] = PackIntScore(grad, hess);
+      gradients_[i] = static_cast<score_t>(grad * grad_scale_);
+      hessians_[i] = static_cast<score_t>(hess * hess_scale_);
+    }
+  }
+
+  /*! \brief Packed quantized gradients and hessians of the current iteration */
+  const int_score_t* int_gradients() const { return int_gradients_.data(); }
+
+  /*! \brief Buffer for the quantized gradients reordered by leaf */
+  int_score_t* ordered_int_gradients() { return ordered_int_gradients_.data(); }
+
+  /*! \brief Dequantized gradients, consistent with the integer histograms */
+  const score_t* gradients() const { return gradients_.data(); }
+
+  /*! \brief Dequantized hessians, consistent with the integer histograms */
+  const score_t* hessians() const { return hessians_.data(); }
+
+  double grad_scale() const { return grad_scale_; }
+
+  double hess_scale() const { return hess_scale_; }
+
+ private:
+  const Config* config_;
+  data_size_t num_data_ = 0;
+  Random random_;
+  std::vector<float> random_values_;
+  std::vector<int_score_t, Common::AlignmentAllocator<int_score_t, kAlignedSize>> int_gradients_;
+  std::vector<int_score_t, Common::AlignmentAllocator<int_score_t, kAlignedSize>> ordered_int_gradients_;
+  std::vector<score_t, Common::AlignmentAllocator<score_t, kAlignedSize>> gradients_;
+  std::vector<score_t, Common::AlignmentAllocator<score_t, kAlignedSize>> hessians_;
+  double grad_scale_ = 1.0;
+  double hess_scale_ = 1.0;
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_TREELEARNER_GRADIENT_DISCRETIZER_HPP_
@@ -63,6 +63,11 @@ Tree* LinearTreeLearner::Train(const score_t* gradients, const score_t *hessians
   Common::FunctionTimer fun_timer("SerialTreeLearner::Train", global_timer);
   gradients_ = gradients;
   hessians_ = hessians;
+  if (gradient_discretizer_ != nullptr) {
+    gradient_discretizer_->DiscretizeGradients(gradients, hessians);
+    gradients_ = gradient_discretizer_->gradients();
+    hessians_ = gradient_discretizer_->hessians();
+  }
   int num_threads = OMP_NUM_THREADS();
   if (share_state_->num_threads != num_threads && share_state_->num_threads > 0) {
     Log::Warning(
@@ -8,8 +8,10 @@
 #include <LightGBM/objective_function.h>
 #include <LightGBM/utils/array_args.h>
 #include <LightGBM/utils/common.h>
+#include <LightGBM/utils/numa.h>
 
 #include <algorithm>
+#include <chrono>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -30,19 +32,8 @@ void SerialTreeLearner::Init(const Dataset* train_data, bool is_constant_hessian
   num_data_ = train_data_->num_data();
   num_features_ = train_data_->num_features();
   int max_cache_size = 0;
-  // Get the max size of pool
-  if (config_->histogram_pool_size <= 0) {
-    max_cache_size = config_->num_leaves;
-  } else {
-    size_t total_histogram_size = 0;
-    for (int i = 0; i < train_data_->num_features(); ++i) {
-      total_histogram_size += kHistEntrySize * train_data_->FeatureNumBin(i);
-    }
-    max_cache_size = static_cast<int>(config_->histogram_pool_size * 1024 * 1024 / total_histogram_size);
-  }
-  // at least need 2 leaves
-  max_cache_size = std::max(2, max_cache_size);
-  max_cache_size = std::min(max_cache_size, config_->num_leaves);
+  int max_spill_size = 0;
+  GetHistogramPoolSize(&max_cache_size, &max_spill_size);
 
   // push split information for all leaves
   best_split_per_leaf_.resize(config_->num_leaves);
@@ -63,12 +54,62 @@ void SerialTreeLearner::Init(const Dataset* train_data, bool is_constant_hessian
   histogram_pool_.DynamicChangeSize(train_data_,
   share_state_->num_hist_total_bin(),
   share_state_->feature_hist_offsets(),
-  config_, max_cache_size, config_->num_leaves);
+  config_, max_cache_size, config_->num_leaves, max_spill_size);
+  histogram_pool_.SetEvictionByGain(config_->histogram_pool_eviction == std::string("gain")
+                                    ? &best_split_per_leaf_ : nullptr);
   Log::Info("Number of data points in the train set: %d, number of used features: %d", num_data_, num_features_);
   if (CostEfficientGradientBoosting::IsEnable(config_)) {
     cegb_.reset(new CostEfficientGradientBoosting(this));
     cegb_->Init();
   }
+  if (config_->max_concurrent_leaves > 1 && NumConcurrentLeaves() == 1) {
+    Log::Warning("max_concurrent_leaves needs the histograms of all leaves in memory, "
+                 "and does not work with monotone constraints or cost-efficient gradient boosting, "
+                 "leaves are split one at a time");
+  }
+  ResetGradientDiscretizer();
+  ResetAltShareStates(true);
+}
+
+void SerialTreeLearner::ResetGradientDiscretizer() {
+  if (config_->use_quantized_grad &&
+      GradientDiscretizer::CanOverflow(num_data_, config_->num_grad_quant_bins)) {
+    Log::Warning("Too many rows for num_grad_quant_bins=%d, integer histograms could overflow. "
+                 "Quantized gradients are disabled.", config_->num_grad_quant_bins);
+    gradient_discretizer_.reset(nullptr);
+  } else if (config_->use_quantized_grad) {
+    if (gradient_discretizer_ == nullptr) {
+      gradient_discretizer_.reset(new GradientDiscretizer(config_));
+    }
+    gradient_discretizer_->Init(num_data_, config_);
+  } else {
+    gradient_discretizer_.reset(nullptr);
+  }
+}
+
+void SerialTreeLearner::ResetAltShareStates(bool rebuild) {
+  if (!config_->adaptive_col_row_wise || train_data_->num_features() == 0) {
+    alt_share_state_.reset(nullptr);
+    alt_hist_data_.clear();
+    col_row_wise_selector_.reset(nullptr);
+    return;
+  }
+  if (alt_share_state_ == nullptr || rebuild) {
+    alt_share_state_.reset(train_data_->GetShareStates(
+        ordered_gradients_.data(), ordered_hessians_.data(),
+        col_sampler_.is_feature_used_bytree(), share_state_->is_constant_hessian,
+        !share_state_->is_col_wise, share_state_->is_col_wise));
+    CHECK_NOTNULL(alt_share_state_);
+    alt_hist_data_.resize(static_cast<size_t>(std::max<uint64_t>(
+        alt_share_state_->num_hist_total_bin(), train_data_->NumTotalBin())) * 2);
+  }
+  // the measured times are not reproducible, deterministic=true uses the static cost model
+  if (rebuild || col_row_wise_selector_ == nullptr ||
+      col_row_wise_selector_->IsTimed() == config_->deterministic) {
+    col_row_wise_selector_.reset(config_->deterministic
+        ? new ColRowWiseSelector(share_state_.get(), alt_share_state_.get())
+        : new ColRowWiseSelector());
+  }
 }
 
 void SerialTreeLearner::GetShareStates(const Dataset* dataset,
@@ -100,6 +141,8 @@ void SerialTreeLearner::ResetTrainingDataInner(const Dataset* train_data,
   // initialize splits for leaf
   smaller_leaf_splits_->ResetNumData(num_data_);
   larger_leaf_splits_->ResetNumData(num_data_);
+  // the leaf splits of concurrent leaves are created again for the new number of data
+  leaf_pairs_.clear();
 
   // initialize data partition
   data_partition_->ResetNumData(num_data_);
@@ -114,38 +157,61 @@ void SerialTreeLearner::ResetTrainingDataInner(const Dataset* train_data,
   if (cegb_ != nullptr) {
     cegb_->Init();
   }
+  ResetGradientDiscretizer();
+  if (reset_multi_val_bin) {
+    ResetAltShareStates(true);
+  }
+}
+
+void SerialTreeLearner::GetHistogramPoolSize(int* cache_size, int* spill_size) const {
+  *cache_size = config_->num_leaves;
+  *spill_size = 0;
+  if (config_->histogram_pool_size <= 0) {
+    return;
+  }
+  size_t total_histogram_size = 0;
+  for (int i = 0; i < train_data_->num_features(); ++i) {
+    total_histogram_size += kHistEntrySize * train_data_->FeatureNumBin(i);
+  }
+  const double pool_bytes = config_->histogram_pool_size * 1024 * 1024;
+  // the quantized histograms get half of the budget, if the full precision ones do not fit
+  const bool use_spill = config_->histogram_pool_spill &&
+                         pool_bytes < static_cast<double>(total_histogram_size) * config_->num_leaves;
+  *cache_size = static_cast<int>((use_spill ? pool_bytes / 2 : pool_bytes) / total_histogram_size);
+  // at least need 2 leaves
+  *cache_size = std::max(2, *cache_size);
+  *cache_size = std::min(*cache_size, config_->num_leaves);
+  if (use_spill) {
+    const double spill_bytes = pool_bytes - static_cast<double>(*cache_size) * total_histogram_size;
+    *spill_size = static_cast<int>(std::max(0.0, spill_bytes) / HistogramPool::SpilledHistogramSize(train_data_));
+    *spill_size = std::min(*spill_size, config_->num_leaves - *cache_size);
+  }
 }
 
 void SerialTreeLearner::ResetConfig(const Config* config) {
-  if (config_->num_leaves != config->num_leaves) {
-    config_ = config;
+  const bool is_num_leaves_changed = config_->num_leaves != config->num_leaves;
+  const bool is_pool_changed = is_num_leaves_changed ||
+                               config_->histogram_pool_size != config->histogram_pool_size ||
+                               config_->histogram_pool_spill != config->histogram_pool_spill;
+  config_ = config;
+  if (is_pool_changed) {
     int max_cache_size = 0;
-    // Get the max size of pool
-    if (config->histogram_pool_size <= 0) {
-      max_cache_size = config_->num_leaves;
-    } else {
-      size_t total_histogram_size = 0;
-      for (int i = 0; i < train_data_->num_features(); ++i) {
-        total_histogram_size += kHistEntrySize * train_data_->FeatureNumBin(i);
-      }
-      max_cache_size = static_cast<int>(config_->histogram_pool_size * 1024 * 1024 / total_histogram_size);
-    }
-    // at least need 2 leaves
-    max_cache_size = std::max(2, max_cache_size);
-    max_cache_size = std::min(max_cache_size, config_->num_leaves);
+    int max_spill_size = 0;
+    GetHistogramPoolSize(&max_cache_size, &max_spill_size);
     histogram_pool_.DynamicChangeSize(train_data_,
     share_state_->num_hist_total_bin(),
     share_state_->feature_hist_offsets(),
-    config_, max_cache_size, config_->num_leaves);
-
+    config_, max_cache_size, config_->num_leaves, max_spill_size);
+  }
+  if (is_num_leaves_changed) {
     // push split information for all leaves
     best_split_per_leaf_.resize(config_->num_leaves);
     data_partition_->ResetLeaves(config_->num_leaves);
-  } else {
-    config_ = config;
   }
   col_sampler_.SetConfig(config_);
   histogram_pool_.ResetConfig(train_data_, config_);
+  histogram_pool_.SetEvictionByGain(config_->histogram_pool_eviction == std::string("gain")
+                                    ? &best_split_per_leaf_ : nullptr);
   if (CostEfficientGradientBoosting::IsEnable(config_)) {
     if (cegb_ == nullptr) {
       cegb_.reset(new CostEfficientGradientBoosting(this));
@@ -153,12 +219,20 @@ void SerialTreeLearner::ResetConfig(const Config* config) {
     cegb_->Init();
   }
   constraints_.reset(LeafConstraintsBase::Create(config_, config_->num_leaves, train_data_->num_features()));
+  ResetGradientDiscretizer();
+  ResetAltShareStates(false);
 }
 
 Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians, bool /*is_first_tree*/) {
   Common::FunctionTimer fun_timer("SerialTreeLearner::Train", global_timer);
   gradients_ = gradients;
   hessians_ = hessians;
+  if (gradient_discretizer_ != nullptr) {
+    // the rest of the tree learner sees the dequantized values, so that leaf sums match the histograms
+    gradient_discretizer_->DiscretizeGradients(gradients, hessians);
+    gradients_ = gradient_discretizer_->gradients();
+    hessians_ = gradient_discretizer_->hessians();
+  }
   int num_threads = OMP_NUM_THREADS();
   if (share_state_->num_threads != num_threads && share_state_->num_threads > 0) {
     Log::Warning(
@@ -167,6 +241,13 @@ Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians
         share_state_->num_threads, num_threads);
   }
   share_state_->num_threads = num_threads;
+  if (alt_share_state_ != nullptr && alt_share_state_->num_threads != num_threads) {
+    alt_share_state_->num_threads = num_threads;
+    // the measured times depend on the number of threads
+    if (col_row_wise_selector_->IsTimed()) {
+      col_row_wise_selector_.reset(new ColRowWiseSelector());
+    }
+  }
 
   // some initial works before training
   BeforeTrain();
@@ -184,6 +265,14 @@ Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians
 
   int init_splits = ForceSplits(tree_ptr, &left_leaf, &right_leaf, &cur_depth);
 
+  const int num_concurrent_leaves = NumConcurrentLeaves();
+  if (num_concurrent_leaves > 1) {
+    GrowConcurrentLeaves(tree_ptr, left_leaf, right_leaf, init_splits,
+                         num_concurrent_leaves, &cur_depth);
+    Log::Debug("Trained a tree with leaves = %d and depth = %d", tree->num_leaves(), cur_depth);
+    return tree.release();
+  }
+
   for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
     // some initial works before finding best split
     if (BeforeFindBestSplit(tree_ptr, left_leaf, right_leaf)) {
@@ -208,6 +297,183 @@ Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians
   return tree.release();
 }
 
+int SerialTreeLearner::NumConcurrentLeaves() const {
+  if (config_->max_concurrent_leaves <= 1 || !config_->monotone_constraints.empty() ||
+      cegb_ != nullptr || !histogram_pool_.is_enough()) {
+    return 1;
+  }
+  return config_->max_concurrent_leaves;
+}
+
+bool SerialTreeLearner::CanBuildLeavesConcurrently() const {
+#ifdef TIMETAG
+  // the timers are indexed by the thread number, which is 0 in all nested regions
+  return false;
+#else
+  if (!share_state_->is_col_wise || gradient_discretizer_ != nullptr ||
+      col_row_wise_selector_ != nullptr) {
+    return false;
+  }
+  // multi-value groups use the per-thread buffers of share_state_
+  for (int group = 0; group < train_data_->num_feature_groups(); ++group) {
+    if (train_data_->IsMultiGroup(group)) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+void SerialTreeLearner::SwapLeafPair(LeafPair* pair) {
+  std::swap(smaller_leaf_splits_, pair->smaller_leaf_splits);
+  std::swap(larger_leaf_splits_, pair->larger_leaf_splits);
+  std::swap(smaller_leaf_histogram_array_, pair->smaller_leaf_histogram_array);
+  std::swap(larger_leaf_histogram_array_, pair->larger_leaf_histogram_array);
+  std::swap(parent_leaf_histogram_array_, pair->parent_leaf_histogram_array);
+}
+
+void SerialTreeLearner::GrowConcurrentLeaves(Tree* tree, int left_leaf, int right_leaf,
+                                             int num_splits, int num_concurrent_leaves,
+                                             int* cur_depth) {
+  if (static_cast<int>(leaf_pairs_.size()) < num_concurrent_leaves) {
+    leaf_pairs_.resize(num_concurrent_leaves);
+  }
+  for (auto& pair : leaf_pairs_) {
+    if (pair.smaller_leaf_splits == nullptr) {
+      pair.smaller_leaf_splits.reset(new LeafSplits(num_data_, config_));
+      pair.larger_leaf_splits.reset(new LeafSplits(num_data_, config_));
+    }
+  }
+  // the leaves of the last split, or the root
+  leaf_pairs_[0].left_leaf = left_leaf;
+  leaf_pairs_[0].right_leaf = right_leaf;
+  std::swap(smaller_leaf_splits_, leaf_pairs_[0].smaller_leaf_splits);
+  std::swap(larger_leaf_splits_, leaf_pairs_[0].larger_leaf_splits);
+  int num_pairs = 1;
+  max_leaves_per_step_ = 1;
+  std::vector<int> candidates;
+  while (num_splits < config_->num_leaves - 1) {
+    FindBestSplitsForLeafPairs(tree, num_pairs);
+    int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
+    if (best_split_per_leaf_[best_leaf].gain <= 0.0) {
+      Log::Warning("No further splits with positive gain, best gain: %f", best_split_per_leaf_[best_leaf].gain);
+      break;
+    }
+    // leaves by decreasing gain, ties are broken like ArgMax, so one leaf per step is the sequential growth
+    candidates.clear();
+    for (int leaf = 0; leaf < tree->num_leaves(); ++leaf) {
+      if (best_split_per_leaf_[leaf].gain > 0.0) {
+        candidates.push_back(leaf);
+      }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+      return best_split_per_leaf_[a] > best_split_per_leaf_[b];
+    });
+    num_pairs = std::min(static_cast<int>(candidates.size()),
+                         std::min(num_concurrent_leaves, config_->num_leaves - 1 - num_splits));
+    max_leaves_per_step_ = std::max(max_leaves_per_step_, num_pairs);
+#ifndef TIMETAG
+    if (num_pairs > 1) {
+      // the leaves hold disjoint rows, partition them at once, one task per leaf.
+      // the right leaves get the next ids in candidate order, as in the splits below
+      const int next_leaf_id = tree->NextLeafId();
+      Threading::ForEachTask(num_pairs, OMP_NUM_THREADS(), config_->use_task_scheduler, [&](int i) {
+        PartitionLeaf(candidates[i], next_leaf_id + i, true);
+      });
+      are_leaves_partitioned_ = true;
+    }
+#endif
+    for (int i = 0; i < num_pairs; ++i) {
+      LeafPair* pair = &leaf_pairs_[i];
+      Split(tree, candidates[i], &pair->left_leaf, &pair->right_leaf);
+      // Split initializes the leaf splits of the new leaves in place, keep them for this pair
+      std::swap(smaller_leaf_splits_, pair->smaller_leaf_splits);
+      std::swap(larger_leaf_splits_, pair->larger_leaf_splits);
+      *cur_depth = std::max(*cur_depth, tree->leaf_depth(pair->left_leaf));
+    }
+    are_leaves_partitioned_ = false;
+    num_splits += num_pairs;
+  }
+  // leave the leaf splits of the last pair in place, as after the sequential growth
+  std::swap(smaller_leaf_splits_, leaf_pairs_[num_pairs - 1].smaller_leaf_splits);
+  std::swap(larger_leaf_splits_, leaf_pairs_[num_pairs - 1].larger_leaf_splits);
+}
+
+void SerialTreeLearner::FindBestSplitsForLeafPairs(const Tree* tree, int num_pairs) {
+  for (int i = 0; i < num_pairs; ++i) {
+    LeafPair* pair = &leaf_pairs_[i];
+    SwapLeafPair(pair);
+    pair->find_splits = BeforeFindBestSplit(tree, pair->left_leaf, pair->right_leaf);
+    if (pair->find_splits) {
+      GetUsedFeatures(&pair->is_feature_used);
+    }
+    SwapLeafPair(pair);
+  }
+  if (CanBuildLeavesConcurrently()) {
+    // one task per leaf, histograms are built by one thread each
+    std::vector<std::pair<const LeafPair*, bool>> tasks;
+    for (int i = 0; i < num_pairs; ++i) {
+      const LeafPair& pair = leaf_pairs_[i];
+      if (!pair.find_splits) {
+        continue;
+      }
+      tasks.emplace_back(&pair, true);
+      if (pair.larger_leaf_histogram_array != nullptr && pair.parent_leaf_histogram_array == nullptr) {
+        tasks.emplace_back(&pair, false);
+      }
+    }
+    auto build_histograms = [&](int i) {
+      const LeafPair* pair = tasks[i].first;
+      const bool is_smaller = tasks[i].second;
+      const LeafSplits* leaf_splits = is_smaller ? pair->smaller_leaf_splits.get()
+                                                 : pair->larger_leaf_splits.get();
+      FeatureHistogram* histogram_array = is_smaller ? pair->smaller_leaf_histogram_array
+                                                     : pair->larger_leaf_histogram_array;
+      // leaves own disjoint ranges of the data partition, so they gather their gradients there
+      const data_size_t offset = leaf_splits->data_indices() == nullptr
+                                 ? 0 : data_partition_->leaf_begin(leaf_splits->leaf_index());
+      train_data_->ConstructHistograms(
+          pair->is_feature_used, leaf_splits->data_indices(),
+          leaf_splits->num_data_in_leaf(), gradients_, hessians_,
+          ordered_gradients_.data() + offset, ordered_hessians_.data() + offset,
+          share_state_.get(), histogram_array[0].RawData() - kHistOffset);
+    };
+    const int num_tasks = static_cast<int>(tasks.size());
+    if (config_->use_task_scheduler) {
+      // the loops over the feature groups of the leaves are nested in the same scheduler,
+      // an OpenMP loop here would make them wait for each other on the scheduler lock
+      TaskScheduler::ParallelFor(num_tasks, build_histograms);
+    } else {
+      OMP_INIT_EX();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(share_state_->num_threads)
+      for (int i = 0; i < num_tasks; ++i) {
+        OMP_LOOP_EX_BEGIN();
+        build_histograms(i);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
+    }
+  } else {
+    for (int i = 0; i < num_pairs; ++i) {
+      LeafPair* pair = &leaf_pairs_[i];
+      if (pair->find_splits) {
+        SwapLeafPair(pair);
+        ConstructHistograms(pair->is_feature_used, parent_leaf_histogram_array_ != nullptr);
+        SwapLeafPair(pair);
+      }
+    }
+  }
+  // the splits are searched in pair order, so the results do not depend on the scheduling
+  for (int i = 0; i < num_pairs; ++i) {
+    LeafPair* pair = &leaf_pairs_[i];
+    if (pair->find_splits) {
+      SwapLeafPair(pair);
+      FindBestSplitsFromHistograms(pair->is_feature_used, parent_leaf_histogram_array_ != nullptr, tree);
+      SwapLeafPair(pair);
+    }
+  }
+}
+
 Tree* SerialTreeLearner::FitByExistingTree(const Tree* old_tree, const score_t* gradients, const score_t *hessians) const {
   auto tree = std::unique_ptr<Tree>(new Tree(*old_tree));
   CHECK_GE(data_partition_->num_leaves(), tree->num_leaves());
@@ -251,11 +517,22 @@ Tree* SerialTreeLearner::FitByExistingTree(const Tree* old_tree, const std::vect
 
 void SerialTreeLearner::BeforeTrain() {
   Common::FunctionTimer fun_timer("SerialTreeLearner::BeforeTrain", global_timer);
+  // no-op unless the affinity or the number of threads changed
+  NUMA::BindThreads(config_->thread_affinity);
+  // the share states and the data partition are rebuilt with the training data
+  share_state_->use_task_scheduler = config_->use_task_scheduler;
+  if (alt_share_state_ != nullptr) {
+    alt_share_state_->use_task_scheduler = config_->use_task_scheduler;
+  }
+  data_partition_->SetUseTaskScheduler(config_->use_task_scheduler);
   // reset histogram pool
   histogram_pool_.ResetMap();
 
   col_sampler_.ResetByTree();
   train_data_->InitTrain(col_sampler_.is_feature_used_bytree(), share_state_.get());
+  if (alt_share_state_ != nullptr) {
+    train_data_->InitTrain(col_sampler_.is_feature_used_bytree(), alt_share_state_.get());
+  }
   // initialize data partition
   data_partition_->Init();
 
@@ -321,8 +598,8 @@ bool SerialTreeLearner::BeforeFindBestSplit(const Tree* tree, int left_leaf, int
   return true;
 }
 
-void SerialTreeLearner::FindBestSplits(const Tree* tree) {
-  std::vector<int8_t> is_feature_used(num_features_, 0);
+void SerialTreeLearner::GetUsedFeatures(std::vector<int8_t>* is_feature_used) {
+  is_feature_used->assign(num_features_, 0);
   #pragma omp parallel for schedule(static, 256) if (num_features_ >= 512)
   for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
     if (!col_sampler_.is_feature_used_bytree()[feature_index]) continue;
@@ -331,8 +608,13 @@ void SerialTreeLearner::FindBestSplits(const Tree* tree) {
       smaller_leaf_histogram_array_[feature_index].set_is_splittable(false);
       continue;
     }
-    is_feature_used[feature_index] = 1;
+    (*is_feature_used)[feature_index] = 1;
   }
+}
+
+void SerialTreeLearner::FindBestSplits(const Tree* tree) {
+  std::vector<int8_t> is_feature_used;
+  GetUsedFeatures(&is_feature_used);
   bool use_subtract = parent_leaf_histogram_array_ != nullptr;
 
 #ifdef USE_CUDA
@@ -354,20 +636,77 @@ void SerialTreeLearner::ConstructHistograms(
   // construct smaller leaf
   hist_t* ptr_smaller_leaf_hist_data =
       smaller_leaf_histogram_array_[0].RawData() - kHistOffset;
-  train_data_->ConstructHistograms(
-      is_feature_used, smaller_leaf_splits_->data_indices(),
-      smaller_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
-      ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
-      ptr_smaller_leaf_hist_data);
+  ConstructLeafHistograms(is_feature_used, smaller_leaf_splits_.get(),
+                          ptr_smaller_leaf_hist_data);
   if (larger_leaf_histogram_array_ != nullptr && !use_subtract) {
     // construct larger leaf
     hist_t* ptr_larger_leaf_hist_data =
         larger_leaf_histogram_array_[0].RawData() - kHistOffset;
+    ConstructLeafHistograms(is_feature_used, larger_leaf_splits_.get(),
+                            ptr_larger_leaf_hist_data);
+  }
+}
+
+void SerialTreeLearner::ConstructLeafHistograms(
+    const std::vector<int8_t>& is_feature_used, const LeafSplits* leaf_splits,
+    hist_t* hist_data) {
+  if (col_row_wise_selector_ == nullptr) {
+    ConstructLeafHistograms(is_feature_used, leaf_splits, share_state_.get(), hist_data);
+    return;
+  }
+  const data_size_t num_data = leaf_splits->num_data_in_leaf();
+  const bool use_alternative = col_row_wise_selector_->UseAlternative(
+      num_data, is_feature_used, col_sampler_.is_feature_used_bytree());
+  const auto start_time = std::chrono::steady_clock::now();
+  if (use_alternative) {
+    hist_t* alt_hist_data = alt_hist_data_.data();
+    ConstructLeafHistograms(is_feature_used, leaf_splits, alt_share_state_.get(), alt_hist_data);
+    // copy into the layout of share_state_, which the histogram pool uses
+    const std::vector<uint32_t>& offsets = share_state_->feature_hist_offsets();
+    const std::vector<uint32_t>& alt_offsets = alt_share_state_->feature_hist_offsets();
+#pragma omp parallel for schedule(static, 256) if (num_features_ >= 1024)
+    for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+      if (!is_feature_used[feature_index]) {
+        continue;
+      }
+      const int num_bin = train_data_->FeatureNumBin(feature_index) -
+          (train_data_->FeatureBinMapper(feature_index)->GetMostFreqBin() == 0 ? 1 : 0);
+      std::memcpy(hist_data + offsets[feature_index] * 2,
+                  alt_hist_data + alt_offsets[feature_index] * 2,
+                  num_bin * kHistEntrySize);
+    }
+  } else {
+    ConstructLeafHistograms(is_feature_used, leaf_splits, share_state_.get(), hist_data);
+  }
+  if (col_row_wise_selector_->IsTimed()) {
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+    int num_used_features = 0;
+    for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+      num_used_features += is_feature_used[feature_index] ? 1 : 0;
+    }
+    col_row_wise_selector_->AddSample(use_alternative, num_data,
+                                      static_cast<double>(num_used_features) / num_features_,
+                                      elapsed.count());
+  }
+}
+
+void SerialTreeLearner::ConstructLeafHistograms(
+    const std::vector<int8_t>& is_feature_used, const LeafSplits* leaf_splits,
+    TrainingShareStates* share_state, hist_t* hist_data) {
+  if (gradient_discretizer_ != nullptr) {
+    train_data_->ConstructIntHistograms(
+        is_feature_used, leaf_splits->data_indices(),
+        leaf_splits->num_data_in_leaf(),
+        gradient_discretizer_->int_gradients(),
+        gradient_discretizer_->ordered_int_gradients(), share_state,
+        gradient_discretizer_->grad_scale(), gradient_discretizer_->hess_scale(),
+        hist_data);
+  } else {
     train_data_->ConstructHistograms(
-        is_feature_used, larger_leaf_splits_->data_indices(),
-        larger_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
-        ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
-        ptr_larger_leaf_hist_data);
+        is_feature_used, leaf_splits->data_indices(),
+        leaf_splits->num_data_in_leaf(), gradients_, hessians_,
+        ordered_gradients_.data(), ordered_hessians_.data(), share_state,
+        hist_data);
   }
 }
 
@@ -581,12 +920,12 @@ void SerialTreeLearner::SplitInner(Tree* tree, int best_leaf, int* left_leaf,
   bool is_numerical_split =
       train_data_->FeatureBinMapper(inner_feature_index)->bin_type() ==
       BinType::NumericalBin;
+  if (!are_leaves_partitioned_) {
+    PartitionLeaf(best_leaf, next_leaf_id, false);
+  }
   if (is_numerical_split) {
     auto threshold_double = train_data_->RealThreshold(
         inner_feature_index, best_split_info.threshold);
-    data_partition_->Split(best_leaf, train_data_, inner_feature_index,
-                           &best_split_info.threshold, 1,
-                           best_split_info.default_left, next_leaf_id);
     if (update_cnt) {
       // don't need to update this in data-based parallel model
       best_split_info.left_count = data_partition_->leaf_count(*left_leaf);
@@ -618,11 +957,6 @@ void SerialTreeLearner::SplitInner(Tree* tree, int best_leaf, int* left_leaf,
     std::vector<uint32_t> cat_bitset = Common::ConstructBitset(
         threshold_int.data(), best_split_info.num_cat_threshold);
 
-    data_partition_->Split(best_leaf, train_data_, inner_feature_index,
-                           cat_bitset_inner.data(),
-                           static_cast<int>(cat_bitset_inner.size()),
-                           best_split_info.default_left, next_leaf_id);
-
     if (update_cnt) {
       // don't need to update this in data-based parallel model
       best_split_info.left_count = data_partition_->leaf_count(*left_leaf);
@@ -681,6 +1015,26 @@ void SerialTreeLearner::SplitInner(Tree* tree, int best_leaf, int* left_leaf,
   }
 }
 
+void SerialTreeLearner::PartitionLeaf(int best_leaf, int right_leaf, bool in_one_block) {
+  const SplitInfo& best_split_info = best_split_per_leaf_[best_leaf];
+  const int inner_feature_index =
+      train_data_->InnerFeatureIndex(best_split_info.feature);
+  if (train_data_->FeatureBinMapper(inner_feature_index)->bin_type() ==
+      BinType::NumericalBin) {
+    data_partition_->Split(best_leaf, train_data_, inner_feature_index,
+                           &best_split_info.threshold, 1,
+                           best_split_info.default_left, right_leaf, in_one_block);
+  } else {
+    std::vector<uint32_t> cat_bitset_inner =
+        Common::ConstructBitset(best_split_info.cat_threshold.data(),
+                                best_split_info.num_cat_threshold);
+    data_partition_->Split(best_leaf, train_data_, inner_feature_index,
+                           cat_bitset_inner.data(),
+                           static_cast<int>(cat_bitset_inner.size()),
+                           best_split_info.default_left, right_leaf, in_one_block);
+  }
+}
+
 void SerialTreeLearner::RenewTreeOutput(Tree* tree, const ObjectiveFunction* obj, std::function<double(const label_t*, int)> residual_getter,
                                         data_size_t total_num_data, const data_size_t* bag_indices, data_size_t bag_cnt) const {
   if (obj != nullptr && obj->IsRenewTreeOutput()) {
@@ -12,6 +12,7 @@
 #include <LightGBM/utils/array_args.h>
 #include <LightGBM/utils/json11.h>
 #include <LightGBM/utils/random.h>
+#include <LightGBM/utils/threading.h>
 
 #include <string>
 #include <cmath>
@@ -23,6 +24,8 @@
 #include "col_sampler.hpp"
 #include "data_partition.hpp"
 #include "feature_histogram.hpp"
+#include "col_row_wise_selector.hpp"
+#include "gradient_discretizer.hpp"
 #include "leaf_splits.hpp"
 #include "monotone_constraints.hpp"
 #include "split_info.hpp"
@@ -40,6 +43,22 @@ using json11::Json;
 /*! \brief forward declaration */
 class CostEfficientGradientBoosting;
 
+/*!
+* \brief Two new leaves of a split and their histograms, while several leaves are split at once
+*/
+struct LeafPair {
+  int left_leaf = -1;
+  int right_leaf = -1;
+  /*! \brief false if the leaves cannot be split further, then no histogram is built */
+  bool find_splits = false;
+  std::unique_ptr<LeafSplits> smaller_leaf_splits;
+  std::unique_ptr<LeafSplits> larger_leaf_splits;
+  FeatureHistogram* smaller_leaf_histogram_array = nullptr;
+  FeatureHistogram* larger_leaf_histogram_array = nullptr;
+  FeatureHistogram* parent_leaf_histogram_array = nullptr;
+  std::vector<int8_t> is_feature_used;
+};
+
 /*!
 * \brief Used for learning a tree by single machine
 */
@@ -59,6 +78,9 @@ class SerialTreeLearner: public TreeLearner {
 
   void ResetIsConstantHessian(bool is_constant_hessian) override {
     share_state_->is_constant_hessian = is_constant_hessian;
+    if (alt_share_state_ != nullptr) {
+      alt_share_state_->is_constant_hessian = is_constant_hessian;
+    }
   }
 
   virtual void ResetTrainingDataInner(const Dataset* train_data,
@@ -86,12 +108,21 @@ class SerialTreeLearner: public TreeLearner {
     if (subset == nullptr) {
       data_partition_->SetUsedDataIndices(used_indices, num_data);
       share_state_->SetUseSubrow(false);
+      if (alt_share_state_ != nullptr) {
+        alt_share_state_->SetUseSubrow(false);
+      }
     } else {
       ResetTrainingDataInner(subset, share_state_->is_constant_hessian, false);
       share_state_->SetUseSubrow(true);
       share_state_->SetSubrowCopied(false);
       share_state_->bagging_use_indices = used_indices;
       share_state_->bagging_indices_cnt = num_data;
+      if (alt_share_state_ != nullptr) {
+        alt_share_state_->SetUseSubrow(true);
+        alt_share_state_->SetSubrowCopied(false);
+        alt_share_state_->bagging_use_indices = used_indices;
+        alt_share_state_->bagging_indices_cnt = num_data;
+      }
     }
   }
 
@@ -101,15 +132,14 @@ class SerialTreeLearner: public TreeLearner {
     if (tree->num_leaves() <= 1) {
       return;
     }
-#pragma omp parallel for schedule(static, 1)
-    for (int i = 0; i < tree->num_leaves(); ++i) {
+    Threading::ForEachTask(tree->num_leaves(), OMP_NUM_THREADS(), config_->use_task_scheduler, [=](int i) {
       double output = static_cast<double>(tree->LeafOutput(i));
       data_size_t cnt_leaf_data = 0;
       auto tmp_idx = data_partition_->GetIndexOnLeaf(i, &cnt_leaf_data);
       for (data_size_t j = 0; j < cnt_leaf_data; ++j) {
         out_score[tmp_idx[j]] += output;
       }
-    }
+    });
   }
 
   void RenewTreeOutput(Tree* tree, const ObjectiveFunction* obj, std::function<double(const label_t*, int)> residual_getter,
@@ -130,6 +160,64 @@ class SerialTreeLearner: public TreeLearner {
 
   void RecomputeBestSplitForLeaf(Tree* tree, int leaf, SplitInfo* split);
 
+  /*!
+  * \brief Create, resize or drop the gradient discretizer according to use_quantized_grad
+  */
+  void ResetGradientDiscretizer();
+
+  /*!
+  * \brief Create or drop the share states of the other histogram layout according to adaptive_col_row_wise
+  * \param rebuild Rebuild the share states, needed when the training data changed
+  */
+  void ResetAltShareStates(bool rebuild);
+
+  /*!
+  * \brief Number of full precision and of quantized histograms that fit into histogram_pool_size
+  * \param cache_size Number of full precision histograms, at least 2
+  * \param spill_size Number of quantized histograms, 0 unless histogram_pool_spill is set
+  */
+  void GetHistogramPoolSize(int* cache_size, int* spill_size) const;
+
+  /*!
+  * \brief Number of leaves split at once, max_concurrent_leaves unless it cannot be used with the current setup
+  */
+  int NumConcurrentLeaves() const;
+
+  /*!
+  * \brief Whether the histograms of several leaves can be built by parallel tasks,
+  *        which needs the histogram building to keep no state in the share states
+  */
+  bool CanBuildLeavesConcurrently() const;
+
+  /*!
+  * \brief Leaf-wise growth that splits up to num_concurrent_leaves leaves with the largest gains in each step
+  * \param tree Current tree
+  * \param left_leaf Left leaf of the last split, or the root
+  * \param right_leaf Right leaf of the last split, -1 for the root
+  * \param num_splits Number of splits already made
+  * \param num_concurrent_leaves Max number of leaves split in one step
+  * \param cur_depth Max depth of the tree, updated
+  */
+  void GrowConcurrentLeaves(Tree* tree, int left_leaf, int right_leaf, int num_splits,
+                            int num_concurrent_leaves, int* cur_depth);
+
+  /*!
+  * \brief Find the best splits of the new leaves of the first num_pairs entries of leaf_pairs_.
+  *        The histograms are built for all pairs first, then the splits are searched in pair order
+  */
+  void FindBestSplitsForLeafPairs(const Tree* tree, int num_pairs);
+
+  /*!
+  * \brief Swap the leaf splits and histograms of the current pair of leaves with the ones stored in pair
+  */
+  void SwapLeafPair(LeafPair* pair);
+
+  /*!
+  * \brief Used features of the current pair of leaves, marks the features that the parent
+  *        could not split as not splittable for the smaller leaf
+  */
+  void GetUsedFeatures(std::vector<int8_t>* is_feature_used);
+
   /*!
   * \brief Some initial works before training
   */
@@ -144,6 +232,19 @@ class SerialTreeLearner: public TreeLearner {
 
   virtual void ConstructHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract);
 
+  /*!
+  * \brief Construct the histograms of one leaf, with the layout chosen by the cost model if adaptive_col_row_wise is on
+  */
+  void ConstructLeafHistograms(const std::vector<int8_t>& is_feature_used,
+                               const LeafSplits* leaf_splits, hist_t* hist_data);
+
+  /*!
+  * \brief Construct the histograms of one leaf with the given share states, and quantized gradients if they are used
+  */
+  void ConstructLeafHistograms(const std::vector<int8_t>& is_feature_used,
+                               const LeafSplits* leaf_splits,
+                               TrainingShareStates* share_state, hist_t* hist_data);
+
   virtual void FindBestSplitsFromHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract, const Tree*);
 
   /*!
@@ -161,6 +262,14 @@ class SerialTreeLearner: public TreeLearner {
   void SplitInner(Tree* tree, int best_leaf, int* left_leaf, int* right_leaf,
                   bool update_cnt);
 
+  /*!
+  * \brief Partition the data of a leaf according to its best split
+  * \param best_leaf The index of leaf that will be splitted
+  * \param right_leaf The index of right leaf after splitted
+  * \param in_one_block Partition by the calling thread only, so that several leaves can be partitioned at once
+  */
+  void PartitionLeaf(int best_leaf, int right_leaf, bool in_one_block);
+
   /* Force splits with forced_split_json dict and then return num splits forced.*/
   int32_t ForceSplits(Tree* tree, int* left_leaf, int* right_leaf,
                       int* cur_depth);
@@ -224,7 +333,21 @@ class SerialTreeLearner: public TreeLearner {
   ColSampler col_sampler_;
   const Json* forced_split_json_;
   std::unique_ptr<TrainingShareStates> share_state_;
+  /*! \brief share states of the other histogram layout, nullptr if adaptive_col_row_wise is off */
+  std::unique_ptr<TrainingShareStates> alt_share_state_;
+  /*! \brief histograms built with alt_share_state_, before they are copied into the layout of share_state_ */
+  std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>> alt_hist_data_;
+  /*! \brief chooses share_state_ or alt_share_state_ for every leaf */
+  std::unique_ptr<ColRowWiseSelector> col_row_wise_selector_;
   std::unique_ptr<CostEfficientGradientBoosting> cegb_;
+  /*! \brief quantizes gradients for integer histograms, nullptr if use_quantized_grad is off */
+  std::unique_ptr<GradientDiscretizer> gradient_discretizer_;
+  /*! \brief new leaves of the leaves split in the current step, used if max_concurrent_leaves > 1 */
+  std::vector<LeafPair> leaf_pairs_;
+  /*! \brief the data of the leaves split in the current step are already partitioned */
+  bool are_leaves_partitioned_ = false;
+  /*! \brief max number of leaves split in one step of the last tree */
+  int max_leaves_per_step_ = 1;
 };
 
 inline data_size_t SerialTreeLearner::GetGlobalDataCountInLeaf(int leaf_idx) const {
@@ -0,0 +1,129 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for
+ * license information.
+ */
+#ifndef LIGHTGBM_TREELEARNER_SPLIT_GAIN_SIMD_HPP_
+#define LIGHTGBM_TREELEARNER_SPLIT_GAIN_SIMD_HPP_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/utils/simd.h>
+
+#include <cstdint>
+
+namespace LightGBM {
+
+/*!
+ * \brief A block of split candidates of one feature, in scan order. The sums
+ * of both sides are gathered by the sequential scan, then the gains of the
+ * whole block are computed at once.
+ */
+struct SplitCandidates {
+  static const int kSize = 64;
+  double left_grad[kSize];
+  double left_hess[kSize];
+  double left_cnt[kSize];
+  double right_grad[kSize];
+  double right_hess[kSize];
+  double right_cnt[kSize];
+  data_size_t left_count[kSize];
+  uint32_t threshold[kSize];
+  double gain[kSize];
+  int size = 0;
+};
+
+#ifdef LGBM_SIMD_X86
+
+/*!
+ * \brief Vectorized split gains, four thresholds per instruction. Every lane
+ * performs the operations of FeatureHistogram::GetSplitGains without monotone
+ * constraints in the same order, and no FMA is used, so the gains are bitwise
+ * identical to the scalar ones.
+ */
+template <bool USE_L1, bool USE_MAX_OUTPUT, bool USE_SMOOTHING>
+struct SplitGainSIMD {
+  /*!
+  * \brief Gains of candidates [0, n - n % 4), the caller computes the tail
+  * \return Number of candidates processed
+  */
+  LGBM_TARGET_AVX2 static int Run(SplitCandidates* cand, double l1, double l2,
+                                  double max_delta_step, double smoothing,
+                                  double parent_output) {
+    const __m256d v_l1 = _mm256_set1_pd(l1);
+    const __m256d v_l2 = _mm256_set1_pd(l2);
+    const __m256d v_max_delta_step = _mm256_set1_pd(max_delta_step);
+    const __m256d v_smoothing = _mm256_set1_pd(smoothing);
+    const __m256d v_parent_output = _mm256_set1_pd(parent_output);
+    const bool clip_output = USE_MAX_OUTPUT && max_delta_step > 0;
+    const int n = cand->size & ~3;
+    for (int i = 0; i < n; i += 4) {
+      const __m256d left = LeafGain(_mm256_loadu_pd(cand->left_grad + i),
+                                    _mm256_loadu_pd(cand->left_hess + i),
+                                    _mm256_loadu_pd(cand->left_cnt + i), v_l1, v_l2,
+                                    v_max_delta_step, clip_output, v_smoothing, v_parent_output);
+      const __m256d right = LeafGain(_mm256_loadu_pd(cand->right_grad + i),
+                                     _mm256_loadu_pd(cand->right_hess + i),
+                                     _mm256_loadu_pd(cand->right_cnt + i), v_l1, v_l2,
+                                     v_max_delta_step, clip_output, v_smoothing, v_parent_output);
+      _mm256_storeu_pd(cand->gain + i, _mm256_add_pd(left, right));
+    }
+    return n;
+  }
+
+ private:
+  LGBM_TARGET_AVX2 static inline __m256d Abs(__m256d x) {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+  }
+
+  LGBM_TARGET_AVX2 static inline __m256d Neg(__m256d x) {
+    return _mm256_xor_pd(_mm256_set1_pd(-0.0), x);
+  }
+
+  /*! \brief max(0, |s| - l1), as std::max(0.0, x) */
+  LGBM_TARGET_AVX2 static inline __m256d RegAbs(__m256d s, __m256d l1) {
+    return _mm256_max_pd(_mm256_sub_pd(Abs(s), l1), _mm256_setzero_pd());
+  }
+
+  /*! \brief Sign(s) * reg for reg >= 0, zero when s is zero */
+  LGBM_TARGET_AVX2 static inline __m256d ApplySign(__m256d s, __m256d reg) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d pos = _mm256_and_pd(_mm256_cmp_pd(s, zero, _CMP_GT_OQ), reg);
+    const __m256d neg = _mm256_and_pd(_mm256_cmp_pd(s, zero, _CMP_LT_OQ), Neg(reg));
+    return _mm256_or_pd(pos, neg);
+  }
+
+  LGBM_TARGET_AVX2 static inline __m256d LeafGain(
+      __m256d g, __m256d h, __m256d cnt, __m256d l1, __m256d l2, __m256d max_delta_step,
+      bool clip_output, __m256d smoothing, __m256d parent_output) {
+    const __m256d h_l2 = _mm256_add_pd(h, l2);
+    if (!USE_MAX_OUTPUT && !USE_SMOOTHING) {
+      // Sign(g)^2 does not change the square
+      const __m256d sg = USE_L1 ? RegAbs(g, l1) : g;
+      return _mm256_div_pd(_mm256_mul_pd(sg, sg), h_l2);
+    }
+    const __m256d sg = USE_L1 ? ApplySign(g, RegAbs(g, l1)) : g;
+    __m256d output = _mm256_div_pd(Neg(sg), h_l2);
+    if (USE_MAX_OUTPUT && clip_output) {
+      const __m256d clip = _mm256_cmp_pd(Abs(output), max_delta_step, _CMP_GT_OQ);
+      const __m256d clipped = _mm256_or_pd(_mm256_and_pd(output, _mm256_set1_pd(-0.0)),
+                                           max_delta_step);
+      output = _mm256_blendv_pd(output, clipped, clip);
+    }
+    if (USE_SMOOTHING) {
+      const __m256d ratio = _mm256_div_pd(cnt, smoothing);
+      const __m256d denom = _mm256_add_pd(ratio, _mm256_set1_pd(1.0));
+      output = _mm256_add_pd(_mm256_div_pd(_mm256_mul_pd(output, ratio), denom),
+                             _mm256_div_pd(parent_output, denom));
+    }
+    // -(2.0 * sg * output + (h + l2) * output * output)
+    const __m256d linear = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), sg), output);
+    const __m256d quadratic = _mm256_mul_pd(_mm256_mul_pd(h_l2, output), output);
+    return Neg(_mm256_add_pd(linear, quadratic));
+  }
+};
+
+#endif  // LGBM_SIMD_X86
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_TREELEARNER_SPLIT_GAIN_SIMD_HPP_
@@ -0,0 +1,206 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_TESTS_CPP_BENCHMARKS_BENCHMARK_H_
+#define LIGHTGBM_TESTS_CPP_BENCHMARKS_BENCHMARK_H_
+
+#include <LightGBM/c_api.h>
+#include <LightGBM/meta.h>
+#include <LightGBM/utils/json11.h>
+#include <LightGBM/utils/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace LightGBM {
+namespace benchmark {
+
+/*! \brief Options of a run, given as key=value on the command line */
+struct Options {
+  /*! \brief rows of the synthetic datasets */
+  data_size_t num_data = 100000;
+  /*! \brief columns of the synthetic datasets */
+  int num_features = 50;
+  /*! \brief fraction of zero feature values in the synthetic datasets */
+  double sparsity = 0.0;
+  /*! \brief boosting rounds of the macro benchmarks */
+  int num_trees = 50;
+  int num_leaves = 31;
+  int max_bin = 255;
+  /*! \brief 0 means the OpenMP default */
+  int num_threads = 0;
+  /*! \brief minimal measured time per benchmark, in seconds */
+  double min_time = 0.5;
+  /*! \brief minimal number of measured calls per benchmark */
+  int min_iterations = 3;
+  int seed = 0;
+  /*! \brief only run the benchmarks whose name contains this */
+  std::string filter;
+  /*! \brief file of the JSON report, stdout when empty */
+  std::string output;
+
+  /*! \brief Parameter string of the C API for the datasets and boosters of the macro benchmarks */
+  std::string LightGBMParameters() const {
+    return "verbose=-1 objective=binary num_leaves=" + std::to_string(num_leaves) +
+           " max_bin=" + std::to_string(max_bin) +
+           " num_threads=" + std::to_string(num_threads) +
+           " seed=" + std::to_string(seed);
+  }
+};
+
+/*! \brief Timings of one benchmark */
+struct Result {
+  std::string name;
+  int64_t iterations = 0;
+  /*! \brief work items per call, e.g. rows, used for the throughput */
+  int64_t items_per_iteration = 0;
+  double mean_ns = 0.0;
+  double median_ns = 0.0;
+  double min_ns = 0.0;
+  double max_ns = 0.0;
+
+  json11::Json ToJson() const {
+    const double items_per_second = mean_ns > 0.0 ? items_per_iteration * 1e9 / mean_ns : 0.0;
+    return json11::Json(json11::Json::object{
+      {"name", json11::Json(name)},
+      {"iterations", json11::Json(static_cast<double>(iterations))},
+      {"items_per_iteration", json11::Json(static_cast<double>(items_per_iteration))},
+      {"mean_ns", json11::Json(mean_ns)},
+      {"median_ns", json11::Json(median_ns)},
+      {"min_ns", json11::Json(min_ns)},
+      {"max_ns", json11::Json(max_ns)},
+      {"items_per_second", json11::Json(items_per_second)},
+    });
+  }
+};
+
+/*! \brief Handed to the benchmark functions, which prepare their data and then call Measure */
+class Context {
+ public:
+  Context(const std::string& name, const Options& options)
+      : name_(name), options_(options) {}
+
+  const Options& options() const { return options_; }
+
+  const std::string& name() const { return name_; }
+
+  /*!
+  * \brief Call body until both min_time and min_iterations are reached, and record the time of every call
+  * \param items_per_iteration Work items done by one call of body
+  * \param body Measured function
+  * \param setup Called before every call of body, not measured
+  */
+  void Measure(int64_t items_per_iteration, const std::function<void()>& body,
+               const std::function<void()>& setup = nullptr) {
+    // one warm-up call, so that lazily allocated buffers are not measured
+    if (setup != nullptr) {
+      setup();
+    }
+    body();
+    std::vector<double> times;
+    double total_ns = 0.0;
+    while (total_ns < options_.min_time * 1e9 ||
+           static_cast<int>(times.size()) < options_.min_iterations) {
+      if (setup != nullptr) {
+        setup();
+      }
+      const auto start = std::chrono::steady_clock::now();
+      body();
+      const auto end = std::chrono::steady_clock::now();
+      const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+      times.push_back(ns);
+      total_ns += ns;
+    }
+    Result result;
+    result.name = name_;
+    result.iterations = static_cast<int64_t>(times.size());
+    result.items_per_iteration = items_per_iteration;
+    result.mean_ns = total_ns / times.size();
+    std::sort(times.begin(), times.end());
+    result.median_ns = times[times.size() / 2];
+    result.min_ns = times.front();
+    result.max_ns = times.back();
+    results_.push_back(result);
+  }
+
+  const std::vector<Result>& results() const { return results_; }
+
+ private:
+  std::string name_;
+  const Options& options_;
+  std::vector<Result> results_;
+};
+
+struct Benchmark {
+  std::string name;
+  std::function<void(Context*)> run;
+};
+
+void RegisterMicroBenchmarks(std::vector<Benchmark>* benchmarks);
+
+void RegisterMacroBenchmarks(std::vector<Benchmark>* benchmarks);
+
+/*! \brief Abort the benchmark on an error of the C API */
+inline void CheckCall(int ret) {
+  if (ret != 0) {
+    Log::Fatal("C API call failed: %s", LGBM_GetLastError());
+  }
+}
+
+/*!
+* \brief Row-major synthetic features with about options.sparsity zeros, and binary labels that
+*        depend on the first features, so that the trees have splits to find
+*/
+inline void GenerateData(const Options& options, int seed, std::vector<double>* features,
+                         std::vector<float>* labels) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> value_dist(-1.0, 1.0);
+  std::uniform_real_distribution<double> zero_dist(0.0, 1.0);
+  const int num_features = options.num_features;
+  features->resize(static_cast<size_t>(options.num_data) * num_features);
+  labels->resize(options.num_data);
+  for (data_size_t i = 0; i < options.num_data; ++i) {
+    double* row = features->data() + static_cast<size_t>(i) * num_features;
+    double score = 0.0;
+    for (int j = 0; j < num_features; ++j) {
+      row[j] = zero_dist(gen) < options.sparsity ? 0.0 : value_dist(gen);
+      score += row[j] / (j + 1);
+    }
+    (*labels)[i] = score + 0.3 * value_dist(gen) > 0.0 ? 1.0f : 0.0f;
+  }
+}
+
+/*! \brief Binned training dataset of the synthetic data, the caller frees it */
+inline DatasetHandle CreateDataset(const Options& options, const std::vector<double>& features,
+                                   const std::vector<float>& labels) {
+  DatasetHandle dataset = nullptr;
+  CheckCall(LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, options.num_data,
+                                      options.num_features, 1, options.LightGBMParameters().c_str(),
+                                      nullptr, &dataset));
+  CheckCall(LGBM_DatasetSetField(dataset, "label", labels.data(), options.num_data,
+                                 C_API_DTYPE_FLOAT32));
+  return dataset;
+}
+
+/*! \brief Booster trained for options.num_trees rounds, the caller frees it */
+inline BoosterHandle TrainBooster(const Options& options, DatasetHandle dataset) {
+  BoosterHandle booster = nullptr;
+  CheckCall(LGBM_BoosterCreate(dataset, options.LightGBMParameters().c_str(), &booster));
+  int is_finished = 0;
+  for (int i = 0; i < options.num_trees && !is_finished; ++i) {
+    CheckCall(LGBM_BoosterUpdateOneIter(booster, &is_finished));
+  }
+  return booster;
+}
+
+}  // namespace benchmark
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_TESTS_CPP_BENCHMARKS_BENCHMARK_H_
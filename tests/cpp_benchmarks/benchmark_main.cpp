@@ -0,0 +1,128 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/utils/common.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+using LightGBM::Common::Atof;
+using LightGBM::Common::Atoi;
+using LightGBM::Log;
+using LightGBM::benchmark::Benchmark;
+using LightGBM::benchmark::Context;
+using LightGBM::benchmark::Options;
+
+namespace {
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    const size_t pos = arg.find('=');
+    if (pos == std::string::npos) {
+      Log::Fatal("Unknown argument %s, arguments are given as key=value", arg.c_str());
+    }
+    const std::string key = arg.substr(0, pos);
+    const std::string value = arg.substr(pos + 1);
+    if (key == "num_data") {
+      Atoi(value.c_str(), &options.num_data);
+    } else if (key == "num_features") {
+      Atoi(value.c_str(), &options.num_features);
+    } else if (key == "sparsity") {
+      Atof(value.c_str(), &options.sparsity);
+    } else if (key == "num_trees") {
+      Atoi(value.c_str(), &options.num_trees);
+    } else if (key == "num_leaves") {
+      Atoi(value.c_str(), &options.num_leaves);
+    } else if (key == "max_bin") {
+      Atoi(value.c_str(), &options.max_bin);
+    } else if (key == "num_threads") {
+      Atoi(value.c_str(), &options.num_threads);
+    } else if (key == "min_time") {
+      Atof(value.c_str(), &options.min_time);
+    } else if (key == "min_iterations") {
+      Atoi(value.c_str(), &options.min_iterations);
+    } else if (key == "seed") {
+      Atoi(value.c_str(), &options.seed);
+    } else if (key == "filter") {
+      options.filter = value;
+    } else if (key == "output") {
+      options.output = value;
+    } else {
+      Log::Fatal("Unknown benchmark option %s", key.c_str());
+    }
+  }
+  if (options.num_data <= 0 || options.num_features <= 0) {
+    Log::Fatal("num_data and num_features should be positive");
+  }
+  if (options.sparsity < 0.0 || options.sparsity >= 1.0) {
+    Log::Fatal("sparsity should be in [0, 1)");
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    const Options options = ParseOptions(argc, argv);
+    if (options.num_threads > 0) {
+      omp_set_num_threads(options.num_threads);
+    }
+    std::vector<Benchmark> benchmarks;
+    LightGBM::benchmark::RegisterMicroBenchmarks(&benchmarks);
+    LightGBM::benchmark::RegisterMacroBenchmarks(&benchmarks);
+
+    json11::Json::array results;
+    for (const auto& benchmark : benchmarks) {
+      if (benchmark.name.find(options.filter) == std::string::npos) {
+        continue;
+      }
+      // progress goes to stderr, stdout may hold the report
+      std::cerr << "Running " << benchmark.name << std::endl;
+      Context context(benchmark.name, options);
+      benchmark.run(&context);
+      for (const auto& result : context.results()) {
+        results.push_back(result.ToJson());
+      }
+    }
+
+    const json11::Json report(json11::Json::object{
+      {"context", json11::Json(json11::Json::object{
+        {"timestamp", json11::Json(static_cast<double>(std::time(nullptr)))},
+        {"num_threads", json11::Json(OMP_NUM_THREADS())},
+        {"num_data", json11::Json(options.num_data)},
+        {"num_features", json11::Json(options.num_features)},
+        {"sparsity", json11::Json(options.sparsity)},
+        {"num_trees", json11::Json(options.num_trees)},
+        {"num_leaves", json11::Json(options.num_leaves)},
+        {"max_bin", json11::Json(options.max_bin)},
+        {"seed", json11::Json(options.seed)},
+      })},
+      {"benchmarks", json11::Json(results)},
+    });
+    if (options.output.empty()) {
+      std::cout << report.dump() << std::endl;
+    } else {
+      std::ofstream out(options.output);
+      if (!out.is_open()) {
+        Log::Fatal("Cannot write benchmark report to %s", options.output.c_str());
+      }
+      out << report.dump() << std::endl;
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << "Met Exceptions:" << std::endl;
+    std::cerr << ex.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/c_api.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+
+namespace LightGBM {
+namespace benchmark {
+
+namespace {
+
+void ConstructDataset(Context* context) {
+  const Options& options = context->options();
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(options, options.seed, &features, &labels);
+  DatasetHandle dataset = nullptr;
+  context->Measure(options.num_data, [&] {
+    dataset = CreateDataset(options, features, labels);
+  }, [&] {
+    if (dataset != nullptr) {
+      CheckCall(LGBM_DatasetFree(dataset));
+      dataset = nullptr;
+    }
+  });
+  CheckCall(LGBM_DatasetFree(dataset));
+}
+
+void Train(Context* context) {
+  const Options& options = context->options();
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(options, options.seed, &features, &labels);
+  DatasetHandle dataset = CreateDataset(options, features, labels);
+  BoosterHandle booster = nullptr;
+  context->Measure(static_cast<int64_t>(options.num_data) * options.num_trees, [&] {
+    booster = TrainBooster(options, dataset);
+  }, [&] {
+    if (booster != nullptr) {
+      CheckCall(LGBM_BoosterFree(booster));
+      booster = nullptr;
+    }
+  });
+  CheckCall(LGBM_BoosterFree(booster));
+  CheckCall(LGBM_DatasetFree(dataset));
+}
+
+/*!
+* \brief Train on a small dataset, whose trees spend most of their time in the per-split loops,
+*        with the loops over leaves and feature groups as OpenMP loops or TaskScheduler tasks
+*/
+void TrainSmall(Context* context, bool use_task_scheduler) {
+  Options options = context->options();
+  options.num_data = std::min<data_size_t>(options.num_data, 10000);
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(options, options.seed, &features, &labels);
+  DatasetHandle dataset = CreateDataset(options, features, labels);
+  const std::string parameters = options.LightGBMParameters() + " force_col_wise=true max_concurrent_leaves=4" +
+                                 " use_task_scheduler=" + (use_task_scheduler ? "true" : "false");
+  BoosterHandle booster = nullptr;
+  context->Measure(static_cast<int64_t>(options.num_data) * options.num_trees, [&] {
+    CheckCall(LGBM_BoosterCreate(dataset, parameters.c_str(), &booster));
+    int is_finished = 0;
+    for (int i = 0; i < options.num_trees && !is_finished; ++i) {
+      CheckCall(LGBM_BoosterUpdateOneIter(booster, &is_finished));
+    }
+  }, [&] {
+    if (booster != nullptr) {
+      CheckCall(LGBM_BoosterFree(booster));
+      booster = nullptr;
+    }
+  });
+  CheckCall(LGBM_BoosterFree(booster));
+  CheckCall(LGBM_DatasetFree(dataset));
+}
+
+/*! \brief Predict rows that were not used for training, in one batch or one row per call */
+void Predict(Context* context, bool single_row) {
+  const Options& options = context->options();
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(options, options.seed, &features, &labels);
+  DatasetHandle dataset = CreateDataset(options, features, labels);
+  BoosterHandle booster = TrainBooster(options, dataset);
+  GenerateData(options, options.seed + 1, &features, &labels);
+  const std::string parameters = "num_threads=" + std::to_string(options.num_threads);
+  int64_t out_len = 0;
+  if (single_row) {
+    // single-row prediction is latency bound, a slice of the rows is enough
+    const data_size_t num_rows = std::min<data_size_t>(options.num_data, 10000);
+    double result = 0.0;
+    context->Measure(num_rows, [&] {
+      for (data_size_t i = 0; i < num_rows; ++i) {
+        CheckCall(LGBM_BoosterPredictForMatSingleRow(
+            booster, features.data() + static_cast<size_t>(i) * options.num_features,
+            C_API_DTYPE_FLOAT64, options.num_features, 1, C_API_PREDICT_NORMAL, 0, -1,
+            parameters.c_str(), &out_len, &result));
+      }
+    });
+  } else {
+    std::vector<double> result(options.num_data);
+    context->Measure(options.num_data, [&] {
+      CheckCall(LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64,
+                                          options.num_data, options.num_features, 1,
+                                          C_API_PREDICT_NORMAL, 0, -1, parameters.c_str(),
+                                          &out_len, result.data()));
+    });
+  }
+  CheckCall(LGBM_BoosterFree(booster));
+  CheckCall(LGBM_DatasetFree(dataset));
+}
+
+}  // namespace
+
+void RegisterMacroBenchmarks(std::vector<Benchmark>* benchmarks) {
+  benchmarks->push_back({"Macro/DatasetConstruct", ConstructDataset});
+  benchmarks->push_back({"Macro/Train", Train});
+  benchmarks->push_back({"Macro/TrainSmall/OpenMP", [](Context* context) {
+    TrainSmall(context, false);
+  }});
+  benchmarks->push_back({"Macro/TrainSmall/TaskScheduler", [](Context* context) {
+    TrainSmall(context, true);
+  }});
+  benchmarks->push_back({"Macro/PredictForMat", [](Context* context) {
+    Predict(context, false);
+  }});
+  benchmarks->push_back({"Macro/PredictForMatSingleRow", [](Context* context) {
+    Predict(context, true);
+  }});
+}
+
+}  // namespace benchmark
+}  // namespace LightGBM
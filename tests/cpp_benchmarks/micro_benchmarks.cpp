@@ -0,0 +1,373 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/bin.h>
+#include <LightGBM/config.h>
+#include <LightGBM/dataset.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/common.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../src/io/parser.hpp"
+#include "../../src/treelearner/data_partition.hpp"
+#include "../../src/treelearner/feature_histogram.hpp"
+#include "benchmark.h"
+
+namespace LightGBM {
+namespace benchmark {
+
+namespace {
+
+/*! \brief Sparse bins are only used for mostly zero features, whatever the sparsity option */
+const double kMinSparseBinSparsity = 0.8;
+
+/*! \brief Gradients of all rows, and the rows of a leaf with their ordered gradients */
+struct HistogramInput {
+  HistogramInput(const Options& options, std::mt19937* gen) {
+    std::uniform_real_distribution<float> grad_dist(-1.0f, 1.0f);
+    gradients.resize(options.num_data);
+    hessians.resize(options.num_data);
+    for (data_size_t i = 0; i < options.num_data; ++i) {
+      gradients[i] = grad_dist(*gen);
+      hessians[i] = grad_dist(*gen) + 1.5f;
+    }
+    // about a third of the rows, as in a leaf a few levels down the tree
+    for (data_size_t i = 0; i < options.num_data; i += 1 + i % 5) {
+      indices.push_back(i);
+      ordered_gradients.push_back(gradients[i]);
+      ordered_hessians.push_back(hessians[i]);
+    }
+  }
+
+  data_size_t num_indices() const { return static_cast<data_size_t>(indices.size()); }
+
+  std::vector<score_t> gradients;
+  std::vector<score_t> hessians;
+  std::vector<data_size_t> indices;
+  std::vector<score_t> ordered_gradients;
+  std::vector<score_t> ordered_hessians;
+};
+
+void BinHistogram(Context* context, bool is_sparse, int num_bin, bool use_indices) {
+  const Options& options = context->options();
+  std::mt19937 gen(options.seed);
+  const double sparsity = is_sparse ? std::max(options.sparsity, kMinSparseBinSparsity)
+                                    : options.sparsity;
+  std::uniform_int_distribution<int> bin_dist(1, num_bin - 1);
+  std::uniform_real_distribution<double> zero_dist(0.0, 1.0);
+  std::unique_ptr<Bin> bin(is_sparse ? Bin::CreateSparseBin(options.num_data, num_bin)
+                                     : Bin::CreateDenseBin(options.num_data, num_bin));
+  for (data_size_t i = 0; i < options.num_data; ++i) {
+    const uint32_t value = zero_dist(gen) < sparsity ? 0 : static_cast<uint32_t>(bin_dist(gen));
+    if (value != 0 || !is_sparse) {
+      bin->Push(0, i, value);
+    }
+  }
+  bin->FinishLoad();
+  const HistogramInput input(options, &gen);
+  std::vector<hist_t> hist(static_cast<size_t>(num_bin) * 2);
+  if (use_indices) {
+    context->Measure(input.num_indices(), [&] {
+      std::fill(hist.begin(), hist.end(), 0.0f);
+      bin->ConstructHistogram(input.indices.data(), 0, input.num_indices(),
+                              input.ordered_gradients.data(), input.ordered_hessians.data(),
+                              hist.data());
+    });
+  } else {
+    context->Measure(options.num_data, [&] {
+      std::fill(hist.begin(), hist.end(), 0.0f);
+      bin->ConstructHistogram(0, options.num_data, input.gradients.data(),
+                              input.hessians.data(), hist.data());
+    });
+  }
+}
+
+void MultiValBinHistogram(Context* context, bool is_sparse, bool use_indices) {
+  const Options& options = context->options();
+  std::mt19937 gen(options.seed);
+  const int num_feature = options.num_features;
+  const int feature_num_bin = options.max_bin;
+  std::vector<uint32_t> offsets(num_feature + 1);
+  for (int j = 0; j <= num_feature; ++j) {
+    offsets[j] = static_cast<uint32_t>(j * feature_num_bin);
+  }
+  const int num_bin = static_cast<int>(offsets.back());
+  const double sparsity = is_sparse ? std::max(options.sparsity, kMinSparseBinSparsity)
+                                    : options.sparsity;
+  std::unique_ptr<MultiValBin> bin;
+  if (is_sparse) {
+    bin.reset(MultiValBin::CreateMultiValSparseBin(options.num_data, num_bin,
+                                                   (1.0 - sparsity) * num_feature));
+  } else {
+    bin.reset(MultiValBin::CreateMultiValDenseBin(options.num_data, num_bin, num_feature, offsets));
+  }
+  std::uniform_int_distribution<int> bin_dist(1, feature_num_bin - 1);
+  std::uniform_real_distribution<double> zero_dist(0.0, 1.0);
+  std::vector<uint32_t> values;
+  for (data_size_t i = 0; i < options.num_data; ++i) {
+    values.clear();
+    for (int j = 0; j < num_feature; ++j) {
+      const uint32_t value = zero_dist(gen) < sparsity ? 0 : static_cast<uint32_t>(bin_dist(gen));
+      // the sparse bin stores the non-zero bins only, as offsets into the histogram
+      if (!is_sparse) {
+        values.push_back(value);
+      } else if (value != 0) {
+        values.push_back(value + offsets[j]);
+      }
+    }
+    bin->PushOneRow(0, i, values);
+  }
+  bin->FinishLoad();
+  const HistogramInput input(options, &gen);
+  std::vector<hist_t> hist(static_cast<size_t>(num_bin) * 2);
+  if (use_indices) {
+    context->Measure(input.num_indices(), [&] {
+      std::fill(hist.begin(), hist.end(), 0.0f);
+      bin->ConstructHistogram(input.indices.data(), 0, input.num_indices(),
+                              input.gradients.data(), input.hessians.data(), hist.data());
+    });
+  } else {
+    context->Measure(options.num_data, [&] {
+      std::fill(hist.begin(), hist.end(), 0.0f);
+      bin->ConstructHistogram(0, options.num_data, input.gradients.data(),
+                              input.hessians.data(), hist.data());
+    });
+  }
+}
+
+void FindBestThreshold(Context* context, MissingType missing_type) {
+  const Options& options = context->options();
+  std::mt19937 gen(options.seed);
+  std::uniform_real_distribution<double> grad_dist(-1.0, 1.0);
+  std::uniform_real_distribution<double> hess_dist(0.5, 1.5);
+  Config config;
+  FeatureMetainfo meta;
+  meta.num_bin = options.max_bin;
+  meta.missing_type = missing_type;
+  meta.offset = 0;
+  meta.default_bin = 0;
+  meta.bin_type = BinType::NumericalBin;
+  meta.config = &config;
+  // the histogram of all rows, with the same rows per bin on average
+  std::vector<hist_t> data(static_cast<size_t>(meta.num_bin) * 2);
+  const double num_data_per_bin = static_cast<double>(options.num_data) / meta.num_bin;
+  double sum_gradient = 0.0, sum_hessian = 0.0;
+  for (int i = 0; i < meta.num_bin; ++i) {
+    data[2 * i] = static_cast<hist_t>(grad_dist(gen) * num_data_per_bin);
+    data[2 * i + 1] = static_cast<hist_t>(hess_dist(gen) * num_data_per_bin);
+    sum_gradient += data[2 * i];
+    sum_hessian += data[2 * i + 1];
+  }
+  FeatureHistogram histogram;
+  histogram.Init(data.data(), &meta);
+  SplitInfo split;
+  context->Measure(meta.num_bin, [&] {
+    histogram.FindBestThreshold(sum_gradient, sum_hessian, options.num_data, nullptr, 0.0,
+                                &split);
+  });
+}
+
+void DataPartitionSplit(Context* context) {
+  const Options& options = context->options();
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(options, options.seed, &features, &labels);
+  DatasetHandle handle = CreateDataset(options, features, labels);
+  const Dataset* dataset = reinterpret_cast<const Dataset*>(handle);
+  DataPartition partition(options.num_data, options.num_leaves);
+  // split the root near the middle of the bins of the first feature
+  const uint32_t threshold = static_cast<uint32_t>(dataset->FeatureNumBin(0) / 2);
+  context->Measure(options.num_data, [&] {
+    partition.Split(0, dataset, 0, &threshold, 1, true, 1);
+  }, [&] {
+    partition.Init();
+  });
+  CheckCall(LGBM_DatasetFree(handle));
+}
+
+void TreePredict(Context* context) {
+  const Options& options = context->options();
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(options, options.seed, &features, &labels);
+  DatasetHandle dataset = CreateDataset(options, features, labels);
+  BoosterHandle booster = TrainBooster(options, dataset);
+  int64_t model_len = 0;
+  CheckCall(LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0,
+                                          &model_len, nullptr));
+  std::vector<char> model(model_len);
+  CheckCall(LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT,
+                                          model_len, &model_len, model.data()));
+  CheckCall(LGBM_BoosterFree(booster));
+  CheckCall(LGBM_DatasetFree(dataset));
+  // read the trees the way GBDT::LoadModelFromString does
+  std::vector<std::unique_ptr<Tree>> trees;
+  const char* p = model.data();
+  while ((p = std::strstr(p, "\nTree=")) != nullptr) {
+    p += 1;
+    p += Common::GetLine(p);
+    p = Common::SkipNewLine(p);
+    size_t used_len = 0;
+    trees.emplace_back(new Tree(p, &used_len));
+    p += used_len;
+  }
+  const data_size_t num_rows = std::min<data_size_t>(options.num_data, 10000);
+  double sum = 0.0;
+  context->Measure(static_cast<int64_t>(num_rows) * trees.size(), [&] {
+    for (data_size_t i = 0; i < num_rows; ++i) {
+      const double* row = features.data() + static_cast<size_t>(i) * options.num_features;
+      for (const auto& tree : trees) {
+        sum += tree->Predict(row);
+      }
+    }
+  });
+  if (sum == 0.0) {
+    Log::Debug("All predictions of Tree::Predict are zero");
+  }
+}
+
+void Atof(Context* context) {
+  const Options& options = context->options();
+  std::mt19937 gen(options.seed);
+  std::uniform_real_distribution<double> value_dist(-1000.0, 1000.0);
+  // the formats of text data files: shortest, fixed precision and exponent notation
+  const char* formats[] = {"%g", "%.6f", "%.17g", "%e"};
+  std::string text;
+  char buffer[64];
+  const int num_values = options.num_data;
+  for (int i = 0; i < num_values; ++i) {
+    std::snprintf(buffer, sizeof(buffer), formats[i % 4], value_dist(gen));
+    text += buffer;
+    text += ',';
+  }
+  double sum = 0.0;
+  context->Measure(num_values, [&] {
+    const char* p = text.c_str();
+    for (int i = 0; i < num_values; ++i) {
+      double value = 0.0;
+      p = Common::Atof(p, &value);
+      sum += value;
+      ++p;
+    }
+  });
+  if (sum == 0.0) {
+    Log::Debug("Sum of the parsed values is zero");
+  }
+}
+
+/*!
+* \brief Parse the lines of a CSV file with the parser of the loader, one line at a time or in blocks of
+*        the same size as the loader's
+* \param precise Parse the values with Common::AtofPrecise, as with precise_float_parser=true
+*/
+void CSVParse(Context* context, bool use_blocks, bool precise) {
+  const Options& options = context->options();
+  std::mt19937 gen(options.seed);
+  std::uniform_real_distribution<double> value_dist(-1000.0, 1000.0);
+  std::uniform_real_distribution<double> zero_dist(0.0, 1.0);
+  const int num_col = options.num_features;
+  std::vector<std::string> lines(options.num_data);
+  char buffer[64];
+  for (auto& line : lines) {
+    line = std::to_string(static_cast<int>(zero_dist(gen) < 0.5));
+    for (int j = 0; j < num_col; ++j) {
+      if (zero_dist(gen) < options.sparsity) {
+        line += ",0";
+      } else {
+        std::snprintf(buffer, sizeof(buffer), ",%g", value_dist(gen));
+        line += buffer;
+      }
+    }
+  }
+  CSVParser parser(0, num_col + 1, precise ? Common::AtofPrecise : Common::Atof);
+  const data_size_t num_lines = options.num_data;
+  const data_size_t block_size = std::max<data_size_t>(16, 32768 / std::max(num_col, 1));
+  std::vector<double> values(static_cast<size_t>(num_col) * block_size);
+  std::vector<double> labels(block_size);
+  std::vector<std::pair<int, double>> features;
+  double sum = 0.0;
+  context->Measure(num_lines, [&] {
+    if (use_blocks) {
+      for (data_size_t begin = 0; begin < num_lines; begin += block_size) {
+        const data_size_t cnt = std::min(block_size, num_lines - begin);
+        parser.ParseBlock(lines.data() + begin, cnt, num_col, values.data(), labels.data());
+        sum += values[0];
+      }
+    } else {
+      for (const auto& line : lines) {
+        double label = 0.0;
+        features.clear();
+        parser.ParseOneLine(line.c_str(), &features, &label);
+        sum += label;
+      }
+    }
+  });
+  if (sum == 0.0) {
+    Log::Debug("Sum of the parsed values is zero");
+  }
+}
+
+}  // namespace
+
+void RegisterMicroBenchmarks(std::vector<Benchmark>* benchmarks) {
+  const struct {
+    const char* name;
+    bool is_sparse;
+    bool is_4bit;
+  } bin_types[] = {
+    {"DenseBin", false, false},
+    {"DenseBin4Bit", false, true},
+    {"SparseBin", true, false},
+  };
+  for (const auto& bin_type : bin_types) {
+    for (const bool use_indices : {false, true}) {
+      const std::string name = std::string("Bin::ConstructHistogram/") + bin_type.name +
+                               (use_indices ? "/leaf" : "/all");
+      const bool is_sparse = bin_type.is_sparse;
+      const bool is_4bit = bin_type.is_4bit;
+      benchmarks->push_back({name, [=](Context* context) {
+        // dense bins with at most 16 bins pack two values per byte
+        BinHistogram(context, is_sparse, is_4bit ? 16 : context->options().max_bin, use_indices);
+      }});
+    }
+  }
+  for (const bool is_sparse : {false, true}) {
+    for (const bool use_indices : {false, true}) {
+      const std::string name = std::string("MultiValBin::ConstructHistogram/") +
+                               (is_sparse ? "Sparse" : "Dense") + (use_indices ? "/leaf" : "/all");
+      benchmarks->push_back({name, [=](Context* context) {
+        MultiValBinHistogram(context, is_sparse, use_indices);
+      }});
+    }
+  }
+  benchmarks->push_back({"FeatureHistogram::FindBestThreshold/MissingNone", [](Context* context) {
+    FindBestThreshold(context, MissingType::None);
+  }});
+  benchmarks->push_back({"FeatureHistogram::FindBestThreshold/MissingNaN", [](Context* context) {
+    FindBestThreshold(context, MissingType::NaN);
+  }});
+  benchmarks->push_back({"DataPartition::Split", DataPartitionSplit});
+  benchmarks->push_back({"Tree::Predict", TreePredict});
+  benchmarks->push_back({"Common::Atof", Atof});
+  for (const bool precise : {false, true}) {
+    for (const bool use_blocks : {false, true}) {
+      const std::string name = std::string("CSVParser::") + (use_blocks ? "ParseBlock" : "ParseOneLine") +
+                               (precise ? "/AtofPrecise" : "/Atof");
+      benchmarks->push_back({name, [=](Context* context) {
+        CSVParse(context, use_blocks, precise);
+      }});
+    }
+  }
+}
+
+}  // namespace benchmark
+}  // namespace LightGBM
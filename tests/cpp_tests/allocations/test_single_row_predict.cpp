@@ -0,0 +1,166 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/*! \brief Allocations of the current thread while counting is enabled */
+thread_local bool count_allocations = false;
+thread_local int num_allocations = 0;
+
+}  // namespace
+
+// replaces the allocation of the whole binary, which only holds the tests of the allocations
+void* operator new(std::size_t size) {
+  if (count_allocations) {
+    ++num_allocations;
+  }
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+class SingleRowPredictTest : public testing::TestWithParam<std::string> {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(3);
+    std::normal_distribution<double> value_dist;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    features_.resize(static_cast<size_t>(kNumData) * kNumFeatures);
+    std::vector<float> labels(kNumData);
+    for (int i = 0; i < kNumData; ++i) {
+      double* row = features_.data() + static_cast<size_t>(i) * kNumFeatures;
+      for (int j = 0; j < kNumFeatures; ++j) {
+        const double r = uniform(gen);
+        row[j] = r < 0.05 ? NAN : (r < 0.3 ? 0.0 : value_dist(gen));
+      }
+      labels[i] = static_cast<float>(static_cast<int>(std::fabs(row[0] - row[1]) * 2) % 3);
+    }
+    const std::string params = GetParam() + " num_leaves=15 verbose=-1 num_threads=1";
+    ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features_.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           params.c_str(), nullptr, &dataset_));
+    ASSERT_EQ(0, LGBM_DatasetSetField(dataset_, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+    ASSERT_EQ(0, LGBM_BoosterCreate(dataset_, params.c_str(), &booster_));
+    int is_finished = 0;
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_EQ(0, LGBM_BoosterUpdateOneIter(booster_, &is_finished));
+    }
+  }
+
+  void TearDown() override {
+    EXPECT_EQ(0, LGBM_BoosterFree(booster_));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset_));
+  }
+
+  static const int kNumData = 300;
+  static const int kNumFeatures = 5;
+  std::vector<double> features_;
+  DatasetHandle dataset_ = nullptr;
+  BoosterHandle booster_ = nullptr;
+};
+
+TEST_P(SingleRowPredictTest, PredictionDoesNotAllocate) {
+  const char* parameter = "pred_early_stop=true pred_early_stop_freq=2 pred_early_stop_margin=1.5";
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX}) {
+    // the batch prediction of the same rows
+    std::vector<double> expected(static_cast<size_t>(kNumData) * 3 * 10);
+    int64_t out_len = 0;
+    ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster_, features_.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           predict_type, 0, -1, parameter, &out_len, expected.data()));
+    const int64_t num_pred = out_len / kNumData;
+
+    FastConfigHandle dense_config;
+    FastConfigHandle sparse_config;
+    ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRowFastInit(booster_, predict_type, 0, -1, C_API_DTYPE_FLOAT64,
+                                                            kNumFeatures, parameter, &dense_config));
+    ASSERT_EQ(0, LGBM_BoosterPredictForCSRSingleRowFastInit(booster_, predict_type, 0, -1, C_API_DTYPE_FLOAT64,
+                                                            kNumFeatures, parameter, &sparse_config));
+    std::vector<double> result(num_pred);
+    std::vector<int32_t> indices(kNumFeatures);
+    std::vector<double> values(kNumFeatures);
+    // the first calls may size the buffer of the thread and parse the parameters
+    ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRowFast(dense_config, features_.data(), &out_len, result.data()));
+    ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster_, features_.data(), C_API_DTYPE_FLOAT64, kNumFeatures, 1,
+                                                    predict_type, 0, -1, parameter, &out_len, result.data()));
+    for (int i = 0; i < kNumData; ++i) {
+      const double* row = features_.data() + static_cast<size_t>(i) * kNumFeatures;
+      int32_t indptr[2] = {0, 0};
+      for (int j = 0; j < kNumFeatures; ++j) {
+        if (row[j] != 0.0) {
+          indices[indptr[1]] = j;
+          values[indptr[1]] = row[j];
+          ++indptr[1];
+        }
+      }
+      count_allocations = true;
+      num_allocations = 0;
+      const int dense_ret = LGBM_BoosterPredictForMatSingleRowFast(dense_config, row, &out_len, result.data());
+      count_allocations = false;
+      ASSERT_EQ(0, dense_ret);
+      ASSERT_EQ(0, num_allocations) << "dense row " << i;
+      ASSERT_EQ(num_pred, out_len);
+      for (int k = 0; k < num_pred; ++k) {
+        ASSERT_EQ(expected[i * num_pred + k], result[k]) << "dense row " << i;
+      }
+
+      count_allocations = true;
+      const int sparse_ret = LGBM_BoosterPredictForCSRSingleRowFast(sparse_config, indptr, C_API_DTYPE_INT32,
+                                                                    indices.data(), values.data(), 2, indptr[1],
+                                                                    &out_len, result.data());
+      count_allocations = false;
+      ASSERT_EQ(0, sparse_ret);
+      ASSERT_EQ(0, num_allocations) << "sparse row " << i;
+      for (int k = 0; k < num_pred; ++k) {
+        ASSERT_EQ(expected[i * num_pred + k], result[k]) << "sparse row " << i;
+      }
+
+      // the APIs that take the parameters on every call
+      count_allocations = true;
+      const int dense_param_ret = LGBM_BoosterPredictForMatSingleRow(booster_, row, C_API_DTYPE_FLOAT64, kNumFeatures,
+                                                                     1, predict_type, 0, -1, parameter, &out_len,
+                                                                     result.data());
+      count_allocations = false;
+      ASSERT_EQ(0, dense_param_ret);
+      ASSERT_EQ(0, num_allocations) << "dense row with parameters " << i;
+      for (int k = 0; k < num_pred; ++k) {
+        ASSERT_EQ(expected[i * num_pred + k], result[k]) << "dense row with parameters " << i;
+      }
+
+      count_allocations = true;
+      const int sparse_param_ret = LGBM_BoosterPredictForCSRSingleRow(booster_, indptr, C_API_DTYPE_INT32,
+                                                                      indices.data(), values.data(),
+                                                                      C_API_DTYPE_FLOAT64, 2, indptr[1], kNumFeatures,
+                                                                      predict_type, 0, -1, parameter, &out_len,
+                                                                      result.data());
+      count_allocations = false;
+      ASSERT_EQ(0, sparse_param_ret);
+      ASSERT_EQ(0, num_allocations) << "sparse row with parameters " << i;
+      for (int k = 0; k < num_pred; ++k) {
+        ASSERT_EQ(expected[i * num_pred + k], result[k]) << "sparse row with parameters " << i;
+      }
+    }
+    ASSERT_EQ(0, LGBM_FastConfigFree(dense_config));
+    ASSERT_EQ(0, LGBM_FastConfigFree(sparse_config));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Objectives, SingleRowPredictTest,
+                         testing::Values("objective=binary", "objective=multiclass num_class=3",
+                                         "objective=regression boosting=rf bagging_freq=1 bagging_fraction=0.5"));
@@ -5,8 +5,12 @@
 #include <gtest/gtest.h>
 
 #include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "../include/LightGBM/utils/common.h"
+#include "../include/LightGBM/utils/openmp_wrapper.h"
 
 
 // This is a basic test for floating number parsing.
@@ -151,3 +155,46 @@ TEST_F(AtofPreciseTest, Inf) {
               << "parsed infinite is not the same for every bit: " << test.data;
   }
 }
+
+#ifdef _OPENMP
+// The helper must not throw again from its destructor while the exception of OMP_THROW_EX unwinds
+TEST(OpenMPWrapper, ReThrowsOnce) {
+  using LightGBM::Log;
+  auto loop = [] {
+    OMP_INIT_EX();
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < 8; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      if (i == 3) {
+        throw std::runtime_error("loop error");
+      }
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+  };
+  EXPECT_THROW(loop(), std::runtime_error);
+}
+#endif  // _OPENMP
+
+// Moving keeps the owned buffer or the viewed memory, and leaves an empty array behind
+TEST(ViewableVector, MovesOwnedAndViewedElements) {
+  using LightGBM::Common::ViewableVector;
+  ViewableVector<int> owned;
+  owned = std::vector<int>{1, 2, 3};
+  const int* owned_data = owned.data();
+  ViewableVector<int> moved(std::move(owned));
+  EXPECT_EQ(owned_data, moved.data());
+  EXPECT_EQ(3u, moved.size());
+  EXPECT_FALSE(moved.is_view());
+  EXPECT_TRUE(owned.empty());
+
+  const std::vector<int> elements = {4, 5};
+  ViewableVector<int> view;
+  view.SetView(elements.data(), elements.size());
+  moved = std::move(view);
+  EXPECT_EQ(elements.data(), moved.data());
+  EXPECT_EQ(2u, moved.size());
+  EXPECT_TRUE(moved.is_view());
+  EXPECT_TRUE(view.empty());
+  EXPECT_FALSE(view.is_view());
+}
@@ -0,0 +1,82 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// more than one chunk of the two-round reader
+const int kNumData = 500000;
+const int kNumFeatures = 12;
+const char* kFilename = "test_dataset_loader.csv";
+const char* kDatasetParams = "linear_tree=true bin_construct_sample_cnt=1000000 verbose=-1";
+const char* kBoosterParams = "objective=regression linear_tree=true num_leaves=4 deterministic=true verbose=-1";
+
+/*! \brief Trees of the model after a few iterations on the dataset */
+std::string TrainedTrees(DatasetHandle dataset) {
+  BoosterHandle booster;
+  EXPECT_EQ(0, LGBM_BoosterCreate(dataset, kBoosterParams, &booster));
+  int is_finished = 0;
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+  }
+  int64_t len = 0;
+  EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &len, nullptr));
+  std::vector<char> model(len);
+  EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, len, &len,
+                                             model.data()));
+  EXPECT_EQ(0, LGBM_BoosterFree(booster));
+  const std::string model_str(model.data());
+  return model_str.substr(0, model_str.find("end of trees"));
+}
+
+}  // namespace
+
+// The raw values of linear trees are the same whether the text file is loaded in memory, in two rounds or
+// the data is given as a matrix: zeros do not keep the value of the previous row and rows are not shifted
+TEST(DatasetLoader, LinearTreeRawDataMatchesMatrix) {
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<int> value_dist(-99, 99);
+  std::uniform_int_distribution<int> zero_dist(0, 1);
+  std::vector<double> features(static_cast<size_t>(kNumData) * kNumFeatures);
+  std::vector<float> labels(kNumData);
+  {
+    std::ofstream file(kFilename, std::ios::trunc);
+    for (int i = 0; i < kNumData; ++i) {
+      // integers, so the text is parsed exactly
+      int label = 0;
+      std::string line;
+      for (int j = 0; j < kNumFeatures; ++j) {
+        const int value = zero_dist(gen) == 0 ? 0 : value_dist(gen);
+        features[static_cast<size_t>(i) * kNumFeatures + j] = value;
+        label += (j + 1) * value;
+        line += "," + std::to_string(value);
+      }
+      labels[i] = static_cast<float>(label / 8);
+      file << label / 8 << line << "\n";
+    }
+  }
+  DatasetHandle matrix_dataset;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                         kDatasetParams, nullptr, &matrix_dataset));
+  ASSERT_EQ(0, LGBM_DatasetSetField(matrix_dataset, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+  const std::string expected = TrainedTrees(matrix_dataset);
+  EXPECT_EQ(0, LGBM_DatasetFree(matrix_dataset));
+  for (bool two_round : {false, true}) {
+    const std::string params = std::string(kDatasetParams) + (two_round ? " two_round=true" : "");
+    DatasetHandle file_dataset;
+    ASSERT_EQ(0, LGBM_DatasetCreateFromFile(kFilename, params.c_str(), nullptr, &file_dataset));
+    EXPECT_EQ(expected, TrainedTrees(file_dataset)) << "two_round " << two_round;
+    EXPECT_EQ(0, LGBM_DatasetFree(file_dataset));
+  }
+  std::remove(kFilename);
+}
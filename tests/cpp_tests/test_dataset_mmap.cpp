@@ -0,0 +1,181 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/io/binary_chunk.hpp"
+
+namespace {
+
+const int kNumData = 1000;
+const int kNumFeatures = 8;
+const char* kBinFilename = "test_dataset_mmap.bin";
+
+/*! \brief Model string after a few iterations on the dataset */
+std::string TrainedModel(DatasetHandle dataset, const std::string& params) {
+  BoosterHandle booster;
+  EXPECT_EQ(0, LGBM_BoosterCreate(dataset, params.c_str(), &booster));
+  int is_finished = 0;
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+  }
+  int64_t len = 0;
+  EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &len, nullptr));
+  std::vector<char> model(len);
+  EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, len, &len,
+                                             model.data()));
+  EXPECT_EQ(0, LGBM_BoosterFree(booster));
+  return std::string(model.data());
+}
+
+std::vector<float> FloatField(DatasetHandle dataset, const char* field_name) {
+  int out_len = 0;
+  const void* out_ptr = nullptr;
+  int out_type = 0;
+  EXPECT_EQ(0, LGBM_DatasetGetField(dataset, field_name, &out_len, &out_ptr, &out_type));
+  EXPECT_EQ(C_API_DTYPE_FLOAT32, out_type);
+  const float* values = reinterpret_cast<const float*>(out_ptr);
+  return std::vector<float>(values, values + out_len);
+}
+
+}  // namespace
+
+class DatasetMmap : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(11);
+    std::normal_distribution<double> value_dist;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    features_.resize(static_cast<size_t>(kNumData) * kNumFeatures);
+    labels_.resize(kNumData);
+    weights_.resize(kNumData);
+    for (int i = 0; i < kNumData; ++i) {
+      double* row = features_.data() + static_cast<size_t>(i) * kNumFeatures;
+      // dense, with NaN
+      row[0] = uniform(gen) < 0.05 ? NAN : value_dist(gen);
+      row[1] = value_dist(gen);
+      // few distinct values, in 4-bit bins
+      row[2] = static_cast<int>(uniform(gen) * 5);
+      // categorical
+      row[3] = static_cast<int>(uniform(gen) * 7);
+      // sparse
+      for (int j = 4; j < kNumFeatures; ++j) {
+        row[j] = uniform(gen) < 0.9 ? 0.0 : value_dist(gen);
+      }
+      labels_[i] = static_cast<float>(row[1] + row[2] * 0.5 + (row[3] == 2 ? 1.0 : 0.0) + row[5]);
+      weights_[i] = static_cast<float>(0.5 + uniform(gen));
+    }
+  }
+
+  void TearDown() override {
+    std::remove(kBinFilename);
+  }
+
+  /*! \brief Save the dataset to kBinFilename, return the model trained on it */
+  std::string SaveBinary(const std::string& params) {
+    DatasetHandle dataset;
+    EXPECT_EQ(0, LGBM_DatasetCreateFromMat(features_.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           params.c_str(), nullptr, &dataset));
+    EXPECT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels_.data(), kNumData, C_API_DTYPE_FLOAT32));
+    EXPECT_EQ(0, LGBM_DatasetSetField(dataset, "weight", weights_.data(), kNumData, C_API_DTYPE_FLOAT32));
+    std::remove(kBinFilename);
+    EXPECT_EQ(0, LGBM_DatasetSaveBinary(dataset, kBinFilename));
+    const std::string model = TrainedModel(dataset, params);
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+    return model;
+  }
+
+  /*! \brief Load kBinFilename copied and in place, and check that the same model is trained */
+  void CheckLoads(const std::string& params, const std::string& expected) {
+    for (const char* load_params : {"", "mmap_binary=true"}) {
+      DatasetHandle loaded;
+      ASSERT_EQ(0, LGBM_DatasetCreateFromFile(kBinFilename, (params + " " + load_params).c_str(), nullptr,
+                                              &loaded));
+      EXPECT_EQ(labels_, FloatField(loaded, "label")) << params << " " << load_params;
+      EXPECT_EQ(weights_, FloatField(loaded, "weight")) << params << " " << load_params;
+      EXPECT_EQ(expected, TrainedModel(loaded, params)) << params << " " << load_params;
+      EXPECT_EQ(0, LGBM_DatasetFree(loaded));
+    }
+  }
+
+  std::vector<double> features_;
+  std::vector<float> labels_;
+  std::vector<float> weights_;
+};
+
+const char* kParams = "num_leaves=7 min_data_in_leaf=5 categorical_feature=3 verbose=-1 num_threads=2";
+
+TEST_F(DatasetMmap, MatchesCopiedBinaryFile) {
+  const std::string params = kParams;
+  CheckLoads(params, SaveBinary(params));
+}
+
+TEST_F(DatasetMmap, LoadsBothVersions) {
+  std::vector<std::string> compressions = {"none"};
+#ifdef USE_LZ4
+  compressions.push_back("lz4");
+#endif
+#ifdef USE_ZSTD
+  compressions.push_back("zstd");
+#endif
+  // the raw data of linear trees is saved as well
+  for (const char* linear_tree : {"false", "true"}) {
+    const std::string params = std::string(kParams) + " linear_tree=" + linear_tree;
+    CheckLoads(params, SaveBinary(params + " binary_version=1"));
+    for (const std::string& compression : compressions) {
+      const std::string save_params = params + " binary_version=2 binary_compression=" + compression;
+      CheckLoads(params, SaveBinary(save_params));
+    }
+  }
+}
+
+TEST_F(DatasetMmap, DetectsCorruptedChunk) {
+  const std::string params = kParams;
+  SaveBinary(params + " binary_version=2");
+  std::vector<char> contents;
+  {
+    std::ifstream file(kBinFilename, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  // in the last chunk
+  contents[contents.size() - 5] ^= 0x10;
+  {
+    std::ofstream file(kBinFilename, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+  }
+  for (const char* load_params : {"", "mmap_binary=true"}) {
+    DatasetHandle loaded = nullptr;
+    EXPECT_EQ(-1, LGBM_DatasetCreateFromFile(kBinFilename, (params + " " + load_params).c_str(), nullptr,
+                                             &loaded)) << load_params;
+  }
+}
+
+TEST(BinaryChunk, ChecksumIsXXH64) {
+  std::string hundred_bytes;
+  for (int i = 0; i < 100; ++i) {
+    hundred_bytes.push_back(static_cast<char>(i));
+  }
+  // the reference values of XXH64 with seed 0, for the steps of 32, 8, 4 and 1 bytes
+  const std::vector<std::pair<std::string, uint64_t>> cases = {
+    {"", 0xEF46DB3751D8E999ULL},
+    {"a", 0xD24EC4F1A98C6E5BULL},
+    {"abc", 0x44BC2CF5AD770999ULL},
+    {"abcd", 0xDE0327B0D25D92CCULL},
+    {"Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL},
+    {hundred_bytes, 0x6AC1E58032166597ULL}};
+  for (const auto& c : cases) {
+    EXPECT_EQ(c.second, LightGBM::BinaryChunkChecksum(c.first.data(), c.first.size())) << c.first.size() << " bytes";
+  }
+}
@@ -0,0 +1,117 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/bin.h>
+#include <LightGBM/config.h>
+#include <LightGBM/utils/simd.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using LightGBM::Bin;
+using LightGBM::data_size_t;
+using LightGBM::hist_t;
+using LightGBM::score_t;
+using LightGBM::SIMD;
+using LightGBM::SIMDLevel;
+
+class DenseBinHistogramTest : public testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    num_bin_ = GetParam();
+    std::mt19937 gen(num_bin_);
+    // make a few bins very frequent so that blocks of rows often collide
+    std::uniform_int_distribution<int> bin_dist(0, num_bin_ - 1);
+    std::uniform_int_distribution<int> hot_dist(0, 3);
+    std::uniform_real_distribution<float> grad_dist(-1.0f, 1.0f);
+    bin_.reset(Bin::CreateDenseBin(kNumData, num_bin_));
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      const int bin = (i % 3 == 0) ? hot_dist(gen) : bin_dist(gen);
+      bin_->Push(0, i, static_cast<uint32_t>(bin));
+    }
+    bin_->FinishLoad();
+    gradients_.resize(kNumData);
+    hessians_.resize(kNumData);
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      gradients_[i] = grad_dist(gen);
+      hessians_[i] = grad_dist(gen) + 1.5f;
+    }
+    for (data_size_t i = 0; i < kNumData; i += 1 + i % 3) {
+      indices_.push_back(i);
+    }
+  }
+
+  void TearDown() override {
+    SIMD::SetLevel("auto");
+  }
+
+  // histograms of every ConstructHistogram overload, over odd offsets and lengths
+  std::vector<hist_t> Construct(SIMDLevel level) {
+    SIMD::SetLevel(level);
+    const data_size_t num_indices = static_cast<data_size_t>(indices_.size());
+    const size_t hist_size = static_cast<size_t>(num_bin_) * 2;
+    std::vector<hist_t> result;
+    const data_size_t starts[] = {0, 1, 3};
+    for (const data_size_t start : starts) {
+      std::vector<hist_t> hist(hist_size * 4, 0.0f);
+      const data_size_t end = kNumData - start;
+      bin_->ConstructHistogram(start, end, gradients_.data(), hessians_.data(), hist.data());
+      bin_->ConstructHistogram(start, end, gradients_.data(), hist.data() + hist_size);
+      const data_size_t index_end = num_indices - start;
+      bin_->ConstructHistogram(indices_.data(), start, index_end, gradients_.data(),
+                               hessians_.data(), hist.data() + hist_size * 2);
+      bin_->ConstructHistogram(indices_.data(), start, index_end, gradients_.data(),
+                               hist.data() + hist_size * 3);
+      result.insert(result.end(), hist.begin(), hist.end());
+    }
+    return result;
+  }
+
+  static const data_size_t kNumData = 10007;
+  int num_bin_;
+  std::unique_ptr<Bin> bin_;
+  std::vector<score_t> gradients_;
+  std::vector<score_t> hessians_;
+  std::vector<data_size_t> indices_;
+};
+
+TEST_P(DenseBinHistogramTest, SIMDMatchesScalarBitwise) {
+  const std::vector<hist_t> expected = Construct(LightGBM::kSIMDNone);
+  const SIMDLevel levels[] = {LightGBM::kSIMDSSE42, LightGBM::kSIMDAVX2, LightGBM::kSIMDAVX512};
+  for (const SIMDLevel level : levels) {
+    if (level > SIMD::Detect()) {
+      continue;
+    }
+    const std::vector<hist_t> actual = Construct(level);
+    ASSERT_EQ(expected.size(), actual.size());
+    EXPECT_EQ(0, std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(hist_t)))
+        << "histogram mismatch with SIMD level " << SIMD::Name(level);
+  }
+}
+
+// 4-bit, 8-bit, 16-bit and 32-bit dense bins
+INSTANTIATE_TEST_SUITE_P(DenseBinTypes, DenseBinHistogramTest, testing::Values(7, 16, 200, 3000, 70000));
+
+TEST(SIMD, SetLevelClampsToDetected) {
+  SIMD::SetLevel(LightGBM::kSIMDAVX512);
+  EXPECT_LE(SIMD::Level(), SIMD::Detect());
+  SIMD::SetLevel("none");
+  EXPECT_EQ(LightGBM::kSIMDNone, SIMD::Level());
+  SIMD::SetLevel("auto");
+  EXPECT_EQ(SIMD::Default(), SIMD::Level());
+}
+
+TEST(SIMD, ConfigValidatesWithoutSettingLevel) {
+  LightGBM::Config config;
+  config.Set({{"simd_level", "NONE"}});
+  EXPECT_EQ("none", config.simd_level);
+  // applied by the booster or the CLI only
+  EXPECT_EQ(SIMD::Default(), SIMD::Level());
+  EXPECT_THROW(config.Set({{"simd_level", "avx3"}}), std::runtime_error);
+}
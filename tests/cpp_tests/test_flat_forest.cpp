@@ -0,0 +1,385 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/boosting.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/flat_forest.h>
+#include <LightGBM/utils/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// not a multiple of the rows evaluated together
+const int kNumData = 2003;
+const int kNumFeatures = 8;
+
+/*! \brief Features with NaN, exact zeros and a categorical column 0 */
+void GenerateData(std::vector<double>* features, std::vector<float>* labels, int num_class) {
+  std::mt19937 gen(42);
+  std::normal_distribution<double> value_dist;
+  std::uniform_int_distribution<int> category_dist(0, 11);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  features->resize(static_cast<size_t>(kNumData) * kNumFeatures);
+  labels->resize(kNumData);
+  for (int i = 0; i < kNumData; ++i) {
+    double* row = features->data() + static_cast<size_t>(i) * kNumFeatures;
+    row[0] = category_dist(gen);
+    for (int j = 1; j < kNumFeatures; ++j) {
+      const double r = uniform(gen);
+      row[j] = r < 0.1 ? NAN : (r < 0.2 ? 0.0 : value_dist(gen));
+    }
+    const double y = (std::isnan(row[1]) ? 1.0 : row[1]) + 0.5 * (static_cast<int>(row[0]) % 3)
+                     - (row[2] == 0.0 ? 1.0 : 0.0) + 0.1 * value_dist(gen);
+    if (num_class > 1) {
+      (*labels)[i] = static_cast<float>(static_cast<int>(std::fabs(y) * 2) % num_class);
+    } else {
+      (*labels)[i] = y > 0.5 ? 1.0f : 0.0f;
+    }
+  }
+}
+
+/*! \brief Train 15 iterations on the generated data */
+void Train(const std::string& params, int num_class, std::vector<double>* features, DatasetHandle* dataset,
+           BoosterHandle* booster) {
+  std::vector<float> labels;
+  GenerateData(features, &labels, num_class);
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features->data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                         params.c_str(), nullptr, dataset));
+  ASSERT_EQ(0, LGBM_DatasetSetField(*dataset, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+  ASSERT_EQ(0, LGBM_BoosterCreate(*dataset, params.c_str(), booster));
+  int is_finished = 0;
+  for (int i = 0; i < 15 && !is_finished; ++i) {
+    ASSERT_EQ(0, LGBM_BoosterUpdateOneIter(*booster, &is_finished));
+  }
+}
+
+/*! \brief Values of the lines "key=v1 v2 ..." of the trees in the model string */
+std::vector<double> ModelValues(const std::string& model, const std::string& key) {
+  std::vector<double> values;
+  std::istringstream lines(model);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, key.size() + 1, key + "=") == 0) {
+      std::istringstream line_values(line.substr(key.size() + 1));
+      double value;
+      while (line_values >> value) {
+        values.push_back(value);
+      }
+    }
+  }
+  return values;
+}
+
+}  // namespace
+
+/*! \brief (params, num_class) */
+class FlatForestTest : public testing::TestWithParam<std::tuple<std::string, int>> {};
+
+TEST_P(FlatForestTest, BatchMatchesSingleRow) {
+  const std::string params = std::get<0>(GetParam()) + " verbose=-1 num_threads=2 categorical_feature=0";
+  const int num_class = std::get<1>(GetParam());
+  std::vector<double> features;
+  DatasetHandle dataset;
+  BoosterHandle booster;
+  Train(params, num_class, &features, &dataset, &booster);
+
+  // column-major and float32 copies of the same rows
+  std::vector<double> col_major(features.size());
+  std::vector<float> features32(features.size());
+  for (int i = 0; i < kNumData; ++i) {
+    for (int j = 0; j < kNumFeatures; ++j) {
+      col_major[static_cast<size_t>(j) * kNumData + i] = features[static_cast<size_t>(i) * kNumFeatures + j];
+      features32[static_cast<size_t>(i) * kNumFeatures + j] =
+          static_cast<float>(features[static_cast<size_t>(i) * kNumFeatures + j]);
+    }
+  }
+
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+    std::vector<double> expected(static_cast<size_t>(kNumData) * num_class);
+    std::vector<double> expected32(expected.size());
+    int64_t out_len;
+    for (int i = 0; i < kNumData; ++i) {
+      ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster, features.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                      C_API_DTYPE_FLOAT64, kNumFeatures, 1, predict_type, 0, -1, "",
+                                                      &out_len, expected.data() + static_cast<size_t>(i) * num_class));
+      ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster, features32.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                      C_API_DTYPE_FLOAT32, kNumFeatures, 1, predict_type, 0, -1, "",
+                                                      &out_len, expected32.data() + static_cast<size_t>(i) * num_class));
+    }
+
+    std::vector<double> result(expected.size());
+    // the scalar scan and the vectorized one
+    for (LightGBM::SIMDLevel level : {LightGBM::kSIMDNone, LightGBM::SIMD::Default()}) {
+      LightGBM::SIMD::SetLevel(level);
+      std::fill(result.begin(), result.end(), 0.0);
+      ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                             predict_type, 0, -1, "", &out_len, result.data()));
+      ASSERT_EQ(static_cast<int64_t>(expected.size()), out_len);
+      for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], result[i]) << "row-major, index " << i;
+      }
+
+      std::fill(result.begin(), result.end(), 0.0);
+      ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, col_major.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 0,
+                                             predict_type, 0, -1, "", &out_len, result.data()));
+      for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i], result[i]) << "column-major, index " << i;
+      }
+
+      std::fill(result.begin(), result.end(), 0.0);
+      ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features32.data(), C_API_DTYPE_FLOAT32, kNumData, kNumFeatures, 1,
+                                             predict_type, 0, -1, "", &out_len, result.data()));
+      for (size_t i = 0; i < expected32.size(); ++i) {
+        ASSERT_EQ(expected32[i], result[i]) << "float32, index " << i;
+      }
+    }
+    LightGBM::SIMD::SetLevel(LightGBM::SIMD::Default());
+
+    // a range of iterations
+    std::vector<double> expected_range(expected.size());
+    for (int i = 0; i < kNumData; ++i) {
+      ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster, features.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                      C_API_DTYPE_FLOAT64, kNumFeatures, 1, predict_type, 3, 5, "",
+                                                      &out_len, expected_range.data() + static_cast<size_t>(i) * num_class));
+    }
+    ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           predict_type, 3, 5, "", &out_len, result.data()));
+    for (size_t i = 0; i < expected_range.size(); ++i) {
+      ASSERT_EQ(expected_range[i], result[i]) << "iterations [3, 8), index " << i;
+    }
+  }
+
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+}
+
+TEST_P(FlatForestTest, FloatRowsAtThresholds) {
+  const std::string params = std::get<0>(GetParam()) + " verbose=-1 num_threads=2 categorical_feature=0";
+  const int num_class = std::get<1>(GetParam());
+  std::vector<double> features;
+  DatasetHandle dataset;
+  BoosterHandle booster;
+  Train(params, num_class, &features, &dataset, &booster);
+  int64_t model_len = 0;
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len, nullptr));
+  std::vector<char> model_str(model_len);
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len,
+                                             model_str.data()));
+  const auto split_features = ModelValues(model_str.data(), "split_feature");
+  const auto thresholds = ModelValues(model_str.data(), "threshold");
+  ASSERT_EQ(split_features.size(), thresholds.size());
+
+  // float values around every threshold, where rounding the value or the threshold would change the decision
+  std::vector<float> rows;
+  for (size_t i = 0; i < thresholds.size(); ++i) {
+    const float rounded = static_cast<float>(thresholds[i]);
+    for (float value : {rounded, std::nextafter(rounded, -INFINITY), std::nextafter(rounded, INFINITY)}) {
+      const size_t base_row = (i * 3) % kNumData;
+      for (int j = 0; j < kNumFeatures; ++j) {
+        rows.push_back(static_cast<float>(features[base_row * kNumFeatures + j]));
+      }
+      rows[rows.size() - kNumFeatures + static_cast<int>(split_features[i])] = value;
+    }
+  }
+  const int num_rows = static_cast<int>(rows.size() / kNumFeatures);
+  ASSERT_GE(num_rows, 64);
+
+  std::vector<double> expected(static_cast<size_t>(num_rows) * num_class);
+  int64_t out_len;
+  for (int i = 0; i < num_rows; ++i) {
+    ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster, rows.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                    C_API_DTYPE_FLOAT32, kNumFeatures, 1, C_API_PREDICT_RAW_SCORE, 0,
+                                                    -1, "", &out_len, expected.data() + static_cast<size_t>(i) * num_class));
+  }
+  std::vector<double> result(expected.size());
+  for (LightGBM::SIMDLevel level : {LightGBM::kSIMDNone, LightGBM::SIMD::Default()}) {
+    LightGBM::SIMD::SetLevel(level);
+    ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, rows.data(), C_API_DTYPE_FLOAT32, num_rows, kNumFeatures, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, result.data()));
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(expected[i], result[i]) << "index " << i;
+    }
+  }
+  LightGBM::SIMD::SetLevel(LightGBM::SIMD::Default());
+
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Models, FlatForestTest,
+    testing::Values(
+        std::make_tuple("objective=binary num_leaves=31", 1),
+        std::make_tuple("objective=binary num_leaves=200 min_data_in_leaf=2", 1),
+        std::make_tuple("objective=binary num_leaves=31 use_missing=false", 1),
+        std::make_tuple("objective=binary num_leaves=31 zero_as_missing=true", 1),
+        std::make_tuple("objective=regression num_leaves=15 boosting=rf bagging_freq=1 bagging_fraction=0.5", 1),
+        std::make_tuple("objective=multiclass num_class=3 num_leaves=31", 3),
+        std::make_tuple("objective=multiclassova num_class=3 num_leaves=80 min_data_in_leaf=3", 3)));
+
+TEST(FlatForest, TreeBlocksMatchOneBlock) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  GenerateData(&features, &labels, 3);
+  const std::string params = "objective=multiclass num_class=3 num_leaves=40 verbose=-1 num_threads=2 "
+                             "categorical_feature=0";
+  DatasetHandle dataset;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                         params.c_str(), nullptr, &dataset));
+  ASSERT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+  BoosterHandle booster;
+  ASSERT_EQ(0, LGBM_BoosterCreate(dataset, params.c_str(), &booster));
+  int is_finished = 0;
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+  }
+  int64_t model_len = 0;
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len, nullptr));
+  std::vector<char> model_str(model_len);
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len,
+                                             model_str.data()));
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+
+  std::unique_ptr<LightGBM::Boosting> boosting(LightGBM::Boosting::CreateBoosting("gbdt", nullptr));
+  ASSERT_TRUE(boosting->LoadModelFromString(model_str.data(), model_str.size()));
+  auto one_block = boosting->GetFlatForest(0, -1, 0, nullptr);
+  // a few trees per block
+  auto tree_blocks = boosting->GetFlatForest(0, -1, 8 * 1024, nullptr);
+  ASSERT_GE(tree_blocks->row_block_size(), one_block->row_block_size());
+  for (bool is_raw_score : {false, true}) {
+    std::vector<double> expected(static_cast<size_t>(kNumData) * 3);
+    std::vector<double> result(expected.size());
+    one_block->Predict(features.data(), kNumFeatures, kNumFeatures, 1, kNumData, is_raw_score, expected.data());
+    tree_blocks->Predict(features.data(), kNumFeatures, kNumFeatures, 1, kNumData, is_raw_score, result.data());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(expected[i], result[i]) << "index " << i;
+    }
+  }
+}
+
+TEST(FlatForest, EarlyStopMatchesSingleRow) {
+  for (int num_class : {1, 3}) {
+    const std::string params = std::string(num_class > 1 ? "objective=multiclass num_class=3" : "objective=binary")
+                               + " num_leaves=31 verbose=-1 num_threads=2 categorical_feature=0";
+    std::vector<double> features;
+    DatasetHandle dataset;
+    BoosterHandle booster;
+    Train(params, num_class, &features, &dataset, &booster);
+    for (const char* predict_params : {"pred_early_stop=true pred_early_stop_freq=2 pred_early_stop_margin=0.8",
+                                       "pred_early_stop=true pred_early_stop_freq=3 pred_early_stop_margin=0.3 "
+                                       "pred_tree_blocking=true"}) {
+      // all the iterations and a range
+      for (const auto& iterations : {std::make_pair(0, -1), std::make_pair(3, 10)}) {
+        const int start_iteration = iterations.first;
+        const int num_iteration = iterations.second;
+        std::vector<double> expected(static_cast<size_t>(kNumData) * num_class);
+        std::vector<double> all_trees(expected.size());
+        std::vector<double> result(expected.size());
+        int64_t out_len;
+        for (int i = 0; i < kNumData; ++i) {
+          const double* row = features.data() + static_cast<size_t>(i) * kNumFeatures;
+          ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster, row, C_API_DTYPE_FLOAT64, kNumFeatures, 1,
+                                                          C_API_PREDICT_NORMAL,
+                                                          start_iteration, num_iteration, predict_params,
+                                                          &out_len,
+                                                          expected.data() + static_cast<size_t>(i) * num_class));
+        }
+        ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                               C_API_PREDICT_NORMAL, start_iteration, num_iteration,
+                                               predict_params, &out_len, result.data()));
+        ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                               C_API_PREDICT_NORMAL, start_iteration, num_iteration, "", &out_len,
+                                               all_trees.data()));
+        int num_stopped = 0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+          ASSERT_EQ(expected[i], result[i]) << predict_params << ", start " << start_iteration << ", index " << i;
+          num_stopped += expected[i] != all_trees[i];
+        }
+        // some rows stop early, not all of them
+        EXPECT_GT(num_stopped, 0);
+        EXPECT_LT(num_stopped, static_cast<int>(expected.size()));
+      }
+    }
+    ASSERT_EQ(0, LGBM_BoosterFree(booster));
+    ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+  }
+}
+
+TEST(FlatForest, KeptByTheModelUntilTheTreesChange) {
+  std::vector<double> features;
+  DatasetHandle dataset;
+  BoosterHandle booster;
+  Train("objective=binary num_leaves=31 verbose=-1 num_threads=2", 1, &features, &dataset, &booster);
+  int64_t model_len = 0;
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len, nullptr));
+  std::vector<char> model_str(model_len);
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len,
+                                             model_str.data()));
+
+  std::unique_ptr<LightGBM::Boosting> boosting(LightGBM::Boosting::CreateBoosting("gbdt", nullptr));
+  ASSERT_TRUE(boosting->LoadModelFromString(model_str.data(), model_str.size()));
+  LightGBM::PredictionEarlyStopConfig early_stop;
+  early_stop.round_period = 2;
+  early_stop.margin_threshold = 0.5;
+  auto all_trees = boosting->GetFlatForest(0, -1, 0, nullptr);
+  ASSERT_NE(nullptr, all_trees);
+  // the same iterations, with or without the number of iterations
+  EXPECT_EQ(all_trees, boosting->GetFlatForest(0, 100, 0, nullptr));
+  EXPECT_EQ(all_trees, boosting->GetFlatForest(-1, -1, 0, nullptr));
+  EXPECT_NE(all_trees, boosting->GetFlatForest(3, 10, 0, nullptr));
+  EXPECT_NE(all_trees, boosting->GetFlatForest(0, -1, 8 * 1024, nullptr));
+  auto with_early_stop = boosting->GetFlatForest(0, -1, 0, &early_stop);
+  EXPECT_NE(all_trees, with_early_stop);
+  EXPECT_EQ(with_early_stop, boosting->GetFlatForest(0, -1, 0, &early_stop));
+  dynamic_cast<LightGBM::GBDTBase*>(boosting.get())->SetLeafValue(0, 0, 1.0);
+  EXPECT_NE(all_trees, boosting->GetFlatForest(0, -1, 0, nullptr));
+  all_trees = boosting->GetFlatForest(0, -1, 0, nullptr);
+  ASSERT_TRUE(boosting->LoadModelFromString(model_str.data(), model_str.size()));
+  EXPECT_NE(all_trees, boosting->GetFlatForest(0, -1, 0, nullptr));
+
+  // the batch predictions of the booster follow its training and rollback
+  auto expect_batch_matches_single_row = [&](const std::string& context) {
+    std::vector<double> expected(kNumData);
+    std::vector<double> result(kNumData);
+    int64_t out_len;
+    for (int i = 0; i < kNumData; ++i) {
+      ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster, features.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                      C_API_DTYPE_FLOAT64, kNumFeatures, 1, C_API_PREDICT_NORMAL,
+                                                      0, -1, "", &out_len, expected.data() + i));
+    }
+    ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           C_API_PREDICT_NORMAL, 0, -1, "", &out_len, result.data()));
+    for (int i = 0; i < kNumData; ++i) {
+      ASSERT_EQ(expected[i], result[i]) << context << " row " << i;
+    }
+  };
+  expect_batch_matches_single_row("trained");
+  ASSERT_EQ(0, LGBM_BoosterRollbackOneIter(booster));
+  expect_batch_matches_single_row("rolled back");
+  // another last tree, for the same number of iterations as the first predictions
+  std::vector<float> gradients(kNumData);
+  std::vector<float> hessians(kNumData, 1.0f);
+  for (int i = 0; i < kNumData; ++i) {
+    gradients[i] = features[static_cast<size_t>(i) * kNumFeatures + 3] > 0 ? 1.0f : -1.0f;
+  }
+  int is_finished = 0;
+  ASSERT_EQ(0, LGBM_BoosterUpdateOneIterCustom(booster, gradients.data(), hessians.data(), &is_finished));
+  expect_batch_matches_single_row("trained again");
+  ASSERT_EQ(0, LGBM_BoosterSetLeafValue(booster, 0, 0, 1.0));
+  expect_batch_matches_single_row("leaf value set");
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+}
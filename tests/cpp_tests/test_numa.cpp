@@ -0,0 +1,42 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/config.h>
+#include <LightGBM/utils/numa.h>
+
+#include <stdexcept>
+#include <vector>
+
+using LightGBM::NUMA;
+
+TEST(NUMA, ParseCPUList) {
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), NUMA::ParseCPUList("0-3,8,10-11"));
+  EXPECT_EQ(std::vector<int>({5}), NUMA::ParseCPUList("5\n"));
+  EXPECT_TRUE(NUMA::ParseCPUList("").empty());
+}
+
+TEST(NUMA, NodeOfThread) {
+  // two nodes, the second one twice as large
+  const std::vector<std::vector<int>> nodes = {{0, 1}, {2, 3, 4, 5}};
+  std::vector<int> compact, spread;
+  for (int tid = 0; tid < 6; ++tid) {
+    compact.push_back(NUMA::NodeOfThread(tid, 6, LightGBM::kAffinityCompact, nodes));
+    spread.push_back(NUMA::NodeOfThread(tid, 6, LightGBM::kAffinitySpread, nodes));
+  }
+  EXPECT_EQ(std::vector<int>({0, 0, 1, 1, 1, 1}), compact);
+  EXPECT_EQ(std::vector<int>({0, 1, 0, 1, 0, 1}), spread);
+  // more threads than CPUs still stay on contiguous ranges
+  EXPECT_EQ(0, NUMA::NodeOfThread(3, 12, LightGBM::kAffinityCompact, nodes));
+  EXPECT_EQ(1, NUMA::NodeOfThread(4, 12, LightGBM::kAffinityCompact, nodes));
+  EXPECT_GE(NUMA::NumNodes(), 1);
+}
+
+TEST(NUMA, ConfigValidatesAffinity) {
+  LightGBM::Config config;
+  config.Set({{"thread_affinity", "compact"}});
+  EXPECT_EQ("compact", config.thread_affinity);
+  EXPECT_THROW(config.Set({{"thread_affinity", "scatter"}}), std::runtime_error);
+}
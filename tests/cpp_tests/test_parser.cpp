@@ -0,0 +1,107 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/io/parser.hpp"
+
+using LightGBM::CSVParser;
+using LightGBM::Common::Atof;
+using LightGBM::Common::AtofPrecise;
+using LightGBM::data_size_t;
+using LightGBM::Parser;
+using LightGBM::TSVParser;
+
+namespace {
+
+/*! \brief Check ParseBlock against the values and labels of ParseOneLine */
+void CheckParseBlock(const Parser& parser, const std::vector<std::string>& lines, int num_col) {
+  const data_size_t num_lines = static_cast<data_size_t>(lines.size());
+  std::vector<double> values(static_cast<size_t>(num_col) * num_lines, -1.0);
+  std::vector<double> labels(num_lines, -1.0);
+  parser.ParseBlock(lines.data(), num_lines, num_col, values.data(), labels.data());
+  for (data_size_t i = 0; i < num_lines; ++i) {
+    std::vector<std::pair<int, double>> features;
+    // TSVParser::ParseOneLine keeps the label of lines without label column
+    double label = 0.0;
+    parser.ParseOneLine(lines[i].c_str(), &features, &label);
+    std::vector<double> expected(num_col, 0.0);
+    for (const auto& feature : features) {
+      if (feature.first < num_col) {
+        expected[feature.first] = feature.second;
+      }
+    }
+    if (std::isnan(label)) {
+      EXPECT_TRUE(std::isnan(labels[i])) << lines[i];
+    } else {
+      EXPECT_EQ(label, labels[i]) << lines[i];
+    }
+    for (int col = 0; col < num_col; ++col) {
+      const double value = values[static_cast<size_t>(col) * num_lines + i];
+      if (std::isnan(expected[col])) {
+        EXPECT_TRUE(std::isnan(value)) << lines[i] << " column " << col;
+      } else {
+        EXPECT_EQ(expected[col], value) << lines[i] << " column " << col;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(Parser, ParseBlockMatchesParseOneLine) {
+  std::vector<std::string> csv_lines = {
+    "1,0.5,-2,0,3e-5",
+    "0,nan,1.25,-0,7",
+    "1,1,2,3,4,",
+    "0,1.5",
+    "",
+    "2,0,0,0,0,9,10",
+  };
+  // AtofPrecise does not parse these
+  const std::vector<std::string> atof_lines = {
+    "0,na,1.25,NA,7",
+    "  3 , 4.5 ,6,,1",
+  };
+  for (Parser::AtofFunc atof : {Parser::AtofFunc(AtofPrecise), Parser::AtofFunc(Atof)}) {
+    if (atof == Parser::AtofFunc(Atof)) {
+      csv_lines.insert(csv_lines.end(), atof_lines.begin(), atof_lines.end());
+    }
+    // label in the first column, in the middle, and without label
+    for (int label_idx : {0, 2, -1}) {
+      CSVParser parser(label_idx, 5, atof);
+      for (int num_col : {3, 4, 5}) {
+        CheckParseBlock(parser, csv_lines, num_col);
+      }
+    }
+  }
+  std::vector<std::string> tsv_lines;
+  for (const std::string& line : csv_lines) {
+    std::string tsv_line = line;
+    for (char& c : tsv_line) {
+      if (c == ',') {
+        c = '\t';
+      }
+    }
+    tsv_lines.push_back(tsv_line);
+  }
+  for (int label_idx : {0, 3}) {
+    TSVParser parser(label_idx, 5, Atof);
+    CheckParseBlock(parser, tsv_lines, 4);
+  }
+}
+
+TEST(Parser, ParseBlockRejectsMalformedField) {
+  CSVParser parser(0, 3, Atof);
+  const std::vector<std::string> lines = {"1,2x,3"};
+  std::vector<double> values(2);
+  std::vector<double> labels(1);
+  EXPECT_THROW(parser.ParseBlock(lines.data(), 1, 2, values.data(), labels.data()), std::runtime_error);
+}
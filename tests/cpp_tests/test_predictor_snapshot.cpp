@@ -0,0 +1,188 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PredictorSnapshotTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(7);
+    std::normal_distribution<double> value_dist;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    features_.resize(static_cast<size_t>(kNumData) * kNumFeatures);
+    std::vector<float> labels(kNumData);
+    for (int i = 0; i < kNumData; ++i) {
+      double* row = features_.data() + static_cast<size_t>(i) * kNumFeatures;
+      for (int j = 0; j < kNumFeatures; ++j) {
+        const double r = uniform(gen);
+        row[j] = r < 0.05 ? NAN : (r < 0.3 ? 0.0 : value_dist(gen));
+      }
+      labels[i] = static_cast<float>(static_cast<int>(std::fabs(row[0] + row[1] - row[2]) * 2) % kNumClass);
+    }
+    const std::string params = "objective=multiclass num_class=3 num_leaves=15 verbose=-1 num_threads=2";
+    ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features_.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           params.c_str(), nullptr, &dataset_));
+    ASSERT_EQ(0, LGBM_DatasetSetField(dataset_, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+    ASSERT_EQ(0, LGBM_BoosterCreate(dataset_, params.c_str(), &booster_));
+    Train(10);
+  }
+
+  void TearDown() override {
+    if (booster_ != nullptr) {
+      EXPECT_EQ(0, LGBM_BoosterFree(booster_));
+    }
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset_));
+  }
+
+  void Train(int num_iteration) {
+    int is_finished = 0;
+    for (int i = 0; i < num_iteration; ++i) {
+      ASSERT_EQ(0, LGBM_BoosterUpdateOneIter(booster_, &is_finished));
+    }
+  }
+
+  /*! \brief Single-row predictions of the booster for all the rows */
+  std::vector<double> BoosterPredictions(int predict_type, int start_iteration, int num_iteration,
+                                         int64_t* num_pred) {
+    std::vector<double> result;
+    std::vector<double> cur(kNumClass * (kNumFeatures + 1) * 20);
+    for (int i = 0; i < kNumData; ++i) {
+      EXPECT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster_, features_.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                      C_API_DTYPE_FLOAT64, kNumFeatures, 1, predict_type,
+                                                      start_iteration, num_iteration, "", num_pred, cur.data()));
+      result.insert(result.end(), cur.begin(), cur.begin() + *num_pred);
+    }
+    return result;
+  }
+
+  static const int kNumData = 500;
+  static const int kNumFeatures = 6;
+  static const int kNumClass = 3;
+  std::vector<double> features_;
+  DatasetHandle dataset_ = nullptr;
+  BoosterHandle booster_ = nullptr;
+};
+
+TEST_F(PredictorSnapshotTest, MatchesBoosterPrediction) {
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX,
+                           C_API_PREDICT_CONTRIB}) {
+    int64_t num_pred = 0;
+    const auto expected = BoosterPredictions(predict_type, 2, 5, &num_pred);
+    PredictorHandle predictor;
+    ASSERT_EQ(0, LGBM_BoosterCreatePredictor(booster_, predict_type, 2, 5, C_API_DTYPE_FLOAT64, kNumFeatures, "",
+                                             &predictor));
+    std::vector<double> result(num_pred);
+    std::vector<double> sparse_result(num_pred);
+    std::vector<int32_t> indices;
+    std::vector<double> values;
+    for (int i = 0; i < kNumData; ++i) {
+      const double* row = features_.data() + static_cast<size_t>(i) * kNumFeatures;
+      int64_t out_len = 0;
+      ASSERT_EQ(0, LGBM_PredictorPredictForMatSingleRow(predictor, row, &out_len, result.data()));
+      ASSERT_EQ(num_pred, out_len);
+      // the same row in CSR format, without the zeros
+      indices.clear();
+      values.clear();
+      for (int j = 0; j < kNumFeatures; ++j) {
+        if (row[j] != 0.0) {
+          indices.push_back(j);
+          values.push_back(row[j]);
+        }
+      }
+      const int32_t indptr[2] = {0, static_cast<int32_t>(indices.size())};
+      ASSERT_EQ(0, LGBM_PredictorPredictForCSRSingleRow(predictor, indptr, C_API_DTYPE_INT32, indices.data(),
+                                                        values.data(), &out_len, sparse_result.data()));
+      ASSERT_EQ(num_pred, out_len);
+      for (int k = 0; k < num_pred; ++k) {
+        ASSERT_EQ(expected[i * num_pred + k], result[k]) << "predict type " << predict_type << ", row " << i;
+        ASSERT_EQ(expected[i * num_pred + k], sparse_result[k]) << "predict type " << predict_type << ", row " << i;
+      }
+    }
+    ASSERT_EQ(0, LGBM_PredictorFree(predictor));
+  }
+}
+
+TEST_F(PredictorSnapshotTest, IndependentOfBooster) {
+  int64_t num_pred = 0;
+  const auto expected = BoosterPredictions(C_API_PREDICT_NORMAL, 0, -1, &num_pred);
+  PredictorHandle predictor;
+  ASSERT_EQ(0, LGBM_BoosterCreatePredictor(booster_, C_API_PREDICT_NORMAL, 0, -1, C_API_DTYPE_FLOAT64, kNumFeatures,
+                                           "", &predictor));
+  // the predictor keeps the model of its creation
+  Train(5);
+  ASSERT_EQ(0, LGBM_BoosterFree(booster_));
+  booster_ = nullptr;
+  std::vector<double> result(num_pred);
+  for (int i = 0; i < kNumData; ++i) {
+    int64_t out_len = 0;
+    ASSERT_EQ(0, LGBM_PredictorPredictForMatSingleRow(predictor, features_.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                      &out_len, result.data()));
+    for (int k = 0; k < num_pred; ++k) {
+      ASSERT_EQ(expected[i * num_pred + k], result[k]);
+    }
+  }
+  ASSERT_EQ(0, LGBM_PredictorFree(predictor));
+}
+
+TEST_F(PredictorSnapshotTest, ConcurrentThreads) {
+  int64_t num_pred = 0;
+  const auto expected = BoosterPredictions(C_API_PREDICT_RAW_SCORE, 0, -1, &num_pred);
+  std::vector<float> features32(features_.begin(), features_.end());
+  std::vector<double> expected32;
+  std::vector<double> cur(num_pred);
+  for (int i = 0; i < kNumData; ++i) {
+    int64_t out_len = 0;
+    ASSERT_EQ(0, LGBM_BoosterPredictForMatSingleRow(booster_, features32.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                    C_API_DTYPE_FLOAT32, kNumFeatures, 1, C_API_PREDICT_RAW_SCORE,
+                                                    0, -1, "", &out_len, cur.data()));
+    expected32.insert(expected32.end(), cur.begin(), cur.end());
+  }
+  PredictorHandle predictor;
+  PredictorHandle predictor32;
+  ASSERT_EQ(0, LGBM_BoosterCreatePredictor(booster_, C_API_PREDICT_RAW_SCORE, 0, -1, C_API_DTYPE_FLOAT64,
+                                           kNumFeatures, "", &predictor));
+  ASSERT_EQ(0, LGBM_BoosterCreatePredictor(booster_, C_API_PREDICT_RAW_SCORE, 0, -1, C_API_DTYPE_FLOAT32,
+                                           kNumFeatures, "", &predictor32));
+  const int kNumThreads = 8;
+  std::vector<int> num_errors(kNumThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<double> result(num_pred);
+      for (int round = 0; round < 20; ++round) {
+        for (int i = t; i < kNumData; i += kNumThreads) {
+          int64_t out_len = 0;
+          const bool use_float32 = (i + round) % 2 == 0;
+          const int ret = use_float32
+            ? LGBM_PredictorPredictForMatSingleRow(predictor32, features32.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                   &out_len, result.data())
+            : LGBM_PredictorPredictForMatSingleRow(predictor, features_.data() + static_cast<size_t>(i) * kNumFeatures,
+                                                   &out_len, result.data());
+          const auto& cur_expected = use_float32 ? expected32 : expected;
+          for (int k = 0; k < num_pred; ++k) {
+            if (ret != 0 || cur_expected[i * num_pred + k] != result[k]) {
+              ++num_errors[t];
+            }
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kNumThreads; ++t) {
+    EXPECT_EQ(0, num_errors[t]) << "thread " << t;
+  }
+  ASSERT_EQ(0, LGBM_PredictorFree(predictor));
+  ASSERT_EQ(0, LGBM_PredictorFree(predictor32));
+}
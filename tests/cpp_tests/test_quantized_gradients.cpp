@@ -0,0 +1,122 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/bin.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using LightGBM::Bin;
+using LightGBM::data_size_t;
+using LightGBM::hist_t;
+using LightGBM::int_hist_t;
+using LightGBM::int_score_t;
+using LightGBM::score_t;
+
+TEST(QuantizedGradients, PackRoundTrip) {
+  for (int grad = -127; grad <= 127; ++grad) {
+    for (int hess = 0; hess <= 254; hess += 7) {
+      const int_hist_t entry = LightGBM::IntHistEntry(LightGBM::PackIntScore(grad, hess));
+      EXPECT_EQ(grad, LightGBM::IntHistGrad(entry));
+      EXPECT_EQ(hess, LightGBM::IntHistHess(entry));
+    }
+  }
+}
+
+TEST(QuantizedGradients, EntriesSumWithoutCarry) {
+  int_hist_t sum = 0;
+  int64_t grad_sum = 0;
+  int64_t hess_sum = 0;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> grad_dist(-8, 8);
+  std::uniform_int_distribution<int> hess_dist(0, 16);
+  for (int i = 0; i < 100000; ++i) {
+    const int grad = grad_dist(gen);
+    const int hess = hess_dist(gen);
+    sum += LightGBM::IntHistEntry(LightGBM::PackIntScore(grad, hess));
+    grad_sum += grad;
+    hess_sum += hess;
+  }
+  EXPECT_EQ(grad_sum, LightGBM::IntHistGrad(sum));
+  EXPECT_EQ(hess_sum, LightGBM::IntHistHess(sum));
+}
+
+class IntHistogramTest : public testing::TestWithParam<std::tuple<bool, int>> {
+ protected:
+  void SetUp() override {
+    const bool is_sparse = std::get<0>(GetParam());
+    num_bin_ = std::get<1>(GetParam());
+    std::mt19937 gen(num_bin_);
+    std::uniform_int_distribution<int> bin_dist(1, num_bin_ - 1);
+    std::uniform_int_distribution<int> grad_dist(-8, 8);
+    std::uniform_int_distribution<int> hess_dist(0, 16);
+    bin_.reset(is_sparse ? Bin::CreateSparseBin(kNumData, num_bin_)
+                         : Bin::CreateDenseBin(kNumData, num_bin_));
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      // sparse bins only store the non-zero bins
+      const int bin = (is_sparse && i % 4 != 0) ? 0 : bin_dist(gen);
+      bin_->Push(0, i, static_cast<uint32_t>(bin));
+    }
+    bin_->FinishLoad();
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      const int grad = grad_dist(gen);
+      const int hess = hess_dist(gen);
+      int_gradients_.push_back(LightGBM::PackIntScore(grad, hess));
+      gradients_.push_back(static_cast<score_t>(grad));
+      hessians_.push_back(static_cast<score_t>(hess));
+    }
+    for (data_size_t i = 0; i < kNumData; i += 1 + i % 3) {
+      indices_.push_back(i);
+    }
+  }
+
+  void ExpectEqual(const std::vector<hist_t>& hist, const std::vector<int_hist_t>& int_hist) {
+    for (int i = 0; i < num_bin_; ++i) {
+      EXPECT_EQ(GET_GRAD(hist, i), static_cast<hist_t>(LightGBM::IntHistGrad(int_hist[i])));
+      EXPECT_EQ(GET_HESS(hist, i), static_cast<hist_t>(LightGBM::IntHistHess(int_hist[i])));
+    }
+  }
+
+  static const data_size_t kNumData = 5003;
+  int num_bin_;
+  std::unique_ptr<Bin> bin_;
+  std::vector<int_score_t> int_gradients_;
+  std::vector<score_t> gradients_;
+  std::vector<score_t> hessians_;
+  std::vector<data_size_t> indices_;
+};
+
+TEST_P(IntHistogramTest, MatchesFloatHistogram) {
+  const data_size_t start = 3;
+  std::vector<hist_t> hist(num_bin_ * 2, 0.0f);
+  std::vector<int_hist_t> int_hist(num_bin_, 0);
+  bin_->ConstructHistogram(start, kNumData, gradients_.data(), hessians_.data(), hist.data());
+  bin_->ConstructIntHistogram(start, kNumData, int_gradients_.data(), int_hist.data());
+  ExpectEqual(hist, int_hist);
+
+  // ordered gradients, as the tree learner passes them for a leaf
+  const data_size_t num_indices = static_cast<data_size_t>(indices_.size());
+  std::vector<score_t> ordered_gradients, ordered_hessians;
+  std::vector<int_score_t> ordered_int_gradients;
+  for (const data_size_t idx : indices_) {
+    ordered_gradients.push_back(gradients_[idx]);
+    ordered_hessians.push_back(hessians_[idx]);
+    ordered_int_gradients.push_back(int_gradients_[idx]);
+  }
+  std::fill(hist.begin(), hist.end(), 0.0f);
+  std::fill(int_hist.begin(), int_hist.end(), 0);
+  bin_->ConstructHistogram(indices_.data(), start, num_indices, ordered_gradients.data(),
+                           ordered_hessians.data(), hist.data());
+  bin_->ConstructIntHistogram(indices_.data(), start, num_indices, ordered_int_gradients.data(),
+                              int_hist.data());
+  ExpectEqual(hist, int_hist);
+}
+
+INSTANTIATE_TEST_SUITE_P(BinTypes, IntHistogramTest,
+                         testing::Combine(testing::Bool(), testing::Values(7, 200, 3000)));
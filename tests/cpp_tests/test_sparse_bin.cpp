@@ -0,0 +1,179 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/bin.h>
+#include <LightGBM/utils/file_io.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using LightGBM::Bin;
+using LightGBM::BufferWriter;
+using LightGBM::data_size_t;
+using LightGBM::hist_t;
+using LightGBM::int_hist_t;
+using LightGBM::int_score_t;
+using LightGBM::score_t;
+
+class SparseBinTest : public testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    const int nonzero_period = GetParam();
+    std::mt19937 gen(nonzero_period);
+    std::uniform_int_distribution<int> bin_dist(1, kNumBin - 1);
+    std::uniform_int_distribution<int> grad_dist(-8, 8);
+    std::uniform_int_distribution<int> hess_dist(0, 16);
+    std::uniform_int_distribution<int> row_dist(0, nonzero_period - 1);
+    sparse_.reset(Bin::CreateSparseBin(kNumData, kNumBin));
+    dense_.reset(Bin::CreateDenseBin(kNumData, kNumBin));
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      const uint32_t bin = row_dist(gen) == 0 ? static_cast<uint32_t>(bin_dist(gen)) : 0;
+      sparse_->Push(0, i, bin);
+      dense_->Push(0, i, bin);
+      bins_.push_back(bin);
+      if (bin != 0) {
+        nonzero_rows_.push_back(i);
+      }
+      const int grad = grad_dist(gen);
+      const int hess = hess_dist(gen);
+      gradients_.push_back(static_cast<score_t>(grad) * 0.37f);
+      hessians_.push_back(static_cast<score_t>(hess) * 0.11f);
+      int_gradients_.push_back(LightGBM::PackIntScore(grad, hess));
+    }
+    sparse_->FinishLoad();
+    dense_->FinishLoad();
+  }
+
+  // compares the histograms of a leaf with the given rows, bin 0 is not kept by sparse bins
+  void ExpectSameHistograms(const std::vector<data_size_t>& indices) {
+    const data_size_t num_indices = static_cast<data_size_t>(indices.size());
+    std::vector<score_t> ordered_gradients, ordered_hessians;
+    std::vector<int_score_t> ordered_int_gradients;
+    for (const data_size_t idx : indices) {
+      ordered_gradients.push_back(gradients_[idx]);
+      ordered_hessians.push_back(hessians_[idx]);
+      ordered_int_gradients.push_back(int_gradients_[idx]);
+    }
+    std::vector<hist_t> sparse_hist(kNumBin * 2, 0.0f), dense_hist(kNumBin * 2, 0.0f);
+    sparse_->ConstructHistogram(indices.data(), 0, num_indices, ordered_gradients.data(),
+                                ordered_hessians.data(), sparse_hist.data());
+    dense_->ConstructHistogram(indices.data(), 0, num_indices, ordered_gradients.data(),
+                               ordered_hessians.data(), dense_hist.data());
+    for (int i = 2; i < kNumBin * 2; ++i) {
+      EXPECT_EQ(dense_hist[i], sparse_hist[i]);
+    }
+
+    std::fill(sparse_hist.begin(), sparse_hist.end(), 0.0f);
+    std::fill(dense_hist.begin(), dense_hist.end(), 0.0f);
+    sparse_->ConstructHistogram(indices.data(), 0, num_indices, ordered_gradients.data(),
+                                sparse_hist.data());
+    dense_->ConstructHistogram(indices.data(), 0, num_indices, ordered_gradients.data(),
+                               dense_hist.data());
+    for (int i = 2; i < kNumBin * 2; ++i) {
+      EXPECT_EQ(dense_hist[i], sparse_hist[i]);
+    }
+
+    std::vector<int_hist_t> sparse_int_hist(kNumBin, 0), dense_int_hist(kNumBin, 0);
+    sparse_->ConstructIntHistogram(indices.data(), 0, num_indices, ordered_int_gradients.data(),
+                                   sparse_int_hist.data());
+    dense_->ConstructIntHistogram(indices.data(), 0, num_indices, ordered_int_gradients.data(),
+                                  dense_int_hist.data());
+    for (int i = 1; i < kNumBin; ++i) {
+      EXPECT_EQ(dense_int_hist[i], sparse_int_hist[i]);
+    }
+  }
+
+  static const data_size_t kNumData = 20011;
+  static const int kNumBin = 37;
+  std::unique_ptr<Bin> sparse_;
+  std::unique_ptr<Bin> dense_;
+  std::vector<score_t> gradients_;
+  std::vector<score_t> hessians_;
+  std::vector<int_score_t> int_gradients_;
+  std::vector<data_size_t> nonzero_rows_;
+  std::vector<uint32_t> bins_;
+};
+
+TEST_P(SparseBinTest, SmallLeafMatchesDenseBin) {
+  std::vector<data_size_t> indices;
+  for (data_size_t i = 5; i < kNumData; i += 97) {
+    indices.push_back(i);
+  }
+  ExpectSameHistograms(indices);
+  // a leaf covering a narrow row range only
+  indices.clear();
+  for (data_size_t i = 7000; i < 7300; i += 3) {
+    indices.push_back(i);
+  }
+  ExpectSameHistograms(indices);
+  // a leaf much smaller than the number of non-zeros, hitting some of them
+  indices.clear();
+  for (size_t k = 1; k < nonzero_rows_.size(); k += 16) {
+    indices.push_back(nonzero_rows_[k] - 1);
+    indices.push_back(nonzero_rows_[k]);
+  }
+  ExpectSameHistograms(indices);
+}
+
+TEST_P(SparseBinTest, LargeLeafMatchesDenseBin) {
+  std::vector<data_size_t> indices;
+  for (data_size_t i = 0; i < kNumData; ++i) {
+    if (i % 7 != 3) {
+      indices.push_back(i);
+    }
+  }
+  ExpectSameHistograms(indices);
+}
+
+TEST_P(SparseBinTest, FlushedPushesMatchFinishLoad) {
+  // rows pushed in chunks, in reverse order within a chunk, flushed after each chunk
+  std::unique_ptr<Bin> flushed(Bin::CreateSparseBin(kNumData, kNumBin));
+  const data_size_t chunk_size = 1000;
+  for (data_size_t start = 0; start < kNumData; start += chunk_size) {
+    for (data_size_t i = std::min(start + chunk_size, kNumData) - 1; i >= start; --i) {
+      flushed->Push(0, i, bins_[i]);
+    }
+    flushed->FlushPushedData();
+  }
+  flushed->FinishLoad();
+  std::vector<char> expected, saved;
+  BufferWriter expected_writer(&expected);
+  BufferWriter saved_writer(&saved);
+  sparse_->SaveBinaryToFile(&expected_writer);
+  flushed->SaveBinaryToFile(&saved_writer);
+  EXPECT_EQ(expected, saved);
+  std::vector<data_size_t> indices;
+  for (data_size_t i = 3; i < kNumData; i += 5) {
+    indices.push_back(i);
+  }
+  std::swap(sparse_, flushed);
+  ExpectSameHistograms(indices);
+}
+
+TEST_P(SparseBinTest, MappedBinMatchesDenseBin) {
+  std::vector<char> saved;
+  BufferWriter writer(&saved);
+  sparse_->SaveBinaryToFile(&writer);
+  // created without data like the bins of a mapped file, the row index is built by the first histogram
+  std::unique_ptr<Bin> mapped(Bin::CreateSparseBin(0, kNumBin));
+  mapped->LoadFromMappedMemory(saved.data(), kNumData);
+  std::swap(sparse_, mapped);
+  std::vector<data_size_t> indices;
+  for (data_size_t i = 5; i < kNumData; i += 97) {
+    indices.push_back(i);
+  }
+  ExpectSameHistograms(indices);
+  indices.clear();
+  for (data_size_t i = 0; i < kNumData; i += 2) {
+    indices.push_back(i);
+  }
+  ExpectSameHistograms(indices);
+}
+
+// dense enough to keep the delta walk, sparse enough to build the row index, and very sparse
+INSTANTIATE_TEST_SUITE_P(Densities, SparseBinTest, testing::Values(4, 50, 1000));
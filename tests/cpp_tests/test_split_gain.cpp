@@ -0,0 +1,129 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/config.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/simd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/treelearner/feature_histogram.hpp"
+
+using LightGBM::BinType;
+using LightGBM::Config;
+using LightGBM::data_size_t;
+using LightGBM::FeatureHistogram;
+using LightGBM::FeatureMetainfo;
+using LightGBM::hist_t;
+using LightGBM::MissingType;
+using LightGBM::SIMD;
+using LightGBM::SplitInfo;
+
+namespace {
+
+const int kNumBin = 40;
+
+/*! \brief Histogram of integer counts and gradients, with empty bins so that several thresholds tie */
+struct Histogram {
+  std::vector<hist_t> data;
+  double sum_gradient = 0.0;
+  double sum_hessian = 0.0;
+  data_size_t num_data = 0;
+};
+
+Histogram MakeHistogram(int seed, int8_t offset, bool empty_last_bin) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> cnt_dist(0, 12);
+  std::uniform_int_distribution<int> grad_dist(-3, 3);
+  Histogram hist;
+  hist.data.assign((kNumBin - offset) * 2, 0.0f);
+  // the bins before the histogram, e.g. the most frequent bin 0
+  const int num_skipped = 20 * offset;
+  hist.num_data = num_skipped;
+  hist.sum_hessian = num_skipped;
+  for (int i = 0; i < kNumBin - offset; ++i) {
+    int cnt = cnt_dist(gen);
+    if (cnt < 5 || (empty_last_bin && i == kNumBin - offset - 1)) {
+      cnt = 0;
+    }
+    hist.data[i * 2] = grad_dist(gen) * cnt;
+    hist.data[i * 2 + 1] = cnt;
+    hist.sum_gradient += hist.data[i * 2];
+    hist.sum_hessian += cnt;
+    hist.num_data += cnt;
+  }
+  return hist;
+}
+
+/*! \brief Best split of the histogram with the scalar or the batched scan */
+SplitInfo FindBestSplit(const Config& config, const FeatureMetainfo& meta, const Histogram& hist,
+                        LightGBM::SIMDLevel level) {
+  SIMD::SetLevel(level);
+  std::vector<hist_t> data = hist.data;
+  FeatureHistogram feature_histogram;
+  feature_histogram.Init(data.data(), &meta);
+  SplitInfo split;
+  feature_histogram.FindBestThreshold(hist.sum_gradient, hist.sum_hessian, hist.num_data, nullptr,
+                                      config.path_smooth > 0 ? 0.25 : 0.0, &split);
+  return split;
+}
+
+}  // namespace
+
+class SplitGainTest : public testing::TestWithParam<std::string> {
+ protected:
+  void TearDown() override {
+    SIMD::SetLevel("auto");
+  }
+};
+
+TEST_P(SplitGainTest, BatchedMatchesScalarBitwise) {
+  if (SIMD::Detect() < LightGBM::kSIMDAVX2) {
+    return;
+  }
+  Config config;
+  config.Set(Config::Str2Map(("min_data_in_leaf=3 min_sum_hessian_in_leaf=0 " + GetParam()).c_str()));
+  int num_splits = 0;
+  for (MissingType missing_type : {MissingType::None, MissingType::Zero, MissingType::NaN}) {
+    for (int8_t offset : {0, 1}) {
+      // an empty NaN bin makes both directions of missing values tie
+      for (bool empty_last_bin : {false, true}) {
+        FeatureMetainfo meta;
+        meta.num_bin = kNumBin;
+        meta.missing_type = missing_type;
+        meta.offset = offset;
+        meta.default_bin = offset == 1 ? 0 : 7;
+        meta.config = &config;
+        meta.bin_type = BinType::NumericalBin;
+        for (int seed = 0; seed < 20; ++seed) {
+          const Histogram hist = MakeHistogram(seed, offset, empty_last_bin);
+          const SplitInfo expected = FindBestSplit(config, meta, hist, LightGBM::kSIMDNone);
+          const SplitInfo actual = FindBestSplit(config, meta, hist, LightGBM::kSIMDAVX2);
+          const std::string context = "missing type " + std::to_string(static_cast<int>(missing_type)) +
+                                      " offset " + std::to_string(offset) + " seed " + std::to_string(seed);
+          EXPECT_EQ(expected.gain, actual.gain) << context;
+          EXPECT_EQ(expected.threshold, actual.threshold) << context;
+          EXPECT_EQ(expected.default_left, actual.default_left) << context;
+          EXPECT_EQ(expected.left_count, actual.left_count) << context;
+          EXPECT_EQ(expected.right_count, actual.right_count) << context;
+          EXPECT_EQ(expected.left_sum_gradient, actual.left_sum_gradient) << context;
+          EXPECT_EQ(expected.left_sum_hessian, actual.left_sum_hessian) << context;
+          EXPECT_EQ(expected.left_output, actual.left_output) << context;
+          EXPECT_EQ(expected.right_output, actual.right_output) << context;
+          num_splits += expected.gain > LightGBM::kMinScore;
+        }
+      }
+    }
+  }
+  EXPECT_GT(num_splits, 0);
+}
+
+// the specializations of the kernel by L1, max output and smoothing
+INSTANTIATE_TEST_SUITE_P(Regularizations, SplitGainTest,
+                         testing::Values("", "lambda_l2=1.5", "lambda_l1=2", "max_delta_step=0.3",
+                                         "path_smooth=4", "lambda_l1=2 max_delta_step=0.3 path_smooth=4"));
@@ -0,0 +1,98 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/utils/task_scheduler.h>
+#include <LightGBM/utils/threading.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using LightGBM::TaskScheduler;
+using LightGBM::Threading;
+
+TEST(TaskScheduler, ParallelForRunsEveryTaskOnce) {
+  std::vector<std::atomic<int>> counts(1000);
+  for (auto& count : counts) {
+    count = 0;
+  }
+  TaskScheduler::ParallelFor(static_cast<int>(counts.size()), [&](int i) { ++counts[i]; });
+  for (auto& count : counts) {
+    EXPECT_EQ(1, count.load());
+  }
+}
+
+TEST(TaskScheduler, NestedParallelFor) {
+  const int num_outer = 17, num_inner = 33;
+  std::atomic<int> total(0);
+  TaskScheduler::ParallelFor(num_outer, [&](int i) {
+    TaskScheduler::ParallelFor(num_inner, [&](int j) { total += i * num_inner + j; });
+  });
+  const int n = num_outer * num_inner;
+  EXPECT_EQ(n * (n - 1) / 2, total.load());
+}
+
+TEST(TaskScheduler, RethrowsTaskException) {
+  std::atomic<int> num_run(0);
+  EXPECT_THROW(TaskScheduler::ParallelFor(64, [&](int i) {
+    ++num_run;
+    if (i == 7) {
+      throw std::runtime_error("task failed");
+    }
+  }), std::runtime_error);
+  // the other tasks still ran, and the scheduler is usable afterwards
+  EXPECT_EQ(64, num_run.load());
+  std::atomic<int> num_after(0);
+  TaskScheduler::ParallelFor(8, [&](int) { ++num_after; });
+  EXPECT_EQ(8, num_after.load());
+}
+
+TEST(TaskScheduler, TaskForCoversRange) {
+  std::vector<int> values(10007, 0);
+  Threading::TaskFor<int>(static_cast<int>(values.size()), 64, [&](int start, int end) {
+    for (int i = start; i < end; ++i) {
+      values[i] += i;
+    }
+  });
+  for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+    EXPECT_EQ(i, values[i]);
+  }
+}
+
+TEST(TaskScheduler, TasksRunOpenMPRegionsAlone) {
+  const int num_threads = OMP_NUM_THREADS();
+  std::atomic<int> max_omp_threads(0);
+  TaskScheduler::ParallelFor(16, [&](int) {
+    int omp_threads = OMP_NUM_THREADS();
+    int seen = max_omp_threads.load();
+    while (omp_threads > seen && !max_omp_threads.compare_exchange_weak(seen, omp_threads)) {}
+  });
+  EXPECT_EQ(1, max_omp_threads.load());
+  // restored for the OpenMP loops after the scheduler loop
+  EXPECT_EQ(num_threads, OMP_NUM_THREADS());
+}
+
+TEST(TaskScheduler, RestartsIdleWorkers) {
+  // longer than the idle time after which the workers stop
+  std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+  std::atomic<int> num_run(0);
+  TaskScheduler::ParallelFor(64, [&](int) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ++num_run;
+    std::lock_guard<std::mutex> lock(mutex);
+    thread_ids.insert(std::this_thread::get_id());
+  });
+  EXPECT_EQ(64, num_run.load());
+  if (OMP_NUM_THREADS() > 1) {
+    EXPECT_GT(thread_ids.size(), 1u);
+  }
+}
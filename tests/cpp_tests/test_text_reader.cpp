@@ -0,0 +1,123 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/meta.h>
+#include <LightGBM/utils/pipeline_reader.h>
+#include <LightGBM/utils/text_reader.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using LightGBM::data_size_t;
+using LightGBM::PipelineReader;
+using LightGBM::TextChunk;
+using LightGBM::TextReader;
+
+namespace {
+
+const char* kFilename = "test_text_reader.txt";
+
+/*! \brief Write a file of lines with various ends of line, return the lines that should be read */
+std::vector<std::string> WriteLines(int num_lines, bool end_with_eol) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> len_dist(0, 40);
+  std::uniform_int_distribution<int> eol_dist(0, 4);
+  std::string contents;
+  std::vector<std::string> lines;
+  for (int i = 0; i < num_lines; ++i) {
+    // a few lines longer than the chunks
+    const int len = i % 37 == 5 ? 300 : 1 + len_dist(gen);
+    std::string line;
+    for (int j = 0; j < len; ++j) {
+      line.push_back(static_cast<char>('a' + (i + j) % 26));
+    }
+    lines.push_back(line);
+    contents += line;
+    if (i + 1 == num_lines && !end_with_eol) {
+      break;
+    }
+    const char* eols[] = {"\n", "\r\n", "\n\n", "\r\n\r\n", "\r"};
+    contents += eols[eol_dist(gen)];
+  }
+  std::ofstream file(kFilename, std::ios::binary | std::ios::trunc);
+  file << "header,line\n" << contents;
+  return lines;
+}
+
+}  // namespace
+
+TEST(TextReader, PipelineReaderSplitsChunksAtLines) {
+  for (bool end_with_eol : {true, false}) {
+    const std::vector<std::string> expected = WriteLines(500, end_with_eol);
+    // chunk sizes smaller and larger than the lines
+    for (size_t chunk_size : {1, 7, 64, 1000, 1 << 20}) {
+      for (int num_threads : {1, 3}) {
+        std::vector<std::string> lines;
+        bool last_line_without_eol = false;
+        std::vector<std::string> copied_lines;
+        EXPECT_TRUE(PipelineReader::Read(kFilename, 12, [&] (TextChunk* chunk) {
+          for (size_t i = 0; i < chunk->num_lines(); ++i) {
+            lines.emplace_back(chunk->line_data(i), chunk->line_size(i));
+          }
+          copied_lines.insert(copied_lines.end(), chunk->lines.begin(), chunk->lines.end());
+          last_line_without_eol = last_line_without_eol || chunk->last_line_without_eol;
+        }, true, chunk_size, num_threads));
+        EXPECT_EQ(expected, lines) << "chunk size " << chunk_size << " threads " << num_threads;
+        EXPECT_EQ(expected, copied_lines) << "chunk size " << chunk_size << " threads " << num_threads;
+        EXPECT_EQ(!end_with_eol, last_line_without_eol);
+      }
+    }
+  }
+  std::remove(kFilename);
+}
+
+TEST(TextReader, ReadsPartInOrder) {
+  const std::vector<std::string> expected = WriteLines(2000, true);
+  TextReader<data_size_t> reader(kFilename, true);
+  EXPECT_EQ("header,line", reader.first_line());
+  std::vector<data_size_t> used_data_indices;
+  for (data_size_t i = 0; i < static_cast<data_size_t>(expected.size()); i += 3) {
+    used_data_indices.push_back(i);
+  }
+  std::vector<std::string> lines;
+  const data_size_t total_cnt = reader.ReadPartAndProcessParallel(used_data_indices,
+      [&] (data_size_t start_idx, const std::vector<std::string>& chunk_lines) {
+    EXPECT_EQ(static_cast<data_size_t>(lines.size()), start_idx);
+    lines.insert(lines.end(), chunk_lines.begin(), chunk_lines.end());
+  });
+  EXPECT_EQ(static_cast<data_size_t>(expected.size()), total_cnt);
+  ASSERT_EQ(used_data_indices.size(), lines.size());
+  for (size_t i = 0; i < lines.size(); ++i) {
+    EXPECT_EQ(expected[used_data_indices[i]], lines[i]);
+  }
+  EXPECT_EQ(static_cast<data_size_t>(expected.size()), reader.ReadAllLines());
+  EXPECT_EQ(expected, reader.Lines());
+  std::remove(kFilename);
+}
+
+TEST(TextReader, StopsOnProcessError) {
+  WriteLines(500, true);
+  int num_chunks = 0;
+  EXPECT_THROW(PipelineReader::Read(kFilename, 0, [&] (TextChunk*) {
+    if (++num_chunks == 3) {
+      throw std::runtime_error("process error");
+    }
+  }, false, 64, 3), std::runtime_error);
+  EXPECT_EQ(3, num_chunks);
+  EXPECT_FALSE(PipelineReader::Read("test_text_reader_missing.txt", 0, [] (TextChunk*) {}));
+  std::remove(kFilename);
+}
+
+#ifndef _WIN32
+TEST(TextReader, StopsOnReadError) {
+  // a directory opens, but reading it fails
+  EXPECT_THROW(PipelineReader::Read(".", 0, [] (TextChunk*) {}, false, 64, 2), std::runtime_error);
+}
+#endif
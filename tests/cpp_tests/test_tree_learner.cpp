@@ -0,0 +1,312 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/config.h>
+#include <LightGBM/dataset.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/treelearner/serial_tree_learner.h"
+
+using LightGBM::ColRowWiseSelector;
+using LightGBM::Config;
+using LightGBM::data_size_t;
+using LightGBM::Dataset;
+using LightGBM::score_t;
+using LightGBM::SerialTreeLearner;
+using LightGBM::Tree;
+
+namespace {
+
+const data_size_t kNumData = 3000;
+const int kNumDense = 6;
+const int kNumSparse = 10;
+
+/*! \brief Tree learner whose histograms are all built with the same layout */
+class ForcedColRowWiseLearner : public SerialTreeLearner {
+ public:
+  explicit ForcedColRowWiseLearner(const Config* config) : SerialTreeLearner(config) {}
+
+  void Force(bool use_alternative) {
+    col_row_wise_selector_.reset(new ColRowWiseSelector(use_alternative));
+  }
+
+  int max_leaves_per_step() const {
+    return max_leaves_per_step_;
+  }
+
+  bool is_histogram_pool_enough() const {
+    return histogram_pool_.is_enough();
+  }
+};
+
+}  // namespace
+
+class TreeLearnerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(17);
+    std::normal_distribution<double> value_dist;
+    std::uniform_int_distribution<int> sparse_dist(0, 9);
+    const int num_col = kNumDense + kNumSparse;
+    features_.assign(static_cast<size_t>(kNumData) * num_col, 0.0);
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      for (int j = 0; j < num_col; ++j) {
+        // the sparse columns go to the multi-value bin of the col-wise layout
+        if (j < kNumDense || sparse_dist(gen) == 0) {
+          features_[static_cast<size_t>(i) * num_col + j] = value_dist(gen);
+        }
+      }
+      gradients_.push_back(static_cast<score_t>(value_dist(gen)));
+      hessians_.push_back(static_cast<score_t>(0.5 + std::abs(value_dist(gen))));
+      // their sums are exact, so histograms computed by subtraction equal the constructed ones
+      int_gradients_.push_back(static_cast<score_t>(std::lround(gradients_.back() * 4)));
+      int_hessians_.push_back(static_cast<score_t>(std::lround(hessians_.back() * 4)));
+    }
+    ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features_.data(), C_API_DTYPE_FLOAT64, kNumData, num_col, 1,
+                                           "max_bin=63 enable_bundle=false verbose=-1", nullptr, &dataset_));
+  }
+
+  void TearDown() override {
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset_));
+  }
+
+  /*!
+  * \brief Train a few trees
+  * \param force Build all histograms with the primary layout if 0, the other layout if 1
+  * \param integer_gradients Train on integer gradients and hessians
+  */
+  std::vector<std::unique_ptr<Tree>> TrainTrees(const std::string& params, int force = -1,
+                                                bool integer_gradients = false) {
+    Config config;
+    config.Set(Config::Str2Map(params.c_str()));
+    ForcedColRowWiseLearner learner(&config);
+    learner.Init(reinterpret_cast<const Dataset*>(dataset_), false);
+    learner.SetForcedSplit(nullptr);
+    if (force >= 0) {
+      learner.Force(force == 1);
+    }
+    std::vector<std::unique_ptr<Tree>> trees;
+    for (int iter = 0; iter < 3; ++iter) {
+      trees.emplace_back(integer_gradients
+                         ? learner.Train(int_gradients_.data(), int_hessians_.data(), iter == 0)
+                         : learner.Train(gradients_.data(), hessians_.data(), iter == 0));
+    }
+    return trees;
+  }
+
+  std::string TrainedTrees(const std::string& params, int force = -1, bool integer_gradients = false) {
+    std::string trees_str;
+    for (const auto& tree : TrainTrees(params, force, integer_gradients)) {
+      trees_str += tree->ToString();
+    }
+    return trees_str;
+  }
+
+  /*!
+  * \brief Sum over the trees of the second order approximation of the loss on the integer gradients,
+  *        which every tree minimizes
+  */
+  double Loss(const std::vector<std::unique_ptr<Tree>>& trees) const {
+    const size_t num_col = kNumDense + kNumSparse;
+    double loss = 0.0;
+    for (const auto& tree : trees) {
+      for (data_size_t i = 0; i < kNumData; ++i) {
+        const double score = tree->Predict(features_.data() + i * num_col);
+        loss += int_gradients_[i] * score + 0.5 * int_hessians_[i] * score * score;
+      }
+    }
+    return loss;
+  }
+
+  DatasetHandle dataset_;
+  std::vector<double> features_;
+  std::vector<score_t> gradients_;
+  std::vector<score_t> hessians_;
+  std::vector<score_t> int_gradients_;
+  std::vector<score_t> int_hessians_;
+};
+
+TEST_F(TreeLearnerTest, ColRowWiseLayoutsGiveSameTrees) {
+  for (const char* gradients : {"", " use_quantized_grad=true"}) {
+    const std::string common = std::string("num_leaves=31 min_data_in_leaf=5 deterministic=true verbose=-1")
+                               + gradients;
+    const std::string expected = TrainedTrees(common + " force_col_wise=true");
+    EXPECT_NE(std::string::npos, expected.find("num_leaves=31"));
+    EXPECT_EQ(expected, TrainedTrees(common + " force_row_wise=true")) << gradients;
+    for (const char* primary : {" force_col_wise=true", " force_row_wise=true"}) {
+      const std::string params = common + primary + " adaptive_col_row_wise=true";
+      // the static cost model, then every leaf built with the primary or the other layout
+      for (int force : {-1, 0, 1}) {
+        EXPECT_EQ(expected, TrainedTrees(params, force)) << gradients << primary << " force " << force;
+      }
+      // the timed cost model
+      std::string timed_params = params;
+      timed_params.replace(timed_params.find("deterministic=true"), 18, "deterministic=false");
+      EXPECT_EQ(expected, TrainedTrees(timed_params)) << gradients << primary << " timed";
+    }
+  }
+}
+
+TEST_F(TreeLearnerTest, HistogramCostCountsUsedFeatures) {
+  const Dataset* dataset = reinterpret_cast<const Dataset*>(dataset_);
+  const int num_features = dataset->num_features();
+  std::vector<int8_t> all_used(num_features, 1);
+  std::vector<int8_t> dense_used(num_features, 0);
+  for (int i = 0; i < kNumDense; ++i) {
+    dense_used[dataset->InnerFeatureIndex(i)] = 1;
+  }
+  for (bool col_wise : {true, false}) {
+    std::unique_ptr<LightGBM::TrainingShareStates> share_state(dataset->GetShareStates(
+        gradients_.data(), hessians_.data(), all_used, false, col_wise, !col_wise));
+    const double all_cost = share_state->HistogramCost(kNumData, all_used, all_used);
+    const double dense_cost = share_state->HistogramCost(kNumData, dense_used, dense_used);
+    EXPECT_GT(dense_cost, 0.0) << col_wise;
+    EXPECT_LT(dense_cost, all_cost) << col_wise;
+    // the features of the leaf select the col-wise groups, the features of the tree the multi-value bin
+    const double leaf_dense_cost = share_state->HistogramCost(kNumData, dense_used, all_used);
+    if (col_wise) {
+      EXPECT_LE(dense_cost, leaf_dense_cost);
+      EXPECT_LT(leaf_dense_cost, all_cost);
+    } else {
+      EXPECT_EQ(all_cost, leaf_dense_cost);
+    }
+  }
+}
+
+TEST_F(TreeLearnerTest, TreeMergeMatchesLinearMerge) {
+  const Dataset* dataset = reinterpret_cast<const Dataset*>(dataset_);
+  const int max_threads = omp_get_max_threads();
+  // an odd number of row blocks, so that a block has no pair in the first round
+  omp_set_num_threads(5);
+  std::vector<int8_t> all_used(dataset->num_features(), 1);
+  std::vector<score_t> ordered_gradients(kNumData);
+  std::vector<score_t> ordered_hessians(kNumData);
+  std::vector<std::vector<LightGBM::hist_t>> hists;
+  for (bool use_tree_merge : {false, true}) {
+    std::unique_ptr<LightGBM::TrainingShareStates> share_state(dataset->GetShareStates(
+        gradients_.data(), hessians_.data(), all_used, false, false, true));
+    share_state->SetUseTreeMerge(use_tree_merge);
+    dataset->InitTrain(all_used, share_state.get());
+    hists.emplace_back(2 * static_cast<size_t>(share_state->num_hist_total_bin()));
+    dataset->ConstructHistograms(all_used, nullptr, kNumData, gradients_.data(), hessians_.data(),
+                                 ordered_gradients.data(), ordered_hessians.data(), share_state.get(),
+                                 hists.back().data());
+  }
+  omp_set_num_threads(max_threads);
+  ASSERT_EQ(hists[0].size(), hists[1].size());
+  double sum_hessians = 0.0;
+  for (size_t i = 0; i < hists[0].size(); ++i) {
+    // the blocks are summed in another order
+    EXPECT_NEAR(hists[0][i], hists[1][i], 1e-9 * (1.0 + std::abs(hists[0][i]))) << i;
+    sum_hessians += i % 2 == 1 ? hists[1][i] : 0.0;
+  }
+  EXPECT_GT(sum_hessians, 0.0);
+}
+
+TEST_F(TreeLearnerTest, HistogramPoolEvictionKeepsTrees) {
+  const std::string common = "num_leaves=31 min_data_in_leaf=5 force_col_wise=true verbose=-1";
+  const std::string expected = TrainedTrees(common, -1, true);
+  // 0.1MB holds the full precision histograms of 6 leaves, or 3 leaves and the quantized ones of 12
+  for (const char* eviction : {"lru", "gain"}) {
+    const std::string params = common + " histogram_pool_size=0.1 histogram_pool_eviction=" + eviction;
+    EXPECT_EQ(expected, TrainedTrees(params, -1, true)) << eviction;
+    // the spilled histograms are quantized, near ties can be split differently, but the fit is as good
+    const double expected_loss = Loss(TrainTrees(common, -1, true));
+    const double loss = Loss(TrainTrees(params + " histogram_pool_spill=true", -1, true));
+    EXPECT_LT(expected_loss, 0.0);
+    EXPECT_NEAR(expected_loss, loss, -0.01 * expected_loss) << eviction;
+  }
+}
+
+TEST_F(TreeLearnerTest, ResetConfigResizesHistogramPool) {
+  const std::string common = "num_leaves=31 min_data_in_leaf=5 force_col_wise=true verbose=-1";
+  const std::string small_pool = common + " histogram_pool_size=0.1";
+  const std::string expected = TrainedTrees(small_pool);
+  Config config;
+  config.Set(Config::Str2Map(common.c_str()));
+  ForcedColRowWiseLearner learner(&config);
+  learner.Init(reinterpret_cast<const Dataset*>(dataset_), false);
+  learner.SetForcedSplit(nullptr);
+  EXPECT_TRUE(learner.is_histogram_pool_enough());
+  // the same number of leaves, only the size of the pool changes
+  Config small_config;
+  small_config.Set(Config::Str2Map(small_pool.c_str()));
+  learner.ResetConfig(&small_config);
+  EXPECT_FALSE(learner.is_histogram_pool_enough());
+  std::string trees_str;
+  for (int iter = 0; iter < 3; ++iter) {
+    std::unique_ptr<Tree> tree(learner.Train(gradients_.data(), hessians_.data(), iter == 0));
+    trees_str += tree->ToString();
+  }
+  EXPECT_EQ(expected, trees_str);
+  Config spill_config;
+  spill_config.Set(Config::Str2Map((small_pool + " histogram_pool_spill=true").c_str()));
+  learner.ResetConfig(&spill_config);
+  EXPECT_FALSE(learner.is_histogram_pool_enough());
+  std::unique_ptr<Tree> tree(learner.Train(gradients_.data(), hessians_.data(), false));
+  EXPECT_EQ(31, tree->num_leaves());
+  learner.ResetConfig(&config);
+  EXPECT_TRUE(learner.is_histogram_pool_enough());
+}
+
+TEST_F(TreeLearnerTest, ConcurrentLeavesGiveSequentialTrees) {
+  // without the sparse columns, so that the col-wise histograms of the leaves are built concurrently
+  std::vector<double> features;
+  std::vector<float> labels;
+  for (data_size_t i = 0; i < kNumData; ++i) {
+    const double* row = features_.data() + i * (kNumDense + kNumSparse);
+    features.insert(features.end(), row, row + kNumDense);
+    labels.push_back(-gradients_[i]);
+  }
+  DatasetHandle dataset;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumDense, 1,
+                                         "max_bin=63 verbose=-1", nullptr, &dataset));
+  ASSERT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+  auto trained_model = [dataset](const std::string& params) {
+    BoosterHandle booster;
+    EXPECT_EQ(0, LGBM_BoosterCreate(dataset, params.c_str(), &booster));
+    int is_finished = 0;
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+    }
+    int64_t len = 0;
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &len, nullptr));
+    std::vector<char> model(len);
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, len, &len,
+                                               model.data()));
+    EXPECT_EQ(0, LGBM_BoosterFree(booster));
+    const std::string model_str(model.data());
+    return model_str.substr(0, model_str.find("end of trees"));
+  };
+  const std::string common = "objective=regression num_leaves=31 min_data_in_leaf=5 max_concurrent_leaves=4 "
+                             "num_threads=3 deterministic=true verbose=-1";
+  // the row-wise histograms of the leaves are built one after another
+  const std::string expected = trained_model(common + " force_row_wise=true");
+  EXPECT_NE(std::string::npos, expected.find("num_leaves=31"));
+  for (const char* scheduler : {"false", "true"}) {
+    EXPECT_EQ(expected, trained_model(common + " force_col_wise=true use_task_scheduler=" + scheduler))
+        << "use_task_scheduler " << scheduler;
+  }
+  // the steps split several leaves at once
+  Config config;
+  config.Set(Config::Str2Map((common + " force_col_wise=true").c_str()));
+  ForcedColRowWiseLearner learner(&config);
+  learner.Init(reinterpret_cast<const Dataset*>(dataset), false);
+  learner.SetForcedSplit(nullptr);
+  std::unique_ptr<Tree> tree(learner.Train(gradients_.data(), hessians_.data(), false));
+  EXPECT_EQ(31, tree->num_leaves());
+  EXPECT_GT(learner.max_leaves_per_step(), 1);
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+}
@@ -0,0 +1,415 @@
+/*!
+ * Copyright (c) 2021 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/tree.h>
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const int kNumData = 1000;
+const int kNumFeatures = 12;
+
+/*! \brief Trees of a model string */
+std::vector<std::unique_ptr<LightGBM::Tree>> ParseTrees(const std::string& model) {
+  std::vector<std::unique_ptr<LightGBM::Tree>> trees;
+  size_t pos = model.find("Tree=");
+  while (pos != std::string::npos) {
+    const size_t begin = model.find('\n', pos) + 1;
+    size_t used_len = 0;
+    trees.emplace_back(new LightGBM::Tree(model.c_str() + begin, &used_len));
+    pos = model.find("Tree=", begin + used_len);
+  }
+  return trees;
+}
+
+/*! \brief Booster trained on dense rows without zeros, NaN or categorical features */
+void TrainNumerical(const std::string& params, int num_class, int num_feature, std::vector<double>* features,
+                    DatasetHandle* dataset, BoosterHandle* booster) {
+  std::mt19937 gen(5);
+  std::normal_distribution<double> value_dist;
+  features->resize(static_cast<size_t>(kNumData) * num_feature);
+  std::vector<float> labels(kNumData);
+  for (int i = 0; i < kNumData; ++i) {
+    double* row = features->data() + static_cast<size_t>(i) * num_feature;
+    double y = 0.0;
+    for (int j = 0; j < num_feature; ++j) {
+      row[j] = value_dist(gen);
+      y += row[j] / (j + 1);
+    }
+    y += row[0] * row[1] + 0.1 * value_dist(gen);
+    labels[i] = num_class > 1 ? static_cast<float>(static_cast<int>(std::fabs(y) * 2) % num_class)
+                              : (y > 0.0 ? 1.0f : 0.0f);
+  }
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features->data(), C_API_DTYPE_FLOAT64, kNumData, num_feature, 1,
+                                         params.c_str(), nullptr, dataset));
+  ASSERT_EQ(0, LGBM_DatasetSetField(*dataset, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+  ASSERT_EQ(0, LGBM_BoosterCreate(*dataset, params.c_str(), booster));
+  int is_finished = 0;
+  for (int i = 0; i < 5 && !is_finished; ++i) {
+    ASSERT_EQ(0, LGBM_BoosterUpdateOneIter(*booster, &is_finished));
+  }
+}
+
+std::string ModelString(BoosterHandle booster) {
+  int64_t model_len = 0;
+  LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len, nullptr);
+  std::vector<char> model_str(model_len);
+  LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len,
+                                model_str.data());
+  return model_str.data();
+}
+
+/*!
+* \brief SHAP interaction values of a tree by their definition: each leaf is a game of the distinct features on its
+*        path, where a present feature follows the row and an absent one follows the path with its fraction of data
+*/
+std::vector<double> InteractionsByDefinition(const LightGBM::Tree& tree, const double* row, int num_feature) {
+  const int num_cols = num_feature + 1;
+  std::vector<double> result(static_cast<size_t>(num_cols) * num_cols, 0.0);
+  std::vector<int> features;
+  std::vector<double> zero_fractions;
+  std::vector<double> one_fractions;
+  std::function<void(int)> visit = [&](int node) {
+    if (node < 0) {
+      const int d = static_cast<int>(features.size());
+      auto value = [&](int subset) {
+        double product = tree.LeafOutput(~node);
+        for (int k = 0; k < d; ++k) {
+          product *= ((subset >> k) & 1) ? one_fractions[k] : zero_fractions[k];
+        }
+        return product;
+      };
+      std::vector<double> factorial(d + 1, 1.0);
+      for (int k = 1; k <= d; ++k) {
+        factorial[k] = factorial[k - 1] * k;
+      }
+      for (int i = 0; i < d; ++i) {
+        for (int j = 0; j < d; ++j) {
+          if (i == j) {
+            continue;
+          }
+          for (int subset = 0; subset < (1 << d); ++subset) {
+            if (((subset >> i) & 1) || ((subset >> j) & 1)) {
+              continue;
+            }
+            int size = 0;
+            for (int k = 0; k < d; ++k) {
+              size += (subset >> k) & 1;
+            }
+            const double weight = factorial[size] * factorial[d - size - 2] / (2 * factorial[d - 1]);
+            result[features[i] * num_cols + features[j]] += weight * (
+              value(subset | (1 << i) | (1 << j)) - value(subset | (1 << i)) - value(subset | (1 << j)) + value(subset));
+          }
+        }
+      }
+      return;
+    }
+    const int feature = tree.split_feature(node);
+    const bool goes_left = row[feature] <= tree.threshold(node);
+    size_t slot = 0;
+    while (slot < features.size() && features[slot] != feature) {
+      ++slot;
+    }
+    const bool is_new = slot == features.size();
+    if (is_new) {
+      features.push_back(feature);
+      zero_fractions.push_back(1.0);
+      one_fractions.push_back(1.0);
+    }
+    const double zero_fraction = zero_fractions[slot];
+    const double one_fraction = one_fractions[slot];
+    for (int child : {tree.left_child(node), tree.right_child(node)}) {
+      zero_fractions[slot] = zero_fraction * tree.data_count(child) / tree.data_count(node);
+      one_fractions[slot] = (goes_left == (child == tree.left_child(node))) ? one_fraction : 0.0;
+      visit(child);
+    }
+    zero_fractions[slot] = zero_fraction;
+    one_fractions[slot] = one_fraction;
+    if (is_new) {
+      features.pop_back();
+      zero_fractions.pop_back();
+      one_fractions.pop_back();
+    }
+  };
+  if (tree.num_leaves() > 1) {
+    visit(0);
+  }
+  return result;
+}
+
+}  // namespace
+
+/*! \brief (params, num_class) */
+class TreeSHAPTest : public testing::TestWithParam<std::tuple<std::string, int>> {};
+
+TEST_P(TreeSHAPTest, FastMatchesRecursion) {
+  const std::string params = std::get<0>(GetParam()) + " verbose=-1 num_threads=2 categorical_feature=0";
+  const int num_class = std::get<1>(GetParam());
+  std::mt19937 gen(17);
+  std::normal_distribution<double> value_dist;
+  std::uniform_int_distribution<int> category_dist(0, 9);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<double> features(static_cast<size_t>(kNumData) * kNumFeatures);
+  std::vector<float> labels(kNumData);
+  for (int i = 0; i < kNumData; ++i) {
+    double* row = features.data() + static_cast<size_t>(i) * kNumFeatures;
+    row[0] = category_dist(gen);
+    double y = 0.3 * (static_cast<int>(row[0]) % 4);
+    for (int j = 1; j < kNumFeatures; ++j) {
+      const double r = uniform(gen);
+      row[j] = r < 0.05 ? NAN : (r < 0.15 ? 0.0 : value_dist(gen));
+      y += (std::isnan(row[j]) ? 0.5 : row[j]) * (j % 3 == 0 ? -1.0 : 1.0) / j;
+    }
+    y += 0.2 * value_dist(gen);
+    labels[i] = num_class > 1 ? static_cast<float>(static_cast<int>(std::fabs(y) * 2) % num_class)
+                              : (y > 0.3 ? 1.0f : 0.0f);
+  }
+  DatasetHandle dataset;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                         params.c_str(), nullptr, &dataset));
+  ASSERT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels.data(), kNumData, C_API_DTYPE_FLOAT32));
+  BoosterHandle booster;
+  ASSERT_EQ(0, LGBM_BoosterCreate(dataset, params.c_str(), &booster));
+  int is_finished = 0;
+  for (int i = 0; i < 8 && !is_finished; ++i) {
+    ASSERT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+  }
+  int64_t model_len = 0;
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len, nullptr));
+  std::vector<char> model_str(model_len);
+  ASSERT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len,
+                                             model_str.data()));
+  auto trees = ParseTrees(model_str.data());
+  ASSERT_EQ(0, static_cast<int>(trees.size()) % num_class);
+
+  // contributions of the recursive TreeSHAP, then of the precomputed data with all, some or no weight tables
+  const int num_cols = kNumFeatures + 1;
+  const std::vector<std::pair<int, int64_t>> table_limits = {{8, 1 << 30}, {4, 1 << 30}, {8, 2000}, {0, 0}};
+  std::vector<std::vector<double>> expected(kNumData, std::vector<double>(num_class * num_cols, 0.0));
+  for (size_t t = 0; t < trees.size(); ++t) {
+    trees[t]->RecomputeMaxDepth();
+    std::vector<std::vector<double>> tree_expected(kNumData, std::vector<double>(num_cols, 0.0));
+    for (int i = 0; i < kNumData; ++i) {
+      trees[t]->PredictContrib(features.data() + static_cast<size_t>(i) * kNumFeatures, kNumFeatures,
+                               tree_expected[i].data());
+    }
+    for (const auto& limits : table_limits) {
+      trees[t]->PrecomputeSHAP(limits.first, limits.second);
+      for (int i = 0; i < kNumData; ++i) {
+        std::vector<double> result(num_cols, 0.0);
+        trees[t]->PredictContrib(features.data() + static_cast<size_t>(i) * kNumFeatures, kNumFeatures,
+                                 result.data());
+        for (int j = 0; j < num_cols; ++j) {
+          ASSERT_NEAR(tree_expected[i][j], result[j], 1e-10 * (1.0 + std::fabs(tree_expected[i][j])))
+              << "tree " << t << ", max table features " << limits.first << ", row " << i << ", column " << j;
+        }
+      }
+      trees[t]->FreeSHAP();
+    }
+    for (int i = 0; i < kNumData; ++i) {
+      for (int j = 0; j < num_cols; ++j) {
+        expected[i][(t % num_class) * num_cols + j] += tree_expected[i][j];
+      }
+    }
+  }
+
+  // the booster computes the same contributions, the weights are computed again after they are freed
+  for (const char* predict_params : {"", "pred_contrib_table_max_features=3 pred_contrib_table_memory_mb=0.01"}) {
+    ASSERT_EQ(0, LGBM_BoosterFreePredictCache(booster));
+    int64_t out_len = 0;
+    std::vector<double> booster_result(static_cast<size_t>(kNumData) * num_class * num_cols);
+    ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumData, kNumFeatures, 1,
+                                           C_API_PREDICT_CONTRIB, 0, -1, predict_params, &out_len,
+                                           booster_result.data()));
+    ASSERT_EQ(static_cast<int64_t>(booster_result.size()), out_len);
+    for (int i = 0; i < kNumData; ++i) {
+      for (int j = 0; j < num_class * num_cols; ++j) {
+        ASSERT_NEAR(expected[i][j], booster_result[i * num_class * num_cols + j],
+                    1e-10 * (1.0 + std::fabs(expected[i][j]))) << predict_params << ", row " << i << ", column " << j;
+      }
+    }
+  }
+
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Models, TreeSHAPTest,
+    testing::Values(
+        std::make_tuple("objective=binary num_leaves=31", 1),
+        // paths with more distinct features than the weight tables
+        std::make_tuple("objective=binary num_leaves=400 min_data_in_leaf=1 min_sum_hessian_in_leaf=0", 1),
+        std::make_tuple("objective=regression num_leaves=15 boosting=rf bagging_freq=1 bagging_fraction=0.5", 1),
+        std::make_tuple("objective=multiclass num_class=3 num_leaves=63 min_data_in_leaf=3", 3)));
+
+TEST(TreeSHAP, InteractionsMatchDefinition) {
+  const int num_feature = 6;
+  const std::string params = "objective=binary num_leaves=40 min_data_in_leaf=5 verbose=-1 num_threads=2";
+  std::vector<double> features;
+  DatasetHandle dataset;
+  BoosterHandle booster;
+  TrainNumerical(params, 1, num_feature, &features, &dataset, &booster);
+  auto trees = ParseTrees(ModelString(booster));
+  const int num_cols = num_feature + 1;
+  for (size_t t = 0; t < trees.size(); ++t) {
+    trees[t]->PrecomputeSHAP(8, 1 << 30);
+    for (int i = 0; i < 100; ++i) {
+      const double* row = features.data() + static_cast<size_t>(i) * num_feature;
+      const auto expected = InteractionsByDefinition(*trees[t], row, num_feature);
+      std::vector<double> result(expected.size(), 0.0);
+      trees[t]->PredictContribInteractions(row, num_feature, result.data());
+      std::unordered_map<int, double> sparse_result;
+      std::unordered_map<int, double> sparse_row;
+      for (int j = 0; j < num_feature; ++j) {
+        sparse_row[j] = row[j];
+      }
+      trees[t]->PredictContribInteractionsByMap(sparse_row, num_feature, &sparse_result);
+      for (int j = 0; j < num_cols * num_cols; ++j) {
+        ASSERT_NEAR(expected[j], result[j], 1e-12) << "tree " << t << ", row " << i << ", index " << j;
+        const double sparse_value = sparse_result.count(j) ? sparse_result[j] : 0.0;
+        ASSERT_NEAR(expected[j], sparse_value, 1e-12) << "tree " << t << ", row " << i << ", index " << j;
+      }
+    }
+  }
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+}
+
+TEST(TreeSHAP, InteractionsSumToContributions) {
+  const int num_feature = 5;
+  const int num_class = 3;
+  const std::string params = "objective=multiclass num_class=3 num_leaves=20 verbose=-1 num_threads=2";
+  std::vector<double> features;
+  DatasetHandle dataset;
+  BoosterHandle booster;
+  TrainNumerical(params, num_class, num_feature, &features, &dataset, &booster);
+  // some zeros, dropped from the sparse rows
+  for (size_t i = 0; i < features.size(); i += 7) {
+    features[i] = 0.0;
+  }
+  const int num_rows = 200;
+  const int num_cols = num_feature + 1;
+  const int matrix_size = num_cols * num_cols;
+  int64_t out_len = 0;
+  std::vector<double> contrib(static_cast<size_t>(num_rows) * num_class * num_cols);
+  ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, num_rows, num_feature, 1,
+                                         C_API_PREDICT_CONTRIB, 0, -1, "", &out_len, contrib.data()));
+  ASSERT_EQ(0, LGBM_BoosterCalcNumPredict(booster, num_rows, C_API_PREDICT_CONTRIB_INTERACTIONS, 0, -1, &out_len));
+  ASSERT_EQ(static_cast<int64_t>(num_rows) * num_class * matrix_size, out_len);
+  std::vector<double> interactions(out_len);
+  ASSERT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, num_rows, num_feature, 1,
+                                         C_API_PREDICT_CONTRIB_INTERACTIONS, 0, -1, "", &out_len, interactions.data()));
+  ASSERT_EQ(static_cast<int64_t>(interactions.size()), out_len);
+  for (int r = 0; r < num_rows; ++r) {
+    for (int k = 0; k < num_class; ++k) {
+      const double* matrix = interactions.data() + (static_cast<size_t>(r) * num_class + k) * matrix_size;
+      const double* cur_contrib = contrib.data() + (static_cast<size_t>(r) * num_class + k) * num_cols;
+      for (int i = 0; i < num_cols; ++i) {
+        double row_sum = 0.0;
+        for (int j = 0; j < num_cols; ++j) {
+          ASSERT_NEAR(matrix[i * num_cols + j], matrix[j * num_cols + i], 1e-12);
+          row_sum += matrix[i * num_cols + j];
+        }
+        ASSERT_NEAR(cur_contrib[i], row_sum, 1e-10) << "row " << r << ", class " << k << ", feature " << i;
+      }
+    }
+  }
+
+  // the same values through the sparse output, one CSR matrix per class
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int r = 0; r < num_rows; ++r) {
+    for (int j = 0; j < num_feature; ++j) {
+      const double value = features[static_cast<size_t>(r) * num_feature + j];
+      if (value != 0.0) {
+        indices.push_back(j);
+        values.push_back(value);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  int64_t sparse_len[2];
+  void* out_indptr = nullptr;
+  int32_t* out_indices = nullptr;
+  void* out_data = nullptr;
+  ASSERT_EQ(0, LGBM_BoosterPredictSparseOutput(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(), values.data(),
+                                               C_API_DTYPE_FLOAT64, indptr.size(), values.size(), num_feature,
+                                               C_API_PREDICT_CONTRIB_INTERACTIONS, 0, -1, "", C_API_MATRIX_TYPE_CSR,
+                                               sparse_len, &out_indptr, &out_indices, &out_data));
+  ASSERT_EQ(static_cast<int64_t>(num_rows + 1) * num_class, sparse_len[1]);
+  const int32_t* result_indptr = reinterpret_cast<const int32_t*>(out_indptr);
+  const double* result_data = reinterpret_cast<const double*>(out_data);
+  int64_t matrix_begin = 0;
+  for (int k = 0; k < num_class; ++k) {
+    const int32_t* cur_indptr = result_indptr + k * (num_rows + 1);
+    std::vector<double> dense(static_cast<size_t>(num_rows) * matrix_size, 0.0);
+    for (int r = 0; r < num_rows; ++r) {
+      for (int32_t e = cur_indptr[r]; e < cur_indptr[r + 1]; ++e) {
+        ASSERT_LT(out_indices[matrix_begin + e], matrix_size);
+        dense[static_cast<size_t>(r) * matrix_size + out_indices[matrix_begin + e]] = result_data[matrix_begin + e];
+      }
+    }
+    for (int r = 0; r < num_rows; ++r) {
+      const double* expected = interactions.data() + (static_cast<size_t>(r) * num_class + k) * matrix_size;
+      for (int j = 0; j < matrix_size; ++j) {
+        ASSERT_NEAR(expected[j], dense[static_cast<size_t>(r) * matrix_size + j], 1e-10)
+          << "row " << r << ", class " << k << ", index " << j;
+      }
+    }
+    matrix_begin += cur_indptr[num_rows];
+  }
+  ASSERT_EQ(sparse_len[0], matrix_begin);
+  ASSERT_EQ(0, LGBM_BoosterFreePredictSparse(out_indptr, out_indices, out_data, C_API_DTYPE_INT32, C_API_DTYPE_FLOAT64));
+
+  // the CSC output has one column per pair of features of the model, also for an input with fewer columns
+  for (int input_cols : {num_feature, num_feature - 1}) {
+    std::vector<int32_t> col_ptr(1, 0);
+    std::vector<int32_t> row_indices;
+    std::vector<double> col_values;
+    for (int j = 0; j < input_cols; ++j) {
+      for (int r = 0; r < num_rows; ++r) {
+        const double value = features[static_cast<size_t>(r) * num_feature + j];
+        if (value != 0.0) {
+          row_indices.push_back(r);
+          col_values.push_back(value);
+        }
+      }
+      col_ptr.push_back(static_cast<int32_t>(row_indices.size()));
+    }
+    ASSERT_EQ(0, LGBM_BoosterPredictSparseOutput(booster, col_ptr.data(), C_API_DTYPE_INT32, row_indices.data(),
+                                                 col_values.data(), C_API_DTYPE_FLOAT64, col_ptr.size(),
+                                                 col_values.size(), num_rows, C_API_PREDICT_CONTRIB_INTERACTIONS, 0, -1,
+                                                 "predict_disable_shape_check=true", C_API_MATRIX_TYPE_CSC,
+                                                 sparse_len, &out_indptr, &out_indices, &out_data));
+    EXPECT_EQ(static_cast<int64_t>(matrix_size + 1) * num_class, sparse_len[1]) << input_cols;
+    const int32_t* out_col_ptr = reinterpret_cast<const int32_t*>(out_indptr);
+    int64_t num_elements = 0;
+    for (int k = 0; k < num_class; ++k) {
+      num_elements += out_col_ptr[k * (matrix_size + 1) + matrix_size];
+    }
+    EXPECT_EQ(sparse_len[0], num_elements) << input_cols;
+    for (int64_t e = 0; e < sparse_len[0]; ++e) {
+      ASSERT_LT(out_indices[e], num_rows);
+    }
+    ASSERT_EQ(0, LGBM_BoosterFreePredictSparse(out_indptr, out_indices, out_data, C_API_DTYPE_INT32,
+                                               C_API_DTYPE_FLOAT64));
+  }
+
+  ASSERT_EQ(0, LGBM_BoosterFree(booster));
+  ASSERT_EQ(0, LGBM_DatasetFree(dataset));
+}